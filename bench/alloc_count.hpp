@@ -0,0 +1,168 @@
+/*!
+ * @file alloc_count.hpp
+ * @brief SofaBuffers benchmarks — heap allocation counting for the C++ wrapper.
+ *
+ * The README promises that the wrapper's heap-free subset (OStreamInline,
+ * OStreamView or any stream over caller storage, FixedString, FixedBytes,
+ * InlineVector, message objects built from them) never touches the heap, and
+ * that only OStream(buflen) and the std::string / std::vector reads do. This
+ * replaces the global operator new / delete with counting versions so a
+ * benchmark can measure that per operation: every replaceable form (array,
+ * nothrow, aligned, sized) is routed through one counter, which only counts
+ * between begin() and end(), so setup and the harness itself are not charged.
+ *
+ * Defines the replacement functions, so include it in exactly one translation
+ * unit of a program (bench.cpp and perf.cpp are separate programs). Valid
+ * with -fno-exceptions: an allocation failure aborts instead of throwing.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_BENCH_ALLOC_COUNT_HPP
+#define SOFAB_BENCH_ALLOC_COUNT_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace alloc_count
+{
+
+struct Counts
+{
+    unsigned long allocs = 0;   //!< operator new calls
+    unsigned long frees = 0;    //!< operator delete calls (non-null)
+    size_t        bytes = 0;    //!< bytes requested
+    unsigned      reps = 1;     //!< operations the counts cover
+};
+
+inline Counts counts;
+inline bool   armed = false;
+
+/*! @brief Start charging allocations to a fresh window. */
+inline void begin() noexcept
+{
+    counts = Counts{};
+    armed = true;
+}
+
+/*! @brief Stop charging; returns the window's counts. */
+inline Counts end() noexcept
+{
+    armed = false;
+    return counts;
+}
+
+inline void *take(size_t n, size_t align) noexcept
+{
+    if (armed) {
+        counts.allocs++;
+        counts.bytes += n;
+    }
+    if (n == 0)
+        n = 1;
+    if (align > alignof(std::max_align_t))
+        return std::aligned_alloc(align, (n + align - 1) / align * align);
+    return std::malloc(n);
+}
+
+inline void give(void *p) noexcept
+{
+    if (p && armed)
+        counts.frees++;
+    std::free(p);
+}
+
+inline void *take_or_abort(size_t n, size_t align) noexcept
+{
+    void *p = take(n, align);
+    if (!p) {
+        std::fputs("alloc_count: out of memory\n", stderr);
+        std::abort();
+    }
+    return p;
+}
+
+/*! @brief Whether a path may use the heap at all. */
+enum class Policy { HeapFree, MayAllocate };
+
+/*!
+ * @brief Run @p fn @p reps times counted. A may-allocate path gets one
+ *        unmeasured call first (so lazily grown capacity is in place, as in
+ *        a long-running receiver); a heap-free one is counted from its very
+ *        first call, so a one-time allocation cannot hide in the warm-up.
+ *
+ * Returns the whole window's counts, not per-op ones: an integer division
+ * would round an occasional allocation down to none.
+ */
+template <typename F>
+Counts measure(Policy policy, F &&fn, unsigned reps = 16)
+{
+    if (policy == Policy::MayAllocate)
+        fn();
+    begin();
+    for (unsigned i = 0; i < reps; i++)
+        fn();
+    Counts c = end();
+    c.reps = reps;
+    return c;
+}
+
+inline void header()
+{
+    std::printf("%-34s %10s %10s %10s  %-13s %s\n",
+                "Workload", "allocs/op", "frees/op", "bytes/op", "policy", "result");
+}
+
+/*!
+ * @brief Print one row, per op. @return false if a heap-free path allocated
+ *        at all in the window.
+ */
+inline bool report(const char *name, Policy policy, Counts c)
+{
+    bool ok = policy == Policy::MayAllocate || c.allocs == 0;
+    std::printf("%-34s %10.2f %10.2f %10.1f  %-13s %s\n", name,
+                (double)c.allocs / c.reps, (double)c.frees / c.reps, (double)c.bytes / c.reps,
+                policy == Policy::HeapFree ? "heap-free" : "may-allocate", ok ? "ok" : "FAIL");
+    return ok;
+}
+
+/*! @brief measure() and report() one row under one @p policy. */
+template <typename F>
+bool check(const char *name, Policy policy, F &&fn)
+{
+    return report(name, policy, measure(policy, fn));
+}
+
+} // namespace alloc_count
+
+void *operator new(std::size_t n) { return alloc_count::take_or_abort(n, 0); }
+void *operator new[](std::size_t n) { return alloc_count::take_or_abort(n, 0); }
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept { return alloc_count::take(n, 0); }
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept { return alloc_count::take(n, 0); }
+void *operator new(std::size_t n, std::align_val_t a) { return alloc_count::take_or_abort(n, static_cast<size_t>(a)); }
+void *operator new[](std::size_t n, std::align_val_t a) { return alloc_count::take_or_abort(n, static_cast<size_t>(a)); }
+void *operator new(std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept
+{
+    return alloc_count::take(n, static_cast<size_t>(a));
+}
+void *operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept
+{
+    return alloc_count::take(n, static_cast<size_t>(a));
+}
+
+void operator delete(void *p) noexcept { alloc_count::give(p); }
+void operator delete[](void *p) noexcept { alloc_count::give(p); }
+void operator delete(void *p, std::size_t) noexcept { alloc_count::give(p); }
+void operator delete[](void *p, std::size_t) noexcept { alloc_count::give(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { alloc_count::give(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { alloc_count::give(p); }
+void operator delete(void *p, std::align_val_t) noexcept { alloc_count::give(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { alloc_count::give(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { alloc_count::give(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { alloc_count::give(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { alloc_count::give(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { alloc_count::give(p); }
+
+#endif /* SOFAB_BENCH_ALLOC_COUNT_HPP */
@@ -6,14 +6,23 @@
  * datasets: a 1000-element u64 array, a small "typical" mixed message, an
  * unbounded 1 MB blob (one-shot, streamed and decoded in chunks) and the
  * "composite" message that exercises the paths the other three never reach.
- * Each workload runs in a ~1 second loop and reports MB/s.
+ * Each workload runs in a ~1 second loop and reports MB/s. The u64 array,
+ * typical and composite datasets are measured a second time through the
+ * object API (descriptors over plain structs) in the "(object)" rows. A short
+ * table after it decodes a buffer of framed typical objects, once record by
+ * record and once through sofab_object_decode_batch().
  *
  * Throughput is measured against *process CPU time* (clock(), not wall-clock),
  * so the number reflects the cost of the implementation rather than OS
  * scheduling noise or the wall-clock speed of the host. MB = 1e6 bytes.
  *
- * Two modes:
+ * Modes:
  *   bench_c              -> timed MB/s table (default, CPU time).
+ *   bench_c --sweep      -> tab-separated table of every dataset at each feed
+ *                           chunk / output buffer size (see "sweep" below);
+ *                           `--sweep list` names the points and
+ *                           `--sweep <dataset> <op> <size>` runs one once, for
+ *                           `run_callgrind.sh sweep`.
  *   bench_c <workload>   -> run one operation once and exit; used by
  *                           run_callgrind.sh to count instructions/op under
  *                           Callgrind (a machine-independent metric). The
@@ -27,10 +36,13 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include "sofab/framing.h"
 #include "sofab/istream.h"
+#include "sofab/object.h"
 #include "sofab/ostream.h"
 
 #define N 1000
@@ -420,6 +432,409 @@ __attribute__((noinline)) void run_decode_composite_skip(void)
     sofab_istream_feed(&is, comp_buf, comp_used);
 }
 
+/* ---- object API (descriptor-driven) ------------------------------------- *
+ * The same three datasets held in plain structs and run through
+ * sofab_object_encode() / sofab_object_field_cb(), which is how the library is
+ * used from C. The descriptors are laid out so the encoder reproduces the raw
+ * rows' bytes exactly (checked in main), which makes each object row read
+ * directly against its stream-API row: the difference is the descriptor walk,
+ * the default tests and the per-field dispatch. */
+
+/* u64 array: one fixed-capacity array field, always full. */
+typedef struct
+{
+    uint64_t a[N];
+} u64_obj_t;
+
+static const sofab_object_descr_field_t u64_obj_fields[] = {
+    SOFAB_OBJECT_FIELD_ARRAY(1, u64_obj_t, a, SOFAB_OBJECT_FIELDTYPE_ARRAY_UNSIGNED),
+};
+static const sofab_object_descr_t u64_obj_info =
+    SOFAB_OBJECT_DESCR(u64_obj_fields, 1, NULL, 0);
+
+/* typical: the object API has no boolean tag; write_boolean() puts an unsigned
+ * 0/1 on the wire, so a one-byte UNSIGNED member carries it identically. */
+typedef struct
+{
+    uint32_t u;
+    int32_t  s;
+} typ_child_t;
+
+typedef struct
+{
+    uint32_t    f1;
+    int32_t     f2;
+    uint8_t     f3;
+    float       f4;
+    char        f5[16];
+    uint16_t    f6[4];
+    typ_child_t f7;
+} typ_obj_t;
+
+static const sofab_object_descr_field_t typ_child_fields[] = {
+    SOFAB_OBJECT_FIELD(1, typ_child_t, u, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+    SOFAB_OBJECT_FIELD(2, typ_child_t, s, SOFAB_OBJECT_FIELDTYPE_SIGNED),
+};
+static const sofab_object_descr_t typ_child_info =
+    SOFAB_OBJECT_DESCR(typ_child_fields, 2, NULL, 0);
+
+static const sofab_object_descr_field_t typ_obj_fields[] = {
+    SOFAB_OBJECT_FIELD(1, typ_obj_t, f1, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+    SOFAB_OBJECT_FIELD(2, typ_obj_t, f2, SOFAB_OBJECT_FIELDTYPE_SIGNED),
+    SOFAB_OBJECT_FIELD(3, typ_obj_t, f3, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+    SOFAB_OBJECT_FIELD(4, typ_obj_t, f4, SOFAB_OBJECT_FIELDTYPE_FP32),
+    SOFAB_OBJECT_FIELD(5, typ_obj_t, f5, SOFAB_OBJECT_FIELDTYPE_STRING),
+    SOFAB_OBJECT_FIELD_ARRAY(6, typ_obj_t, f6, SOFAB_OBJECT_FIELDTYPE_ARRAY_UNSIGNED),
+    SOFAB_OBJECT_FIELD_SEQUENCE(7, typ_obj_t, f7, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+};
+static const sofab_object_descr_t *const typ_obj_nested[] = { &typ_child_info };
+static const sofab_object_descr_t typ_obj_info =
+    SOFAB_OBJECT_DESCR(typ_obj_fields, 7, typ_obj_nested, 1);
+
+/* composite: field 1 is a wrapper-array holder with one descriptor slot per
+ * element, field 4 a struct left at its default so the encoder omits it. */
+typedef struct
+{
+    char s[COMP_ITEMS][COMP_ITEM_MAX];
+} comp_items_t;
+
+typedef struct { uint32_t deep; } comp_l3_t;
+typedef struct { comp_l3_t l3; } comp_l2_t;
+typedef struct { comp_l2_t l2; int32_t tail; } comp_l1_t;
+typedef struct { uint32_t x; } comp_f4_t;
+
+typedef struct
+{
+    comp_items_t items;
+    char         text[COMP_TEXT_LEN + 1];
+    comp_l1_t    l1;
+    comp_f4_t    f4;
+    uint32_t     f130;
+} comp_obj_t;
+
+#define COMP_SLOT(i) \
+    SOFAB_OBJECT_FIELD(i, comp_items_t, s[i], SOFAB_OBJECT_FIELDTYPE_STRING)
+#define COMP_SLOT4(i)  COMP_SLOT(i), COMP_SLOT(i + 1), COMP_SLOT(i + 2), COMP_SLOT(i + 3)
+#define COMP_SLOT16(i) COMP_SLOT4(i), COMP_SLOT4(i + 4), COMP_SLOT4(i + 8), COMP_SLOT4(i + 12)
+
+static const sofab_object_descr_field_t comp_items_fields[] = {
+    COMP_SLOT16(0), COMP_SLOT16(16), COMP_SLOT16(32), COMP_SLOT16(48),
+};
+static const sofab_object_descr_t comp_items_info =
+    SOFAB_OBJECT_DESCR_SEQ(comp_items_fields, COMP_ITEMS, NULL, 0);
+
+static const sofab_object_descr_field_t comp_l3_fields[] = {
+    SOFAB_OBJECT_FIELD(1, comp_l3_t, deep, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+};
+static const sofab_object_descr_t comp_l3_info =
+    SOFAB_OBJECT_DESCR(comp_l3_fields, 1, NULL, 0);
+
+static const sofab_object_descr_field_t comp_l2_fields[] = {
+    SOFAB_OBJECT_FIELD_SEQUENCE(1, comp_l2_t, l3, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+};
+static const sofab_object_descr_t *const comp_l2_nested[] = { &comp_l3_info };
+static const sofab_object_descr_t comp_l2_info =
+    SOFAB_OBJECT_DESCR(comp_l2_fields, 1, comp_l2_nested, 1);
+
+static const sofab_object_descr_field_t comp_l1_fields[] = {
+    SOFAB_OBJECT_FIELD_SEQUENCE(1, comp_l1_t, l2, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+    SOFAB_OBJECT_FIELD(2, comp_l1_t, tail, SOFAB_OBJECT_FIELDTYPE_SIGNED),
+};
+static const sofab_object_descr_t *const comp_l1_nested[] = { &comp_l2_info };
+static const sofab_object_descr_t comp_l1_info =
+    SOFAB_OBJECT_DESCR(comp_l1_fields, 2, comp_l1_nested, 1);
+
+static const sofab_object_descr_field_t comp_f4_fields[] = {
+    SOFAB_OBJECT_FIELD(1, comp_f4_t, x, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+};
+static const sofab_object_descr_t comp_f4_info =
+    SOFAB_OBJECT_DESCR(comp_f4_fields, 1, NULL, 0);
+
+static const sofab_object_descr_field_t comp_obj_fields[] = {
+    SOFAB_OBJECT_FIELD_SEQUENCE(1, comp_obj_t, items, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+    SOFAB_OBJECT_FIELD(2, comp_obj_t, text, SOFAB_OBJECT_FIELDTYPE_STRING),
+    SOFAB_OBJECT_FIELD_SEQUENCE(3, comp_obj_t, l1, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 1),
+    SOFAB_OBJECT_FIELD_SEQUENCE(4, comp_obj_t, f4, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 2),
+    SOFAB_OBJECT_FIELD(130, comp_obj_t, f130, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+};
+static const sofab_object_descr_t *const comp_obj_nested[] = {
+    &comp_items_info, &comp_l1_info, &comp_f4_info,
+};
+static const sofab_object_descr_t comp_obj_info =
+    SOFAB_OBJECT_DESCR(comp_obj_fields, 5, comp_obj_nested, 3);
+
+/* encode sources and decode targets (static, like the raw rows') */
+static u64_obj_t  u64_obj_src, u64_obj_dec;
+static typ_obj_t  typ_obj_src, typ_obj_dec;
+static comp_obj_t comp_obj_src, comp_obj_dec;
+
+static uint8_t  u64_obj_buf[sizeof enc_u64_buf];
+static size_t   u64_obj_used;
+static uint8_t  typ_obj_buf[sizeof typ_buf];
+static size_t   typ_obj_used;
+static uint8_t  comp_obj_buf[sizeof comp_buf];
+static size_t   comp_obj_used;
+
+static void make_objects(void)
+{
+    memcpy(u64_obj_src.a, src, sizeof u64_obj_src.a);
+
+    typ_obj_src.f1 = 0xDEADBEEF;
+    typ_obj_src.f2 = -12345;
+    typ_obj_src.f3 = 1;
+    typ_obj_src.f4 = 3.14159f;
+    strcpy(typ_obj_src.f5, "sofab");
+    memcpy(typ_obj_src.f6, arr16, sizeof typ_obj_src.f6);
+    typ_obj_src.f7.u = 99;
+    typ_obj_src.f7.s = -7;
+
+    memcpy(comp_obj_src.items.s, comp_items, sizeof comp_obj_src.items.s);
+    memcpy(comp_obj_src.text, COMP_TEXT, sizeof comp_obj_src.text);
+    comp_obj_src.l1.l2.l3.deep = 7;
+    comp_obj_src.l1.tail = -1;
+    comp_obj_src.f130 = 0xDEADBEEF;
+}
+
+__attribute__((noinline)) void run_encode_u64_array_object(void)
+{
+    sofab_ostream_t os;
+    sofab_ostream_init(&os, u64_obj_buf, sizeof u64_obj_buf, 0, NULL, NULL);
+    sofab_object_encode(&os, &u64_obj_info, &u64_obj_src);
+    u64_obj_used = sofab_ostream_bytes_used(&os);
+}
+
+__attribute__((noinline)) void run_encode_typical_object(void)
+{
+    sofab_ostream_t os;
+    sofab_ostream_init(&os, typ_obj_buf, sizeof typ_obj_buf, 0, NULL, NULL);
+    sofab_object_encode(&os, &typ_obj_info, &typ_obj_src);
+    typ_obj_used = sofab_ostream_bytes_used(&os);
+}
+
+__attribute__((noinline)) void run_encode_composite_object(void)
+{
+    sofab_ostream_t os;
+    sofab_ostream_init(&os, comp_obj_buf, sizeof comp_obj_buf, 0, NULL, NULL);
+    sofab_object_encode(&os, &comp_obj_info, &comp_obj_src);
+    comp_obj_used = sofab_ostream_bytes_used(&os);
+}
+
+/* Each decode re-initializes its target first, as object.h requires before
+ * every message, so the rows include that cost. One decoder slot per nesting
+ * level below the root. */
+__attribute__((noinline)) void run_decode_u64_array_object(void)
+{
+    sofab_istream_t is;
+    sofab_object_decoder_t dec[1];
+
+    sofab_object_init(&u64_obj_info, &u64_obj_dec);
+    memset(dec, 0, sizeof dec);
+    dec[0].info = &u64_obj_info;
+    dec[0].dst = (uint8_t *)&u64_obj_dec;
+    dec[0].depth = 0;
+    sofab_istream_init(&is, sofab_object_field_cb, dec);
+    sofab_istream_feed(&is, u64_obj_buf, u64_obj_used);
+}
+
+__attribute__((noinline)) void run_decode_typical_object(void)
+{
+    sofab_istream_t is;
+    sofab_object_decoder_t dec[2];
+
+    sofab_object_init(&typ_obj_info, &typ_obj_dec);
+    memset(dec, 0, sizeof dec);
+    dec[0].info = &typ_obj_info;
+    dec[0].dst = (uint8_t *)&typ_obj_dec;
+    dec[0].depth = 1;
+    sofab_istream_init(&is, sofab_object_field_cb, dec);
+    sofab_istream_feed(&is, typ_obj_buf, typ_obj_used);
+}
+
+__attribute__((noinline)) void run_decode_composite_object(void)
+{
+    sofab_istream_t is;
+    sofab_object_decoder_t dec[4];
+
+    sofab_object_init(&comp_obj_info, &comp_obj_dec);
+    memset(dec, 0, sizeof dec);
+    dec[0].info = &comp_obj_info;
+    dec[0].dst = (uint8_t *)&comp_obj_dec;
+    dec[0].depth = 3;
+    sofab_istream_init(&is, sofab_object_field_cb, dec);
+    sofab_istream_feed(&is, comp_obj_buf, comp_obj_used);
+}
+
+/* ---- batch decode ----------------------------------------------------------
+ * BATCH_RECORDS typical objects back to back, each framed (a one-byte length
+ * prefix: the message is well under 128 bytes), decoded into an array. The
+ * per-record row is the loop a caller writes without the batch call: per record
+ * an init, a fresh stream and sofab_object_field_cb, which searches the
+ * descriptor for every field. The batch row is sofab_object_decode_batch(),
+ * which resets one stream and looks the top-level fields up in a table built
+ * once per call. Not a BENCH_SPEC dataset, so a table of its own. */
+#define BATCH_RECORDS 256
+
+static uint8_t     batch_buf[BATCH_RECORDS * (sizeof typ_obj_buf + 1)];
+static size_t      batch_used;
+static typ_obj_t   batch_dec[BATCH_RECORDS];
+static sofab_ret_t batch_status[BATCH_RECORDS];
+
+static void make_batch(void)
+{
+    batch_used = 0;
+    for (size_t i = 0; i < BATCH_RECORDS; i++) {
+        batch_buf[batch_used] = (uint8_t)typ_obj_used;
+        memcpy(batch_buf + batch_used + 1, typ_obj_buf, typ_obj_used);
+        batch_used += 1 + typ_obj_used;
+    }
+}
+
+__attribute__((noinline)) void run_decode_typical_records(void)
+{
+    const uint8_t *p = batch_buf, *end = batch_buf + batch_used;
+    sofab_istream_t is;
+    sofab_object_decoder_t dec[2];
+
+    memset(dec, 0, sizeof dec);
+    dec[0].info = &typ_obj_info;
+    dec[0].depth = 1;
+    for (size_t i = 0; p != end; i++) {
+        size_t prefixlen, msglen;
+
+        if (sofab_framing_next(p, (size_t)(end - p), &prefixlen, &msglen) != SOFAB_RET_OK)
+            break;
+        sofab_object_init(&typ_obj_info, &batch_dec[i]);
+        dec[0].dst = (uint8_t *)&batch_dec[i];
+        sofab_istream_init(&is, sofab_object_field_cb, dec);
+        batch_status[i] = sofab_istream_feed(&is, p + prefixlen, msglen);
+        p += prefixlen + msglen;
+    }
+}
+
+__attribute__((noinline)) void run_decode_typical_batch(void)
+{
+    sofab_object_decoder_t dec[2];
+    size_t count;
+
+    memset(dec, 0, sizeof dec);
+    dec[0].info = &typ_obj_info;
+    dec[0].depth = 1;
+    sofab_object_decode_batch(dec, batch_buf, batch_used, batch_dec, sizeof batch_dec[0],
+                              BATCH_RECORDS, batch_status, &count, NULL);
+}
+
+static int batch_check(void)
+{
+    for (size_t i = 0; i < BATCH_RECORDS; i++)
+        if (batch_status[i] != SOFAB_RET_OK
+            || memcmp(&batch_dec[i], &typ_obj_src, sizeof typ_obj_src) != 0)
+            return -1;
+    return 0;
+}
+
+/* ---- chunk / buffer-size sweep ------------------------------------------- *
+ * The rows above fix the two streaming knobs: messages are fed to the decoder
+ * whole (the blob in BLOB_CHUNK pieces) and encoded one-shot (the blob through
+ * a BLOB_CHUNK buffer). Deployed, both are whatever the transport hands over —
+ * a byte at a time off a UART, an MTU per datagram, 64 KB per socket read —
+ * and the flush buffer is whatever memory the target can spare. The sweep runs
+ * every dataset through each point of SWEEP_SIZES, as feed-chunk size on
+ * decode and as output buffer size (with a flush sink) on encode, plus the
+ * whole-message point (one feed / one-shot buffer, no sink) the rows above
+ * use. Where per-feed or per-flush overhead takes over is where the MB/s
+ * curve bends; sizes at or above the message are the whole-message point and
+ * are skipped. */
+static const size_t SWEEP_SIZES[] = { 1, 16, 64, 256, 1500, 4096, 65536 };
+#define SWEEP_NSIZES (sizeof SWEEP_SIZES / sizeof SWEEP_SIZES[0])
+#define SWEEP_WHOLE  0 /* size value of the whole-message point */
+
+typedef struct
+{
+    const char              *name;
+    void                   (*encode)(sofab_ostream_t *os);
+    sofab_istream_field_cb_t cb;
+    const uint8_t           *buf;   /* one-shot encoding, input to decode */
+    const size_t            *used;
+} sweep_dataset_t;
+
+static void encode_u64_array(sofab_ostream_t *os)
+{
+    sofab_ostream_write_array_of_unsigned(os, 1, src, N, sizeof(uint64_t));
+}
+
+static void encode_blob(sofab_ostream_t *os)
+{
+    sofab_ostream_write_blob(os, 1, blob_src, BLOB_LEN);
+}
+
+static const sweep_dataset_t SWEEP_DATASETS[] = {
+    { "u64_array", encode_u64_array, cb_array,     enc_u64_buf, &enc_u64_used },
+    { "typical",   encode_typical,   cb_typical,   typ_buf,     &typ_used },
+    { "blob",      encode_blob,      cb_blob,      blob_buf,    &blob_used },
+    { "composite", encode_composite, cb_composite, comp_buf,    &comp_used },
+};
+#define SWEEP_NDATASETS (sizeof SWEEP_DATASETS / sizeof SWEEP_DATASETS[0])
+
+static const sweep_dataset_t *sweep_ds;
+static size_t      sweep_size;           /* chunk / buffer bytes, or SWEEP_WHOLE */
+static uint8_t     sweep_out[1 << 20];   /* holds the 1 MB blob one-shot too */
+static size_t      sweep_bytes;          /* bytes encoded by the last operation */
+static size_t      sweep_calls;          /* feeds or flushes of the last operation */
+static sofab_ret_t sweep_ret;            /* verdict of the last feed */
+
+/* Same contract as blob_sink(): consume and discard. */
+static void sweep_sink(sofab_ostream_t *ctx, const uint8_t *data, size_t len, void *usr)
+{
+    (void)ctx;
+    (void)usr;
+    if (len)
+        blob_sink_xor ^= data[0];
+    sweep_bytes += len;
+    sweep_calls++;
+}
+
+__attribute__((noinline)) void run_sweep_encode(void)
+{
+    sofab_ostream_t os;
+
+    sweep_bytes = 0;
+    sweep_calls = 0;
+    if (sweep_size == SWEEP_WHOLE) {
+        sofab_ostream_init(&os, sweep_out, sizeof sweep_out, 0, NULL, NULL);
+        sweep_ds->encode(&os);
+        sweep_bytes = sofab_ostream_bytes_used(&os);
+    } else {
+        sofab_ostream_init(&os, sweep_out, sweep_size, 0, sweep_sink, NULL);
+        sweep_ds->encode(&os);
+        sofab_ostream_flush(&os);
+    }
+}
+
+__attribute__((noinline)) void run_sweep_decode(void)
+{
+    sofab_istream_t is;
+    size_t len = *sweep_ds->used;
+    size_t chunk = sweep_size == SWEEP_WHOLE ? len : sweep_size;
+
+    sweep_calls = 0;
+    sofab_istream_init(&is, sweep_ds->cb, NULL);
+    for (size_t off = 0; off < len; off += chunk) {
+        size_t n = len - off;
+        if (n > chunk)
+            n = chunk;
+        sweep_ret = sofab_istream_feed(&is, sweep_ds->buf + off, n);
+        sweep_calls++;
+    }
+}
+
+static const sweep_dataset_t *sweep_find(const char *name)
+{
+    for (size_t i = 0; i < SWEEP_NDATASETS; i++)
+        if (!strcmp(SWEEP_DATASETS[i].name, name))
+            return &SWEEP_DATASETS[i];
+    return NULL;
+}
+
 /* ---- measurement (process CPU time) -------------------------------------- */
 
 static double cpu_now(void)
@@ -451,7 +866,7 @@ static long calibrate_block(void (*fn)(void))
     }
 }
 
-static double measure(void (*fn)(void), size_t bytes)
+static double measure_for(void (*fn)(void), size_t bytes, double seconds)
 {
     fn(); /* warmup */
     long   block = calibrate_block(fn);
@@ -463,10 +878,15 @@ static double measure(void (*fn)(void), size_t bytes)
             fn();
         it += block;
         el = cpu_now() - t0;
-    } while (el < 1.0);
+    } while (el < seconds);
     return (double)bytes * (double)it / el / 1e6; /* MB/s, MB = 1e6 bytes */
 }
 
+static double measure(void (*fn)(void), size_t bytes)
+{
+    return measure_for(fn, bytes, 1.0);
+}
+
 /* ---- single-shot mode (one operation, for Callgrind instruction counts) -- */
 
 /* FNV-1a over the encoded message. The C and C++ tools must agree on it for
@@ -489,6 +909,7 @@ static int run_one(const char *w)
     make_src();
     make_blob();
     make_composite();
+    make_objects();
 
     if (!strcmp(w, "encode_u64_array")) {
         run_encode_u64_array();
@@ -505,6 +926,15 @@ static int run_one(const char *w)
     } else if (!strcmp(w, "encode_composite")) {
         run_encode_composite();
         bytes = comp_used;
+    } else if (!strcmp(w, "encode_u64_array_object")) {
+        run_encode_u64_array_object();
+        bytes = u64_obj_used;
+    } else if (!strcmp(w, "encode_typical_object")) {
+        run_encode_typical_object();
+        bytes = typ_obj_used;
+    } else if (!strcmp(w, "encode_composite_object")) {
+        run_encode_composite_object();
+        bytes = comp_obj_used;
     } else if (!strcmp(w, "decode_u64_array")) {
         run_encode_u64_array();          /* setup (excluded from collection) */
         run_decode_u64_array();
@@ -525,6 +955,28 @@ static int run_one(const char *w)
         run_encode_composite();          /* setup (excluded from collection) */
         run_decode_composite_skip();
         bytes = comp_used;
+    } else if (!strcmp(w, "decode_u64_array_object")) {
+        run_encode_u64_array_object();   /* setup (excluded from collection) */
+        run_decode_u64_array_object();
+        bytes = u64_obj_used;
+    } else if (!strcmp(w, "decode_typical_object")) {
+        run_encode_typical_object();     /* setup (excluded from collection) */
+        run_decode_typical_object();
+        bytes = typ_obj_used;
+    } else if (!strcmp(w, "decode_composite_object")) {
+        run_encode_composite_object();   /* setup (excluded from collection) */
+        run_decode_composite_object();
+        bytes = comp_obj_used;
+    } else if (!strcmp(w, "decode_typical_records")) {
+        run_encode_typical_object();     /* setup (excluded from collection) */
+        make_batch();
+        run_decode_typical_records();
+        bytes = batch_used;
+    } else if (!strcmp(w, "decode_typical_batch")) {
+        run_encode_typical_object();     /* setup (excluded from collection) */
+        make_batch();
+        run_decode_typical_batch();
+        bytes = batch_used;
     } else {
         fprintf(stderr, "unknown workload: %s\n", w);
         return 1;
@@ -534,26 +986,165 @@ static int run_one(const char *w)
      * count (the harness's `bytes` column) */
     fprintf(stderr,
             "arr0=%llu f1=%u s_f2=%d str=%s blob0=%u xor=%u item63=%s deep=%u "
-            "csum=%08x BYTES=%zu\n",
+            "csum=%08x obj: arr1=%llu f1=%u item63=%s csum=%08x BYTES=%zu\n",
             (unsigned long long)dec_array[0], T.f1, T.s_f2, T.f5,
             blob_dec[0], blob_sink_xor, C.items[COMP_ITEMS - 1], C.deep,
-            fnv1a(comp_buf, comp_used), bytes);
+            fnv1a(comp_buf, comp_used),
+            (unsigned long long)u64_obj_dec.a[1], typ_obj_dec.f1,
+            comp_obj_dec.items.s[COMP_ITEMS - 1],
+            fnv1a(comp_obj_buf, comp_obj_used), bytes);
+    return 0;
+}
+
+/* ---- sweep mode ---------------------------------------------------------- */
+
+/* Shorter than the ~1 s BENCH_SPEC loop: the sweep has ~60 points. */
+#define SWEEP_SECONDS 0.25
+
+static void sweep_size_str(char *out, size_t len, size_t size)
+{
+    if (size == SWEEP_WHOLE)
+        snprintf(out, len, "whole");
+    else
+        snprintf(out, len, "%zu", size);
+}
+
+/* Every point of the sweep, in table order; `fn` returns non-zero to stop. */
+static int sweep_each(int (*fn)(const sweep_dataset_t *ds, bool encode, size_t size))
+{
+    for (size_t d = 0; d < SWEEP_NDATASETS; d++) {
+        const sweep_dataset_t *ds = &SWEEP_DATASETS[d];
+        for (int encode = 1; encode >= 0; encode--) {
+            for (size_t i = 0; i <= SWEEP_NSIZES; i++) {
+                size_t size = i < SWEEP_NSIZES ? SWEEP_SIZES[i] : SWEEP_WHOLE;
+                if (size != SWEEP_WHOLE && size >= *ds->used)
+                    continue;
+                int rc = fn(ds, encode, size);
+                if (rc)
+                    return rc;
+            }
+        }
+    }
+    return 0;
+}
+
+static int sweep_list_point(const sweep_dataset_t *ds, bool encode, size_t size)
+{
+    char sz[24];
+    sweep_size_str(sz, sizeof sz, size);
+    printf("%s %s %s\n", ds->name, encode ? "encode" : "decode", sz);
+    return 0;
+}
+
+/* Run one point once, checked: a streamed encode must hand the sink exactly
+ * the one-shot bytes, and a chunked decode must end on a field boundary. */
+static int sweep_prepare(const sweep_dataset_t *ds, bool encode, size_t size)
+{
+    sweep_ds = ds;
+    sweep_size = size;
+    if (encode) {
+        run_sweep_encode();
+        if (sweep_bytes != *ds->used) {
+            fprintf(stderr, "bench: sweep %s encode at %zu wrote %zu bytes, expected %zu\n",
+                    ds->name, size, sweep_bytes, *ds->used);
+            return 1;
+        }
+    } else {
+        run_sweep_decode();
+        if (sweep_ret != SOFAB_RET_OK) {
+            fprintf(stderr, "bench: sweep %s decode at %zu did not complete (%d)\n",
+                    ds->name, size, (int)sweep_ret);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int sweep_time_point(const sweep_dataset_t *ds, bool encode, size_t size)
+{
+    char sz[24];
+
+    if (sweep_prepare(ds, encode, size))
+        return 1;
+
+    size_t calls = sweep_calls;
+    double mb_s = measure_for(encode ? run_sweep_encode : run_sweep_decode,
+                              *ds->used, SWEEP_SECONDS);
+    sweep_size_str(sz, sizeof sz, size);
+    printf("%s\t%s\t%s\t%zu\t%zu\t%.1f\t%.2f\n", ds->name, encode ? "encode" : "decode",
+           sz, *ds->used, calls, (double)*ds->used / mb_s * 1e3, mb_s);
+    fflush(stdout);
+    return 0;
+}
+
+static void make_all(void)
+{
+    make_src();
+    make_blob();
+    make_composite();
+    run_encode_u64_array();
+    run_encode_typical();
+    run_encode_blob_oneshot();
+    run_encode_composite();
+}
+
+/* bench_c --sweep [list | <dataset> <encode|decode> <size|whole>] */
+static int sweep_main(int argc, char **argv)
+{
+    make_all();
+
+    if (argc == 0) {
+        printf("dataset\top\tsize\tbytes\tcalls\tns/op\tMB/s\n");
+        return sweep_each(sweep_time_point);
+    }
+    if (argc == 1 && !strcmp(argv[0], "list"))
+        return sweep_each(sweep_list_point);
+
+    const sweep_dataset_t *ds = argc == 3 ? sweep_find(argv[0]) : NULL;
+    if (!ds || (strcmp(argv[1], "encode") && strcmp(argv[1], "decode"))) {
+        fprintf(stderr, "usage: bench_c --sweep [list | <dataset> <encode|decode> <size|whole>]\n");
+        return 1;
+    }
+
+    bool encode = !strcmp(argv[1], "encode");
+    size_t size = !strcmp(argv[2], "whole") ? SWEEP_WHOLE : (size_t)strtoul(argv[2], NULL, 10);
+    if (size == SWEEP_WHOLE && strcmp(argv[2], "whole")) {
+        fprintf(stderr, "bench: sweep size must be > 0 or \"whole\"\n");
+        return 1;
+    }
+
+    /* The setup above runs outside run_sweep_*, so under Callgrind
+     * (--toggle-collect=run_sweep_encode / run_sweep_decode) this is the one
+     * collected operation. */
+    sweep_ds = ds;
+    sweep_size = size;
+    if (encode)
+        run_sweep_encode();
+    else
+        run_sweep_decode();
+    fprintf(stderr, "CALLS=%zu BYTES=%zu\n", sweep_calls, *ds->used);
     return 0;
 }
 
 int main(int argc, char **argv)
 {
+    if (argc >= 2 && !strcmp(argv[1], "--sweep"))
+        return sweep_main(argc - 2, argv + 2);
     if (argc >= 2)
         return run_one(argv[1]);
 
     make_src();
     make_blob();
     make_composite();
+    make_objects();
     run_encode_u64_array();
     run_encode_typical();
     run_encode_blob_oneshot();
     run_encode_blob_streaming();
     run_encode_composite();
+    run_encode_u64_array_object();
+    run_encode_typical_object();
+    run_encode_composite_object();
     size_t ba = enc_u64_used, bt = typ_used, bb = blob_used, bc = comp_used;
 
     /* Parity checks: a port whose encoding diverges prints a different size
@@ -580,6 +1171,32 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    /* The object rows are only comparable to the stream rows if they move the
+     * same bytes and the same values. */
+    run_decode_u64_array_object();
+    run_decode_typical_object();
+    run_decode_composite_object();
+    if (u64_obj_used != ba || memcmp(u64_obj_buf, enc_u64_buf, ba) != 0
+        || typ_obj_used != bt || memcmp(typ_obj_buf, typ_buf, bt) != 0
+        || comp_obj_used != bc || memcmp(comp_obj_buf, comp_buf, bc) != 0
+        || memcmp(&u64_obj_dec, &u64_obj_src, sizeof u64_obj_src) != 0
+        || memcmp(&typ_obj_dec, &typ_obj_src, sizeof typ_obj_src) != 0
+        || memcmp(&comp_obj_dec, &comp_obj_src, sizeof comp_obj_src) != 0) {
+        fprintf(stderr, "bench: object API self-check failed\n");
+        return 1;
+    }
+
+    make_batch();
+    memset(batch_dec, 0, sizeof batch_dec);
+    run_decode_typical_records();
+    int records_ok = batch_check();
+    memset(batch_dec, 0, sizeof batch_dec);
+    run_decode_typical_batch();
+    if (records_ok != 0 || batch_check() != 0) {
+        fprintf(stderr, "bench: batch decode self-check failed\n");
+        return 1;
+    }
+
     printf("=== SofaBuffers C throughput (CPU time, MB/s) ===\n");
     printf("%-26s %12s\n", "Workload", "MB/s");
     printf("%-26s %12s\n", "--------", "----");
@@ -593,6 +1210,16 @@ int main(int argc, char **argv)
     printf("%-26s %12.2f\n", "decode: blob 1MB",           measure(run_decode_blob, bb));
     printf("%-26s %12.2f\n", "decode: composite",          measure(run_decode_composite, bc));
     printf("%-26s %12.2f\n", "decode: composite skip-all", measure(run_decode_composite_skip, bc));
+    printf("%-26s %12.2f\n", "encode: u64 array (object)", measure(run_encode_u64_array_object, ba));
+    printf("%-26s %12.2f\n", "encode: typical (object)",   measure(run_encode_typical_object, bt));
+    printf("%-26s %12.2f\n", "encode: composite (object)", measure(run_encode_composite_object, bc));
+    printf("%-26s %12.2f\n", "decode: u64 array (object)", measure(run_decode_u64_array_object, ba));
+    printf("%-26s %12.2f\n", "decode: typical (object)",   measure(run_decode_typical_object, bt));
+    printf("%-26s %12.2f\n", "decode: composite (object)", measure(run_decode_composite_object, bc));
+
+    printf("\n=== SofaBuffers C batch decode (%d typical objects, MB/s) ===\n", BATCH_RECORDS);
+    printf("%-26s %12.2f\n", "decode: record by record",  measure(run_decode_typical_records, batch_used));
+    printf("%-26s %12.2f\n", "decode: one batch call",    measure(run_decode_typical_batch, batch_used));
     printf("\nMB = 1e6 bytes. ~1s CPU-time loop per workload.\n");
     return 0;
 }
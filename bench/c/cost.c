@@ -0,0 +1,290 @@
+/*!
+ * @file cost.c
+ * @brief SofaBuffers C — worst-case decode cost per input byte.
+ *
+ * Replays the algorithmic-complexity corpus (test/fuzz/corpus/cost, found by
+ * sofabfuzz_cost) through the same decode target the fuzzer searched,
+ * test/fuzz/cost_target.h, and reports what each input costs per byte. The
+ * target's seeds run first, so the table also shows the baseline:
+ * seed-typical is an ordinary message, and the worst row divided by it is the
+ * amplification an adversary gets out of this decoder. A decoder change that
+ * makes a corpus input more expensive is a change that makes a DoS cheaper.
+ *
+ * Modes:
+ *   bench_cost [--counters] [PATH...]  -> timed table (CPU time) of the seeds
+ *                                         and every input under PATH (a file,
+ *                                         or a directory of *.bin); default
+ *                                         PATH is the in-tree corpus.
+ *                                         --counters adds instructions/byte
+ *                                         where perf_event_open is allowed.
+ *   bench_cost --list [PATH...]        -> print the input names, one per line.
+ *   bench_cost --once NAME [PATH...]   -> decode input NAME once and exit; used
+ *                                         by `run_callgrind.sh cost` to count
+ *                                         Ir/byte (--toggle-collect=run_cost).
+ *
+ * Tab-separated output with a header line.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cost_target.h"
+#include "perf_events.h"
+
+#define COST_MAX_INPUTS 256
+
+typedef struct
+{
+    char    *name;
+    uint8_t *buf;
+    size_t   len;
+} cost_input_t;
+
+static cost_input_t inputs[COST_MAX_INPUTS];
+static size_t       ninputs;
+
+static void add_input(const char *name, const uint8_t *buf, size_t len)
+{
+    if (ninputs == COST_MAX_INPUTS) {
+        fprintf(stderr, "bench_cost: more than %d inputs, ignoring %s\n", COST_MAX_INPUTS, name);
+        return;
+    }
+    cost_input_t *in = &inputs[ninputs++];
+    in->name = strdup(name);
+    in->buf = malloc(len ? len : 1);
+    in->len = len;
+    if (!in->name || !in->buf) {
+        fprintf(stderr, "bench_cost: out of memory\n");
+        exit(1);
+    }
+    memcpy(in->buf, buf, len);
+}
+
+static bool load_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+
+    uint8_t *buf = NULL;
+    size_t len = 0, cap = 0;
+    for (;;) {
+        if (len == cap) {
+            cap = cap ? cap * 2 : 4096;
+            buf = realloc(buf, cap);
+            if (!buf) {
+                fprintf(stderr, "bench_cost: out of memory\n");
+                exit(1);
+            }
+        }
+        size_t n = fread(buf + len, 1, cap - len, f);
+        if (n == 0)
+            break;
+        len += n;
+    }
+    fclose(f);
+    add_input(path, buf, len);
+    free(buf);
+    return true;
+}
+
+static int by_name(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* A directory contributes its *.bin files, in name order. */
+static bool load_path(const char *path)
+{
+    DIR *d = opendir(path);
+    if (!d)
+        return load_file(path);
+
+    char *names[COST_MAX_INPUTS];
+    size_t n = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL && n < COST_MAX_INPUTS) {
+        size_t l = strlen(e->d_name);
+        if (l < 4 || strcmp(e->d_name + l - 4, ".bin") != 0)
+            continue;
+        names[n] = malloc(strlen(path) + l + 2);
+        if (!names[n]) {
+            fprintf(stderr, "bench_cost: out of memory\n");
+            exit(1);
+        }
+        sprintf(names[n], "%s/%s", path, e->d_name);
+        n++;
+    }
+    closedir(d);
+
+    qsort(names, n, sizeof names[0], by_name);
+    for (size_t i = 0; i < n; i++) {
+        load_file(names[i]);
+        free(names[i]);
+    }
+    return true;
+}
+
+__attribute__((noinline)) void run_cost(const cost_input_t *in)
+{
+    cost_target_decode(in->buf, in->len);
+}
+
+/* ---- measurement (process CPU time) -------------------------------------- */
+
+static double cpu_now(void)
+{
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+}
+
+/* Same block-sampling scheme as micro.c. */
+#define COST_BLOCK_SECONDS 0.01
+#define COST_SECONDS       0.25
+
+static perf_events_t perf_ev;
+static bool          perf_ev_on;
+static long          perf_ev_iters; /* decodes in the last counted window */
+
+static double measure(const cost_input_t *in, double *instr_msg)
+{
+    run_cost(in); /* warmup */
+
+    long block = 1;
+    for (;; block *= 2) {
+        double t0 = cpu_now();
+        for (long k = 0; k < block; k++)
+            run_cost(in);
+        if (cpu_now() - t0 >= COST_BLOCK_SECONDS)
+            break;
+    }
+
+    if (perf_ev_on)
+        perf_events_start(&perf_ev);
+    double t0 = cpu_now();
+    long   it = 0;
+    double el;
+    do {
+        for (long k = 0; k < block; k++)
+            run_cost(in);
+        it += block;
+        el = cpu_now() - t0;
+    } while (el < COST_SECONDS);
+    if (perf_ev_on) {
+        perf_events_stop(&perf_ev);
+        perf_ev_iters = it;
+        *instr_msg = perf_ev.fd[PERF_EV_INSTRUCTIONS] >= 0
+            ? (double)perf_ev.value[PERF_EV_INSTRUCTIONS] / (double)it
+            : -1;
+    }
+
+    return el / (double)it * 1e9; /* ns per message */
+}
+
+static const cost_input_t *find_input(const char *name)
+{
+    for (size_t i = 0; i < ninputs; i++)
+        if (!strcmp(inputs[i].name, name))
+            return &inputs[i];
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    const char *once = NULL;
+    bool list = false, counters = false, any_path = false;
+
+    static uint8_t seed[4096];
+    for (unsigned i = 0; i < COST_SEED_COUNT; i++)
+        add_input(cost_seed_names[i], seed, cost_target_seed(i, seed, sizeof seed));
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--list")) {
+            list = true;
+        } else if (!strcmp(argv[i], "--counters")) {
+            counters = true;
+        } else if (!strcmp(argv[i], "--once") && i + 1 < argc) {
+            once = argv[++i];
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s [--counters | --list | --once NAME] [PATH...]\n", argv[0]);
+            return 2;
+        } else {
+            any_path = true;
+            if (!load_path(argv[i])) {
+                fprintf(stderr, "bench_cost: cannot read %s\n", argv[i]);
+                return 1;
+            }
+        }
+    }
+#ifdef SOFAB_COST_CORPUS
+    if (!any_path && !load_path(SOFAB_COST_CORPUS))
+        fprintf(stderr, "bench_cost: no corpus at %s, seeds only\n", SOFAB_COST_CORPUS);
+#else
+    (void)any_path;
+#endif
+
+    if (list) {
+        for (size_t i = 0; i < ninputs; i++)
+            printf("%s\n", inputs[i].name);
+        return 0;
+    }
+
+    if (once) {
+        const cost_input_t *in = find_input(once);
+        if (!in) {
+            fprintf(stderr, "bench_cost: unknown input %s\n", once);
+            return 1;
+        }
+        run_cost(in);
+        fprintf(stderr, "BYTES=%zu\n", in->len);
+        return 0;
+    }
+
+    if (counters)
+        perf_ev_on = perf_events_open(&perf_ev);
+
+    printf("input\tbytes\tns/msg\tns/byte\tinstr/byte\n");
+    size_t worst = 0;
+    double worst_nsb = 0, base_nsb = 0;
+    for (size_t i = 0; i < ninputs; i++) {
+        const cost_input_t *in = &inputs[i];
+        double instr = -1;
+        double ns = measure(in, &instr);
+        double nsb = in->len ? ns / (double)in->len : 0;
+
+        printf("%s\t%zu\t%.1f\t%.2f\t", in->name, in->len, ns, nsb);
+        if (instr >= 0 && in->len)
+            printf("%.1f\n", instr / (double)in->len);
+        else
+            printf("-\n");
+
+        if (i == 0)
+            base_nsb = nsb;
+        if (nsb > worst_nsb) {
+            worst_nsb = nsb;
+            worst = i;
+        }
+    }
+    printf("worst\t%s\t%.2f ns/byte", inputs[worst].name, worst_nsb);
+    if (base_nsb > 0)
+        printf("\t%.1fx %s", worst_nsb / base_nsb, inputs[0].name);
+    printf("\n");
+
+    if (perf_ev_on) {
+        /* the full counter set for the worst input, below the table */
+        double instr = -1;
+        measure(&inputs[worst], &instr);
+        printf("counters per decode of %s:\n", inputs[worst].name);
+        perf_events_report(&perf_ev, (unsigned long)perf_ev_iters);
+        perf_events_close(&perf_ev);
+    }
+    return 0;
+}
@@ -0,0 +1,513 @@
+/*!
+ * @file micro.c
+ * @brief SofaBuffers C — per-primitive microbenchmark matrix.
+ *
+ * The bench/perf datasets are whole messages, so a change to one primitive —
+ * the varint decoder, the scalar store, one array element path — shows up
+ * there only as a blended number. Here every row isolates a single primitive:
+ *
+ *   varint    encoded value length 1..10 bytes x unsigned/signed; the decode
+ *             rows additionally x target width 1/2/4/8 (only the lengths the
+ *             width can hold: 2, 3, 5 and 10 bytes at most)
+ *   fixlen    each subtype: fp32, fp64, string, blob (16 bytes)
+ *   array     each array type: u8..u64, i8..i64, fp32, fp64
+ *
+ * A row is one operation over a batch of items of that primitive — 64 fields
+ * at the same id (so the field header is one byte and constant), or one array
+ * field of 64 elements — and its cost is reported per item. The encoded bytes
+ * of every row are checked before anything is measured (a varint row must
+ * encode to exactly 1 + length bytes per field) and every decode row must give
+ * back the value it was built from.
+ *
+ * Three modes:
+ *   bench_micro                   -> timed table of every row (CPU time).
+ *   bench_micro --timed <prefix>  -> timed table of the rows whose name starts
+ *                                    with <prefix> (e.g. dec_varint_u).
+ *   bench_micro --list            -> print the row names, one per line.
+ *   bench_micro <workload>        -> run one operation once and exit; used by
+ *                                    `run_callgrind.sh micro` to count Ir/op
+ *                                    (--toggle-collect=run_micro).
+ *
+ * The table is tab-separated with a header line, so it can be diffed or fed
+ * straight to a script. MB = 1e6 bytes of encoded message.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "sofab/istream.h"
+#include "sofab/ostream.h"
+
+#define MICRO_FIELDS 64  /* scalar fields per operation */
+#define MICRO_ELEMS  64  /* array elements per operation */
+#define MICRO_FIXLEN 16  /* string / blob payload bytes */
+#define MICRO_ID     1   /* every field at one id: a one-byte header throughout */
+
+#define MICRO_CASES_MAX 128
+
+enum { MICRO_ENCODE, MICRO_DECODE };
+enum { MICRO_VARINT, MICRO_FIXLEN_FIELD, MICRO_ARRAY };
+#define MICRO_INTEGER 0xFF /* micro_case_t.fix for a varint array */
+
+typedef struct
+{
+    char     name[32];
+    uint8_t  op;     /* MICRO_ENCODE / MICRO_DECODE */
+    uint8_t  kind;   /* MICRO_VARINT / MICRO_FIXLEN_FIELD / MICRO_ARRAY */
+    uint8_t  sign;   /* varint and integer array: 1 = signed */
+    uint8_t  len;    /* varint: encoded value length in bytes */
+    uint8_t  width;  /* varint decode target / array element width in bytes */
+    uint8_t  fix;    /* fixlen / array: sofab_fixlentype_t, or MICRO_INTEGER */
+    size_t   items;  /* fields (scalar rows) or elements (array rows) per op */
+    sofab_istream_field_cb_t cb;
+} micro_case_t;
+
+static micro_case_t cases[MICRO_CASES_MAX];
+static size_t       ncases;
+
+/* inputs of the current row */
+static sofab_unsigned_t in_u;
+static sofab_signed_t   in_s;
+static uint8_t          in_array[MICRO_ELEMS * 8];
+static const char       in_text[MICRO_FIXLEN + 1] = "micro-benchmark!";
+
+static uint8_t  enc_buf[MICRO_FIELDS * 32];
+static size_t   enc_used;
+
+/* decode targets */
+static union
+{
+    uint8_t  u8;
+    uint16_t u16;
+    uint32_t u32;
+    uint64_t u64;
+    int8_t   i8;
+    int16_t  i16;
+    int32_t  i32;
+    int64_t  i64;
+    float    f32;
+    double   f64;
+} dec_scalar;
+static uint8_t dec_array[MICRO_ELEMS * 8];
+static char    dec_text[MICRO_FIXLEN + 1];
+
+/* ---- decode callbacks (one per target type, so none branches on the row) - */
+
+#define MICRO_CB_SCALAR(name, member) \
+    static void cb_##name(sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usr) \
+    { \
+        (void)id; \
+        (void)size; \
+        (void)count; \
+        (void)usr; \
+        sofab_istream_read_##name(ctx, &dec_scalar.member); \
+    }
+
+#define MICRO_CB_ARRAY(name, type) \
+    static void cb_array_##name(sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usr) \
+    { \
+        (void)id; \
+        (void)size; \
+        (void)usr; \
+        sofab_istream_read_array_of_##name(ctx, (type *)dec_array, count); \
+    }
+
+MICRO_CB_SCALAR(u8, u8)
+MICRO_CB_SCALAR(u16, u16)
+MICRO_CB_SCALAR(u32, u32)
+MICRO_CB_SCALAR(u64, u64)
+MICRO_CB_SCALAR(i8, i8)
+MICRO_CB_SCALAR(i16, i16)
+MICRO_CB_SCALAR(i32, i32)
+MICRO_CB_SCALAR(i64, i64)
+MICRO_CB_SCALAR(fp32, f32)
+MICRO_CB_SCALAR(fp64, f64)
+
+MICRO_CB_ARRAY(u8, uint8_t)
+MICRO_CB_ARRAY(u16, uint16_t)
+MICRO_CB_ARRAY(u32, uint32_t)
+MICRO_CB_ARRAY(u64, uint64_t)
+MICRO_CB_ARRAY(i8, int8_t)
+MICRO_CB_ARRAY(i16, int16_t)
+MICRO_CB_ARRAY(i32, int32_t)
+MICRO_CB_ARRAY(i64, int64_t)
+MICRO_CB_ARRAY(fp32, float)
+MICRO_CB_ARRAY(fp64, double)
+
+static void cb_string(sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usr)
+{
+    (void)id;
+    (void)size;
+    (void)count;
+    (void)usr;
+    sofab_istream_read_string(ctx, dec_text, sizeof dec_text);
+}
+
+static void cb_blob(sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usr)
+{
+    (void)id;
+    (void)count;
+    (void)usr;
+    sofab_istream_read_blob(ctx, dec_text, size);
+}
+
+static const sofab_istream_field_cb_t cb_varint[2][4] = {
+    { cb_u8, cb_u16, cb_u32, cb_u64 },
+    { cb_i8, cb_i16, cb_i32, cb_i64 },
+};
+static const sofab_istream_field_cb_t cb_array_int[2][4] = {
+    { cb_array_u8, cb_array_u16, cb_array_u32, cb_array_u64 },
+    { cb_array_i8, cb_array_i16, cb_array_i32, cb_array_i64 },
+};
+
+/* ---- the matrix ---------------------------------------------------------- */
+
+/* Longest varint a value of this many bytes can need: ceil(8 * width / 7). */
+static unsigned varint_len_max(unsigned width)
+{
+    return (8 * width + 6) / 7;
+}
+
+static micro_case_t *add_case(uint8_t op, uint8_t kind)
+{
+    micro_case_t *c = &cases[ncases++];
+    memset(c, 0, sizeof *c);
+    c->op = op;
+    c->kind = kind;
+    return c;
+}
+
+static const char *fix_name(uint8_t fix)
+{
+    switch (fix)
+    {
+        case SOFAB_FIXLENTYPE_FP32:   return "fp32";
+        case SOFAB_FIXLENTYPE_FP64:   return "fp64";
+        case SOFAB_FIXLENTYPE_STRING: return "string";
+        default:                      return "blob";
+    }
+}
+
+static void build_cases(void)
+{
+    static const uint8_t widths[4] = {1, 2, 4, 8};
+    static const uint8_t fixes[4] = {
+        SOFAB_FIXLENTYPE_FP32, SOFAB_FIXLENTYPE_FP64,
+        SOFAB_FIXLENTYPE_STRING, SOFAB_FIXLENTYPE_BLOB,
+    };
+
+    for (uint8_t op = MICRO_ENCODE; op <= MICRO_DECODE; op++) {
+        const char *tag = op == MICRO_ENCODE ? "enc" : "dec";
+
+        /* The encoder takes every integer as a full-width value, so its rows
+         * vary by length only; the decoder stores to a target of a given
+         * width, so its rows vary by both. */
+        for (uint8_t sign = 0; sign <= 1; sign++) {
+            for (uint8_t len = 1; len <= 10; len++) {
+                if (op == MICRO_ENCODE) {
+                    micro_case_t *c = add_case(op, MICRO_VARINT);
+                    c->sign = sign;
+                    c->len = len;
+                    c->width = 8;
+                    c->items = MICRO_FIELDS;
+                    snprintf(c->name, sizeof c->name, "%s_varint_%c_len%u",
+                             tag, sign ? 's' : 'u', len);
+                    continue;
+                }
+                for (unsigned w = 0; w < 4; w++) {
+                    if (len > varint_len_max(widths[w]))
+                        continue;
+                    micro_case_t *c = add_case(op, MICRO_VARINT);
+                    c->sign = sign;
+                    c->len = len;
+                    c->width = widths[w];
+                    c->items = MICRO_FIELDS;
+                    c->cb = cb_varint[sign][w];
+                    snprintf(c->name, sizeof c->name, "%s_varint_%c_len%u_w%u",
+                             tag, sign ? 's' : 'u', len, widths[w]);
+                }
+            }
+        }
+
+        for (unsigned f = 0; f < 4; f++) {
+            micro_case_t *c = add_case(op, MICRO_FIXLEN_FIELD);
+            c->fix = fixes[f];
+            c->items = MICRO_FIELDS;
+            c->cb = fixes[f] == SOFAB_FIXLENTYPE_FP32   ? cb_fp32
+                  : fixes[f] == SOFAB_FIXLENTYPE_FP64   ? cb_fp64
+                  : fixes[f] == SOFAB_FIXLENTYPE_STRING ? cb_string
+                  : cb_blob;
+            snprintf(c->name, sizeof c->name, "%s_fixlen_%s", tag, fix_name(fixes[f]));
+        }
+
+        for (uint8_t sign = 0; sign <= 1; sign++) {
+            for (unsigned w = 0; w < 4; w++) {
+                micro_case_t *c = add_case(op, MICRO_ARRAY);
+                c->sign = sign;
+                c->width = widths[w];
+                c->fix = MICRO_INTEGER;
+                c->items = MICRO_ELEMS;
+                c->cb = cb_array_int[sign][w];
+                snprintf(c->name, sizeof c->name, "%s_array_%c%u",
+                         tag, sign ? 'i' : 'u', 8u * widths[w]);
+            }
+        }
+        for (unsigned f = 0; f < 2; f++) {
+            micro_case_t *c = add_case(op, MICRO_ARRAY);
+            c->fix = fixes[f];
+            c->width = fixes[f] == SOFAB_FIXLENTYPE_FP32 ? 4 : 8;
+            c->items = MICRO_ELEMS;
+            c->cb = fixes[f] == SOFAB_FIXLENTYPE_FP32 ? cb_array_fp32 : cb_array_fp64;
+            snprintf(c->name, sizeof c->name, "%s_array_%s", tag, fix_name(fixes[f]));
+        }
+    }
+}
+
+/* Inputs for a row. A varint row's value is the largest one of exactly `len`
+ * bytes (for a signed row: the most negative, after ZigZag), clamped to the
+ * target width at the width's own maximum length. Array elements reuse the
+ * suite's multiplicative constant, truncated to the element width. */
+static void prepare_inputs(const micro_case_t *c)
+{
+    if (c->kind == MICRO_VARINT) {
+        unsigned bits = 7u * c->len;
+        unsigned wbits = 8u * c->width;
+        if (bits >= wbits) {
+            in_u = wbits >= 64 ? UINT64_MAX : (((uint64_t)1 << wbits) - 1);
+            in_s = wbits >= 64 ? INT64_MIN : -((int64_t)1 << (wbits - 1));
+        } else {
+            in_u = ((uint64_t)1 << bits) - 1;
+            in_s = -((int64_t)1 << (bits - 1));
+        }
+    } else if (c->kind == MICRO_ARRAY) {
+        for (size_t i = 0; i < MICRO_ELEMS; i++) {
+            uint64_t v = (uint64_t)i * 0x9E3779B97F4A7C15ULL;
+            switch (c->fix)
+            {
+                case SOFAB_FIXLENTYPE_FP32: {
+                    float f = (float)i * 1.25f;
+                    memcpy(in_array + i * 4, &f, 4);
+                    break;
+                }
+                case SOFAB_FIXLENTYPE_FP64: {
+                    double d = (double)i * 1.25;
+                    memcpy(in_array + i * 8, &d, 8);
+                    break;
+                }
+                default:
+                    memcpy(in_array + i * c->width, &v, c->width); /* little-endian host */
+                    break;
+            }
+        }
+    }
+}
+
+/* ---- workloads ----------------------------------------------------------- */
+
+static void micro_encode(const micro_case_t *c)
+{
+    sofab_ostream_t os;
+    sofab_ostream_init(&os, enc_buf, sizeof enc_buf, 0, NULL, NULL);
+
+    switch (c->kind)
+    {
+        case MICRO_VARINT:
+            if (c->sign)
+                for (int i = 0; i < MICRO_FIELDS; i++)
+                    sofab_ostream_write_signed(&os, MICRO_ID, in_s);
+            else
+                for (int i = 0; i < MICRO_FIELDS; i++)
+                    sofab_ostream_write_unsigned(&os, MICRO_ID, in_u);
+            break;
+
+        case MICRO_FIXLEN_FIELD:
+            switch (c->fix)
+            {
+                case SOFAB_FIXLENTYPE_FP32:
+                    for (int i = 0; i < MICRO_FIELDS; i++)
+                        sofab_ostream_write_fp32(&os, MICRO_ID, 3.14159f);
+                    break;
+                case SOFAB_FIXLENTYPE_FP64:
+                    for (int i = 0; i < MICRO_FIELDS; i++)
+                        sofab_ostream_write_fp64(&os, MICRO_ID, 2.718281828459045);
+                    break;
+                case SOFAB_FIXLENTYPE_STRING:
+                    for (int i = 0; i < MICRO_FIELDS; i++)
+                        sofab_ostream_write_string(&os, MICRO_ID, in_text);
+                    break;
+                default:
+                    for (int i = 0; i < MICRO_FIELDS; i++)
+                        sofab_ostream_write_blob(&os, MICRO_ID, in_text, MICRO_FIXLEN);
+                    break;
+            }
+            break;
+
+        default:
+            if (c->fix == SOFAB_FIXLENTYPE_FP32)
+                sofab_ostream_write_array_of_fp32(&os, MICRO_ID, (const float *)in_array, MICRO_ELEMS);
+            else if (c->fix == SOFAB_FIXLENTYPE_FP64)
+                sofab_ostream_write_array_of_fp64(&os, MICRO_ID, (const double *)in_array, MICRO_ELEMS);
+            else if (c->sign)
+                sofab_ostream_write_array_of_signed(&os, MICRO_ID, in_array, MICRO_ELEMS, c->width);
+            else
+                sofab_ostream_write_array_of_unsigned(&os, MICRO_ID, in_array, MICRO_ELEMS, c->width);
+            break;
+    }
+
+    enc_used = sofab_ostream_bytes_used(&os);
+}
+
+static void micro_decode(const micro_case_t *c)
+{
+    sofab_istream_t is;
+    sofab_istream_init(&is, c->cb, NULL);
+    sofab_istream_feed(&is, enc_buf, enc_used);
+}
+
+/* The one Callgrind toggle point for every row (the row is the argument). */
+__attribute__((noinline)) void run_micro(const micro_case_t *c)
+{
+    if (c->op == MICRO_ENCODE)
+        micro_encode(c);
+    else
+        micro_decode(c);
+}
+
+/* Encode the row's input (for a decode row: the bytes it will decode) and
+ * check it is what the row claims to measure. */
+static bool prepare(const micro_case_t *c)
+{
+    prepare_inputs(c);
+    micro_encode(c);
+
+    if (c->kind == MICRO_VARINT && enc_used != MICRO_FIELDS * (1u + c->len)) {
+        fprintf(stderr, "bench_micro: %s encodes to %zu bytes, expected %u\n",
+                c->name, enc_used, MICRO_FIELDS * (1u + c->len));
+        return false;
+    }
+    if (c->op == MICRO_ENCODE)
+        return true;
+
+    memset(&dec_scalar, 0, sizeof dec_scalar);
+    memset(dec_array, 0, sizeof dec_array);
+    memset(dec_text, 0, sizeof dec_text);
+    micro_decode(c);
+
+    bool ok;
+    switch (c->kind)
+    {
+        case MICRO_VARINT:
+            ok = c->sign ? memcmp(&dec_scalar, &in_s, c->width) == 0  /* little-endian host */
+                         : memcmp(&dec_scalar, &in_u, c->width) == 0;
+            break;
+        case MICRO_FIXLEN_FIELD:
+            ok = c->fix == SOFAB_FIXLENTYPE_FP32 ? dec_scalar.f32 == 3.14159f
+               : c->fix == SOFAB_FIXLENTYPE_FP64 ? dec_scalar.f64 == 2.718281828459045
+               : memcmp(dec_text, in_text, MICRO_FIXLEN) == 0;
+            break;
+        default:
+            ok = memcmp(dec_array, in_array, MICRO_ELEMS * (size_t)c->width) == 0;
+            break;
+    }
+    if (!ok)
+        fprintf(stderr, "bench_micro: %s does not decode to its input\n", c->name);
+    return ok;
+}
+
+/* ---- measurement (process CPU time) -------------------------------------- */
+
+static double cpu_now(void)
+{
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+}
+
+/* Same block-sampling scheme as bench.c (see BENCH_BLOCK_SECONDS there), with
+ * a shorter loop: a row is one primitive, its cost is steady within a fraction
+ * of a second, and the matrix has over a hundred of them. */
+#define MICRO_BLOCK_SECONDS 0.01
+#define MICRO_SECONDS       0.25
+
+static double measure(const micro_case_t *c, double *ns_item)
+{
+    run_micro(c); /* warmup */
+
+    long block = 1;
+    for (;; block *= 2) {
+        double t0 = cpu_now();
+        for (long k = 0; k < block; k++)
+            run_micro(c);
+        if (cpu_now() - t0 >= MICRO_BLOCK_SECONDS)
+            break;
+    }
+
+    double t0 = cpu_now();
+    long   it = 0;
+    double el;
+    do {
+        for (long k = 0; k < block; k++)
+            run_micro(c);
+        it += block;
+        el = cpu_now() - t0;
+    } while (el < MICRO_SECONDS);
+
+    *ns_item = el / (double)it / (double)c->items * 1e9;
+    return (double)enc_used * (double)it / el / 1e6; /* MB/s, MB = 1e6 bytes */
+}
+
+static const micro_case_t *find_case(const char *name)
+{
+    for (size_t i = 0; i < ncases; i++)
+        if (!strcmp(cases[i].name, name))
+            return &cases[i];
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    const char *prefix = "";
+
+    build_cases();
+
+    if (argc >= 2 && !strcmp(argv[1], "--list")) {
+        for (size_t i = 0; i < ncases; i++)
+            printf("%s\n", cases[i].name);
+        return 0;
+    }
+
+    if (argc >= 2 && !strcmp(argv[1], "--timed")) {
+        if (argc >= 3)
+            prefix = argv[2];
+    } else if (argc >= 2) {
+        const micro_case_t *c = find_case(argv[1]);
+        if (!c) {
+            fprintf(stderr, "unknown workload: %s\n", argv[1]);
+            return 1;
+        }
+        if (!prepare(c))
+            return 1;
+        run_micro(c);
+        fprintf(stderr, "ITEMS=%zu BYTES=%zu\n", c->items, enc_used);
+        return 0;
+    }
+
+    printf("workload\titems\tbytes\tns/item\tMB/s\n");
+    for (size_t i = 0; i < ncases; i++) {
+        const micro_case_t *c = &cases[i];
+        double ns_item;
+
+        if (strncmp(c->name, prefix, strlen(prefix)) != 0)
+            continue;
+        if (!prepare(c))
+            return 1;
+
+        double mb_s = measure(c, &ns_item);
+        printf("%s\t%zu\t%zu\t%.3f\t%.2f\n", c->name, c->items, enc_used, ns_item, mb_s);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,358 @@
+/*!
+ * @file mt.c
+ * @brief SofaBuffers C — multi-thread scaling benchmark.
+ *
+ * The library keeps all state in caller-owned contexts, so one context per
+ * thread needs no locking at all. This measures whether it also scales: N
+ * threads (1, 2, 4 ... up to the online CPU count) each encode or decode the
+ * u64 array and typical datasets through their own sofab_ostream_t /
+ * sofab_istream_t and buffers, for a fixed wall-clock window, and the table
+ * reports the aggregate throughput and the scaling efficiency
+ *
+ *   efficiency(N) = aggregate MB/s at N threads / (N * MB/s at 1 thread)
+ *
+ * which stays near 1.0 while nothing is shared. Two layouts of the per-thread
+ * contexts:
+ *
+ *   padded   every thread's contexts and operation counter in their own
+ *            cache lines (the default; what a worker pool should do)
+ *   packed   all threads' contexts back to back in one array, so neighbours
+ *            share the cache lines at each boundary — every encode or decode
+ *            writes its context, and the efficiency drop against `padded` is
+ *            what false sharing between adjacent contexts costs
+ *
+ * Usage: bench_mt [--threads N] [--seconds S] [--packed | --padded]
+ *        (both layouts by default; S per point, default 0.5)
+ *
+ * Throughput is over wall-clock time here, unlike bench_c: process CPU time
+ * sums over threads and would hide exactly the contention this looks for.
+ * Output is tab-separated with a header line. MB = 1e6 bytes.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sofab/istream.h"
+#include "sofab/ostream.h"
+
+#define N          1000
+#define MT_LINE    64
+#define MT_THREADS_MAX 256
+
+/* ---- datasets (same bytes as bench_c's u64 array and typical rows) ------- */
+
+static uint64_t src[N];
+static const uint16_t arr16[4] = {10, 20, 30, 40};
+
+static void make_src(void)
+{
+    for (int i = 0; i < N; i++)
+        src[i] = (uint64_t)i * 0x9E3779B97F4A7C15ULL;
+}
+
+/* Everything one operation writes besides its buffers: this is what the
+ * layouts place either in private cache lines or back to back. */
+typedef struct
+{
+    sofab_ostream_t         os;
+    sofab_istream_t         is;
+    sofab_istream_decoder_t nested;
+    uint64_t                ops;
+} mt_ctx_t;
+
+typedef struct
+{
+    _Alignas(MT_LINE) mt_ctx_t ctx;
+} mt_ctx_padded_t;
+
+/* Per-thread buffers and decode targets, always private (cache-line aligned
+ * and padded by the allocation), so only the contexts differ between layouts. */
+typedef struct
+{
+    _Alignas(MT_LINE) uint8_t u64_buf[N * 11 + 16];
+    size_t   u64_used;
+    uint8_t  typ_buf[256];
+    size_t   typ_used;
+    uint64_t dec_array[N];
+    struct
+    {
+        uint32_t f1;
+        int32_t  f2;
+        bool     f3;
+        float    f4;
+        char     f5[16];
+        uint16_t f6[4];
+        uint32_t s_f1;
+        int32_t  s_f2;
+    } T;
+} mt_data_t;
+
+typedef struct
+{
+    mt_ctx_t  *ctx;
+    mt_data_t *data;
+} mt_worker_t;
+
+/* ---- workloads ----------------------------------------------------------- */
+
+static void encode_u64_array(mt_worker_t *w)
+{
+    sofab_ostream_t *os = &w->ctx->os;
+    sofab_ostream_init(os, w->data->u64_buf, sizeof w->data->u64_buf, 0, NULL, NULL);
+    sofab_ostream_write_array_of_unsigned(os, 1, src, N, sizeof(uint64_t));
+    w->data->u64_used = sofab_ostream_bytes_used(os);
+}
+
+static void encode_typical(mt_worker_t *w)
+{
+    sofab_ostream_t *os = &w->ctx->os;
+    sofab_ostream_init(os, w->data->typ_buf, sizeof w->data->typ_buf, 0, NULL, NULL);
+    sofab_ostream_write_unsigned(os, 1, 0xDEADBEEF);
+    sofab_ostream_write_signed(os, 2, -12345);
+    sofab_ostream_write_boolean(os, 3, true);
+    sofab_ostream_write_fp32(os, 4, 3.14159f);
+    sofab_ostream_write_string(os, 5, "sofab");
+    sofab_ostream_write_array_of_unsigned(os, 6, arr16, 4, sizeof(uint16_t));
+    sofab_ostream_write_sequence_begin(os, 7);
+    sofab_ostream_write_unsigned(os, 1, 99);
+    sofab_ostream_write_signed(os, 2, -7);
+    sofab_ostream_write_sequence_end(os);
+    w->data->typ_used = sofab_ostream_bytes_used(os);
+}
+
+static void cb_array(sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usr)
+{
+    mt_worker_t *w = (mt_worker_t *)usr;
+    (void)size;
+    if (id == 1)
+        sofab_istream_read_array_of_u64(ctx, w->data->dec_array, count);
+}
+
+static void decode_u64_array(mt_worker_t *w)
+{
+    sofab_istream_init(&w->ctx->is, cb_array, w);
+    sofab_istream_feed(&w->ctx->is, w->data->u64_buf, w->data->u64_used);
+}
+
+static void cb_child(sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usr)
+{
+    mt_worker_t *w = (mt_worker_t *)usr;
+    (void)size;
+    (void)count;
+    if (id == 1)
+        sofab_istream_read_u32(ctx, &w->data->T.s_f1);
+    else if (id == 2)
+        sofab_istream_read_i32(ctx, &w->data->T.s_f2);
+}
+
+static void cb_typical(sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usr)
+{
+    mt_worker_t *w = (mt_worker_t *)usr;
+    (void)size;
+    switch (id)
+    {
+        case 1: sofab_istream_read_u32(ctx, &w->data->T.f1); break;
+        case 2: sofab_istream_read_i32(ctx, &w->data->T.f2); break;
+        case 3: sofab_istream_read_bool(ctx, &w->data->T.f3); break;
+        case 4: sofab_istream_read_fp32(ctx, &w->data->T.f4); break;
+        case 5: sofab_istream_read_string(ctx, w->data->T.f5, sizeof w->data->T.f5); break;
+        case 6: sofab_istream_read_array_of_u16(ctx, w->data->T.f6, count); break;
+        case 7: sofab_istream_read_sequence(ctx, &w->ctx->nested, cb_child, w); break;
+        default: break;
+    }
+}
+
+static void decode_typical(mt_worker_t *w)
+{
+    sofab_istream_init(&w->ctx->is, cb_typical, w);
+    sofab_istream_feed(&w->ctx->is, w->data->typ_buf, w->data->typ_used);
+}
+
+typedef struct
+{
+    const char *name;
+    void      (*run)(mt_worker_t *w);
+} mt_workload_t;
+
+static const mt_workload_t WORKLOADS[] = {
+    { "encode_u64_array", encode_u64_array },
+    { "encode_typical",   encode_typical },
+    { "decode_u64_array", decode_u64_array },
+    { "decode_typical",   decode_typical },
+};
+#define NWORKLOADS (sizeof WORKLOADS / sizeof WORKLOADS[0])
+
+/* ---- threads ------------------------------------------------------------- */
+
+/* Checked once per block so the flag's cache line is read, not hammered. */
+#define MT_BLOCK 64
+
+static pthread_barrier_t mt_start;
+static atomic_bool       mt_stop;
+
+typedef struct
+{
+    mt_worker_t          worker;
+    const mt_workload_t *workload;
+} mt_thread_arg_t;
+
+static void *mt_thread(void *p)
+{
+    mt_thread_arg_t *a = (mt_thread_arg_t *)p;
+    mt_worker_t     *w = &a->worker;
+
+    pthread_barrier_wait(&mt_start);
+    while (!atomic_load_explicit(&mt_stop, memory_order_relaxed)) {
+        for (int k = 0; k < MT_BLOCK; k++) {
+            a->workload->run(w);
+            w->ctx->ops++;
+        }
+    }
+    return NULL;
+}
+
+static double wall_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void *alloc_lines(size_t size)
+{
+    size = (size + MT_LINE - 1) / MT_LINE * MT_LINE;
+    void *p = aligned_alloc(MT_LINE, size);
+    if (!p) {
+        fprintf(stderr, "bench_mt: out of memory\n");
+        exit(1);
+    }
+    memset(p, 0, size);
+    return p;
+}
+
+/* Run one workload on `threads` threads for `seconds` of wall time; returns
+ * the aggregate MB/s. */
+static double mt_run(const mt_workload_t *wl, int threads, bool packed, double seconds)
+{
+    pthread_t       tid[MT_THREADS_MAX];
+    mt_thread_arg_t arg[MT_THREADS_MAX];
+    mt_ctx_t        *packed_ctx = NULL;
+    mt_ctx_padded_t *padded_ctx = NULL;
+
+    if (packed)
+        packed_ctx = alloc_lines(sizeof(mt_ctx_t) * (size_t)threads);
+    else
+        padded_ctx = alloc_lines(sizeof(mt_ctx_padded_t) * (size_t)threads);
+
+    for (int t = 0; t < threads; t++) {
+        arg[t].workload = wl;
+        arg[t].worker.ctx = packed ? &packed_ctx[t] : &padded_ctx[t].ctx;
+        arg[t].worker.data = alloc_lines(sizeof(mt_data_t));
+        /* the bytes a decode workload reads */
+        encode_u64_array(&arg[t].worker);
+        encode_typical(&arg[t].worker);
+    }
+
+    size_t bytes = strstr(wl->name, "u64") ? arg[0].worker.data->u64_used
+                                           : arg[0].worker.data->typ_used;
+
+    atomic_store(&mt_stop, false);
+    pthread_barrier_init(&mt_start, NULL, (unsigned)threads + 1);
+    for (int t = 0; t < threads; t++)
+        pthread_create(&tid[t], NULL, mt_thread, &arg[t]);
+
+    pthread_barrier_wait(&mt_start);
+    double t0 = wall_now();
+    struct timespec nap = { (time_t)seconds, (long)((seconds - (double)(time_t)seconds) * 1e9) };
+    nanosleep(&nap, NULL);
+    atomic_store(&mt_stop, true);
+
+    uint64_t ops = 0;
+    for (int t = 0; t < threads; t++) {
+        pthread_join(tid[t], NULL);
+        ops += arg[t].worker.ctx->ops;
+    }
+    double el = wall_now() - t0;
+    pthread_barrier_destroy(&mt_start);
+
+    /* a thread that decoded garbage would post an unearned number */
+    bool ok = true;
+    for (int t = 0; t < threads; t++) {
+        mt_data_t *d = arg[t].worker.data;
+        if (!strncmp(wl->name, "decode", 6))
+            ok &= strstr(wl->name, "u64") ? d->dec_array[N - 1] == src[N - 1]
+                                          : d->T.f1 == 0xDEADBEEF && d->T.s_f2 == -7;
+        free(d);
+    }
+    free(packed_ctx);
+    free(padded_ctx);
+    if (!ok) {
+        fprintf(stderr, "bench_mt: %s decode self-check failed\n", wl->name);
+        exit(1);
+    }
+
+    return (double)bytes * (double)ops / el / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    long   max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    double seconds = 0.5;
+    bool   run_padded = true, run_packed = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            max_threads = strtol(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc)
+            seconds = strtod(argv[++i], NULL);
+        else if (!strcmp(argv[i], "--packed"))
+            run_padded = false;
+        else if (!strcmp(argv[i], "--padded"))
+            run_packed = false;
+        else {
+            fprintf(stderr, "usage: bench_mt [--threads N] [--seconds S] [--packed | --padded]\n");
+            return 1;
+        }
+    }
+    if (max_threads < 1)
+        max_threads = 1;
+    if (max_threads > MT_THREADS_MAX)
+        max_threads = MT_THREADS_MAX;
+    if (!(seconds > 0.0))
+        seconds = 0.5;
+
+    make_src();
+
+    printf("workload\tlayout\tthreads\tMB/s\tMB/s/thread\tefficiency\n");
+    for (size_t i = 0; i < NWORKLOADS; i++) {
+        for (int packed = 0; packed <= 1; packed++) {
+            if ((packed && !run_packed) || (!packed && !run_padded))
+                continue;
+
+            double one = 0.0;
+            for (long n = 1;; n = n * 2 > max_threads && n < max_threads ? max_threads : n * 2) {
+                double mb_s = mt_run(&WORKLOADS[i], (int)n, packed, seconds);
+                if (n == 1)
+                    one = mb_s;
+                printf("%s\t%s\t%ld\t%.1f\t%.1f\t%.3f\n", WORKLOADS[i].name,
+                       packed ? "packed" : "padded", n, mb_s, mb_s / (double)n,
+                       one > 0.0 ? mb_s / ((double)n * one) : 0.0);
+                fflush(stdout);
+                if (n >= max_threads)
+                    break;
+            }
+        }
+    }
+    return 0;
+}
@@ -5,7 +5,8 @@
  * Standalone executable reporting two complementary metrics for a single
  * representative message (scalars of every width, signed/unsigned integer
  * arrays, a float array, a string and a nested sequence), serialized and
- * deserialized through the low-level stream API:
+ * deserialized through the low-level stream API and through the object API
+ * (a descriptor over a plain struct, as applications use it):
  *
  *   1. CPU cycles/op  -- a value to judge the *cost of the code itself*. Read
  *      straight off the hardware cycle counter (x86 TSC / AArch64 virtual count
@@ -20,15 +21,45 @@
  * describe the exact same work. The C and C++ perf tools encode the identical
  * message and print the identical report, so the two can be compared directly.
  *
+ * Both are means. `perf_c --latency` instead times every operation on its own
+ * and prints the distribution — percentiles and an HDR-style histogram — which
+ * is what a tail-latency objective for single small messages is written
+ * against:
+ *
+ *   perf_c --latency [--samples N] [--cpu N] [--cold]
+ *
+ *   --samples N  timed operations per workload (default 100000), after a
+ *                warm-up of a tenth as many
+ *   --cpu N      pin the process to CPU N first (Linux), so migrations do not
+ *                land in the tail
+ *   --cold       evict the message buffer and the decode target / encode
+ *                source from the data cache before every operation
+ *
+ * `perf_c --counters` adds hardware event counts per operation to the mean
+ * report — instructions, branches, branch misses, L1D misses, cycles — via
+ * perf_events.h; without access to them it says so and reports as usual.
+ *
+ * Latencies are in cycle-counter ticks (see perf_cycles()): CPU cycles on x86,
+ * the fixed-frequency virtual counter on AArch64.
+ *
  * SPDX-License-Identifier: MIT
  */
 
+#if defined(__linux__)
+#define _GNU_SOURCE /* sched_setaffinity() */
+#include <sched.h>
+#endif
+
 #include "sofab/istream.h"
+#include "sofab/object.h"
 #include "sofab/ostream.h"
 
+#include "perf_events.h"
+
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
@@ -156,11 +187,106 @@ static void perf_field_cb(
     }
 }
 
-static void perf_decode(const uint8_t *buf, size_t len, perf_out_t *o)
+static perf_out_t perf_out;
+
+static uint32_t perf_decode(const uint8_t *buf, size_t len)
 {
     sofab_istream_t is;
-    sofab_istream_init(&is, perf_field_cb, o);
+    sofab_istream_init(&is, perf_field_cb, &perf_out);
     sofab_istream_feed(&is, buf, len);
+    return perf_out.u32;
+}
+
+/* The same message as a struct and descriptor. The object API has no boolean
+ * tag; a one-byte UNSIGNED member puts the same 0/1 varint on the wire. */
+typedef struct
+{
+    uint32_t u32;
+    int32_t  i32;
+} perf_obj_child_t;
+
+typedef struct
+{
+    uint32_t         u32;
+    int32_t          i32;
+    uint64_t         u64;
+    int64_t          i64;
+    uint8_t          b;
+    float            f32;
+    double           f64;
+    char             str[32];
+    uint32_t         samples[8];
+    int32_t          deltas[8];
+    double           fp64[4];
+    perf_obj_child_t child;
+} perf_obj_t;
+
+static const sofab_object_descr_field_t perf_obj_child_fields[] = {
+    SOFAB_OBJECT_FIELD(1, perf_obj_child_t, u32, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+    SOFAB_OBJECT_FIELD(2, perf_obj_child_t, i32, SOFAB_OBJECT_FIELDTYPE_SIGNED),
+};
+static const sofab_object_descr_t perf_obj_child_info =
+    SOFAB_OBJECT_DESCR(perf_obj_child_fields, 2, NULL, 0);
+
+static const sofab_object_descr_field_t perf_obj_fields[] = {
+    SOFAB_OBJECT_FIELD(1, perf_obj_t, u32, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+    SOFAB_OBJECT_FIELD(2, perf_obj_t, i32, SOFAB_OBJECT_FIELDTYPE_SIGNED),
+    SOFAB_OBJECT_FIELD(3, perf_obj_t, u64, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+    SOFAB_OBJECT_FIELD(4, perf_obj_t, i64, SOFAB_OBJECT_FIELDTYPE_SIGNED),
+    SOFAB_OBJECT_FIELD(5, perf_obj_t, b, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+    SOFAB_OBJECT_FIELD(6, perf_obj_t, f32, SOFAB_OBJECT_FIELDTYPE_FP32),
+    SOFAB_OBJECT_FIELD(7, perf_obj_t, f64, SOFAB_OBJECT_FIELDTYPE_FP64),
+    SOFAB_OBJECT_FIELD(8, perf_obj_t, str, SOFAB_OBJECT_FIELDTYPE_STRING),
+    SOFAB_OBJECT_FIELD_ARRAY(9, perf_obj_t, samples, SOFAB_OBJECT_FIELDTYPE_ARRAY_UNSIGNED),
+    SOFAB_OBJECT_FIELD_ARRAY(10, perf_obj_t, deltas, SOFAB_OBJECT_FIELDTYPE_ARRAY_SIGNED),
+    SOFAB_OBJECT_FIELD_ARRAY(11, perf_obj_t, fp64, SOFAB_OBJECT_FIELDTYPE_ARRAY_FP64),
+    SOFAB_OBJECT_FIELD_SEQUENCE(12, perf_obj_t, child, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+};
+static const sofab_object_descr_t *const perf_obj_nested[] = { &perf_obj_child_info };
+static const sofab_object_descr_t perf_obj_info =
+    SOFAB_OBJECT_DESCR(perf_obj_fields, 12, perf_obj_nested, 1);
+
+static perf_obj_t perf_obj_src;
+static perf_obj_t perf_obj_out;
+
+static void perf_obj_make(void)
+{
+    perf_obj_src.u32 = 0xDEADBEEFu;
+    perf_obj_src.i32 = -12345;
+    perf_obj_src.u64 = 0x0123456789ABCDEFull;
+    perf_obj_src.i64 = -5000000000000ll;
+    perf_obj_src.b   = 1;
+    perf_obj_src.f32 = 3.14159f;
+    perf_obj_src.f64 = 2.718281828459045;
+    strcpy(perf_obj_src.str, PERF_STRING);
+    memcpy(perf_obj_src.samples, perf_samples, sizeof perf_obj_src.samples);
+    memcpy(perf_obj_src.deltas, perf_deltas, sizeof perf_obj_src.deltas);
+    memcpy(perf_obj_src.fp64, perf_fp64, sizeof perf_obj_src.fp64);
+    perf_obj_src.child.u32 = 99;
+    perf_obj_src.child.i32 = -7;
+}
+
+static size_t perf_obj_encode(uint8_t *buf, size_t buflen)
+{
+    sofab_ostream_t os;
+    sofab_ostream_init(&os, buf, buflen, 0, NULL, NULL);
+    sofab_object_encode(&os, &perf_obj_info, &perf_obj_src);
+    return sofab_ostream_bytes_used(&os);
+}
+
+static uint32_t perf_obj_decode(const uint8_t *buf, size_t len)
+{
+    sofab_istream_t is;
+    sofab_object_decoder_t dec[2];
+
+    sofab_object_init(&perf_obj_info, &perf_obj_out);
+    memset(dec, 0, sizeof dec);
+    dec[0].info = &perf_obj_info;
+    dec[0].dst = (uint8_t *)&perf_obj_out;
+    dec[0].depth = 1;
+    sofab_istream_init(&is, sofab_object_field_cb, dec);
+    sofab_istream_feed(&is, buf, len);
+    return perf_obj_out.u32;
 }
 
 /*****************************************************************************/
@@ -180,6 +306,11 @@ static double cpu_now(void)
     return (double)clock() / (double)CLOCKS_PER_SEC;
 }
 
+/* Hardware counters (--counters), bracketing the same timed loop as the cycle
+ * counter; perf_ev holds the last measurement's counts until it is reported. */
+static perf_events_t perf_ev;
+static bool          perf_ev_on;
+
 static void perf_report(const char *what, perf_result_t r, size_t bytes)
 {
     printf("\n--- perf: %s ---\n", what);
@@ -193,6 +324,8 @@ static void perf_report(const char *what, perf_result_t r, size_t bytes)
 #endif
     printf("  CPU time/op   : %.1f ns  (process CPU time, not wall-clock)\n", r.ns_op);
     printf("  throughput    : %.1f MB/s  (speedtest, MB = 1e6 bytes)\n", r.mb_s);
+    if (perf_ev_on)
+        perf_events_report(&perf_ev, r.iters);
 }
 
 /* Sample the CPU clock once per block of operations rather than once per
@@ -204,13 +337,19 @@ static void perf_report(const char *what, perf_result_t r, size_t bytes)
  * that a single reading cannot matter. The printed output is unchanged. */
 #define PERF_BLOCK_SECONDS 0.01 /* clock cost lands under ~0.01% of a block */
 
-static perf_result_t measure_encode(uint8_t *buf, size_t buflen, size_t *msg_size)
+/* The API under test is passed in; each call site is constant, so the
+ * compiler specializes these and the operation is still called directly. */
+typedef size_t (*perf_encode_fn)(uint8_t *buf, size_t buflen);
+typedef uint32_t (*perf_decode_fn)(const uint8_t *buf, size_t len);
+
+static perf_result_t measure_encode(
+    perf_encode_fn encode, uint8_t *buf, size_t buflen, size_t *msg_size)
 {
     volatile size_t sink = 0;
     size_t          msg  = 0;
 
     for (unsigned i = 0; i < 1000u; i++) /* warmup */
-        msg = perf_encode(buf, buflen);
+        msg = encode(buf, buflen);
     *msg_size = msg;
 
     /* One clock reading per block of operations, not per operation — see the
@@ -219,22 +358,26 @@ static perf_result_t measure_encode(uint8_t *buf, size_t buflen, size_t *msg_siz
     for (;; block *= 2) {
         double tc = cpu_now();
         for (unsigned long k = 0; k < block; k++)
-            sink += perf_encode(buf, buflen);
+            sink += encode(buf, buflen);
         if (cpu_now() - tc >= PERF_BLOCK_SECONDS)
             break;
     }
 
     unsigned long it = 0;
     double        el;
+    if (perf_ev_on)
+        perf_events_start(&perf_ev);
     uint64_t      c0 = perf_cycles();
     double        t0 = cpu_now();
     do {
         for (unsigned long k = 0; k < block; k++)
-            sink += perf_encode(buf, buflen);
+            sink += encode(buf, buflen);
         it += block;
         el = cpu_now() - t0;
     } while (el < 1.0);
     uint64_t c1 = perf_cycles();
+    if (perf_ev_on)
+        perf_events_stop(&perf_ev);
     (void)sink;
 
     perf_result_t r;
@@ -245,37 +388,37 @@ static perf_result_t measure_encode(uint8_t *buf, size_t buflen, size_t *msg_siz
     return r;
 }
 
-static perf_result_t measure_decode(const uint8_t *buf, size_t len, perf_out_t *out)
+static perf_result_t measure_decode(perf_decode_fn decode, const uint8_t *buf, size_t len)
 {
     volatile uint32_t sink = 0;
 
     for (unsigned i = 0; i < 1000u; i++) /* warmup */
-        perf_decode(buf, len, out);
+        decode(buf, len);
 
     unsigned long block = 1;
     for (;; block *= 2) {
         double tc = cpu_now();
-        for (unsigned long k = 0; k < block; k++) {
-            perf_decode(buf, len, out);
-            sink += out->u32;
-        }
+        for (unsigned long k = 0; k < block; k++)
+            sink += decode(buf, len);
         if (cpu_now() - tc >= PERF_BLOCK_SECONDS)
             break;
     }
 
     unsigned long it = 0;
     double        el;
+    if (perf_ev_on)
+        perf_events_start(&perf_ev);
     uint64_t      c0 = perf_cycles();
     double        t0 = cpu_now();
     do {
-        for (unsigned long k = 0; k < block; k++) {
-            perf_decode(buf, len, out);
-            sink += out->u32;
-        }
+        for (unsigned long k = 0; k < block; k++)
+            sink += decode(buf, len);
         it += block;
         el = cpu_now() - t0;
     } while (el < 1.0);
     uint64_t c1 = perf_cycles();
+    if (perf_ev_on)
+        perf_events_stop(&perf_ev);
     (void)sink;
 
     perf_result_t r;
@@ -286,28 +429,331 @@ static perf_result_t measure_decode(const uint8_t *buf, size_t len, perf_out_t *
     return r;
 }
 
-int main(void)
+/*****************************************************************************/
+/* latency distribution                                                      */
+/*****************************************************************************/
+
+/* Log-linear buckets in the manner of HdrHistogram: values below 16 are exact,
+ * and every power of two above is split into 16 equal sub-buckets, so a value
+ * is recorded to within 1/16 (6.25%) of itself at any magnitude. 61 * 16
+ * counters cover the full 64-bit range in ~8 KB with no allocation. */
+#define LAT_SUB_BITS 4
+#define LAT_SUB      (1u << LAT_SUB_BITS)
+#define LAT_BUCKETS  (64 - LAT_SUB_BITS + 1)
+
+typedef struct
+{
+    uint64_t count[LAT_BUCKETS][LAT_SUB];
+    uint64_t n;
+    uint64_t min;
+    uint64_t max;
+} lat_hist_t;
+
+static unsigned lat_msb(uint64_t v)
+{
+    return 63u - (unsigned)__builtin_clzll(v);
+}
+
+static void lat_record(lat_hist_t *h, uint64_t v)
+{
+    unsigned b, sub;
+
+    if (v < LAT_SUB) {
+        b = 0;
+        sub = (unsigned)v;
+    } else {
+        unsigned shift = lat_msb(v) - LAT_SUB_BITS;
+        b = shift + 1;
+        sub = (unsigned)(v >> shift) - LAT_SUB;
+    }
+    h->count[b][sub]++;
+    if (h->n == 0 || v < h->min)
+        h->min = v;
+    if (v > h->max)
+        h->max = v;
+    h->n++;
+}
+
+/* Largest value a bucket holds, which is what a percentile reports: the true
+ * value is at most this, and at most 1/16 less. */
+static uint64_t lat_bucket_top(unsigned b, unsigned sub)
+{
+    if (b == 0)
+        return sub;
+    unsigned shift = b - 1;
+    return (((uint64_t)(sub + LAT_SUB) + 1) << shift) - 1;
+}
+
+static uint64_t lat_percentile(const lat_hist_t *h, double pct)
+{
+    uint64_t want = (uint64_t)(pct / 100.0 * (double)h->n + 0.999999);
+    uint64_t cum = 0;
+
+    if (want == 0)
+        want = 1;
+    for (unsigned b = 0; b < LAT_BUCKETS; b++)
+        for (unsigned sub = 0; sub < LAT_SUB; sub++) {
+            cum += h->count[b][sub];
+            if (cum >= want) {
+                uint64_t top = lat_bucket_top(b, sub);
+                return top < h->max ? top : h->max;
+            }
+        }
+    return h->max;
+}
+
+/* Evict [p, p + len) from every data-cache level. Elsewhere a sweep over a
+ * buffer larger than any last-level cache does it the slow way. */
+#define LAT_LINE 64
+
+#if defined(__x86_64__) || defined(__i386__)
+static void lat_evict(const void *p, size_t len)
+{
+    const char *c = (const char *)p;
+    for (size_t off = 0; off < len; off += LAT_LINE)
+        _mm_clflush(c + off);
+    _mm_clflush(c + len - 1);
+    _mm_mfence();
+}
+#elif defined(__aarch64__)
+static void lat_evict(const void *p, size_t len)
+{
+    const char *c = (const char *)p;
+    for (size_t off = 0; off < len; off += LAT_LINE)
+        __asm__ volatile("dc civac, %0" : : "r"(c + off) : "memory");
+    __asm__ volatile("dc civac, %0" : : "r"(c + len - 1) : "memory");
+    __asm__ volatile("dsb ish" : : : "memory");
+}
+#else
+static uint8_t lat_sweep[64u << 20];
+
+static void lat_evict(const void *p, size_t len)
+{
+    (void)p;
+    (void)len;
+    for (size_t off = 0; off < sizeof lat_sweep; off += LAT_LINE)
+        lat_sweep[off]++;
+}
+#endif
+
+typedef struct
+{
+    const char    *what;
+    perf_encode_fn encode;    /* one of encode / decode is set */
+    perf_decode_fn decode;
+    void          *state;     /* encode source or decode target (evicted when cold) */
+    size_t         statelen;
+} lat_workload_t;
+
+typedef struct
+{
+    unsigned long samples;
+    bool          cold;
+} lat_options_t;
+
+static lat_hist_t lat_hist;
+
+/* Back-to-back readings of the counter: the floor under every sample. */
+static uint64_t lat_timer_overhead(void)
+{
+    uint64_t best = UINT64_MAX;
+    for (unsigned i = 0; i < 10000u; i++) {
+        uint64_t t0 = perf_cycles();
+        uint64_t t1 = perf_cycles();
+        if (t1 - t0 < best)
+            best = t1 - t0;
+    }
+    return best;
+}
+
+static void lat_run(const lat_workload_t *w, const lat_options_t *opt,
+                    uint8_t *buf, size_t buflen, size_t len)
+{
+    volatile uint64_t sink = 0;
+    unsigned long     warmup = opt->samples / 10;
+
+    memset(&lat_hist, 0, sizeof lat_hist);
+
+    for (unsigned long i = 0; i < warmup + opt->samples; i++) {
+        if (opt->cold) {
+            lat_evict(buf, len);
+            if (w->state)
+                lat_evict(w->state, w->statelen);
+        }
+
+        uint64_t t0 = perf_cycles();
+        if (w->encode)
+            sink += w->encode(buf, buflen);
+        else
+            sink += w->decode(buf, len);
+        uint64_t t1 = perf_cycles();
+
+        if (i >= warmup)
+            lat_record(&lat_hist, t1 - t0);
+    }
+    (void)sink;
+
+    static const double pcts[] = { 50.0, 90.0, 99.0, 99.9, 99.99 };
+
+    printf("\n--- latency: %s, %s cache ---\n", w->what, opt->cold ? "cold" : "warm");
+    printf("  samples       : %lu  (after %lu warm-up)\n", opt->samples, warmup);
+    printf("  min / max     : %llu / %llu ticks\n",
+           (unsigned long long)lat_hist.min, (unsigned long long)lat_hist.max);
+    for (size_t i = 0; i < sizeof pcts / sizeof pcts[0]; i++)
+        printf("  p%-12g : %llu ticks\n", pcts[i],
+               (unsigned long long)lat_percentile(&lat_hist, pcts[i]));
+
+    /* The percentile distribution as HdrHistogram prints it: one line per
+     * occupied bucket, so the table can go straight into its plotter. */
+    printf("  %12s %14s %12s %14s\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+    uint64_t cum = 0;
+    for (unsigned b = 0; b < LAT_BUCKETS; b++)
+        for (unsigned sub = 0; sub < LAT_SUB; sub++) {
+            if (!lat_hist.count[b][sub])
+                continue;
+            cum += lat_hist.count[b][sub];
+            double frac = (double)cum / (double)lat_hist.n;
+            uint64_t top = lat_bucket_top(b, sub);
+            if (top > lat_hist.max)
+                top = lat_hist.max;
+            if (cum < lat_hist.n)
+                printf("  %12llu %14.6f %12llu %14.2f\n", (unsigned long long)top, frac,
+                       (unsigned long long)cum, 1.0 / (1.0 - frac));
+            else
+                printf("  %12llu %14.6f %12llu %14s\n", (unsigned long long)top, frac,
+                       (unsigned long long)cum, "inf");
+        }
+}
+
+static int lat_pin(long cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET((int)cpu, &set);
+    if (sched_setaffinity(0, sizeof set, &set) != 0) {
+        perror("perf: sched_setaffinity");
+        return 1;
+    }
+    return 0;
+#else
+    (void)cpu;
+    fprintf(stderr, "perf: --cpu is not supported on this platform, running unpinned\n");
+    return 0;
+#endif
+}
+
+static int latency_main(int argc, char **argv)
+{
+    lat_options_t opt = { 100000ul, false };
+    long          cpu = -1;
+
+    for (int i = 0; i < argc; i++) {
+        if (!strcmp(argv[i], "--cold"))
+            opt.cold = true;
+        else if (!strcmp(argv[i], "--samples") && i + 1 < argc)
+            opt.samples = strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--cpu") && i + 1 < argc)
+            cpu = strtol(argv[++i], NULL, 10);
+        else {
+            fprintf(stderr, "usage: perf_c --latency [--samples N] [--cpu N] [--cold]\n");
+            return 1;
+        }
+    }
+    if (opt.samples == 0) {
+        fprintf(stderr, "perf: --samples must be > 0\n");
+        return 1;
+    }
+    if (cpu >= 0 && lat_pin(cpu))
+        return 1;
+
+#if !PERF_HAVE_CYCLES
+    fprintf(stderr, "perf: latency mode needs the cycle counter, unavailable on this arch\n");
+    return 1;
+#else
+    static uint8_t buffer[512];
+    static uint8_t obj_buffer[512];
+
+    perf_obj_make();
+    size_t msg_size = perf_encode(buffer, sizeof buffer);
+    size_t obj_size = perf_obj_encode(obj_buffer, sizeof obj_buffer);
+
+    const lat_workload_t workloads[] = {
+        { "serialize (stream API)",   perf_encode, NULL, NULL, 0 },
+        { "deserialize (stream API)", NULL, perf_decode, &perf_out, sizeof perf_out },
+        { "serialize (object API)",   perf_obj_encode, NULL, &perf_obj_src, sizeof perf_obj_src },
+        { "deserialize (object API)", NULL, perf_obj_decode, &perf_obj_out, sizeof perf_obj_out },
+    };
+
+    printf("=== SofaBuffers C per-op latency (cycle-counter ticks) ===\n");
+    printf("message size    : %zu bytes\n", msg_size);
+    printf("timer overhead  : %llu ticks  (included in every sample)\n",
+           (unsigned long long)lat_timer_overhead());
+    if (cpu >= 0)
+        printf("pinned to CPU   : %ld\n", cpu);
+
+    for (size_t i = 0; i < sizeof workloads / sizeof workloads[0]; i++) {
+        bool obj = workloads[i].encode == perf_obj_encode || workloads[i].decode == perf_obj_decode;
+        lat_run(&workloads[i], &opt, obj ? obj_buffer : buffer,
+                obj ? sizeof obj_buffer : sizeof buffer, obj ? obj_size : msg_size);
+    }
+
+    printf("\nValue = bucket upper bound (within 1/16 of the sample); "
+           "ticks are CPU cycles on x86.\n");
+    return 0;
+#endif
+}
+
+int main(int argc, char **argv)
 {
     uint8_t buffer[512];
+    uint8_t obj_buffer[512];
     size_t  msg_size = 0;
+    size_t  obj_size = 0;
+
+    if (argc >= 2 && !strcmp(argv[1], "--latency"))
+        return latency_main(argc - 2, argv + 2);
+    if (argc >= 2 && !strcmp(argv[1], "--counters"))
+        perf_ev_on = perf_events_open(&perf_ev);
+    else if (argc >= 2) {
+        fprintf(stderr, "usage: perf_c [--counters | --latency ...]\n");
+        return 1;
+    }
 
     printf("=== SofaBuffers C per-op cost (cycles/op + throughput MB/s) ===\n");
 
-    perf_result_t enc = measure_encode(buffer, sizeof buffer, &msg_size);
+    perf_result_t enc = measure_encode(perf_encode, buffer, sizeof buffer, &msg_size);
     perf_report("serialize (stream API)", enc, msg_size);
 
-    perf_out_t out;
-    perf_decode(buffer, msg_size, &out);
+    perf_decode(buffer, msg_size);
     /* sanity check that the decode actually reproduced the data */
-    if (out.u32 != 0xDEADBEEFu || strcmp(out.str, PERF_STRING) != 0)
+    if (perf_out.u32 != 0xDEADBEEFu || strcmp(perf_out.str, PERF_STRING) != 0)
     {
         fprintf(stderr, "perf: decode self-check failed\n");
         return 1;
     }
 
-    perf_result_t dec = measure_decode(buffer, msg_size, &out);
+    perf_result_t dec = measure_decode(perf_decode, buffer, msg_size);
     perf_report("deserialize (stream API)", dec, msg_size);
 
+    perf_obj_make();
+    perf_result_t oenc = measure_encode(perf_obj_encode, obj_buffer, sizeof obj_buffer, &obj_size);
+    perf_report("serialize (object API)", oenc, obj_size);
+
+    /* the two APIs must agree on the wire, or the rows are not comparable */
+    perf_obj_decode(obj_buffer, obj_size);
+    if (obj_size != msg_size || memcmp(obj_buffer, buffer, msg_size) != 0
+        || memcmp(&perf_obj_out, &perf_obj_src, sizeof perf_obj_src) != 0)
+    {
+        fprintf(stderr, "perf: object API self-check failed\n");
+        return 1;
+    }
+
+    perf_result_t odec = measure_decode(perf_obj_decode, obj_buffer, obj_size);
+    perf_report("deserialize (object API)", odec, obj_size);
+
+    if (perf_ev_on)
+        perf_events_close(&perf_ev);
     printf("\ncycles/op tracks code cost; MB/s is this machine's throughput.\n");
     return 0;
 }
@@ -0,0 +1,456 @@
+/*!
+ * @file vectors.c
+ * @brief SofaBuffers C — per-construct replay of the conformance vectors and of
+ *        captured traffic.
+ *
+ * The BENCH_SPEC datasets are four messages; a regression in a construct none
+ * of them leans on (a fixlen array, an empty or deeply nested sequence, a
+ * two-byte field header) moves nothing there. assets/test_vectors.json has one
+ * vector per wire construct, each tagged with a `group`, so this times encode
+ * and decode of every vector and reports them per group. Each vector is
+ * encoded by replaying its fields through the stream API and decoded back
+ * through the conformance engine's callback (test/shared/sofab_test_vectors.c),
+ * after one checked round trip; a vector that does not reproduce its bytes
+ * aborts the run.
+ *
+ * PATH arguments add captured traffic: a file is one message, a directory
+ * contributes its *.bin files in name order. There is no schema for those, so
+ * they are decoded by a generic callback that binds every field by its wire
+ * type (varints to 64 bits, fixlen by subtype, arrays up to 256 elements,
+ * strings and blobs up to 4 KiB, every sequence entered) — the cost a
+ * receiver that reads everything pays for that traffic.
+ *
+ * Modes:
+ *   bench_vectors [--vectors FILE] [--per-vector] [PATH...]
+ *                                 -> timed table (CPU time), one row per group,
+ *                                    then a decode-only table of the captured
+ *                                    inputs; --per-vector adds a row per vector.
+ *   bench_vectors --list [PATH...]
+ *                                 -> print the input names, one per line.
+ *   bench_vectors --once NAME [PATH...]
+ *                                 -> encode and decode input NAME once and
+ *                                    exit; used by `run_callgrind.sh vectors`
+ *                                    (--toggle-collect=run_encode / run_decode).
+ *
+ * A group's figures are for one message of each of its vectors, so every
+ * construct weighs the same however short its message is. Tab-separated output
+ * with a header line per table; MB = 1e6 bytes of encoded message.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sofab/istream.h"
+#include "sofab/ostream.h"
+#include "sofab_test_vectors.h"
+
+#define VEC_ENCBUF      4096
+#define VEC_MAX_INPUTS  256
+#define VEC_MAX_GROUPS  64
+#define ANY_ELEMS       256     /* generic decode: array capacity */
+#define ANY_FIXLEN      4096    /* generic decode: string / blob capacity */
+
+static sofab_test_vector_set_t *set;
+
+/* ---- captured inputs -------------------------------------------------------- */
+
+typedef struct
+{
+    char    *name;
+    uint8_t *buf;
+    size_t   len;
+} vec_input_t;
+
+static vec_input_t inputs[VEC_MAX_INPUTS];
+static size_t      ninputs;
+
+static void add_input(const char *name, const uint8_t *buf, size_t len)
+{
+    if (ninputs == VEC_MAX_INPUTS) {
+        fprintf(stderr, "bench_vectors: more than %d inputs, ignoring %s\n", VEC_MAX_INPUTS, name);
+        return;
+    }
+    vec_input_t *in = &inputs[ninputs++];
+    in->name = strdup(name);
+    in->buf = malloc(len ? len : 1);
+    in->len = len;
+    if (!in->name || !in->buf) {
+        fprintf(stderr, "bench_vectors: out of memory\n");
+        exit(1);
+    }
+    memcpy(in->buf, buf, len);
+}
+
+static bool load_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return false;
+
+    uint8_t *buf = NULL;
+    size_t len = 0, cap = 0;
+    for (;;) {
+        if (len == cap) {
+            cap = cap ? cap * 2 : 4096;
+            buf = realloc(buf, cap);
+            if (!buf) {
+                fprintf(stderr, "bench_vectors: out of memory\n");
+                exit(1);
+            }
+        }
+        size_t n = fread(buf + len, 1, cap - len, f);
+        if (n == 0)
+            break;
+        len += n;
+    }
+    fclose(f);
+    add_input(path, buf, len);
+    free(buf);
+    return true;
+}
+
+static int by_name(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* A directory contributes its *.bin files, in name order. */
+static bool load_path(const char *path)
+{
+    DIR *d = opendir(path);
+    if (!d)
+        return load_file(path);
+
+    char *names[VEC_MAX_INPUTS];
+    size_t n = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL && n < VEC_MAX_INPUTS) {
+        size_t l = strlen(e->d_name);
+        if (l < 4 || strcmp(e->d_name + l - 4, ".bin") != 0)
+            continue;
+        names[n] = malloc(strlen(path) + l + 2);
+        if (!names[n]) {
+            fprintf(stderr, "bench_vectors: out of memory\n");
+            exit(1);
+        }
+        sprintf(names[n], "%s/%s", path, e->d_name);
+        n++;
+    }
+    closedir(d);
+
+    qsort(names, n, sizeof names[0], by_name);
+    for (size_t i = 0; i < n; i++) {
+        load_file(names[i]);
+        free(names[i]);
+    }
+    return true;
+}
+
+/* ---- generic decode (no schema) --------------------------------------------- */
+
+typedef struct
+{
+    uint64_t u;
+    int64_t  s;
+    float    f32;
+    double   f64;
+    union {
+        uint64_t u64[ANY_ELEMS];
+        int64_t  i64[ANY_ELEMS];
+        float    f32[ANY_ELEMS];
+        double   f64[ANY_ELEMS];
+    } arr;
+    char     bytes[ANY_FIXLEN];
+    sofab_istream_decoder_t seq[SOFAB_MAX_DEPTH + 1];
+} any_dst_t;
+
+static any_dst_t any_dst;
+
+/* Bind the field as its wire type says. Sequences are entered with one decoder
+ * per open level (ctx->depth is the parent's level when the callback fires);
+ * a string, blob or array over the capacity is left unbound and skipped. */
+static void any_field_cb(sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usr)
+{
+    any_dst_t *d = usr;
+    uint8_t type = ctx->target_opt & 0x07;
+    uint8_t sub = (ctx->target_opt >> 3) & 0x07;
+    (void)id;
+
+    switch (type) {
+    case SOFAB_TYPE_VARINT_UNSIGNED:
+        sofab_istream_read_u64(ctx, &d->u);
+        break;
+    case SOFAB_TYPE_VARINT_SIGNED:
+        sofab_istream_read_i64(ctx, &d->s);
+        break;
+    case SOFAB_TYPE_FIXLEN:
+        if (sub == SOFAB_FIXLENTYPE_FP32)
+            sofab_istream_read_fp32(ctx, &d->f32);
+        else if (sub == SOFAB_FIXLENTYPE_FP64)
+            sofab_istream_read_fp64(ctx, &d->f64);
+        else if (sub == SOFAB_FIXLENTYPE_STRING && size < sizeof d->bytes)
+            sofab_istream_read_string(ctx, d->bytes, sizeof d->bytes);
+        else if (sub == SOFAB_FIXLENTYPE_BLOB && size <= sizeof d->bytes)
+            sofab_istream_read_blob(ctx, d->bytes, sizeof d->bytes);
+        break;
+    case SOFAB_TYPE_VARINTARRAY_UNSIGNED:
+        if (count <= ANY_ELEMS)
+            sofab_istream_read_array_of_u64(ctx, d->arr.u64, ANY_ELEMS);
+        break;
+    case SOFAB_TYPE_VARINTARRAY_SIGNED:
+        if (count <= ANY_ELEMS)
+            sofab_istream_read_array_of_i64(ctx, d->arr.i64, ANY_ELEMS);
+        break;
+    case SOFAB_TYPE_FIXLENARRAY:
+        if (count > ANY_ELEMS)
+            break;
+        if (sub == SOFAB_FIXLENTYPE_FP32)
+            sofab_istream_read_array_of_fp32(ctx, d->arr.f32, ANY_ELEMS);
+        else if (sub == SOFAB_FIXLENTYPE_FP64)
+            sofab_istream_read_array_of_fp64(ctx, d->arr.f64, ANY_ELEMS);
+        break;
+    case SOFAB_TYPE_SEQUENCE_START:
+        sofab_istream_read_sequence(ctx, &d->seq[ctx->depth], any_field_cb, d);
+        break;
+    default:
+        break;
+    }
+}
+
+static sofab_ret_t any_decode(const uint8_t *buf, size_t len)
+{
+    sofab_istream_t is;
+    sofab_istream_init(&is, any_field_cb, &any_dst);
+    return sofab_istream_feed(&is, buf, len);
+}
+
+/* ---- workloads (Callgrind toggle points) ------------------------------------ */
+
+/* An input is a vector (index < vector count) or a captured input after them. */
+static uint8_t enc_buf[VEC_ENCBUF];
+
+__attribute__((noinline)) void run_encode(size_t vi)
+{
+    size_t len;
+    sofab_test_vectors_encode(set, vi, enc_buf, sizeof enc_buf, &len);
+}
+
+__attribute__((noinline)) void run_decode(size_t vi)
+{
+    size_t nvec = sofab_test_vectors_count(set);
+    if (vi < nvec) {
+        size_t len;
+        const uint8_t *bytes = sofab_test_vectors_bytes(set, vi, &len);
+        sofab_test_vectors_decode(set, vi, bytes, len);
+    } else {
+        any_decode(inputs[vi - nvec].buf, inputs[vi - nvec].len);
+    }
+}
+
+/* ---- measurement (process CPU time) ----------------------------------------- */
+
+static double cpu_now(void)
+{
+    return (double)clock() / (double)CLOCKS_PER_SEC;
+}
+
+/* Same block-sampling scheme as micro.c, with a shorter window: a full run is
+ * two measurements for every vector. */
+#define VEC_BLOCK_SECONDS 0.005
+#define VEC_SECONDS       0.05
+
+static double measure(void (*fn)(size_t), size_t vi)
+{
+    fn(vi); /* warmup */
+
+    long block = 1;
+    for (;; block *= 2) {
+        double t0 = cpu_now();
+        for (long k = 0; k < block; k++)
+            fn(vi);
+        if (cpu_now() - t0 >= VEC_BLOCK_SECONDS)
+            break;
+    }
+
+    double t0 = cpu_now();
+    long   it = 0;
+    double el;
+    do {
+        for (long k = 0; k < block; k++)
+            fn(vi);
+        it += block;
+        el = cpu_now() - t0;
+    } while (el < VEC_SECONDS);
+
+    return el / (double)it * 1e9; /* ns per message */
+}
+
+static double mbps(size_t bytes, double ns)
+{
+    return ns > 0 ? (double)bytes / ns * 1e3 : 0;
+}
+
+/* ---- main ------------------------------------------------------------------- */
+
+typedef struct
+{
+    const char *name;
+    unsigned    vectors;
+    size_t      bytes;
+    double      enc_ns;
+    double      dec_ns;
+} vec_group_t;
+
+static vec_group_t groups[VEC_MAX_GROUPS];
+static size_t      ngroups;
+
+static vec_group_t *group_of(const char *name)
+{
+    for (size_t g = 0; g < ngroups; g++)
+        if (!strcmp(groups[g].name, name))
+            return &groups[g];
+    if (ngroups == VEC_MAX_GROUPS) {
+        fprintf(stderr, "bench_vectors: more than %d groups\n", VEC_MAX_GROUPS);
+        exit(1);
+    }
+    groups[ngroups].name = name;
+    return &groups[ngroups++];
+}
+
+static const char *input_name(size_t vi)
+{
+    size_t nvec = sofab_test_vectors_count(set);
+    return vi < nvec ? sofab_test_vectors_name(set, vi) : inputs[vi - nvec].name;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    const char *once = NULL;
+    bool list = false, per_vector = false;
+
+#ifdef SOFAB_VECTORS_JSON
+    path = SOFAB_VECTORS_JSON;
+#endif
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--list")) {
+            list = true;
+        } else if (!strcmp(argv[i], "--per-vector")) {
+            per_vector = true;
+        } else if (!strcmp(argv[i], "--vectors") && i + 1 < argc) {
+            path = argv[++i];
+        } else if (!strcmp(argv[i], "--once") && i + 1 < argc) {
+            once = argv[++i];
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s [--vectors FILE] [--per-vector | --list | --once NAME] [PATH...]\n",
+                    argv[0]);
+            return 2;
+        } else if (!load_path(argv[i])) {
+            fprintf(stderr, "bench_vectors: cannot read %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "bench_vectors: no vector file (--vectors FILE)\n");
+        return 2;
+    }
+
+    char err[256];
+    set = sofab_test_vectors_load(path, err, sizeof err);
+    if (!set) {
+        fprintf(stderr, "bench_vectors: %s\n", err);
+        return 1;
+    }
+    size_t nvec = sofab_test_vectors_count(set);
+
+    if (list) {
+        for (size_t i = 0; i < nvec; i++)
+            if (sofab_test_vectors_supported(set, i))
+                printf("%s\n", sofab_test_vectors_name(set, i));
+        for (size_t i = 0; i < ninputs; i++)
+            printf("%s\n", inputs[i].name);
+        return 0;
+    }
+
+    /* nothing is timed until every vector reproduces its bytes */
+    for (size_t i = 0; i < nvec; i++) {
+        if (sofab_test_vectors_supported(set, i) && sofab_test_vectors_check(set, i, err, sizeof err)) {
+            fprintf(stderr, "bench_vectors: %s: %s\n", sofab_test_vectors_name(set, i), err);
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < ninputs; i++) {
+        sofab_ret_t r = any_decode(inputs[i].buf, inputs[i].len);
+        if (r != SOFAB_RET_OK)
+            fprintf(stderr, "bench_vectors: %s does not decode (%d), timing it anyway\n", inputs[i].name, (int)r);
+    }
+
+    if (once) {
+        for (size_t vi = 0; vi < nvec + ninputs; vi++) {
+            if (strcmp(input_name(vi), once) != 0)
+                continue;
+            size_t len;
+            if (vi < nvec) {
+                sofab_test_vectors_bytes(set, vi, &len);
+                run_encode(vi);
+            } else {
+                len = inputs[vi - nvec].len;
+            }
+            run_decode(vi);
+            fprintf(stderr, "BYTES=%zu\n", len);
+            return 0;
+        }
+        fprintf(stderr, "bench_vectors: unknown input %s\n", once);
+        return 1;
+    }
+
+    if (per_vector)
+        printf("group\tinput\tbytes\tenc ns/msg\tenc MB/s\tdec ns/msg\tdec MB/s\n");
+    for (size_t i = 0; i < nvec; i++) {
+        if (!sofab_test_vectors_supported(set, i))
+            continue;
+        size_t len;
+        sofab_test_vectors_bytes(set, i, &len);
+        double enc = measure(run_encode, i);
+        double dec = measure(run_decode, i);
+
+        vec_group_t *g = group_of(sofab_test_vectors_group(set, i));
+        g->vectors++;
+        g->bytes += len;
+        g->enc_ns += enc;
+        g->dec_ns += dec;
+
+        if (per_vector)
+            printf("%s\t%s\t%zu\t%.1f\t%.1f\t%.1f\t%.1f\n", g->name, sofab_test_vectors_name(set, i), len,
+                   enc, mbps(len, enc), dec, mbps(len, dec));
+    }
+    if (per_vector)
+        printf("\n");
+
+    printf("group\tvectors\tbytes\tenc ns/msg\tenc MB/s\tdec ns/msg\tdec MB/s\n");
+    for (size_t g = 0; g < ngroups; g++) {
+        const vec_group_t *gr = &groups[g];
+        printf("%s\t%u\t%zu\t%.1f\t%.1f\t%.1f\t%.1f\n", gr->name, gr->vectors, gr->bytes,
+               gr->enc_ns / gr->vectors, mbps(gr->bytes, gr->enc_ns),
+               gr->dec_ns / gr->vectors, mbps(gr->bytes, gr->dec_ns));
+    }
+
+    if (ninputs)
+        printf("\ninput\tbytes\tdec ns/msg\tdec MB/s\n");
+    for (size_t i = 0; i < ninputs; i++) {
+        double dec = measure(run_decode, nvec + i);
+        printf("%s\t%zu\t%.1f\t%.1f\n", inputs[i].name, inputs[i].len, dec, mbps(inputs[i].len, dec));
+    }
+
+    sofab_test_vectors_free(set);
+    return 0;
+}
@@ -6,14 +6,20 @@
  * through the header-only C++ wrapper (sofab.hpp), so the figures are directly
  * comparable. The wrapper's write()/read() templates inline to the same C
  * corelib calls; this benchmark measures whatever overhead those abstractions
- * add.
+ * add. The "(object)" rows use generated-style message classes through
+ * OStreamObject / IStreamObject, against bench_c's descriptor rows.
  *
  * Throughput is measured against *process CPU time* (std::clock(), not
  * wall-clock), so it reflects the cost of the implementation, not OS scheduling
  * or the machine clock. MB = 1e6 bytes.
  *
- * Two modes:
+ * Three modes:
  *   bench_cpp              -> timed MB/s table (default, CPU time).
+ *   bench_cpp --alloc      -> heap allocations and bytes per operation of
+ *                            every workload, plus the heap-using flavors
+ *                            (OStream(buflen), std::vector reads); exits
+ *                            non-zero if a heap-free workload allocates
+ *                            (alloc_count.hpp).
  *   bench_cpp <workload>   -> run one operation once and exit; used by
  *                            run_callgrind.sh to count instructions/op under
  *                            Callgrind (a machine-independent metric). The
@@ -29,13 +35,17 @@
  */
 
 #include "sofab/sofab.hpp"
+#include "alloc_count.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
 #include <span>
 #include <string>
+#include <vector>
 
 #define N 1000
 
@@ -142,7 +152,7 @@ void make_composite()
         snprintf(comp_items[i], sizeof comp_items[i], "item-%d", i);
 }
 
-void encode_typical(OStreamRaw &os)
+void encode_typical(sofab::OStreamImpl &os)
 {
     os.write(1, static_cast<uint32_t>(0xDEADBEEF));
     os.write(2, static_cast<int32_t>(-12345));
@@ -276,6 +286,318 @@ void cb_typical(sofab_istream_t *, sofab_id_t id, size_t, size_t, void *usr)
     }
 }
 
+/* ---- message objects (generated-style) ------------------------------------
+ * The same three datasets as sofab::Message classes, written the way the code
+ * generator writes them — writeIf() for a leaf, writeLazy() for a nested field,
+ * a _maxSize derived with max_size_v — and run through OStreamObject /
+ * IStreamObject. Ids and values match the raw rows, so the encodings are
+ * byte-identical (checked in main) and each object row reads directly against
+ * its raw row: the difference is the virtual serialize()/deserialize()
+ * dispatch and the per-field default tests. */
+
+using U64Array = sofab::InlineVector<uint64_t, N>;
+
+struct U64Msg final : sofab::Message
+{
+    U64Array a;
+
+    static constexpr size_t _maxSize = sofab::max_size_v<
+        sofab::Field<1, U64Array>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        return _ostream.writeIf(1, a, !a.empty());
+    }
+
+    void deserialize(sofab::IStreamImpl &_istream, sofab::id _id, size_t, size_t _count) noexcept override
+    {
+        if (_id == 1)
+            _istream.readArray(a, _count, N);
+    }
+};
+
+struct TypicalChild final : sofab::Message
+{
+    uint32_t u = 0;
+    int32_t  s = 0;
+
+    static constexpr size_t _maxSize = sofab::max_size_v<
+        sofab::Field<1, uint32_t>,
+        sofab::Field<2, int32_t>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        return _ostream
+            .writeIf(1, u, u != 0)
+            .writeIf(2, s, s != 0)
+        ;
+    }
+
+    void deserialize(sofab::IStreamImpl &_istream, sofab::id _id, size_t, size_t) noexcept override
+    {
+        switch (_id)
+        {
+            case 1: _istream.read(u); break;
+            case 2: _istream.read(s); break;
+            default: break;
+        }
+    }
+};
+
+struct TypicalMsg final : sofab::Message
+{
+    uint32_t                f1 = 0;
+    int32_t                 f2 = 0;
+    bool                    f3 = false;
+    float                   f4 = 0.0f;
+    sofab::FixedString<15>  f5;
+    std::array<uint16_t, 4> f6{};
+    TypicalChild            f7;
+
+    static constexpr size_t _maxSize = sofab::max_size_v<
+        sofab::Field<1, uint32_t>,
+        sofab::Field<2, int32_t>,
+        sofab::Field<3, bool>,
+        sofab::Field<4, float>,
+        sofab::Field<5, sofab::FixedString<15>>,
+        sofab::Field<6, std::array<uint16_t, 4>>,
+        sofab::Field<7, TypicalChild>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        return _ostream
+            .writeIf(1, f1, f1 != 0)
+            .writeIf(2, f2, f2 != 0)
+            .writeIf(3, f3, f3)
+            .writeIf(4, f4, f4 != 0.0f)
+            .writeIf(5, f5, !f5.empty())
+            .writeIf(6, f6, f6 != std::array<uint16_t, 4>{})
+            .writeLazy(7, f7)
+        ;
+    }
+
+    void deserialize(sofab::IStreamImpl &_istream, sofab::id _id, size_t _size, size_t _count) noexcept override
+    {
+        switch (_id)
+        {
+            case 1: _istream.read(f1); break;
+            case 2: _istream.read(f2); break;
+            case 3: _istream.read(f3); break;
+            case 4: _istream.read(f4); break;
+            case 5: _istream.readString(f5, _size, f5.capacity()); break;
+            case 6: _istream.readArray(f6, _count, 4); break;
+            case 7: _istream.read(f7); break;
+            default: break;
+        }
+    }
+};
+
+using CompItem  = sofab::FixedString<COMP_ITEM_MAX - 1>;
+using CompItems = sofab::InlineVector<CompItem, COMP_ITEMS>;
+using CompText  = sofab::FixedString<COMP_TEXT_LEN>;
+
+/* Wrapper array encode (MESSAGE_SPEC §5.1): the child id is the index, an
+ * interior empty element is omitted and the last one is always written. */
+struct CompItemsOut final : sofab::OStreamMessage
+{
+    const CompItems &items;
+
+    explicit CompItemsOut(const CompItems &i) noexcept : items{i} { }
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        auto result = _ostream.writeIf(0, 0u, false);
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            result.writeIf(static_cast<sofab_id_t>(i), items[i],
+                !items[i].empty() || i + 1 == items.size());
+        }
+        return result;
+    }
+};
+
+struct CompL3 final : sofab::Message
+{
+    uint32_t deep = 0;
+
+    static constexpr size_t _maxSize = sofab::max_size_v<sofab::Field<1, uint32_t>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        return _ostream.writeIf(1, deep, deep != 0);
+    }
+
+    void deserialize(sofab::IStreamImpl &_istream, sofab::id _id, size_t, size_t) noexcept override
+    {
+        if (_id == 1)
+            _istream.read(deep);
+    }
+};
+
+struct CompL2 final : sofab::Message
+{
+    CompL3 l3;
+
+    static constexpr size_t _maxSize = sofab::max_size_v<sofab::Field<1, CompL3>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        return _ostream.writeLazy(1, l3);
+    }
+
+    void deserialize(sofab::IStreamImpl &_istream, sofab::id _id, size_t, size_t) noexcept override
+    {
+        if (_id == 1)
+            _istream.read(l3);
+    }
+};
+
+struct CompL1 final : sofab::Message
+{
+    CompL2  l2;
+    int32_t tail = 0;
+
+    static constexpr size_t _maxSize = sofab::max_size_v<
+        sofab::Field<1, CompL2>,
+        sofab::Field<2, int32_t>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        return _ostream
+            .writeLazy(1, l2)
+            .writeIf(2, tail, tail != 0)
+        ;
+    }
+
+    void deserialize(sofab::IStreamImpl &_istream, sofab::id _id, size_t, size_t) noexcept override
+    {
+        switch (_id)
+        {
+            case 1: _istream.read(l2); break;
+            case 2: _istream.read(tail); break;
+            default: break;
+        }
+    }
+};
+
+/* Field 4: left at its default, so writeLazy() discards its frame. */
+struct CompF4 final : sofab::Message
+{
+    uint32_t x = 0;
+
+    static constexpr size_t _maxSize = sofab::max_size_v<sofab::Field<1, uint32_t>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        return _ostream.writeIf(1, x, x != 0);
+    }
+
+    void deserialize(sofab::IStreamImpl &_istream, sofab::id _id, size_t, size_t) noexcept override
+    {
+        if (_id == 1)
+            _istream.read(x);
+    }
+};
+
+struct CompositeMsg final : sofab::Message
+{
+    CompItems items;
+    CompText  text;
+    CompL1    l1;
+    CompF4    f4;
+    uint32_t  f130 = 0;
+
+    sofab::FixedStringSeq<CompItems> itemsSeq;  //!< Decode-side collector for items.
+
+    static constexpr size_t _maxSize = sofab::max_size_v<
+        sofab::Field<1, CompItems>,
+        sofab::Field<2, CompText>,
+        sofab::Field<3, CompL1>,
+        sofab::Field<4, CompF4>,
+        sofab::Field<130, uint32_t>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        return _ostream
+            .writeLazy(1, CompItemsOut{items})
+            .writeIf(2, text, !text.empty())
+            .writeLazy(3, l1)
+            .writeLazy(4, f4)
+            .writeIf(130, f130, f130 != 0)
+        ;
+    }
+
+    void deserialize(sofab::IStreamImpl &_istream, sofab::id _id, size_t _size, size_t) noexcept override
+    {
+        switch (_id)
+        {
+            case 1:   _istream.readSequence(itemsSeq, items); break;
+            case 2:   _istream.readString(text, _size, text.capacity()); break;
+            case 3:   _istream.read(l1); break;
+            case 4:   _istream.read(f4); break;
+            case 130: _istream.read(f130); break;
+            default: break;
+        }
+    }
+};
+
+/* OStreamObject serializes into its own inline buffer; rewinding that buffer
+ * lets one populated object be encoded over and over, the way the raw rows
+ * re-encode the same static source. */
+template <typename M>
+class OStreamObjectRaw : public sofab::OStreamObject<M>
+{
+public:
+    void rewind() noexcept
+    {
+        sofab_ostream_buffer_set(&this->ctx_, this->buffer_, M::_maxSize, 0);
+    }
+};
+
+OStreamObjectRaw<U64Msg>       u64_os;
+OStreamObjectRaw<TypicalMsg>   typ_os;
+OStreamObjectRaw<CompositeMsg> comp_os;
+size_t u64_obj_used, typ_obj_used, comp_obj_used;
+
+/* decoded values kept for the single-shot report (the objects are per-op) */
+uint64_t obj_arr1;
+uint32_t obj_f1;
+char     obj_item63[COMP_ITEM_MAX];
+
+void make_objects()
+{
+    U64Msg &u = u64_os.operator->();
+    u.a.resize(N);
+    std::memcpy(u.a.data(), src, sizeof src);
+
+    TypicalMsg &t = typ_os.operator->();
+    t.f1 = 0xDEADBEEF;
+    t.f2 = -12345;
+    t.f3 = true;
+    t.f4 = 3.14159f;
+    t.f5 = "sofab";
+    std::memcpy(t.f6.data(), arr16, sizeof arr16);
+    t.f7.u = 99;
+    t.f7.s = -7;
+
+    CompositeMsg &c = comp_os.operator->();
+    for (int i = 0; i < COMP_ITEMS; i++)
+        c.items.emplace_back() = comp_items[i];
+    c.text = COMP_TEXT;
+    c.l1.l2.l3.deep = 7;
+    c.l1.tail = -1;
+    c.f130 = 0xDEADBEEF;
+}
+
 double cpu_now()
 {
     return (double)std::clock() / (double)CLOCKS_PER_SEC;
@@ -417,6 +739,138 @@ extern "C" __attribute__((noinline)) void run_decode_composite_skip()
     is.feed(comp_buf, comp_used);
 }
 
+extern "C" __attribute__((noinline)) void run_encode_u64_array_object()
+{
+    u64_os.rewind();
+    u64_os.serialize();
+    u64_obj_used = u64_os.bytesUsed();
+}
+
+extern "C" __attribute__((noinline)) void run_encode_typical_object()
+{
+    typ_os.rewind();
+    typ_os.serialize();
+    typ_obj_used = typ_os.bytesUsed();
+}
+
+extern "C" __attribute__((noinline)) void run_encode_composite_object()
+{
+    comp_os.rewind();
+    comp_os.serialize();
+    comp_obj_used = comp_os.bytesUsed();
+}
+
+/* A fresh IStreamObject per message, as a receiver uses it; constructing it
+ * default-initializes the message, which is the counterpart of the C rows'
+ * sofab_object_init(). */
+extern "C" __attribute__((noinline)) void run_decode_u64_array_object()
+{
+    sofab::IStreamObject<U64Msg> is;
+    is.feed(u64_os.data(), u64_obj_used);
+    obj_arr1 = (*is).a[1];
+}
+
+extern "C" __attribute__((noinline)) void run_decode_typical_object()
+{
+    sofab::IStreamObject<TypicalMsg> is;
+    is.feed(typ_os.data(), typ_obj_used);
+    obj_f1 = (*is).f1;
+}
+
+extern "C" __attribute__((noinline)) void run_decode_composite_object()
+{
+    sofab::IStreamObject<CompositeMsg> is;
+    is.feed(comp_os.data(), comp_obj_used);
+    const auto &items = (*is).items;
+    if (items.size() == COMP_ITEMS)
+        std::memcpy(obj_item63, items[COMP_ITEMS - 1].c_str(), items[COMP_ITEMS - 1].size() + 1);
+}
+
+/* ---- heap-using flavors (--alloc only) ------------------------------------
+ * The wrapper's two documented heap users, driven over the same datasets so
+ * the allocation table shows what they cost next to the heap-free rows. */
+
+static size_t typ_heap_used;
+static std::vector<std::string> comp_vec;
+
+/* OStream(buflen) owns its buffer: a std::shared_ptr allocation per stream. */
+extern "C" __attribute__((noinline)) void run_encode_typical_heap()
+{
+    sofab::OStream os(sizeof typ_buf);
+    encode_typical(os);
+    typ_heap_used = os.bytesUsed();
+}
+
+static void cb_composite_vec(sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usr)
+{
+    if (id == 1)
+        static_cast<IStreamRaw *>(usr)->read(comp_vec);
+    else
+        cb_composite(ctx, id, size, count, usr);
+}
+
+/* The wrapper array read into a std::vector<std::string>, starting from an
+ * empty vector as a receiver that keeps nothing between messages does. */
+extern "C" __attribute__((noinline)) void run_decode_composite_vector()
+{
+    std::vector<std::string>().swap(comp_vec);
+    IStreamRaw is;
+    is.init(cb_composite_vec, &is);
+    is.feed(comp_buf, comp_used);
+}
+
+/* ---- allocation mode ------------------------------------------------------ */
+
+/* Every workload of the timed table under the counting operator new, plus the
+ * two heap flavors. The stream-API decode rows read into std::string (presized,
+ * as in the timed table), so they are allowed to allocate; everything else is
+ * the heap-free subset and must not. */
+static int run_alloc()
+{
+    using alloc_count::Policy;
+    using alloc_count::check;
+
+    /* No warm-up calls for the encoders: each decode row reads what its
+     * encode row above it just wrote, and a heap-free row counts from the
+     * first call on. */
+    make_src();
+    make_blob();
+    make_composite();
+    make_objects();
+
+    printf("=== SofaBuffers C++ heap allocations per operation ===\n");
+    alloc_count::header();
+    bool ok = true;
+    ok &= check("encode: u64 array (1000)",   Policy::HeapFree,    run_encode_u64_array);
+    ok &= check("encode: typical message",    Policy::HeapFree,    run_encode_typical);
+    ok &= check("encode: blob 1MB one-shot",  Policy::HeapFree,    run_encode_blob_oneshot);
+    ok &= check("encode: blob 1MB streaming", Policy::HeapFree,    run_encode_blob_streaming);
+    ok &= check("encode: composite",          Policy::HeapFree,    run_encode_composite);
+    ok &= check("decode: u64 array (1000)",   Policy::HeapFree,    run_decode_u64_array);
+    ok &= check("decode: typical message",    Policy::MayAllocate, run_decode_typical);
+    ok &= check("decode: blob 1MB",           Policy::HeapFree,    run_decode_blob);
+    ok &= check("decode: composite",          Policy::MayAllocate, run_decode_composite);
+    ok &= check("decode: composite skip-all", Policy::HeapFree,    run_decode_composite_skip);
+    ok &= check("encode: u64 array (object)", Policy::HeapFree,    run_encode_u64_array_object);
+    ok &= check("encode: typical (object)",   Policy::HeapFree,    run_encode_typical_object);
+    ok &= check("encode: composite (object)", Policy::HeapFree,    run_encode_composite_object);
+    ok &= check("decode: u64 array (object)", Policy::HeapFree,    run_decode_u64_array_object);
+    ok &= check("decode: typical (object)",   Policy::HeapFree,    run_decode_typical_object);
+    ok &= check("decode: composite (object)", Policy::HeapFree,    run_decode_composite_object);
+    ok &= check("encode: typical OStream(buflen)", Policy::MayAllocate, run_encode_typical_heap);
+    ok &= check("decode: composite std::vector",   Policy::MayAllocate, run_decode_composite_vector);
+
+    if (typ_heap_used != typ_used || comp_vec.size() != COMP_ITEMS || comp_vec[COMP_ITEMS - 1] != "item-63") {
+        fprintf(stderr, "bench: heap flavor self-check failed\n");
+        return 1;
+    }
+    if (!ok) {
+        fprintf(stderr, "bench: a heap-free workload allocated\n");
+        return 1;
+    }
+    return 0;
+}
+
 /* ---- single-shot mode (one operation, for Callgrind instruction counts) -- */
 
 /* FNV-1a over the encoded message; must match bench_c's for every workload —
@@ -449,6 +903,7 @@ static int run_one(const char *w)
     make_src();
     make_blob();
     make_composite();
+    make_objects();
 
     if (!strcmp(w, "encode_u64_array")) {
         run_encode_u64_array();
@@ -465,6 +920,15 @@ static int run_one(const char *w)
     } else if (!strcmp(w, "encode_composite")) {
         run_encode_composite();
         bytes = comp_used;
+    } else if (!strcmp(w, "encode_u64_array_object")) {
+        run_encode_u64_array_object();
+        bytes = u64_obj_used;
+    } else if (!strcmp(w, "encode_typical_object")) {
+        run_encode_typical_object();
+        bytes = typ_obj_used;
+    } else if (!strcmp(w, "encode_composite_object")) {
+        run_encode_composite_object();
+        bytes = comp_obj_used;
     } else if (!strcmp(w, "decode_u64_array")) {
         run_encode_u64_array();          /* setup (excluded from collection) */
         run_decode_u64_array();
@@ -485,6 +949,18 @@ static int run_one(const char *w)
         run_encode_composite();          /* setup (excluded from collection) */
         run_decode_composite_skip();
         bytes = comp_used;
+    } else if (!strcmp(w, "decode_u64_array_object")) {
+        run_encode_u64_array_object();   /* setup (excluded from collection) */
+        run_decode_u64_array_object();
+        bytes = u64_obj_used;
+    } else if (!strcmp(w, "decode_typical_object")) {
+        run_encode_typical_object();     /* setup (excluded from collection) */
+        run_decode_typical_object();
+        bytes = typ_obj_used;
+    } else if (!strcmp(w, "decode_composite_object")) {
+        run_encode_composite_object();   /* setup (excluded from collection) */
+        run_decode_composite_object();
+        bytes = comp_obj_used;
     } else {
         fprintf(stderr, "unknown workload: %s\n", w);
         return 1;
@@ -492,28 +968,71 @@ static int run_one(const char *w)
 
     fprintf(stderr,
             "arr0=%llu f1=%u s_f2=%d str=%.5s blob0=%u xor=%u item63=%s deep=%u "
-            "csum=%08x BYTES=%zu\n",
+            "csum=%08x obj: arr1=%llu f1=%u item63=%s csum=%08x BYTES=%zu\n",
             (unsigned long long)dec_array[0], T.f1, T.s_f2, T.f5.c_str(),
             blob_dec[0], blob_sink_xor, C.items[COMP_ITEMS - 1].c_str(), C.deep,
-            fnv1a(comp_buf, comp_used), bytes);
+            fnv1a(comp_buf, comp_used),
+            (unsigned long long)obj_arr1, obj_f1, obj_item63,
+            fnv1a(comp_os.data(), comp_obj_used), bytes);
     return 0;
 }
 
+/* The object rows are only comparable to the raw rows if they move the same
+ * bytes, and decode back to the values they were built from. */
+static bool check_objects(size_t ba, size_t bt, size_t bc)
+{
+    if (u64_obj_used != ba || memcmp(u64_os.data(), enc_u64_buf, ba) != 0
+        || typ_obj_used != bt || memcmp(typ_os.data(), typ_buf, bt) != 0
+        || comp_obj_used != bc || memcmp(comp_os.data(), comp_buf, bc) != 0)
+        return false;
+
+    sofab::IStreamObject<U64Msg> u;
+    sofab::IStreamObject<TypicalMsg> t;
+    sofab::IStreamObject<CompositeMsg> c;
+    bool fed = u.feed(u64_os.data(), u64_obj_used).code() == sofab::Error::None
+        && t.feed(typ_os.data(), typ_obj_used).code() == sofab::Error::None
+        && c.feed(comp_os.data(), comp_obj_used).code() == sofab::Error::None;
+
+    const U64Msg &us = u64_os.operator->();
+    const TypicalMsg &ts = typ_os.operator->();
+    const CompositeMsg &cs = comp_os.operator->();
+
+    bool items_ok = (*c).items.size() == COMP_ITEMS;
+    for (int i = 0; items_ok && i < COMP_ITEMS; i++)
+        items_ok = std::string_view{(*c).items[i]} == std::string_view{cs.items[i]};
+
+    return fed
+        && std::equal(us.a.begin(), us.a.end(), (*u).a.begin(), (*u).a.end())
+        && (*t).f1 == ts.f1 && (*t).f2 == ts.f2 && (*t).f3 == ts.f3 && (*t).f4 == ts.f4
+        && std::string_view{(*t).f5} == "sofab" && (*t).f6 == ts.f6
+        && (*t).f7.u == 99 && (*t).f7.s == -7
+        && items_ok
+        && std::string_view{(*c).text} == std::string_view{COMP_TEXT, COMP_TEXT_LEN}
+        && (*c).l1.l2.l3.deep == 7 && (*c).l1.tail == -1
+        && (*c).f4.x == 0 && (*c).f130 == 0xDEADBEEFu;
+}
+
 int main(int argc, char **argv)
 {
     presize_targets();
 
+    if (argc >= 2 && !strcmp(argv[1], "--alloc"))
+        return run_alloc();
     if (argc >= 2)
         return run_one(argv[1]);
 
     make_src();
     make_blob();
     make_composite();
+    make_objects();
     run_encode_u64_array();
     run_encode_typical();
     run_encode_blob_oneshot();
     run_encode_blob_streaming();
     run_encode_composite();
+    run_encode_u64_array_object();
+    run_encode_typical_object();
+    run_encode_composite_object();
     size_t ba = enc_u64_used, bt = typ_used, bb = blob_used, bc = comp_used;
 
     if (bb != BLOB_ENCODED || blob_streamed != BLOB_ENCODED) {
@@ -535,6 +1054,11 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    if (!check_objects(ba, bt, bc)) {
+        fprintf(stderr, "bench: message object self-check failed\n");
+        return 1;
+    }
+
     printf("=== SofaBuffers C++ throughput (CPU time, MB/s) ===\n");
     printf("%-26s %12s\n", "Workload", "MB/s");
     printf("%-26s %12s\n", "--------", "----");
@@ -548,6 +1072,12 @@ int main(int argc, char **argv)
     printf("%-26s %12.2f\n", "decode: blob 1MB",           measure(run_decode_blob, bb));
     printf("%-26s %12.2f\n", "decode: composite",          measure(run_decode_composite, bc));
     printf("%-26s %12.2f\n", "decode: composite skip-all", measure(run_decode_composite_skip, bc));
+    printf("%-26s %12.2f\n", "encode: u64 array (object)", measure(run_encode_u64_array_object, ba));
+    printf("%-26s %12.2f\n", "encode: typical (object)",   measure(run_encode_typical_object, bt));
+    printf("%-26s %12.2f\n", "encode: composite (object)", measure(run_encode_composite_object, bc));
+    printf("%-26s %12.2f\n", "decode: u64 array (object)", measure(run_decode_u64_array_object, ba));
+    printf("%-26s %12.2f\n", "decode: typical (object)",   measure(run_decode_typical_object, bt));
+    printf("%-26s %12.2f\n", "decode: composite (object)", measure(run_decode_composite_object, bc));
     printf("\nMB = 1e6 bytes. ~1s CPU-time loop per workload.\n");
     return 0;
 }
@@ -15,7 +15,14 @@
  *      CPU time (std::clock(), not wall-clock). MB = 1e6 bytes.
  *
  * Both metrics are gathered over the same adaptive ~1 s CPU-time loop, so they
- * describe the exact same work.
+ * describe the exact same work. The message is measured once through the raw
+ * stream API and once as a generated-style sofab::Message driven by
+ * OStreamObject / IStreamObject, the counterpart of perf.c's object API rows.
+ *
+ * `perf_cpp --counters` adds the same hardware event counts per operation as
+ * `perf_c --counters` (perf_events.h). `perf_cpp --alloc` instead counts heap
+ * allocations per operation of the four workloads (alloc_count.hpp) and exits
+ * non-zero if a heap-free one allocates.
  *
  * Thin subclasses expose the protected ctx_/buffer_ so the streams drive a
  * caller-owned buffer (no per-iteration allocation or zeroing), exactly like
@@ -26,6 +33,10 @@
 
 #include "sofab/sofab.hpp"
 
+#include "alloc_count.hpp"
+#include "perf_events.h"
+
+#include <array>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
@@ -182,6 +193,150 @@ void perf_decode(const uint8_t *buf, size_t len, PerfOut &out)
     is.feed(buf, len);
 }
 
+/* The same message as generated-style message classes. */
+struct PerfChild final : sofab::Message
+{
+    uint32_t u32 = 0;
+    int32_t  i32 = 0;
+
+    static constexpr size_t _maxSize = sofab::max_size_v<
+        sofab::Field<1, uint32_t>,
+        sofab::Field<2, int32_t>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        return _ostream
+            .writeIf(1, u32, u32 != 0)
+            .writeIf(2, i32, i32 != 0)
+        ;
+    }
+
+    void deserialize(sofab::IStreamImpl &_istream, sofab::id _id, size_t, size_t) noexcept override
+    {
+        switch (_id)
+        {
+            case 1: _istream.read(u32); break;
+            case 2: _istream.read(i32); break;
+            default: break;
+        }
+    }
+};
+
+struct PerfMsg final : sofab::Message
+{
+    uint32_t                u32 = 0;
+    int32_t                 i32 = 0;
+    uint64_t                u64 = 0;
+    int64_t                 i64 = 0;
+    bool                    b = false;
+    float                   f32 = 0.0f;
+    double                  f64 = 0.0;
+    sofab::FixedString<31>  str;
+    std::array<uint32_t, 8> samples{};
+    std::array<int32_t, 8>  deltas{};
+    std::array<double, 4>   fp64{};
+    PerfChild               child;
+
+    static constexpr size_t _maxSize = sofab::max_size_v<
+        sofab::Field<1, uint32_t>,
+        sofab::Field<2, int32_t>,
+        sofab::Field<3, uint64_t>,
+        sofab::Field<4, int64_t>,
+        sofab::Field<5, bool>,
+        sofab::Field<6, float>,
+        sofab::Field<7, double>,
+        sofab::Field<8, sofab::FixedString<31>>,
+        sofab::Field<9, std::array<uint32_t, 8>>,
+        sofab::Field<10, std::array<int32_t, 8>>,
+        sofab::Field<11, std::array<double, 4>>,
+        sofab::Field<12, PerfChild>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        return _ostream
+            .writeIf(1, u32, u32 != 0)
+            .writeIf(2, i32, i32 != 0)
+            .writeIf(3, u64, u64 != 0)
+            .writeIf(4, i64, i64 != 0)
+            .writeIf(5, b, b)
+            .writeIf(6, f32, f32 != 0.0f)
+            .writeIf(7, f64, f64 != 0.0)
+            .writeIf(8, str, !str.empty())
+            .writeIf(9, samples, samples != std::array<uint32_t, 8>{})
+            .writeIf(10, deltas, deltas != std::array<int32_t, 8>{})
+            .writeIf(11, fp64, fp64 != std::array<double, 4>{})
+            .writeLazy(12, child)
+        ;
+    }
+
+    void deserialize(sofab::IStreamImpl &_istream, sofab::id _id, size_t _size, size_t _count) noexcept override
+    {
+        switch (_id)
+        {
+            case 1:  _istream.read(u32); break;
+            case 2:  _istream.read(i32); break;
+            case 3:  _istream.read(u64); break;
+            case 4:  _istream.read(i64); break;
+            case 5:  _istream.read(b); break;
+            case 6:  _istream.read(f32); break;
+            case 7:  _istream.read(f64); break;
+            case 8:  _istream.readString(str, _size, str.capacity()); break;
+            case 9:  _istream.readArray(samples, _count, 8); break;
+            case 10: _istream.readArray(deltas, _count, 8); break;
+            case 11: _istream.readArray(fp64, _count, 4); break;
+            case 12: _istream.read(child); break;
+            default: break;
+        }
+    }
+};
+
+/* One populated OStreamObject, re-encoded by rewinding its inline buffer. */
+class PerfObjectStream : public sofab::OStreamObject<PerfMsg>
+{
+public:
+    void rewind() noexcept
+    {
+        sofab_ostream_buffer_set(&ctx_, buffer_, PerfMsg::_maxSize, 0);
+    }
+};
+
+PerfObjectStream perf_os;
+
+void perf_obj_make()
+{
+    PerfMsg &m = perf_os.operator->();
+    m.u32 = 0xDEADBEEFu;
+    m.i32 = -12345;
+    m.u64 = 0x0123456789ABCDEFull;
+    m.i64 = -5000000000000ll;
+    m.b   = true;
+    m.f32 = 3.14159f;
+    m.f64 = 2.718281828459045;
+    m.str = PERF_STRING;
+    std::memcpy(m.samples.data(), perf_samples, sizeof perf_samples);
+    std::memcpy(m.deltas.data(), perf_deltas, sizeof perf_deltas);
+    std::memcpy(m.fp64.data(), perf_fp64, sizeof perf_fp64);
+    m.child.u32 = 99;
+    m.child.i32 = -7;
+}
+
+size_t perf_obj_encode()
+{
+    perf_os.rewind();
+    perf_os.serialize();
+    return perf_os.bytesUsed();
+}
+
+/* A fresh IStreamObject per message, as a receiver uses it. */
+uint32_t perf_obj_decode(const uint8_t *buf, size_t len)
+{
+    sofab::IStreamObject<PerfMsg> is;
+    is.feed(buf, len);
+    return (*is).u32;
+}
+
 /*****************************************************************************/
 /* measurement                                                               */
 /*****************************************************************************/
@@ -199,6 +354,11 @@ double cpu_now()
     return (double)std::clock() / (double)CLOCKS_PER_SEC;
 }
 
+/* Hardware counters (--counters), bracketing the same timed loop as the cycle
+ * counter; perf_ev holds the last measurement's counts until it is reported. */
+perf_events_t perf_ev;
+bool          perf_ev_on = false;
+
 void perf_report(const char *what, PerfResult r, size_t bytes)
 {
     printf("\n--- perf: %s ---\n", what);
@@ -212,6 +372,8 @@ void perf_report(const char *what, PerfResult r, size_t bytes)
 #endif
     printf("  CPU time/op   : %.1f ns  (process CPU time, not wall-clock)\n", r.ns_op);
     printf("  throughput    : %.1f MB/s  (speedtest, MB = 1e6 bytes)\n", r.mb_s);
+    if (perf_ev_on)
+        perf_events_report(&perf_ev, r.iters);
 }
 
 /* Sample the CPU clock once per block of operations rather than once per
@@ -237,6 +399,8 @@ PerfResult measure_loop(F &&body, size_t bytes)
 
     unsigned long it = 0;
     double        el;
+    if (perf_ev_on)
+        perf_events_start(&perf_ev);
     uint64_t      c0 = perf_cycles();
     double        t0 = cpu_now();
     do {
@@ -246,6 +410,8 @@ PerfResult measure_loop(F &&body, size_t bytes)
         el = cpu_now() - t0;
     } while (el < 1.0);
     uint64_t c1 = perf_cycles();
+    if (perf_ev_on)
+        perf_events_stop(&perf_ev);
 
     return PerfResult{
         it,
@@ -281,13 +447,82 @@ PerfResult measure_decode(const uint8_t *buf, size_t len, PerfOut &out)
     return r;
 }
 
+PerfResult measure_obj_encode(size_t &msg_size)
+{
+    volatile size_t sink = 0;
+    size_t          msg  = 0;
+
+    for (unsigned i = 0; i < 1000u; i++) /* warmup */
+        msg = perf_obj_encode();
+    msg_size = msg;
+
+    PerfResult r = measure_loop([&] { sink = sink + perf_obj_encode(); }, msg);
+    (void)sink;
+    return r;
+}
+
+PerfResult measure_obj_decode(const uint8_t *buf, size_t len)
+{
+    volatile uint32_t sink = 0;
+
+    for (unsigned i = 0; i < 1000u; i++) /* warmup */
+        perf_obj_decode(buf, len);
+
+    PerfResult r = measure_loop([&] { sink = sink + perf_obj_decode(buf, len); }, len);
+    (void)sink;
+    return r;
+}
+
+/* The stream-API decode reads field 8 into a std::string, so it may allocate;
+ * the other three are the heap-free subset and must not. */
+int run_alloc()
+{
+    using alloc_count::Policy;
+    using alloc_count::check;
+
+    /* The sizes are taken inside the counted encode rows, which run before
+     * the decode rows that read them. */
+    uint8_t buffer[512];
+    size_t  msg_size = 0;
+    PerfOut out;
+    out.str.resize(32);
+    perf_obj_make();
+    size_t obj_size = 0;
+
+    printf("=== SofaBuffers C++ heap allocations per operation ===\n");
+    alloc_count::header();
+    bool ok = true;
+    ok &= check("serialize (stream API)", Policy::HeapFree,
+                [&] { msg_size = perf_encode(buffer, sizeof buffer); });
+    ok &= check("deserialize (stream API)", Policy::MayAllocate,
+                [&] { perf_decode(buffer, msg_size, out); });
+    ok &= check("serialize (message object)", Policy::HeapFree,
+                [&] { obj_size = perf_obj_encode(); });
+    ok &= check("deserialize (message object)", Policy::HeapFree,
+                [&] { perf_obj_decode(perf_os.data(), obj_size); });
+    if (!ok) {
+        fprintf(stderr, "perf: a heap-free workload allocated\n");
+        return 1;
+    }
+    return 0;
+}
+
 } // namespace
 
-int main()
+int main(int argc, char **argv)
 {
     uint8_t buffer[512];
     size_t  msg_size = 0;
 
+    if (argc >= 2 && !std::strcmp(argv[1], "--alloc"))
+        return run_alloc();
+    if (argc >= 2 && !std::strcmp(argv[1], "--counters"))
+        perf_ev_on = perf_events_open(&perf_ev);
+    else if (argc >= 2) {
+        fprintf(stderr, "usage: perf_cpp [--counters | --alloc]\n");
+        return 1;
+    }
+
     printf("=== SofaBuffers C++ per-op cost (cycles/op + throughput MB/s) ===\n");
 
     PerfResult enc = measure_encode(buffer, sizeof buffer, msg_size);
@@ -306,6 +541,28 @@ int main()
     PerfResult dec = measure_decode(buffer, msg_size, out);
     perf_report("deserialize (stream API)", dec, msg_size);
 
+    perf_obj_make();
+    size_t obj_size = 0;
+    PerfResult oenc = measure_obj_encode(obj_size);
+    perf_report("serialize (message object)", oenc, obj_size);
+
+    /* the two paths must agree on the wire, or the rows are not comparable */
+    sofab::IStreamObject<PerfMsg> check;
+    bool fed = check.feed(perf_os.data(), obj_size).code() == sofab::Error::None;
+    const PerfMsg &src = perf_os.operator->();
+    if (!fed || obj_size != msg_size || std::memcmp(perf_os.data(), buffer, msg_size) != 0
+        || (*check).u64 != src.u64 || std::string_view{(*check).str} != PERF_STRING
+        || (*check).fp64 != src.fp64 || (*check).child.i32 != -7)
+    {
+        fprintf(stderr, "perf: message object self-check failed\n");
+        return 1;
+    }
+
+    PerfResult odec = measure_obj_decode(perf_os.data(), obj_size);
+    perf_report("deserialize (message object)", odec, obj_size);
+
+    if (perf_ev_on)
+        perf_events_close(&perf_ev);
     printf("\ncycles/op tracks code cost; MB/s is this machine's throughput.\n");
     return 0;
 }
@@ -0,0 +1,191 @@
+/*!
+ * @file perf_events.h
+ * @brief SofaBuffers benchmarks — optional hardware event counters.
+ *
+ * Cycles/op says that a change regressed, not why. These counters split it:
+ * retired instructions (more work), branches and branch misses (the decoder's
+ * state switch mispredicting), L1D read misses (a layout or footprint
+ * change). Read through Linux perf_event_open(2), user space only, one
+ * counter per event rather than one group, so an event the PMU lacks does not
+ * take the others down with it. Counts are scaled for multiplexing.
+ *
+ * Shared by perf.c and perf.cpp (valid C and C++). Nothing is required: off
+ * Linux, or where the syscall is refused — a container without
+ * CAP_PERFMON, perf_event_paranoid above 2, a VM without a virtual PMU —
+ * perf_events_open() returns false and the tools report without counters.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_BENCH_PERF_EVENTS_H
+#define SOFAB_BENCH_PERF_EVENTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum
+{
+    PERF_EV_CYCLES,
+    PERF_EV_INSTRUCTIONS,
+    PERF_EV_BRANCHES,
+    PERF_EV_BRANCH_MISSES,
+    PERF_EV_L1D_MISSES,
+    PERF_EV_COUNT
+};
+
+static const char *const perf_ev_names[PERF_EV_COUNT] = {
+    "cycles", "instructions", "branches", "branch-misses", "L1D misses",
+};
+
+typedef struct
+{
+    int      fd[PERF_EV_COUNT];       /* -1: event unavailable */
+    uint64_t value[PERF_EV_COUNT];    /* counts of the last start/stop window */
+    bool     counted[PERF_EV_COUNT];  /* false: no count for that window */
+} perf_events_t;
+
+#if defined(__linux__)
+
+static int perf_events_open_one_(uint32_t type, uint64_t config)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/*!
+ * @brief Open every counter this host allows for the calling thread.
+ * @return true if at least one opened; otherwise prints why to stderr.
+ */
+static bool perf_events_open(perf_events_t *pe)
+{
+    static const struct { uint32_t type; uint64_t config; } ev[PERF_EV_COUNT] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                              | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                              | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    };
+    bool any = false;
+    int  err = 0;
+
+    for (int i = 0; i < PERF_EV_COUNT; i++) {
+        pe->fd[i] = perf_events_open_one_(ev[i].type, ev[i].config);
+        pe->value[i] = 0;
+        pe->counted[i] = false;
+        if (pe->fd[i] >= 0)
+            any = true;
+        else if (!err)
+            err = errno;
+    }
+    if (!any)
+        fprintf(stderr, "perf: hardware counters unavailable (perf_event_open: %s), "
+                        "reporting without them\n", strerror(err));
+    return any;
+}
+
+static void perf_events_start(perf_events_t *pe)
+{
+    for (int i = 0; i < PERF_EV_COUNT; i++)
+        if (pe->fd[i] >= 0) {
+            ioctl(pe->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(pe->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+}
+
+static void perf_events_stop(perf_events_t *pe)
+{
+    for (int i = 0; i < PERF_EV_COUNT; i++) {
+        uint64_t v[3]; /* value, time enabled, time running */
+
+        if (pe->fd[i] < 0)
+            continue;
+        ioctl(pe->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        /* unreadable, or never scheduled on the PMU: no count, not a zero */
+        if (read(pe->fd[i], v, sizeof v) != (ssize_t)sizeof v || v[2] == 0) {
+            pe->value[i] = 0;
+            pe->counted[i] = false;
+            continue;
+        }
+        pe->counted[i] = true;
+        /* scaled up if the PMU multiplexed this counter with others */
+        pe->value[i] = v[2] < v[1]
+            ? (uint64_t)((double)v[0] * (double)v[1] / (double)v[2])
+            : v[0];
+    }
+}
+
+static void perf_events_close(perf_events_t *pe)
+{
+    for (int i = 0; i < PERF_EV_COUNT; i++)
+        if (pe->fd[i] >= 0) {
+            close(pe->fd[i]);
+            pe->fd[i] = -1;
+        }
+}
+
+#else /* !__linux__ */
+
+static bool perf_events_open(perf_events_t *pe)
+{
+    for (int i = 0; i < PERF_EV_COUNT; i++) {
+        pe->fd[i] = -1;
+        pe->value[i] = 0;
+        pe->counted[i] = false;
+    }
+    fprintf(stderr, "perf: hardware counters need Linux perf_event_open, "
+                    "reporting without them\n");
+    return false;
+}
+
+static void perf_events_start(perf_events_t *pe) { (void)pe; }
+static void perf_events_stop(perf_events_t *pe) { (void)pe; }
+static void perf_events_close(perf_events_t *pe) { (void)pe; }
+
+#endif
+
+/*!
+ * @brief Print the last window's counts divided by @p ops, plus the derived
+ *        IPC and miss rate where both inputs were counted.
+ */
+static void perf_events_report(const perf_events_t *pe, unsigned long ops)
+{
+    for (int i = 0; i < PERF_EV_COUNT; i++) {
+        if (pe->fd[i] < 0 || !pe->counted[i])
+            printf("  %-14s: (unavailable)\n", perf_ev_names[i]);
+        else
+            printf("  %-14s: %.1f/op\n", perf_ev_names[i], (double)pe->value[i] / (double)ops);
+    }
+    if (pe->counted[PERF_EV_CYCLES] && pe->counted[PERF_EV_INSTRUCTIONS]
+        && pe->value[PERF_EV_CYCLES])
+        printf("  %-14s: %.2f\n", "IPC",
+               (double)pe->value[PERF_EV_INSTRUCTIONS] / (double)pe->value[PERF_EV_CYCLES]);
+    if (pe->counted[PERF_EV_BRANCHES] && pe->counted[PERF_EV_BRANCH_MISSES]
+        && pe->value[PERF_EV_BRANCHES])
+        printf("  %-14s: %.2f%%\n", "branch miss",
+               100.0 * (double)pe->value[PERF_EV_BRANCH_MISSES]
+                     / (double)pe->value[PERF_EV_BRANCHES]);
+}
+
+#endif /* SOFAB_BENCH_PERF_EVENTS_H */
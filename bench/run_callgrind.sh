@@ -11,6 +11,25 @@
 # script builds them if missing. Run via: cmake --build build --target
 # run_bench_callgrind   (or: BUILD=build bash bench/run_callgrind.sh)
 #
+# With the argument `micro` it instead runs every row of bench_micro (the
+# per-primitive matrix) and prints a tab-separated table of Ir per operation
+# and per item (target run_bench_micro_callgrind).
+#
+# With `sweep` it runs every point of `bench_c --sweep` (each dataset at each
+# feed chunk / output buffer size) and prints Ir per operation and per feed or
+# flush call (target run_bench_sweep_callgrind).
+#
+# With `cost` it decodes every input of `bench_cost --list` (the seeds and the
+# complexity corpus, test/fuzz/corpus/cost) and prints Ir per message and per
+# input byte, then the worst. If COST_MAX_IR_PER_BYTE is set, a worst input
+# above it fails the run (target run_bench_cost_callgrind).
+#
+# With `vectors` it encodes and decodes every conformance vector of
+# `bench_vectors --list` (assets/test_vectors.json) once each and prints Ir per
+# message for both directions, and per byte; extra arguments are captured
+# inputs passed on to bench_vectors, decoded only (target
+# run_bench_vectors_callgrind).
+#
 set -euo pipefail
 ROOT="$(cd "$(dirname "$0")/.." && pwd)"
 BUILD="${BUILD:-$ROOT/build}"
@@ -23,6 +42,105 @@ if ! command -v valgrind >/dev/null 2>&1; then
     exit 1
 fi
 
+if [ "${1:-}" = micro ]; then
+    MBIN="$BUILD/bench/bench_micro"
+    if [ ! -x "$MBIN" ]; then
+        echo ">> building bench_micro ..." >&2
+        cmake --build "$BUILD" --target bench_micro >/dev/null
+    fi
+    OUT="$(mktemp -d)"
+    trap 'rm -rf "$OUT"' EXIT
+    printf "workload\titems\tbytes\tIr/op\tIr/item\n"
+    for w in $("$MBIN" --list); do
+        valgrind --tool=callgrind --collect-atstart=no --toggle-collect=run_micro \
+            --callgrind-out-file="$OUT/$w.out" "$MBIN" "$w" >/dev/null 2>"$OUT/$w.log"
+        ir="$(grep -m1 '^summary:' "$OUT/$w.out" | awk '{print $2}')"
+        items="$(grep -ohE 'ITEMS=[0-9]+' "$OUT/$w.log" | cut -d= -f2)"
+        bytes="$(grep -ohE 'BYTES=[0-9]+' "$OUT/$w.log" | cut -d= -f2)"
+        awk -v w="$w" -v i="$items" -v b="$bytes" -v ir="$ir" \
+            'BEGIN{ printf "%s\t%s\t%s\t%s\t%.1f\n", w, i, b, ir, ir / i }'
+    done
+    exit 0
+fi
+
+if [ "${1:-}" = sweep ]; then
+    if [ ! -x "$CBIN" ]; then
+        echo ">> building bench_c ..." >&2
+        cmake --build "$BUILD" --target bench_c >/dev/null
+    fi
+    OUT="$(mktemp -d)"
+    trap 'rm -rf "$OUT"' EXIT
+    printf "dataset\top\tsize\tbytes\tcalls\tIr/op\tIr/call\n"
+    "$CBIN" --sweep list | while read -r ds op size; do
+        f="$OUT/$ds.$op.$size"
+        valgrind --tool=callgrind --collect-atstart=no --toggle-collect="run_sweep_$op" \
+            --callgrind-out-file="$f.out" "$CBIN" --sweep "$ds" "$op" "$size" \
+            >/dev/null 2>"$f.log"
+        ir="$(grep -m1 '^summary:' "$f.out" | awk '{print $2}')"
+        calls="$(grep -ohE 'CALLS=[0-9]+' "$f.log" | cut -d= -f2)"
+        bytes="$(grep -ohE 'BYTES=[0-9]+' "$f.log" | cut -d= -f2)"
+        awk -v d="$ds" -v o="$op" -v s="$size" -v b="$bytes" -v c="$calls" -v ir="$ir" \
+            'BEGIN{ printf "%s\t%s\t%s\t%s\t%s\t%s\t", d, o, s, b, c, ir;
+                    if (c > 0) printf "%.1f\n", ir / c; else printf "-\n" }'
+    done
+    exit 0
+fi
+
+if [ "${1:-}" = cost ]; then
+    KBIN="$BUILD/bench/bench_cost"
+    if [ ! -x "$KBIN" ]; then
+        echo ">> building bench_cost ..." >&2
+        cmake --build "$BUILD" --target bench_cost >/dev/null
+    fi
+    OUT="$(mktemp -d)"
+    trap 'rm -rf "$OUT"' EXIT
+    printf "input\tbytes\tIr/msg\tIr/byte\n"
+    i=0
+    "$KBIN" --list | while read -r name; do
+        valgrind --tool=callgrind --collect-atstart=no --toggle-collect=run_cost \
+            --callgrind-out-file="$OUT/$i.out" "$KBIN" --once "$name" >/dev/null 2>"$OUT/$i.log"
+        ir="$(grep -m1 '^summary:' "$OUT/$i.out" | awk '{print $2}')"
+        bytes="$(grep -ohE 'BYTES=[0-9]+' "$OUT/$i.log" | cut -d= -f2)"
+        awk -v n="$name" -v b="$bytes" -v ir="$ir" \
+            'BEGIN{ printf "%s\t%s\t%s\t%.1f\n", n, b, ir, b > 0 ? ir / b : 0 }'
+        i=$((i + 1))
+    done | tee "$OUT/table"
+    worst="$(sort -t"$(printf '\t')" -k4,4 -g "$OUT/table" | tail -1)"
+    printf "worst\t%s\n" "$worst"
+    if [ -n "${COST_MAX_IR_PER_BYTE:-}" ]; then
+        awk -v w="$(echo "$worst" | cut -f4)" -v m="$COST_MAX_IR_PER_BYTE" \
+            'BEGIN{ if (w > m) { printf "worst-case %.1f Ir/byte exceeds %s\n", w, m > "/dev/stderr"; exit 1 } }'
+    fi
+    exit 0
+fi
+
+if [ "${1:-}" = vectors ]; then
+    shift
+    VBIN="$BUILD/bench/bench_vectors"
+    if [ ! -x "$VBIN" ]; then
+        echo ">> building bench_vectors ..." >&2
+        cmake --build "$BUILD" --target bench_vectors >/dev/null
+    fi
+    OUT="$(mktemp -d)"
+    trap 'rm -rf "$OUT"' EXIT
+    printf "input\tbytes\tenc Ir/msg\tdec Ir/msg\tdec Ir/byte\n"
+    i=0
+    "$VBIN" --list "$@" | while read -r name; do
+        for dir in encode decode; do
+            valgrind --tool=callgrind --collect-atstart=no --toggle-collect="run_$dir" \
+                --callgrind-out-file="$OUT/$i.$dir.out" "$VBIN" --once "$name" "$@" \
+                >/dev/null 2>"$OUT/$i.$dir.log"
+        done
+        enc="$(grep -m1 '^summary:' "$OUT/$i.encode.out" | awk '{print $2}')"
+        dec="$(grep -m1 '^summary:' "$OUT/$i.decode.out" | awk '{print $2}')"
+        bytes="$(grep -ohE 'BYTES=[0-9]+' "$OUT/$i.decode.log" | cut -d= -f2)"
+        awk -v n="$name" -v b="$bytes" -v e="${enc:-0}" -v d="$dec" \
+            'BEGIN{ printf "%s\t%s\t%s\t%s\t%.1f\n", n, b, e > 0 ? e : "-", d, b > 0 ? d / b : 0 }'
+        i=$((i + 1))
+    done
+    exit 0
+fi
+
 if [ ! -x "$CBIN" ] || [ ! -x "$CPPBIN" ]; then
     echo ">> building bench_c / bench_cpp ..."
     cmake --build "$BUILD" --target bench_c bench_cpp >/dev/null
@@ -36,6 +154,11 @@ trap 'rm -rf "$OUT"' EXIT
 # of it, which under MB/s drowns in memory bandwidth. The optional
 # `blob 1MB passthrough` row is absent because this port does not implement
 # pass-through -- a port that does not omits the row rather than faking it.
+#
+# The `_object` rows move the same bytes through the layer applications use:
+# descriptors (sofab_object_encode / sofab_object_field_cb) in C, generated-
+# style message classes (OStreamObject / IStreamObject) in C++. Their distance
+# from the raw row above is what object.c, or the wrapper's dispatch, costs.
 WORKLOADS=(
     encode_u64_array
     encode_typical
@@ -47,6 +170,12 @@ WORKLOADS=(
     decode_blob
     decode_composite
     decode_composite_skip
+    encode_u64_array_object
+    encode_typical_object
+    encode_composite_object
+    decode_u64_array_object
+    decode_typical_object
+    decode_composite_object
 )
 
 run_cg() { # $1 binary, $2 tag, $3 workload
@@ -76,6 +205,12 @@ label() {
         decode_blob)           echo "decode: blob 1MB";;
         decode_composite)      echo "decode: composite";;
         decode_composite_skip) echo "decode: composite skip-all";;
+        encode_u64_array_object) echo "encode: u64 array (object)";;
+        encode_typical_object)   echo "encode: typical (object)";;
+        encode_composite_object) echo "encode: composite (object)";;
+        decode_u64_array_object) echo "decode: u64 array (object)";;
+        decode_typical_object)   echo "decode: typical (object)";;
+        decode_composite_object) echo "decode: composite (object)";;
     esac
 }
 
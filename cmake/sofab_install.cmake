@@ -16,6 +16,35 @@ install(TARGETS sofabuffers
     RUNTIME DESTINATION ${CMAKE_INSTALL_BINDIR}
     INCLUDES DESTINATION ${CMAKE_INSTALL_INCLUDEDIR})
 
+# The batch library, where it was built (see src/CMakeLists.txt), is exported
+# alongside as `sofa-buffers::batch`; the package config then pulls in Threads.
+set(SOFAB_CONFIG_THREADS OFF)
+if(TARGET sofabuffers_batch)
+    set(SOFAB_CONFIG_THREADS ON)
+    set_target_properties(sofabuffers_batch PROPERTIES EXPORT_NAME batch)
+    install(TARGETS sofabuffers_batch
+        EXPORT ${SOFAB_PACKAGE_NAME}-targets
+        ARCHIVE DESTINATION ${CMAKE_INSTALL_LIBDIR}
+        LIBRARY DESTINATION ${CMAKE_INSTALL_LIBDIR}
+        RUNTIME DESTINATION ${CMAKE_INSTALL_BINDIR}
+        INCLUDES DESTINATION ${CMAKE_INSTALL_INCLUDEDIR})
+endif()
+
+# The POSIX adapters likewise, as `sofa-buffers::posix`; with the background
+# sink in them they need Threads as well.
+if(TARGET sofabuffers_posix)
+    if(SOFAB_HAVE_BGSINK)
+        set(SOFAB_CONFIG_THREADS ON)
+    endif()
+    set_target_properties(sofabuffers_posix PROPERTIES EXPORT_NAME posix)
+    install(TARGETS sofabuffers_posix
+        EXPORT ${SOFAB_PACKAGE_NAME}-targets
+        ARCHIVE DESTINATION ${CMAKE_INSTALL_LIBDIR}
+        LIBRARY DESTINATION ${CMAKE_INSTALL_LIBDIR}
+        RUNTIME DESTINATION ${CMAKE_INSTALL_BINDIR}
+        INCLUDES DESTINATION ${CMAKE_INSTALL_INCLUDEDIR})
+endif()
+
 # Public headers: src/include/sofab/*.{h,hpp} -> <prefix>/include/sofab/.
 install(DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}/include/sofab
     DESTINATION ${CMAKE_INSTALL_INCLUDEDIR})
@@ -8,11 +8,12 @@ required_conan_version = ">=2.0"
 
 # Optional feature toggles: Conan option name -> upstream SOFAB_DISABLE_* macro.
 # Each option is positive-sense (True = feature present); a False value disables
-# the feature by defining the corresponding macro. Object-API selects a source
-# file; the rest are compile-time guards that also appear in the public headers,
+# the feature by defining the corresponding macro. Object-API and framing select
+# a source file; the rest are compile-time guards that also appear in the public headers,
 # so they are re-exported as cpp_info.defines below.
 _SOFAB_FEATURES = {
     "object_api": "SOFAB_DISABLE_OBJECT_API",
+    "framing": "SOFAB_DISABLE_FRAMING",
     "array": "SOFAB_DISABLE_ARRAY_SUPPORT",
     "sequence": "SOFAB_DISABLE_SEQUENCE_SUPPORT",
     "fixlen": "SOFAB_DISABLE_FIXLEN_SUPPORT",
@@ -23,7 +24,7 @@ _SOFAB_FEATURES = {
 
 # Macros consumed only by the .c sources (not the public headers); no need to
 # propagate these to downstream compilations.
-_SOFAB_SOURCE_ONLY_MACROS = {"SOFAB_DISABLE_OBJECT_API"}
+_SOFAB_SOURCE_ONLY_MACROS = {"SOFAB_DISABLE_OBJECT_API", "SOFAB_DISABLE_FRAMING"}
 
 
 class SofaBuffersCorelibConan(ConanFile):
@@ -48,6 +49,7 @@ class SofaBuffersCorelibConan(ConanFile):
         "fPIC": [True, False],
         # Feature toggles (all default to on / full wire format).
         "object_api": [True, False],
+        "framing": [True, False],
         "array": [True, False],
         "sequence": [True, False],
         "fixlen": [True, False],
@@ -59,6 +61,7 @@ class SofaBuffersCorelibConan(ConanFile):
         "shared": False,
         "fPIC": True,
         "object_api": True,
+        "framing": True,
         "array": True,
         "sequence": True,
         "fixlen": True,
@@ -96,6 +99,10 @@ class SofaBuffersCorelibConan(ConanFile):
         tc.variables["SOFAB_INSTALL"] = True
         tc.variables["SOFAB_BUILD_TESTS"] = False
         tc.variables["SOFAB_ENABLE_BENCH"] = False
+        # The pthread batch library and the POSIX adapters are separate targets
+        # that package_info() does not describe; keep them out of the package.
+        tc.variables["SOFAB_DISABLE_BATCH"] = True
+        tc.variables["SOFAB_DISABLE_POSIX"] = True
         # A disabled feature (option False) sets its SOFAB_DISABLE_* CMake option.
         for opt, macro in _SOFAB_FEATURES.items():
             tc.variables[macro] = not getattr(self.options, opt)
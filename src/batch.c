@@ -0,0 +1,852 @@
+/*!
+ * @file batch.c
+ * @brief SofaBuffers C - Parallel batch encode and decode on POSIX threads.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* pthreads are POSIX, not C99; the library itself is built with extensions off */
+#define _POSIX_C_SOURCE 200809L
+
+#define SOFAB_BATCH_C
+
+/* includes *******************************************************************/
+#include "sofab/batch.h"
+#include "sofab/framing.h"
+#include "scan.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* constants ******************************************************************/
+
+/* First segment size of an encode run, before it grows by doubling. */
+#define BATCH_SEGMENT_INITIAL   (4096)
+
+/* types **********************************************************************/
+
+/*!
+ * @brief Thread bookkeeping; the first member of every run, so that
+ *        _run_workers() can start and join runs of any kind.
+ */
+typedef struct
+{
+    pthread_t tid;                      /*!< Thread working this run */
+    int started;                        /*!< Whether @c tid was created */
+} _worker_t;
+
+/*!
+ * @brief One encode run: a contiguous slice of the source objects.
+ */
+typedef struct
+{
+    _worker_t worker;                   /*!< Must come first */
+    const sofab_object_descr_t *info;   /*!< Descriptor of every object */
+    const uint8_t *src;                 /*!< First object of the run */
+    size_t stride;                      /*!< Distance between objects */
+    size_t n;                           /*!< Objects in the run */
+    uint8_t *seg;                       /*!< Heap segment holding the run's frames */
+    size_t seglen;                      /*!< Bytes of @c seg in use */
+    size_t segcap;                      /*!< Bytes of @c seg allocated */
+    uint8_t *out;                       /*!< Where the segment goes in the output */
+    sofab_ret_t ret;                    /*!< Outcome of the run */
+} _encode_run_t;
+
+/*!
+ * @brief One decode run: a contiguous range of indexed frames.
+ */
+typedef struct
+{
+    _worker_t worker;                   /*!< Must come first */
+    sofab_object_decoder_t *dec;        /*!< The run's own decoder chain */
+    const uint8_t *frames;              /*!< First frame of the run */
+    size_t len;                         /*!< Bytes of frames in the run */
+    uint8_t *dst;                       /*!< First destination object */
+    size_t stride;                      /*!< Distance between objects */
+    size_t n;                           /*!< Frames in the run */
+    sofab_ret_t *status;                /*!< First verdict slot */
+    size_t count;                       /*!< Records decoded */
+    sofab_ret_t ret;                    /*!< Outcome of the run */
+} _decode_run_t;
+
+/*!
+ * @brief One element of the wrapper array: its id and its body, the bytes from
+ *        after its header up to (not including) its sequence end.
+ */
+typedef struct
+{
+    size_t start;                       /*!< First byte of the body */
+    size_t end;                         /*!< Offset of the element's sequence end */
+    sofab_id_t id;                      /*!< Element id, i.e. its index */
+} _element_t;
+
+/*!
+ * @brief What the structural scan found.
+ */
+typedef struct
+{
+    _element_t *list;                   /*!< Elements in wire order */
+    size_t count;                       /*!< Entries of @c list in use */
+    size_t cap;                         /*!< Entries of @c list allocated */
+    unsigned occurrences;               /*!< Times the array opened at the top level */
+    int ascending;                      /*!< Whether the element ids strictly ascend */
+} _scan_t;
+
+/*!
+ * @brief One element run: a slice of the scanned elements.
+ */
+typedef struct
+{
+    _worker_t worker;                   /*!< Must come first */
+    const sofab_object_descr_t *holder; /*!< Descriptor of the wrapper array */
+    uint8_t *holder_dst;                /*!< The wrapper array in the destination */
+    sofab_object_decoder_t *dec;        /*!< The run's own element decoder chain */
+    uint8_t depth;                      /*!< Nesting levels left inside an element */
+    const uint8_t *msg;                 /*!< The message */
+    const _element_t *list;             /*!< First element of the run */
+    size_t n;                           /*!< Elements in the run */
+    sofab_ret_t ret;                    /*!< Outcome of the run */
+} _seq_run_t;
+
+/* functions ******************************************************************/
+
+/*!
+ * @brief Number of runs to split @p n records into.
+ *
+ * @param n        Records in the batch.
+ * @param threads  Threads the caller allows.
+ * @return Between 1 and @p threads, and no more than one run per
+ *         @ref SOFAB_BATCH_MIN_RUN records.
+ */
+static unsigned _runs (size_t n, unsigned threads)
+{
+    size_t runs = n / SOFAB_BATCH_MIN_RUN;
+
+    if (runs < 1)
+    {
+        runs = 1;
+    }
+
+    return runs < threads ? (unsigned)runs : threads;
+}
+
+/*!
+ * @brief Work all runs: run 0 on the calling thread, the others on threads of
+ *        their own, and return once all are done.
+ *
+ * A thread that cannot be created is not an error: its run is worked on the
+ * calling thread instead, after run 0.
+ *
+ * @param runs   Array of run structures, each starting with a @ref _worker_t.
+ * @param size   Size of one run structure.
+ * @param count  Number of runs.
+ * @param fn     Worker function, called with a pointer to its run.
+ */
+static void _run_workers (void *runs, size_t size, unsigned count, void *(*fn) (void *))
+{
+    uint8_t *p = (uint8_t *)runs;
+    unsigned t;
+
+    for (t = 1; t < count; t++)
+    {
+        _worker_t *w = (_worker_t *)(p + t * size);
+        w->started = pthread_create(&w->tid, NULL, fn, w) == 0;
+    }
+
+    fn(p);
+
+    for (t = 1; t < count; t++)
+    {
+        _worker_t *w = (_worker_t *)(p + t * size);
+        if (w->started)
+        {
+            pthread_join(w->tid, NULL);
+        }
+        else
+        {
+            fn(w);
+        }
+    }
+}
+
+/*!
+ * @brief Grow an encode run's segment to at least twice its size.
+ *
+ * @param run  Encode run.
+ * @return 0 on success, -1 if the memory cannot be had.
+ */
+static int _segment_grow (_encode_run_t *run)
+{
+    size_t cap = run->segcap ? run->segcap * 2 : BATCH_SEGMENT_INITIAL;
+    uint8_t *seg;
+
+    if (cap < run->segcap)
+    {
+        return -1;
+    }
+
+    seg = (uint8_t *)realloc(run->seg, cap);
+    if (seg == NULL)
+    {
+        return -1;
+    }
+
+    run->seg = seg;
+    run->segcap = cap;
+
+    return 0;
+}
+
+/*!
+ * @brief Encode worker: frame every object of the run into its segment.
+ *
+ * Each frame is encoded straight into the free tail of the segment and then
+ * moved down over the unused head of the prefix room, so the frames lie back
+ * to back. An object that does not fit grows the segment and is encoded again.
+ *
+ * @param arg  The @ref _encode_run_t.
+ * @return NULL.
+ */
+static void *_encode_worker (void *arg)
+{
+    _encode_run_t *run = (_encode_run_t *)arg;
+    size_t i;
+
+    run->ret = SOFAB_RET_OK;
+
+    for (i = 0; i < run->n; i++)
+    {
+        const void *obj = run->src + i * run->stride;
+        sofab_ostream_t os;
+        uint8_t *frame;
+        size_t framelen;
+        sofab_ret_t ret;
+
+        for (;;)
+        {
+            if (run->segcap - run->seglen < SOFAB_FRAMING_PREFIX_MAX && _segment_grow(run) != 0)
+            {
+                run->ret = SOFAB_RET_E_ARGUMENT;
+                return NULL;
+            }
+
+            sofab_framing_begin(&os, run->seg + run->seglen, run->segcap - run->seglen);
+            ret = sofab_object_encode(&os, run->info, obj);
+            if (ret != SOFAB_RET_E_BUFFER_FULL)
+            {
+                break;
+            }
+            if (_segment_grow(run) != 0)
+            {
+                run->ret = SOFAB_RET_E_ARGUMENT;
+                return NULL;
+            }
+        }
+
+        if (ret == SOFAB_RET_OK)
+        {
+            ret = sofab_framing_end(&os, &frame, &framelen);
+        }
+        if (ret != SOFAB_RET_OK)
+        {
+            run->ret = ret;
+            return NULL;
+        }
+
+        memmove(run->seg + run->seglen, frame, framelen);
+        run->seglen += framelen;
+    }
+
+    return NULL;
+}
+
+/*!
+ * @brief Stitch worker: copy the run's segment to its place in the output.
+ *
+ * @param arg  The @ref _encode_run_t.
+ * @return NULL.
+ */
+static void *_stitch_worker (void *arg)
+{
+    _encode_run_t *run = (_encode_run_t *)arg;
+
+    if (run->seglen)
+    {
+        memcpy(run->out, run->seg, run->seglen);
+    }
+
+    return NULL;
+}
+
+/*!
+ * @brief Decode worker: decode the run's frames into its destinations.
+ *
+ * @param arg  The @ref _decode_run_t.
+ * @return NULL.
+ */
+static void *_decode_worker (void *arg)
+{
+    _decode_run_t *run = (_decode_run_t *)arg;
+
+    run->ret = sofab_object_decode_batch(run->dec, run->frames, run->len, run->dst,
+        run->stride, run->n, run->status, &run->count, NULL);
+
+    return NULL;
+}
+
+/*!
+ * @brief Record one element in the scan result.
+ *
+ * @return 0 on success, -1 if the list cannot grow.
+ */
+static int _scan_push (_scan_t *scan, sofab_id_t id, size_t start, size_t end)
+{
+    if (scan->count == scan->cap)
+    {
+        size_t cap = scan->cap ? scan->cap * 2 : 1024;
+        _element_t *list = (_element_t *)realloc(scan->list, cap * sizeof(*list));
+
+        if (list == NULL)
+        {
+            return -1;
+        }
+        scan->list = list;
+        scan->cap = cap;
+    }
+
+    if (scan->count != 0 && id <= scan->list[scan->count - 1].id)
+    {
+        scan->ascending = 0;
+    }
+    scan->list[scan->count].id = id;
+    scan->list[scan->count].start = start;
+    scan->list[scan->count].end = end;
+    scan->count++;
+
+    return 0;
+}
+
+/*!
+ * @brief Structural scan: walk a whole message and record the elements of the
+ *        top-level wrapper array @p id.
+ *
+ * Every sequence that opens directly inside that array is an element; its body
+ * is everything up to the sequence end that brings the nesting back to the
+ * array's level. Only the framing is followed, nothing is decoded or checked
+ * against a descriptor.
+ *
+ * @param msg   The message.
+ * @param len   Length of @p msg.
+ * @param id    Id of the wrapper array field.
+ * @param scan  Receives the elements (zero-initialized by the caller).
+ * @return 0 if the message is well-framed and complete, -1 otherwise (or if
+ *         memory ran out); the caller then decodes serially.
+ */
+static int _scan_message (const uint8_t *msg, size_t len, sofab_id_t id, _scan_t *scan)
+{
+    const uint8_t *p = msg, *end = msg + len;
+    unsigned depth = 0;
+    int in_array = 0;
+    size_t element = 0;
+    sofab_id_t element_id = 0;
+
+    scan->ascending = 1;
+
+    while (p != end)
+    {
+        const uint8_t *header = p;
+        sofab_id_t field;
+        uint8_t type;
+
+        if (sofab_scan_header(&p, end, &field, &type) != 0)
+        {
+            return -1;
+        }
+
+        if (type == SOFAB_TYPE_SEQUENCE_START)
+        {
+            if (depth == SOFAB_MAX_DEPTH)
+            {
+                return -1;
+            }
+            if (depth == 0 && field == id)
+            {
+                in_array = 1;
+                scan->occurrences++;
+            }
+            else if (depth == 1 && in_array)
+            {
+                element = (size_t)(p - msg);
+                element_id = field;
+            }
+            depth++;
+        }
+        else if (type == SOFAB_TYPE_SEQUENCE_END)
+        {
+            if (depth == 0)
+            {
+                return -1;
+            }
+            depth--;
+            if (depth == 1 && in_array)
+            {
+                if (_scan_push(scan, element_id, element, (size_t)(header - msg)) != 0)
+                {
+                    return -1;
+                }
+            }
+            else if (depth == 0)
+            {
+                in_array = 0;
+            }
+        }
+        else if (sofab_scan_value(&p, end, type) != 0)
+        {
+            return -1;
+        }
+    }
+
+    return depth == 0 ? 0 : -1;
+}
+
+/*!
+ * @brief Find the slot of element @p id in a wrapper array descriptor.
+ *
+ * @return The slot's field descriptor, or NULL for an over-index id.
+ */
+static const sofab_object_descr_field_t *_holder_slot (
+    const sofab_object_descr_t *holder, sofab_id_t id)
+{
+    size_t i;
+
+    /* the slots are normally listed in id order */
+    if (id < holder->field_count && holder->field_list[id].id == id)
+    {
+        return &holder->field_list[id];
+    }
+    for (i = 0; i < holder->field_count; i++)
+    {
+        if (holder->field_list[i].id == id)
+        {
+            return &holder->field_list[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*!
+ * @brief Element worker: decode the bodies of the run's elements into their slots.
+ *
+ * Each body is decoded as the message of its element type, exactly as the
+ * serial decode does it through the nested decoder. An element type that is
+ * itself a wrapper array is reset first, because the serial decode resets it
+ * every time the element opens (MESSAGE_SPEC §7.4) and a repeated id must not
+ * merge here either.
+ *
+ * @param arg  The @ref _seq_run_t.
+ * @return NULL.
+ */
+static void *_seq_worker (void *arg)
+{
+    _seq_run_t *run = (_seq_run_t *)arg;
+    size_t i;
+
+    run->ret = SOFAB_RET_OK;
+
+    for (i = 0; i < run->n; i++)
+    {
+        const _element_t *e = &run->list[i];
+        const sofab_object_descr_field_t *slot = _holder_slot(run->holder, e->id);
+        sofab_istream_t is;
+
+        if (slot == NULL)
+        {
+            continue;   /* over-index: the decode of the rest rejected it already */
+        }
+
+        run->dec->info = run->holder->nested_list[slot->nested_idx];
+        run->dec->dst = run->holder_dst + slot->offset;
+        run->dec->depth = run->depth;
+        if (run->dec->info->fixed_seq)
+        {
+            sofab_object_init(run->dec->info, run->dec->dst);
+        }
+
+        sofab_istream_init(&is, sofab_object_field_cb, run->dec);
+        if (sofab_istream_feed(&is, run->msg + e->start, e->end - e->start) != SOFAB_RET_OK)
+        {
+            run->ret = SOFAB_RET_E_INVALID_MSG;
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
+/*!
+ * @brief The serial decode of a whole message.
+ */
+static sofab_ret_t _decode_serial (
+    const sofab_object_descr_t *info, uint8_t depth, const void *msg, size_t len, void *dst)
+{
+    sofab_object_decoder_t *dec;
+    sofab_istream_t is;
+    sofab_ret_t ret;
+
+    dec = (sofab_object_decoder_t *)calloc(depth + 1u, sizeof(*dec));
+    if (dec == NULL)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    dec[0].info = info;
+    dec[0].dst = (uint8_t *)dst;
+    dec[0].depth = depth;
+    sofab_istream_init(&is, sofab_object_field_cb, dec);
+    ret = sofab_istream_feed(&is, msg, len);
+
+    free(dec);
+
+    return ret;
+}
+
+//
+
+extern sofab_ret_t sofab_batch_encode (
+    const sofab_object_descr_t *info,
+    const void *src,
+    size_t stride,
+    size_t n,
+    unsigned threads,
+    uint8_t *out,
+    size_t outlen,
+    size_t *used)
+{
+    _encode_run_t *runs;
+    sofab_ret_t ret = SOFAB_RET_OK;
+    size_t first = 0, total = 0;
+    unsigned nruns, t;
+
+    assert(info != NULL);
+    assert(src != NULL || n == 0);
+    assert(out != NULL || outlen == 0);
+    assert(threads >= 1);
+    assert(used != NULL);
+
+    *used = 0;
+    if (n == 0)
+    {
+        return SOFAB_RET_OK;
+    }
+
+    nruns = _runs(n, threads);
+    runs = (_encode_run_t *)calloc(nruns, sizeof(*runs));
+    if (runs == NULL)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    for (t = 0; t < nruns; t++)
+    {
+        runs[t].info = info;
+        runs[t].src = (const uint8_t *)src + first * stride;
+        runs[t].stride = stride;
+        runs[t].n = n / nruns + (t < n % nruns);
+        first += runs[t].n;
+    }
+
+    _run_workers(runs, sizeof(*runs), nruns, _encode_worker);
+
+    /* the first failing object, in record order, decides */
+    for (t = 0; t < nruns && ret == SOFAB_RET_OK; t++)
+    {
+        ret = runs[t].ret;
+        runs[t].out = out + total;
+        total += runs[t].seglen;
+    }
+
+    if (ret == SOFAB_RET_OK)
+    {
+        *used = total;
+        if (total > outlen)
+        {
+            ret = SOFAB_RET_E_BUFFER_FULL;
+        }
+        else
+        {
+            _run_workers(runs, sizeof(*runs), nruns, _stitch_worker);
+        }
+    }
+
+    for (t = 0; t < nruns; t++)
+    {
+        free(runs[t].seg);
+    }
+    free(runs);
+
+    return ret;
+}
+
+extern sofab_ret_t sofab_batch_decode (
+    const sofab_object_descr_t *info,
+    uint8_t depth,
+    const void *frames,
+    size_t len,
+    void *dst,
+    size_t stride,
+    size_t n,
+    sofab_ret_t *status,
+    unsigned threads,
+    size_t *count,
+    size_t *used)
+{
+    const uint8_t *p = (const uint8_t *)frames;
+    sofab_object_decoder_t *decs;
+    _decode_run_t *runs;
+    size_t *index;
+    size_t i, off = 0, first = 0;
+    sofab_ret_t ret = SOFAB_RET_OK;
+    unsigned nruns, t;
+
+    assert(info != NULL);
+    assert(frames != NULL || len == 0);
+    assert(dst != NULL || n == 0);
+    assert(status != NULL || n == 0);
+    assert(threads >= 1);
+    assert(count != NULL);
+
+    /* every frame takes at least its one-byte prefix, so len bounds the count */
+    if (n > len)
+    {
+        n = len;
+    }
+
+    index = (size_t *)malloc((n + 1) * sizeof(*index));
+    if (index == NULL)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    /* the frame index: where each of the records to decode starts */
+    for (i = 0; i < n && off != len; i++)
+    {
+        size_t prefixlen, msglen;
+
+        ret = sofab_framing_next(p + off, len - off, &prefixlen, &msglen);
+        if (ret != SOFAB_RET_OK)
+        {
+            break;
+        }
+        index[i] = off;
+        off += prefixlen + msglen;
+    }
+    index[i] = off;
+    n = i;
+
+    nruns = _runs(n, threads);
+    runs = (_decode_run_t *)calloc(nruns, sizeof(*runs));
+    decs = (sofab_object_decoder_t *)calloc((size_t)nruns * (depth + 1u), sizeof(*decs));
+    if (runs == NULL || decs == NULL)
+    {
+        free(decs);
+        free(runs);
+        free(index);
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    /* runs of about equal bytes rather than records, so that a stretch of
+       large records does not leave one thread with most of the work */
+    for (t = 0; t < nruns; t++)
+    {
+        size_t last = n;
+
+        if (t + 1 < nruns)
+        {
+            size_t target = off / nruns * (t + 1);
+
+            last = first;
+            while (last < n && index[last] < target)
+            {
+                last++;
+            }
+        }
+
+        runs[t].dec = decs + (size_t)t * (depth + 1u);
+        runs[t].dec->info = info;
+        runs[t].dec->depth = depth;
+        runs[t].frames = p + index[first];
+        runs[t].len = index[last] - index[first];
+        runs[t].dst = (uint8_t *)dst + first * stride;
+        runs[t].stride = stride;
+        runs[t].n = last - first;
+        runs[t].status = status + first;
+        first = last;
+    }
+
+    _run_workers(runs, sizeof(*runs), nruns, _decode_worker);
+
+    /* a run ends early only on a defective descriptor; the first one decides */
+    *count = n;
+    for (t = 0; t < nruns; t++)
+    {
+        if (runs[t].ret != SOFAB_RET_OK)
+        {
+            ret = runs[t].ret;
+            *count = (size_t)(runs[t].status - status) + runs[t].count;
+            break;
+        }
+    }
+    if (used != NULL)
+    {
+        *used = index[*count];
+    }
+
+    free(decs);
+    free(runs);
+    free(index);
+
+    return ret;
+}
+
+extern sofab_ret_t sofab_batch_decode_seq (
+    const sofab_object_descr_t *info,
+    uint8_t depth,
+    sofab_id_t id,
+    const void *msg,
+    size_t len,
+    void *dst,
+    unsigned threads)
+{
+    const uint8_t *p = (const uint8_t *)msg;
+    const sofab_object_descr_field_t *field = NULL;
+    const sofab_object_descr_t *holder;
+    sofab_object_decoder_t *decs;
+    _seq_run_t *runs;
+    _scan_t scan;
+    sofab_istream_t is;
+    sofab_ret_t ret = SOFAB_RET_OK;
+    size_t i, from, first = 0;
+    unsigned nruns, t;
+
+    assert(info != NULL);
+    assert(msg != NULL || len == 0);
+    assert(dst != NULL);
+    assert(threads >= 1);
+
+    /* the form the two phases handle: a top-level sequence field whose nested
+       descriptor is a holder of nested objects, reachable with the depth given */
+    for (i = 0; i < info->field_count && field == NULL; i++)
+    {
+        if (info->field_list[i].id == id)
+        {
+            field = &info->field_list[i];
+        }
+    }
+    if (threads < 2 || depth < 2 || field == NULL
+        || field->type != SOFAB_OBJECT_FIELDTYPE_SEQUENCE)
+    {
+        return _decode_serial(info, depth, msg, len, dst);
+    }
+    holder = info->nested_list[field->nested_idx];
+    if (!(holder->fixed_seq & SOFAB_OBJECT_SEQ_HOLDER) || holder->field_count == 0)
+    {
+        return _decode_serial(info, depth, msg, len, dst);
+    }
+    for (i = 0; i < holder->field_count; i++)
+    {
+        if (holder->field_list[i].type != SOFAB_OBJECT_FIELDTYPE_SEQUENCE)
+        {
+            return _decode_serial(info, depth, msg, len, dst);
+        }
+    }
+
+    /* phase 1: where the elements are */
+    memset(&scan, 0, sizeof(scan));
+    if (_scan_message(p, len, id, &scan) != 0 || scan.occurrences != 1)
+    {
+        free(scan.list);
+        return _decode_serial(info, depth, msg, len, dst);
+    }
+
+    nruns = scan.ascending ? _runs(scan.count, threads) : 1;
+    runs = (_seq_run_t *)calloc(nruns, sizeof(*runs));
+    decs = (sofab_object_decoder_t *)calloc((size_t)depth + 1u + (size_t)nruns * (depth - 1u),
+                                            sizeof(*decs));
+    if (runs == NULL || decs == NULL)
+    {
+        free(decs);
+        free(runs);
+        free(scan.list);
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    /* phase 2a: the message without the element bodies. Each body is cut out
+       between its header and its sequence end, so the elements still open and
+       close on the wire: the holder is reset, the sized count observed and an
+       over-index element rejected here, as in the serial decode. */
+    decs[0].info = info;
+    decs[0].dst = (uint8_t *)dst;
+    decs[0].depth = depth;
+    sofab_istream_init(&is, sofab_object_field_cb, decs);
+    for (i = 0, from = 0; i < scan.count && (ret == SOFAB_RET_OK || ret == SOFAB_RET_INCOMPLETE); i++)
+    {
+        ret = sofab_istream_feed(&is, p + from, scan.list[i].start - from);
+        from = scan.list[i].end;
+    }
+    if (ret == SOFAB_RET_OK || ret == SOFAB_RET_INCOMPLETE)
+    {
+        ret = sofab_istream_feed(&is, p + from, len - from);
+    }
+
+    /* phase 2b: the bodies, in runs of about equal bytes */
+    if (ret == SOFAB_RET_OK && scan.count != 0)
+    {
+        size_t base = scan.list[0].start;
+        size_t span = scan.list[scan.count - 1].end - base;
+
+        for (t = 0; t < nruns; t++)
+        {
+            size_t last = scan.count;
+
+            if (t + 1 < nruns)
+            {
+                size_t target = base + span / nruns * (t + 1);
+
+                last = first;
+                while (last < scan.count && scan.list[last].start < target)
+                {
+                    last++;
+                }
+            }
+
+            runs[t].holder = holder;
+            runs[t].holder_dst = (uint8_t *)dst + field->offset;
+            runs[t].dec = decs + depth + 1u + (size_t)t * (depth - 1u);
+            runs[t].depth = (uint8_t)(depth - 2u);
+            runs[t].msg = p;
+            runs[t].list = scan.list + first;
+            runs[t].n = last - first;
+            first = last;
+        }
+
+        _run_workers(runs, sizeof(*runs), nruns, _seq_worker);
+
+        for (t = 0; t < nruns; t++)
+        {
+            if (runs[t].ret != SOFAB_RET_OK)
+            {
+                ret = runs[t].ret;
+                break;
+            }
+        }
+    }
+
+    free(decs);
+    free(runs);
+    free(scan.list);
+
+    return ret;
+}
@@ -0,0 +1,212 @@
+/*!
+ * @file bgsink.c
+ * @brief SofaBuffers C - Output stream sink flushed by a background thread.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* pthreads are POSIX, not C99; the library itself is built with extensions off */
+#define _POSIX_C_SOURCE 200809L
+
+#define SOFAB_BGSINK_C
+
+/* includes *******************************************************************/
+#include "sofab/bgsink.h"
+
+#include <assert.h>
+#include <errno.h>
+
+/* functions ******************************************************************/
+
+/*
+ * The ring: buffer i % SOFAB_BGSINK_BUFFERS is queued once tail has passed i
+ * and handed back once head has. Only the encoder advances tail and only the
+ * writer thread head, each publishing with a release store that the other
+ * side's acquire load pairs with, so the filled lengths and bytes are visible
+ * before the counter is. C99 has no <stdatomic.h>; the GCC/Clang __atomic
+ * builtins stand in.
+ *
+ * Sleeping: a side about to sleep raises its flag, then looks at the other's
+ * counter once more; a side that has just advanced its counter looks at the
+ * other's flag. Both are sequentially consistent, so at least one of them
+ * sees the other, and a wake-up is never lost. The flag is raised and the
+ * wait begun under the lock, and the waker signals under it, so the signal
+ * cannot fall between the two.
+ */
+
+static uint8_t *_segment (const sofab_bgsink_t *sink, unsigned i)
+{
+    return sink->buffer + (size_t)(i % SOFAB_BGSINK_BUFFERS) * sink->seglen;
+}
+
+static void _wake (sofab_bgsink_t *sink, int *waiting)
+{
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST))
+    {
+        pthread_mutex_lock(&sink->lock);
+        pthread_cond_broadcast(&sink->cond);
+        pthread_mutex_unlock(&sink->lock);
+    }
+}
+
+/*!
+ * @brief Wait until no more than @p limit buffers are queued.
+ */
+static void _wait_queued (sofab_bgsink_t *sink, unsigned limit)
+{
+    const unsigned tail = sink->tail;
+
+    while (tail - __atomic_load_n(&sink->head, __ATOMIC_ACQUIRE) > limit)
+    {
+        pthread_mutex_lock(&sink->lock);
+        __atomic_store_n(&sink->encoder_waiting, 1, __ATOMIC_SEQ_CST);
+        if (tail - __atomic_load_n(&sink->head, __ATOMIC_SEQ_CST) > limit)
+        {
+            pthread_cond_wait(&sink->cond, &sink->lock);
+        }
+        __atomic_store_n(&sink->encoder_waiting, 0, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&sink->lock);
+    }
+}
+
+/*!
+ * @brief Writer thread: write the queued buffers in order until stopped.
+ */
+static void *_writer (void *arg)
+{
+    sofab_bgsink_t *sink = (sofab_bgsink_t *)arg;
+    unsigned head = sink->head;
+
+    for (;;)
+    {
+        if (head != __atomic_load_n(&sink->tail, __ATOMIC_ACQUIRE))
+        {
+            sink->write(_segment(sink, head), sink->len[head % SOFAB_BGSINK_BUFFERS], sink->usrptr);
+            head++;
+            __atomic_store_n(&sink->head, head, __ATOMIC_SEQ_CST);
+            _wake(sink, &sink->encoder_waiting);
+            continue;
+        }
+
+        pthread_mutex_lock(&sink->lock);
+        __atomic_store_n(&sink->writer_waiting, 1, __ATOMIC_SEQ_CST);
+        if (head == __atomic_load_n(&sink->tail, __ATOMIC_SEQ_CST))
+        {
+            if (sink->stop)
+            {
+                pthread_mutex_unlock(&sink->lock);
+                break;
+            }
+            pthread_cond_wait(&sink->cond, &sink->lock);
+        }
+        __atomic_store_n(&sink->writer_waiting, 0, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&sink->lock);
+    }
+
+    return NULL;
+}
+
+/*!
+ * @brief Flush callback of a background sink: queue the buffer, move to the
+ *        next one.
+ */
+static void _bgsink_flush (sofab_ostream_t *ctx, const uint8_t *data, size_t len, void *usrptr)
+{
+    sofab_bgsink_t *sink = (sofab_bgsink_t *)usrptr;
+
+    assert(data == _segment(sink, sink->tail));
+    (void)data;
+
+    if (len > 0)
+    {
+        sink->len[sink->tail % SOFAB_BGSINK_BUFFERS] = len;
+        __atomic_store_n(&sink->tail, sink->tail + 1, __ATOMIC_SEQ_CST);
+        _wake(sink, &sink->writer_waiting);
+    }
+
+    /* back-pressure: only once every buffer is queued */
+    _wait_queued(sink, SOFAB_BGSINK_BUFFERS - 1);
+    sofab_ostream_buffer_set(ctx, _segment(sink, sink->tail), sink->seglen, 0);
+}
+
+//
+
+extern sofab_ret_t sofab_ostream_bgsink_start (
+    sofab_ostream_t *os, sofab_bgsink_t *sink, uint8_t *buffer, size_t buflen,
+    sofab_bgsink_write_cb_t write, void *usrptr)
+{
+    int err;
+
+    assert(os != NULL);
+    assert(sink != NULL);
+    assert(buffer != NULL);
+    assert(buflen >= SOFAB_BGSINK_BUFFERS * SOFAB_MIN_OUTPUT_BUFFER);
+    assert(write != NULL);
+
+    sink->write = write;
+    sink->usrptr = usrptr;
+    sink->buffer = buffer;
+    sink->seglen = buflen / SOFAB_BGSINK_BUFFERS;
+    sink->head = 0;
+    sink->tail = 0;
+    sink->writer_waiting = 0;
+    sink->encoder_waiting = 0;
+    sink->stop = 0;
+
+    err = pthread_mutex_init(&sink->lock, NULL);
+    if (err == 0)
+    {
+        err = pthread_cond_init(&sink->cond, NULL);
+        if (err == 0)
+        {
+            err = pthread_create(&sink->thread, NULL, _writer, sink);
+            if (err != 0)
+            {
+                pthread_cond_destroy(&sink->cond);
+            }
+        }
+        if (err != 0)
+        {
+            pthread_mutex_destroy(&sink->lock);
+        }
+    }
+    if (err != 0)
+    {
+        errno = err;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    sofab_ostream_init(os, buffer, sink->seglen, 0, _bgsink_flush, sink);
+
+    return SOFAB_RET_OK;
+}
+
+extern void sofab_ostream_bgsink_flush (sofab_ostream_t *os)
+{
+    assert(os != NULL);
+    assert(os->flush == _bgsink_flush);
+
+    sofab_ostream_flush(os);
+    _wait_queued((sofab_bgsink_t *)os->usrptr, 0);
+}
+
+extern void sofab_ostream_bgsink_stop (sofab_ostream_t *os)
+{
+    sofab_bgsink_t *sink;
+
+    assert(os != NULL);
+    assert(os->flush == _bgsink_flush);
+
+    sink = (sofab_bgsink_t *)os->usrptr;
+
+    sofab_ostream_bgsink_flush(os);
+
+    pthread_mutex_lock(&sink->lock);
+    sink->stop = 1;
+    pthread_cond_broadcast(&sink->cond);
+    pthread_mutex_unlock(&sink->lock);
+
+    pthread_join(sink->thread, NULL);
+    pthread_cond_destroy(&sink->cond);
+    pthread_mutex_destroy(&sink->lock);
+}
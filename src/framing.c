@@ -0,0 +1,733 @@
+/*!
+ * @file framing.c
+ * @brief SofaBuffers C - Length-delimited framing for streams of messages.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define SOFAB_FRAMING_C
+
+/* includes *******************************************************************/
+#include "sofab/framing.h"
+
+#include "scan.h"
+
+#include <assert.h>
+#include <string.h>
+
+/* constants ******************************************************************/
+
+/* Reader states. */
+#define FRAMING_STATE_PREFIX    0   /* between frames, or inside a prefix */
+#define FRAMING_STATE_PAYLOAD   1   /* inside a frame's message */
+#define FRAMING_STATE_INVALID   2   /* a prefix was malformed; sticky */
+#define FRAMING_STATE_CHECK     3   /* inside a checked frame's CRC32C */
+#define FRAMING_STATE_RESYNC    4   /* searching the window for the next frame */
+
+/* functions ******************************************************************/
+
+/*!
+ * @brief The framing is lost: search for the next frame if the reader has a
+ *        window, stop for good otherwise.
+ *
+ * @param ctx  Reader context.
+ */
+static void _framing_lost (sofab_framing_reader_t *ctx)
+{
+    ctx->state = ctx->window ? FRAMING_STATE_RESYNC : FRAMING_STATE_INVALID;
+    ctx->window_len = 0;
+    ctx->window_scan = 0;
+    ctx->prefix = 0;
+    ctx->prefix_shift = 0;
+    ctx->crc = 0;
+}
+
+/*!
+ * @brief Report the current frame to the end callback and expect the next prefix.
+ *
+ * A message still incomplete when its frame runs out can never be completed:
+ * the next byte belongs to the next frame. So what sofab_istream_feed() calls
+ * INCOMPLETE is INVALID at this level.
+ *
+ * @param ctx  Reader context.
+ */
+static void _frame_end (sofab_framing_reader_t *ctx)
+{
+    sofab_ret_t result = ctx->result;
+
+    if (result == SOFAB_RET_INCOMPLETE)
+    {
+        result = SOFAB_RET_E_INVALID_MSG;
+    }
+
+    ctx->state = FRAMING_STATE_PREFIX;
+    ctx->crc = 0;
+    ctx->check = 0;
+    ctx->check_len = 0;
+    ctx->window_len = 0;
+    ctx->end(ctx, &ctx->istream, result, ctx->usrptr);
+}
+
+/*!
+ * @brief The current frame's message is complete: end the frame, or first
+ *        expect its check.
+ *
+ * @param ctx  Reader context.
+ */
+static void _payload_end (sofab_framing_reader_t *ctx)
+{
+    if (ctx->checked)
+    {
+        ctx->state = FRAMING_STATE_CHECK;
+    }
+    else
+    {
+        _frame_end(ctx);
+    }
+}
+
+/*!
+ * @brief Feed one byte of a checked frame's CRC32C, and end the frame with the
+ *        last one.
+ *
+ * @param ctx   Reader context.
+ * @param byte  Next byte of the check.
+ */
+static void _check_decode (sofab_framing_reader_t *ctx, uint8_t byte)
+{
+    ctx->check |= (uint32_t)byte << (8 * ctx->check_len);
+    ctx->check_len++;
+
+    if (ctx->check_len == SOFAB_FRAMING_CHECK_LEN)
+    {
+        int lost = ctx->check != ctx->crc;
+        size_t held = ctx->hold ? ctx->window_len : 0;
+
+        if (lost)
+        {
+            ctx->result = SOFAB_RET_E_INVALID_MSG;
+        }
+        _frame_end(ctx);
+
+        /* the length that led here is in doubt: where a window allows, look
+         * for the next frame rather than trust it, from the frame's second
+         * byte on if the window holds the frame */
+        if (lost && ctx->window)
+        {
+            _framing_lost(ctx);
+            if (held != 0)
+            {
+                ctx->skipped++;
+                ctx->window_len = held - 1;
+                memmove(ctx->window, ctx->window + 1, ctx->window_len);
+            }
+        }
+    }
+}
+
+/*!
+ * @brief Start a frame of @p len bytes: have the begin callback set up a fresh
+ *        stream for it, and close it right away if it is empty.
+ *
+ * @param ctx  Reader context.
+ * @param len  Message length from the prefix.
+ */
+static void _frame_begin (sofab_framing_reader_t *ctx, size_t len)
+{
+    if (ctx->hold && len > ctx->window_size - ctx->window_len - SOFAB_FRAMING_CHECK_LEN)
+    {
+        /* too long for the window to keep */
+        ctx->hold = 0;
+        ctx->window_len = 0;
+    }
+
+    ctx->begin(ctx, &ctx->istream, len, ctx->usrptr);
+    ctx->remaining = len;
+    ctx->state = FRAMING_STATE_PAYLOAD;
+
+    if (len == 0)
+    {
+        /* the all-default message: an empty feed is its whole input */
+        ctx->result = sofab_istream_feed(&ctx->istream, NULL, 0);
+        _payload_end(ctx);
+    }
+    else
+    {
+        ctx->result = SOFAB_RET_INCOMPLETE;
+    }
+}
+
+/*!
+ * @brief Feed one prefix byte.
+ *
+ * @param ctx   Reader context.
+ * @param byte  Next byte of the prefix.
+ * @return 0 while the prefix continues or once it completed, -1 if it is malformed.
+ */
+static int _prefix_decode (sofab_framing_reader_t *ctx, uint8_t byte)
+{
+    /* the fifth byte may only carry the top 4 of the 32 bits, and ends the prefix */
+    if (ctx->prefix_shift == 28 && (byte & 0xF0) != 0)
+    {
+        return -1;
+    }
+
+    ctx->prefix |= (uint32_t)(byte & 0x7F) << ctx->prefix_shift;
+    ctx->prefix_shift += 7;
+
+    if (byte & 0x80)
+    {
+        return 0;
+    }
+
+#if SIZE_MAX < UINT32_MAX
+    if (ctx->prefix > SIZE_MAX)
+    {
+        return -1;
+    }
+#endif
+
+    uint32_t len = ctx->prefix;
+    ctx->prefix = 0;
+    ctx->prefix_shift = 0;
+    _frame_begin(ctx, (size_t)len);
+
+    return 0;
+}
+
+/*!
+ * @brief Keep @p n bytes of the current frame, consumed from @p src, in the
+ *        window if it holds the frame.
+ *
+ * Called once the bytes have been read, but before they can end the frame.
+ * When the window is being replayed @p src lies in it, never before the bytes
+ * kept, and the move down may overwrite it.
+ *
+ * @param ctx  Reader context.
+ * @param src  The bytes.
+ * @param n    Number of bytes.
+ */
+static void _hold (sofab_framing_reader_t *ctx, const uint8_t *src, size_t n)
+{
+    if (ctx->hold)
+    {
+        if (src != ctx->window + ctx->window_len)
+        {
+            memmove(ctx->window + ctx->window_len, src, n);
+        }
+        ctx->window_len += n;
+    }
+}
+
+/*!
+ * @brief Consume input in one of the decoding states: a prefix byte, a check
+ *        byte, or as much of the payload as there is.
+ *
+ * @param ctx  Reader context, not in the invalid or resync state.
+ * @param p    Input position, advanced.
+ * @param len  Input left, decreased.
+ */
+static void _step (sofab_framing_reader_t *ctx, const uint8_t **p, size_t *len)
+{
+    if (ctx->state == FRAMING_STATE_PREFIX)
+    {
+        if (ctx->prefix_shift == 0)
+        {
+            /* a checked frame is kept until its check passed, to be searched
+             * again from its second byte should it fail */
+            ctx->hold = ctx->checked && ctx->window != NULL;
+        }
+        _hold(ctx, *p, 1);
+        if (ctx->checked)
+        {
+            ctx->crc = sofab_crc32c(ctx->crc, *p, 1);
+        }
+        if (_prefix_decode(ctx, **p) != 0)
+        {
+            /* the offending byte is left to start the search, if any */
+            _framing_lost(ctx);
+            return;
+        }
+        (*p)++;
+        (*len)--;
+    }
+    else if (ctx->state == FRAMING_STATE_CHECK)
+    {
+        _hold(ctx, *p, 1);
+        _check_decode(ctx, **p);
+        (*p)++;
+        (*len)--;
+    }
+    else
+    {
+        size_t n = *len < ctx->remaining ? *len : ctx->remaining;
+
+        /* checked while the chunk is hot, in the same pass as the decode */
+        if (ctx->checked)
+        {
+            ctx->crc = sofab_crc32c(ctx->crc, *p, n);
+        }
+
+        /* once the message is rejected the rest of its frame is only skipped */
+        if (ctx->result != SOFAB_RET_E_INVALID_MSG)
+        {
+            ctx->result = sofab_istream_feed(&ctx->istream, *p, n);
+        }
+        _hold(ctx, *p, n);
+        *p += n;
+        *len -= n;
+        ctx->remaining -= n;
+
+        if (ctx->remaining == 0)
+        {
+            _payload_end(ctx);
+        }
+    }
+}
+
+/*!
+ * @brief Judge a candidate frame at the start of @p data.
+ *
+ * Cheapest test first: the prefix, then the frame's extent, then the
+ * structural scan, then the check.
+ *
+ * @param data      Candidate frame start.
+ * @param len       Bytes available at @p data.
+ * @param max       Longest frame to accept.
+ * @param checked   Whether frames end in a CRC32C.
+ * @param framelen  Receives the frame length on success.
+ * @return SOFAB_RET_OK if the frame passes, SOFAB_RET_INCOMPLETE if it runs past
+ *         @p len (and might pass), SOFAB_RET_E_INVALID_MSG if it cannot be one.
+ */
+static sofab_ret_t _candidate (
+    const uint8_t *data, size_t len, size_t max, uint8_t checked, size_t *framelen)
+{
+    size_t prefixlen = 0, msglen = 0, n;
+
+    if (sofab_framing_next(data, len, &prefixlen, &msglen) == SOFAB_RET_E_INVALID_MSG)
+    {
+        return SOFAB_RET_E_INVALID_MSG;
+    }
+    if (prefixlen == 0)
+    {
+        return SOFAB_RET_INCOMPLETE; /* not even the prefix is here */
+    }
+    /* a padded prefix is legal, but no writer makes one */
+    if ((prefixlen > 1 && data[prefixlen - 1] == 0)
+        || msglen > max - prefixlen
+        || (checked && SOFAB_FRAMING_CHECK_LEN > max - prefixlen - msglen))
+    {
+        return SOFAB_RET_E_INVALID_MSG;
+    }
+
+    n = prefixlen + msglen + (checked ? SOFAB_FRAMING_CHECK_LEN : 0);
+    if (n > len)
+    {
+        return SOFAB_RET_INCOMPLETE;
+    }
+    if (sofab_scan_message(data + prefixlen, msglen) != 0
+        || (checked && sofab_framing_next_checked(data, len, &prefixlen, &msglen) != SOFAB_RET_OK))
+    {
+        return SOFAB_RET_E_INVALID_MSG;
+    }
+
+    *framelen = n;
+    return SOFAB_RET_OK;
+}
+
+/*!
+ * @brief Judge a candidate frame at the start of @p data as a search does.
+ *
+ * As _candidate(); an unchecked candidate must also be followed by one that is
+ * not invalid (a second frame, or the end of the bytes).
+ *
+ * @param data     Candidate frame start.
+ * @param len      Bytes available at @p data.
+ * @param max      Longest frame to accept.
+ * @param checked  Whether frames end in a CRC32C.
+ * @return As _candidate().
+ */
+static sofab_ret_t _accept (const uint8_t *data, size_t len, size_t max, uint8_t checked)
+{
+    size_t framelen, next;
+    sofab_ret_t ret = _candidate(data, len, max, checked, &framelen);
+
+    if (ret == SOFAB_RET_OK && !checked
+        && _candidate(data + framelen, len - framelen, max, 0, &next) == SOFAB_RET_E_INVALID_MSG)
+    {
+        return SOFAB_RET_E_INVALID_MSG;
+    }
+
+    return ret;
+}
+
+/*!
+ * @brief Find the first candidate in @p data that passes.
+ *
+ * @param data     Bytes to search.
+ * @param len      Length of @p data.
+ * @param max      Longest frame to accept.
+ * @param checked  Whether frames end in a CRC32C.
+ * @param skip     Receives the offset of the frame found, or of the first
+ *                 candidate still incomplete (@p len if none).
+ * @return SOFAB_RET_OK if a frame was found, SOFAB_RET_INCOMPLETE otherwise.
+ */
+static sofab_ret_t _search (
+    const uint8_t *data, size_t len, size_t max, uint8_t checked, size_t *skip)
+{
+    size_t i, keep = len;
+
+    for (i = 0; i < len; i++)
+    {
+        sofab_ret_t ret = _accept(data + i, len - i, max, checked);
+
+        if (ret == SOFAB_RET_OK)
+        {
+            *skip = i;
+            return SOFAB_RET_OK;
+        }
+        if (ret == SOFAB_RET_INCOMPLETE && keep == len)
+        {
+            keep = i;
+        }
+    }
+
+    *skip = keep;
+    return SOFAB_RET_INCOMPLETE;
+}
+
+/*!
+ * @brief Search the reader's window, going on where the last search stopped.
+ *
+ * A rejected candidate stays rejected however many bytes follow; only an
+ * incomplete one can still pass. The window is kept from the first incomplete
+ * candidate on, and @c window_scan is where the search goes on behind it: the
+ * candidates in between were rejected. Only the first incomplete candidate
+ * and the one at @c window_scan are judged again, so a byte-by-byte feed costs
+ * a few candidates per byte, not the whole window. The search stops at a
+ * second incomplete candidate, so a frame behind two false starts is found
+ * once one of them is decided, at the latest when the window is full.
+ *
+ * @param ctx   Reader context, in the resync state.
+ * @param skip  Receives the offset of the frame found, or of the first
+ *              candidate still incomplete (the window length if none).
+ * @return SOFAB_RET_OK if a frame was found, SOFAB_RET_INCOMPLETE otherwise.
+ */
+static sofab_ret_t _search_window (sofab_framing_reader_t *ctx, size_t *skip)
+{
+    const uint8_t *data = ctx->window;
+    const size_t len = ctx->window_len;
+    size_t i = 0, keep = len;
+    sofab_ret_t ret;
+
+    if (ctx->window_scan != 0)
+    {
+        ret = _accept(data, len, ctx->window_size, ctx->checked);
+        if (ret == SOFAB_RET_OK)
+        {
+            *skip = 0;
+            return SOFAB_RET_OK;
+        }
+        if (ret == SOFAB_RET_INCOMPLETE)
+        {
+            keep = 0;
+        }
+        i = ctx->window_scan;
+    }
+
+    for (; i < len; i++)
+    {
+        ret = _accept(data + i, len - i, ctx->window_size, ctx->checked);
+        if (ret == SOFAB_RET_OK)
+        {
+            *skip = i;
+            return SOFAB_RET_OK;
+        }
+        if (ret == SOFAB_RET_INCOMPLETE)
+        {
+            if (keep != len)
+            {
+                break;
+            }
+            keep = i;
+        }
+    }
+
+    *skip = keep;
+    ctx->window_scan = keep == len ? 0 : i - keep;
+    return SOFAB_RET_INCOMPLETE;
+}
+
+/*!
+ * @brief Search the window; on a find, decode from there.
+ *
+ * The window is replayed through the decoding states. Should the framing be
+ * lost again in the replay, what it left in the window and the rest of the
+ * window are searched in turn.
+ *
+ * @param ctx  Reader context, in the resync state.
+ */
+static void _resync (sofab_framing_reader_t *ctx)
+{
+    while (ctx->state == FRAMING_STATE_RESYNC)
+    {
+        const uint8_t *p;
+        size_t skip, len;
+
+        if (_search_window(ctx, &skip) != SOFAB_RET_OK)
+        {
+            /* keep what may still start a frame */
+            ctx->skipped += skip;
+            ctx->window_len -= skip;
+            memmove(ctx->window, ctx->window + skip, ctx->window_len);
+            return;
+        }
+
+        ctx->skipped += skip;
+        ctx->state = FRAMING_STATE_PREFIX;
+        p = ctx->window + skip;
+        len = ctx->window_len - skip;
+
+        /* from here on the window holds what the replay keeps */
+        ctx->window_len = 0;
+        ctx->window_scan = 0;
+        while (len && ctx->state != FRAMING_STATE_RESYNC)
+        {
+            _step(ctx, &p, &len);
+        }
+        memmove(ctx->window + ctx->window_len, p, len);
+        ctx->window_len += len;
+    }
+}
+
+//
+
+extern size_t sofab_framing_prefix (uint8_t *out, uint32_t len)
+{
+    size_t n = 0;
+
+    assert(out != NULL);
+
+    do
+    {
+        uint8_t b = len & 0x7F;
+        len >>= 7;
+        if (len) b |= 0x80;
+        out[n++] = b;
+    } while (len != 0);
+
+    return n;
+}
+
+extern void sofab_framing_begin (sofab_ostream_t *os, uint8_t *buffer, size_t buflen)
+{
+    assert(buflen >= SOFAB_FRAMING_PREFIX_MAX);
+
+    sofab_ostream_init(os, buffer, buflen, SOFAB_FRAMING_PREFIX_MAX, NULL, NULL);
+}
+
+extern sofab_ret_t sofab_framing_end (
+    sofab_ostream_t *os, uint8_t **frame, size_t *framelen)
+{
+    uint8_t prefix[SOFAB_FRAMING_PREFIX_MAX];
+    uint8_t *payload;
+    size_t len, n;
+
+    assert(os != NULL);
+    assert(frame != NULL);
+    assert(framelen != NULL);
+    /* a stream that flushed has handed off the bytes the prefix belongs in front of */
+    assert(os->flush == NULL);
+    assert(sofab_ostream_bytes_used(os) >= SOFAB_FRAMING_PREFIX_MAX);
+
+    payload = os->buffer + SOFAB_FRAMING_PREFIX_MAX;
+    len = (size_t)(os->offset - payload);
+#if SIZE_MAX > UINT32_MAX
+    if (len > SOFAB_FRAMING_LEN_MAX)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+#endif
+
+    n = sofab_framing_prefix(prefix, (uint32_t)len);
+    memcpy(payload - n, prefix, n);
+
+    *frame = payload - n;
+    *framelen = n + len;
+
+    return SOFAB_RET_OK;
+}
+
+extern void sofab_framing_begin_checked (sofab_ostream_t *os, uint8_t *buffer, size_t buflen)
+{
+    assert(buflen >= SOFAB_FRAMING_PREFIX_MAX + SOFAB_FRAMING_CHECK_LEN);
+
+    sofab_framing_begin(os, buffer, buflen - SOFAB_FRAMING_CHECK_LEN);
+}
+
+extern sofab_ret_t sofab_framing_end_checked (
+    sofab_ostream_t *os, uint8_t **frame, size_t *framelen)
+{
+    sofab_ret_t ret;
+    uint8_t *check;
+    uint32_t crc;
+
+    ret = sofab_framing_end(os, frame, framelen);
+    if (ret != SOFAB_RET_OK)
+    {
+        return ret;
+    }
+
+    /* in the room sofab_framing_begin_checked() kept behind the stream */
+    crc = sofab_crc32c(0, *frame, *framelen);
+    check = *frame + *framelen;
+    check[0] = (uint8_t)crc;
+    check[1] = (uint8_t)(crc >> 8);
+    check[2] = (uint8_t)(crc >> 16);
+    check[3] = (uint8_t)(crc >> 24);
+    *framelen += SOFAB_FRAMING_CHECK_LEN;
+
+    return SOFAB_RET_OK;
+}
+
+extern void sofab_framing_reader_init (
+    sofab_framing_reader_t *ctx, sofab_framing_begin_cb_t begin,
+    sofab_framing_end_cb_t end, void *usrptr)
+{
+    assert(ctx != NULL);
+    assert(begin != NULL);
+    assert(end != NULL);
+
+    ctx->begin = begin;
+    ctx->end = end;
+    ctx->usrptr = usrptr;
+    ctx->remaining = 0;
+    ctx->prefix = 0;
+    ctx->result = SOFAB_RET_OK;
+    ctx->crc = 0;
+    ctx->check = 0;
+    ctx->window = NULL;
+    ctx->window_size = 0;
+    ctx->window_len = 0;
+    ctx->window_scan = 0;
+    ctx->skipped = 0;
+    ctx->prefix_shift = 0;
+    ctx->check_len = 0;
+    ctx->checked = 0;
+    ctx->hold = 0;
+    ctx->state = FRAMING_STATE_PREFIX;
+}
+
+extern void sofab_framing_reader_init_checked (
+    sofab_framing_reader_t *ctx, sofab_framing_begin_cb_t begin,
+    sofab_framing_end_cb_t end, void *usrptr)
+{
+    sofab_framing_reader_init(ctx, begin, end, usrptr);
+    ctx->checked = 1;
+}
+
+extern void sofab_framing_reader_resync (
+    sofab_framing_reader_t *ctx, uint8_t *window, size_t size)
+{
+    assert(ctx != NULL);
+    assert(window != NULL);
+    assert(size >= SOFAB_FRAMING_PREFIX_MAX + SOFAB_FRAMING_CHECK_LEN);
+
+    ctx->window = window;
+    ctx->window_size = size;
+    ctx->window_len = 0;
+    ctx->window_scan = 0;
+}
+
+extern sofab_ret_t sofab_framing_reader_feed (
+    sofab_framing_reader_t *ctx, const void *data, size_t datalen)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    assert(ctx != NULL);
+    assert(data != NULL || datalen == 0);
+
+    while (datalen && ctx->state != FRAMING_STATE_INVALID)
+    {
+        if (ctx->state == FRAMING_STATE_RESYNC)
+        {
+            size_t n = ctx->window_size - ctx->window_len;
+
+            if (n > datalen)
+            {
+                n = datalen;
+            }
+            memcpy(ctx->window + ctx->window_len, p, n);
+            ctx->window_len += n;
+            p += n;
+            datalen -= n;
+            _resync(ctx);
+        }
+        else
+        {
+            _step(ctx, &p, &datalen);
+
+            /* a failed frame left its bytes to search */
+            if (ctx->state == FRAMING_STATE_RESYNC && ctx->window_len != 0)
+            {
+                _resync(ctx);
+            }
+        }
+    }
+
+    if (ctx->state == FRAMING_STATE_INVALID)
+    {
+        return SOFAB_RET_E_INVALID_MSG;
+    }
+    if (ctx->state != FRAMING_STATE_PREFIX || ctx->prefix_shift != 0)
+    {
+        return SOFAB_RET_INCOMPLETE;
+    }
+
+    return SOFAB_RET_OK;
+}
+
+extern sofab_ret_t sofab_framing_next_checked (
+    const uint8_t *data, size_t len, size_t *prefixlen, size_t *msglen)
+{
+    sofab_ret_t ret;
+    size_t n;
+    uint32_t check;
+
+    assert(data != NULL || len == 0);
+    assert(prefixlen != NULL);
+    assert(msglen != NULL);
+
+    ret = sofab_framing_next(data, len, prefixlen, msglen);
+    if (ret != SOFAB_RET_OK)
+    {
+        return ret;
+    }
+
+    n = *prefixlen + *msglen;
+    if (len - n < SOFAB_FRAMING_CHECK_LEN)
+    {
+        return SOFAB_RET_INCOMPLETE;
+    }
+
+    check = (uint32_t)data[n] | (uint32_t)data[n + 1] << 8
+          | (uint32_t)data[n + 2] << 16 | (uint32_t)data[n + 3] << 24;
+
+    return sofab_crc32c(0, data, n) == check ? SOFAB_RET_OK : SOFAB_RET_E_INVALID_MSG;
+}
+
+extern sofab_ret_t sofab_framing_resync (const uint8_t *data, size_t len, size_t *skip)
+{
+    assert(data != NULL || len == 0);
+    assert(skip != NULL);
+
+    return _search(data, len, SIZE_MAX, 0, skip);
+}
+
+extern sofab_ret_t sofab_framing_resync_checked (const uint8_t *data, size_t len, size_t *skip)
+{
+    assert(data != NULL || len == 0);
+    assert(skip != NULL);
+
+    return _search(data, len, SIZE_MAX, 1, skip);
+}
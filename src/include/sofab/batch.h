@@ -0,0 +1,206 @@
+/*!
+ * @file batch.h
+ * @brief SofaBuffers C - Parallel batch encode and decode on POSIX threads.
+ *
+ * Bulk conversion between an array of objects and a buffer of framed messages
+ * (the length-delimited framing of @c sofab/framing.h), spread over a number of
+ * worker threads the caller chooses. The records are split into contiguous
+ * runs, one per thread, and each thread works its run with its own streams and
+ * decoder chain, so the threads share nothing but the read-only descriptor and
+ * their disjoint slices of the caller's arrays. The output is the same, byte
+ * for byte and record for record, whatever the thread count.
+ *
+ * - @ref sofab_batch_encode encodes each run into a segment of its own and
+ *   stitches the segments into the output in record order.
+ * - @ref sofab_batch_decode first indexes the frames of its input, then decodes
+ *   the runs concurrently into the caller's pre-sized destination array (each
+ *   with @ref sofab_object_decode_batch).
+ * - @ref sofab_batch_decode_seq does the same inside a single message, for the
+ *   elements of one large wrapper array.
+ *
+ * Unlike the rest of the library this module needs a hosted platform: it
+ * creates threads (pthreads) and allocates its segments and index from the
+ * heap. It is therefore not part of @c libsofabuffers but a library of its own,
+ * @c sofa-buffers::batch, built for hosted targets only.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_BATCH_H
+#define SOFAB_BATCH_H
+
+/**
+ * @defgroup c_api C API
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SOFAB_BATCH_C
+# define SOFAB_BATCH_EXTERN extern
+#else
+# define SOFAB_BATCH_EXTERN
+#endif
+
+/* includes *******************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sofab/object.h"
+
+/* constants ******************************************************************/
+
+/*!
+ * @brief Fewest records a worker thread is given.
+ *
+ * Creating a thread costs about as much as decoding a few hundred small
+ * records, so a batch is never split into runs shorter than this: a small
+ * batch uses fewer threads than asked for, down to the calling thread alone.
+ */
+#ifndef SOFAB_BATCH_MIN_RUN
+# define SOFAB_BATCH_MIN_RUN    (256)
+#endif
+
+/* prototypes *****************************************************************/
+
+/*!
+ * @brief Encode an array of objects into a buffer of framed messages.
+ *
+ * Object @c i is read from @c (const uint8_t*)src @c + @c i*stride and encoded
+ * with @ref sofab_object_encode as frame @c i of @p out. Each of the @p threads
+ * runs (the calling thread works one of them) encodes into a heap segment that
+ * grows as needed, and the segments are copied into @p out in order once all
+ * runs are done.
+ *
+ * @param info     Object descriptor shared by all objects.
+ * @param src      First source object.
+ * @param stride   Distance between source objects in bytes.
+ * @param n        Number of objects.
+ * @param threads  Number of threads to use, at least 1 (the calling thread
+ *                 counts as one).
+ * @param out      Output buffer (may be NULL when @p outlen is 0).
+ * @param outlen   Size of @p out in bytes.
+ * @param used     Receives the length of the framed output. On
+ *                 SOFAB_RET_E_BUFFER_FULL it is the size @p out needs.
+ *
+ * @return SOFAB_RET_OK on success, SOFAB_RET_E_BUFFER_FULL if the output does
+ *         not fit into @p outlen bytes (@p out is then left untouched), the
+ *         error of @ref sofab_object_encode or @ref sofab_framing_end for the
+ *         first object that fails, or SOFAB_RET_E_ARGUMENT if the segments
+ *         cannot be allocated.
+ */
+extern sofab_ret_t sofab_batch_encode (
+    const sofab_object_descr_t *info,
+    const void *src,
+    size_t stride,
+    size_t n,
+    unsigned threads,
+    uint8_t *out,
+    size_t outlen,
+    size_t *used);
+
+/*!
+ * @brief Decode a buffer of framed messages into an array of objects.
+ *
+ * The parallel counterpart of @ref sofab_object_decode_batch, with the same
+ * contract for @p frames, @p dst, @p status, @p count and @p used and the same
+ * stopping rules: after @p n records, at the end of @p frames, at a frame that
+ * runs past it, or at a malformed length prefix. The frames up to there are
+ * indexed first, then split into @p threads runs of about equal byte size,
+ * which are decoded concurrently, each with a decoder chain of
+ * @p depth @c + @c 1 slots of its own.
+ *
+ * @param info     Object descriptor shared by all records.
+ * @param depth    Nesting levels the decoder chains support (the @c depth of
+ *                 their first slot, see @ref sofab_object_field_cb).
+ * @param frames   Framed input (may be NULL when @p len is 0).
+ * @param len      Length of @p frames in bytes.
+ * @param dst      First destination object.
+ * @param stride   Distance between destination objects in bytes.
+ * @param n        Capacity of @p dst and @p status, in records.
+ * @param status   Receives one verdict per decoded record: SOFAB_RET_OK or
+ *                 SOFAB_RET_E_INVALID_MSG.
+ * @param threads  Number of threads to use, at least 1 (the calling thread
+ *                 counts as one).
+ * @param count    Receives the number of records decoded.
+ * @param used     Receives the bytes consumed. May be NULL.
+ *
+ * @return As @ref sofab_object_decode_batch, or SOFAB_RET_E_ARGUMENT if the
+ *         index or the decoder chains cannot be allocated (nothing is decoded
+ *         then).
+ */
+extern sofab_ret_t sofab_batch_decode (
+    const sofab_object_descr_t *info,
+    uint8_t depth,
+    const void *frames,
+    size_t len,
+    void *dst,
+    size_t stride,
+    size_t n,
+    sofab_ret_t *status,
+    unsigned threads,
+    size_t *count,
+    size_t *used);
+
+/*!
+ * @brief Decode one message whose bulk is a single wrapper array, with the
+ *        array's elements decoded concurrently.
+ *
+ * For a message dominated by one wrapper array of struct elements (MESSAGE_SPEC
+ * §5.1: a field @p id of @p info whose nested descriptor is a holder, see
+ * @ref SOFAB_OBJECT_DESCR_SEQ, whose slots are all nested objects). Decoding
+ * takes two phases:
+ *  1. A structural scan walks the wire format without decoding anything and
+ *     records the byte range of every element of that array.
+ *  2. The message is decoded as usual, but with the element bodies cut out, so
+ *     everything outside them (other fields, the holder reset of §7.4, the
+ *     element count of a sized holder, the over-index reject and the §7.3
+ *     skips) is settled exactly as in the serial decode. Then the bodies are
+ *     decoded into their slots concurrently, the element id being the index.
+ *
+ * The result is the serial decode's: the same return value and, on
+ * SOFAB_RET_OK, the same destination. Where the two phases could not promise
+ * that, the message is simply decoded serially: a single thread, a message
+ * that carries the array more than once or not at all, a descriptor that is not
+ * of the form above, or input the scan does not accept (malformed or truncated,
+ * which the serial decode then reports). Elements whose ids do not strictly
+ * ascend (a repeated or out-of-order id) keep the two phases, but their bodies
+ * are decoded in wire order on the calling thread.
+ *
+ * As with @ref sofab_object_field_cb only what the wire carries is written:
+ * initialize @p dst with @ref sofab_object_init first.
+ *
+ * @param info     Descriptor of the message.
+ * @param depth    Nesting levels the decoder chains support (the @c depth of
+ *                 their first slot, see @ref sofab_object_field_cb); at least 2
+ *                 (holder and element) for the elements to be decoded in
+ *                 parallel.
+ * @param id       Id of the wrapper array field in @p info.
+ * @param msg      The whole message.
+ * @param len      Length of @p msg in bytes.
+ * @param dst      Destination object.
+ * @param threads  Number of threads to use, at least 1 (the calling thread
+ *                 counts as one).
+ *
+ * @return SOFAB_RET_OK, SOFAB_RET_INCOMPLETE or SOFAB_RET_E_INVALID_MSG as
+ *         @ref sofab_istream_feed would report for the whole message, or
+ *         SOFAB_RET_E_ARGUMENT if the working memory cannot be allocated.
+ */
+extern sofab_ret_t sofab_batch_decode_seq (
+    const sofab_object_descr_t *info,
+    uint8_t depth,
+    sofab_id_t id,
+    const void *msg,
+    size_t len,
+    void *dst,
+    unsigned threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */ // end of defgroup
+
+#endif /* SOFAB_BATCH_H */
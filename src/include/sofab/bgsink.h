@@ -0,0 +1,143 @@
+/*!
+ * @file bgsink.h
+ * @brief SofaBuffers C - Output stream sink flushed by a background thread.
+ *
+ * For a sink that is slow, or slow at times (compression, a network write),
+ * and would otherwise stall the encoder inside every flush callback. The
+ * caller's buffer is cut into @ref SOFAB_BGSINK_BUFFERS buffers. A flush only
+ * hands the filled buffer to a writer thread of the sink's own and moves the
+ * encoder on to the next buffer, with sofab_ostream_buffer_set(); the writer
+ * thread passes the buffers, in order, to the caller's write callback. The
+ * encoder waits only when all the buffers are queued or being written.
+ *
+ * The hand-over is a single-producer, single-consumer ring of buffer indices
+ * with atomic head and tail counters, so the encoder and the writer never take
+ * a lock to pass a buffer. One of them only sleeps on the sink's condition
+ * variable when it has nothing to do: the writer on an empty ring, the encoder
+ * on a full one.
+ *
+ * This module needs POSIX threads and is part of @c sofa-buffers::posix where
+ * pthreads are found.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_BGSINK_H
+#define SOFAB_BGSINK_H
+
+/**
+ * @defgroup c_api C API
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SOFAB_BGSINK_C
+# define SOFAB_BGSINK_EXTERN extern
+#else
+# define SOFAB_BGSINK_EXTERN
+#endif
+
+/* includes *******************************************************************/
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sofab/ostream.h"
+
+/* constants ******************************************************************/
+
+/*!
+ * @brief Buffers of a background sink.
+ *
+ * How much sink jitter is absorbed: up to this many minus one buffers queue
+ * up for the writer thread while the encoder fills the last one; only when
+ * that one is flushed too does the encoder wait.
+ */
+#ifndef SOFAB_BGSINK_BUFFERS
+# define SOFAB_BGSINK_BUFFERS       (4)
+#endif
+#if SOFAB_BGSINK_BUFFERS < 2 || SOFAB_BGSINK_BUFFERS > 64
+# error "SOFAB_BGSINK_BUFFERS must be 2..64"
+#endif
+
+/* types **********************************************************************/
+
+/*!
+ * @brief Write callback, run on the writer thread.
+ *
+ * Receives the buffers in the order they were filled. May take as long as it
+ * needs; the buffer is handed back to the encoder when it returns.
+ *
+ * @param data    Filled part of the buffer.
+ * @param len     Bytes at @p data, never 0.
+ * @param usrptr  User pointer given to sofab_ostream_bgsink_start().
+ */
+typedef void (*sofab_bgsink_write_cb_t) (const uint8_t *data, size_t len, void *usrptr);
+
+/*!
+ * @brief Background sink state.
+ */
+typedef struct sofab_bgsink
+{
+    sofab_bgsink_write_cb_t write;      /*!< Write callback */
+    void *usrptr;                       /*!< User pointer for @c write */
+    uint8_t *buffer;                    /*!< Start of the first buffer */
+    size_t seglen;                      /*!< Bytes per buffer */
+    size_t len[SOFAB_BGSINK_BUFFERS];   /*!< Filled length of each queued buffer */
+    unsigned head;                      /*!< Buffers written (writer thread's counter) */
+    unsigned tail;                      /*!< Buffers queued (encoder's counter) */
+    int writer_waiting;                 /*!< Writer thread sleeps on @c cond (empty ring) */
+    int encoder_waiting;                /*!< Encoder sleeps on @c cond (full ring, or a flush) */
+    int stop;                           /*!< Writer thread is to exit once the ring is empty */
+    pthread_t thread;                   /*!< Writer thread */
+    pthread_mutex_t lock;               /*!< Guards sleeping only */
+    pthread_cond_t cond;                /*!< Wakes a sleeper */
+} sofab_bgsink_t;
+
+/* prototypes *****************************************************************/
+
+/*!
+ * @brief Initialize an output stream with a background sink and start its
+ *        writer thread.
+ *
+ * @param os      Output stream to initialize.
+ * @param sink    Sink state, valid until sofab_ostream_bgsink_stop().
+ * @param buffer  Encode buffer.
+ * @param buflen  Size of @p buffer, at least @ref SOFAB_BGSINK_BUFFERS times
+ *                @ref SOFAB_MIN_OUTPUT_BUFFER.
+ * @param write   Write callback (required).
+ * @param usrptr  User pointer passed to @p write.
+ *
+ * @return SOFAB_RET_OK, or SOFAB_RET_E_ARGUMENT if the thread cannot be
+ *         created, with @c errno set to the reason.
+ */
+extern sofab_ret_t sofab_ostream_bgsink_start (
+    sofab_ostream_t *os, sofab_bgsink_t *sink, uint8_t *buffer, size_t buflen,
+    sofab_bgsink_write_cb_t write, void *usrptr);
+
+/*!
+ * @brief Hand everything encoded so far to the writer and wait until it has
+ *        all been written.
+ *
+ * @param os  Output stream set up by @ref sofab_ostream_bgsink_start.
+ */
+extern void sofab_ostream_bgsink_flush (sofab_ostream_t *os);
+
+/*!
+ * @brief Flush, then stop the writer thread.
+ *
+ * @param os  Output stream set up by @ref sofab_ostream_bgsink_start; it
+ *            must not be written to afterwards.
+ */
+extern void sofab_ostream_bgsink_stop (sofab_ostream_t *os);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */ // end of defgroup
+
+#endif /* SOFAB_BGSINK_H */
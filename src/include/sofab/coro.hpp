@@ -0,0 +1,587 @@
+/*!
+ * @file coro.hpp
+ * @brief SofaBuffers C++ - coroutine adapters for asynchronous decode and encode.
+ *
+ * The streams are push-driven and synchronous: @ref sofab::IStreamImpl::feed
+ * takes whatever bytes arrived and reports @ref sofab::Error::Incomplete, and
+ * an encoder's flush callback must have dealt with a full buffer by the time it
+ * returns. On an event loop that means a hand-written state machine around
+ * every read, and a flush callback that cannot wait for a socket without
+ * blocking the loop. The adapters here let a C++20 coroutine do both:
+ *
+ *  - @ref sofab::decodeFrom pulls chunks from an awaitable source into a
+ *    caller buffer and feeds them until end of input or a malformed message.
+ *  - @ref sofab::OStreamAsync encodes one field at a time and, after each,
+ *    suspends until an awaitable sink has taken every chunk it produced, and
+ *    while its @ref sofab::BufferPool has no chunk to give
+ *    (@ref sofab::PoolAcquire).
+ *
+ * No runtime is assumed. A source is any object with
+ * @c read(std::span<uint8_t>) returning an awaitable of a byte count (0 at end
+ * of input); a sink is any object with @c write(std::span<const uint8_t>)
+ * returning an awaitable of @c bool (false if the bytes could not be taken).
+ * @ref sofab::Task is awaitable, so both may simply be coroutines themselves.
+ *
+ * Kept out of `sofab.hpp`: it pulls in @c <coroutine> and builds on
+ * `pool.hpp`, neither of which the synchronous wrapper needs.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_CORO_HPP
+#define SOFAB_CORO_HPP
+
+/**
+ * @defgroup cpp_api C++ API
+ * @{
+ */
+
+/* includes *******************************************************************/
+#include "sofab/sofab.hpp"
+#include "sofab/pool.hpp"
+
+#include <algorithm>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+/* types **********************************************************************/
+namespace sofab
+{
+    /*!
+     * @brief Minimal lazy coroutine returning a @p T.
+     *
+     * The body does not run until the task is awaited (or @ref start ed); on
+     * completion it resumes its awaiter directly (symmetric transfer), so a
+     * chain of awaited tasks neither grows the stack nor needs a scheduler.
+     * This is just enough to compose the adapters below with a caller's own
+     * coroutines; any executor that resumes a suspended handle drives it.
+     *
+     * @tparam T  Result type (not @c void).
+     */
+    template <typename T>
+    class [[nodiscard]] Task
+    {
+    public:
+        /*! @brief Coroutine promise (used by the compiler). */
+        struct promise_type
+        {
+            std::optional<T> value_;                //!< Set by co_return.
+            std::coroutine_handle<> continuation_;  //!< Awaiter to resume on completion.
+
+            Task get_return_object() noexcept
+            {
+                return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+            }
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            struct FinalAwaiter
+            {
+                bool await_ready() noexcept
+                {
+                    return false;
+                }
+
+                std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<promise_type> handle) noexcept
+                {
+                    auto continuation = handle.promise().continuation_;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept
+                { }
+            };
+
+            FinalAwaiter final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_value(T value) noexcept
+            {
+                value_.emplace(std::move(value));
+            }
+
+            // The wrapper is built without exceptions; nothing here throws.
+            void unhandled_exception() noexcept
+            {
+                std::terminate();
+            }
+        };
+
+    private:
+        std::coroutine_handle<promise_type> handle_;
+
+        explicit Task(std::coroutine_handle<promise_type> handle) noexcept
+            : handle_{handle}
+        { }
+
+    public:
+        /*! @brief Copying is deleted (a task has exactly one awaiter). */
+        Task(const Task&) = delete;
+        /*! @brief Copying is deleted (a task has exactly one awaiter). */
+        Task& operator=(const Task&) = delete;
+
+        /*! @brief Take over @p other's coroutine. */
+        Task(Task &&other) noexcept
+            : handle_{std::exchange(other.handle_, {})}
+        { }
+
+        /*! @brief Destroy the held coroutine, then take over @p other's. */
+        Task& operator=(Task &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle_)
+                {
+                    handle_.destroy();
+                }
+                handle_ = std::exchange(other.handle_, {});
+            }
+            return *this;
+        }
+
+        /*! @brief Destroy the coroutine frame. */
+        ~Task() noexcept
+        {
+            if (handle_)
+            {
+                handle_.destroy();
+            }
+        }
+
+        /*! @brief Awaiting a task runs it and yields its result. */
+        auto operator co_await() noexcept
+        {
+            struct Awaiter
+            {
+                std::coroutine_handle<promise_type> handle_;
+
+                bool await_ready() noexcept
+                {
+                    return handle_.done();
+                }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+                {
+                    handle_.promise().continuation_ = awaiter;
+                    return handle_;
+                }
+
+                T await_resume() noexcept
+                {
+                    return std::move(*handle_.promise().value_);
+                }
+            };
+
+            return Awaiter{handle_};
+        }
+
+        /*!
+         * @brief Run a top-level task up to its first suspension.
+         *
+         * For the outermost task, which nothing awaits: the executor that
+         * resumes its suspended awaitables carries it to completion.
+         */
+        void start() noexcept
+        {
+            handle_.resume();
+        }
+
+        /*! @brief True once the task has returned. */
+        bool done() const noexcept
+        {
+            return handle_.done();
+        }
+
+        /*! @brief Result of a finished task (see @ref done). */
+        T& result() noexcept
+        {
+            return *handle_.promise().value_;
+        }
+    };
+
+    /*!
+     * @brief Decode a message from an asynchronous byte source.
+     *
+     * Reads into @p buffer and feeds each chunk to @p istream until the source
+     * reports end of input (a read of 0 bytes) or a chunk makes the message
+     * invalid. The wire format carries no length, so the end of input is the
+     * end of the message: an @ref Error::None after one chunk says only that it
+     * stopped on a field boundary, and reading continues.
+     *
+     * @p buffer is the only staging storage — reused for every read and free
+     * again once this returns — so a service can size it per connection.
+     *
+     * @param istream  Stream to decode into (e.g. an @ref IStreamObject).
+     * @param source   Object whose @c read(std::span<uint8_t>) is awaitable
+     *                 and yields the byte count read, 0 at end of input.
+     * @param buffer   Staging buffer for one chunk (non-empty).
+     * @return @ref Error::None for a complete message, @ref Error::Incomplete
+     *         if input ended mid-field, or @ref Error::InvalidMessage as soon
+     *         as the message is malformed.
+     */
+    template <typename Source>
+    Task<Error> decodeFrom(IStreamImpl &istream, Source &source, std::span<uint8_t> buffer)
+    {
+        assert(!buffer.empty());
+
+        Error state = Error::None;
+
+        for (;;)
+        {
+            size_t len = co_await source.read(buffer);
+            if (len == 0)
+            {
+                co_return state;
+            }
+
+            state = istream.feed(buffer.data(), len).code();
+            if (state == Error::InvalidMessage)
+            {
+                co_return state;
+            }
+        }
+    }
+
+    /*!
+     * @brief Awaitable that takes a chunk from a @ref BufferPool, suspending
+     *        while none is free.
+     *
+     * The release that frees a chunk resumes the awaiting coroutine — on that
+     * thread, inside that call — so no executor is involved. The chunk is not
+     * held for it meanwhile: if another taker gets there first the result is
+     * an empty handle, and the caller awaits again.
+     */
+    class [[nodiscard]] PoolAcquire : BufferPool::Waiter
+    {
+        BufferPool &pool_;
+        BufferPool::Chunk chunk_;
+        std::coroutine_handle<> handle_;
+
+        static void wake_(BufferPool::Waiter &waiter) noexcept
+        {
+            static_cast<PoolAcquire&>(waiter).handle_.resume();
+        }
+
+    public:
+        /*!
+         * @brief Prepare to take a chunk from @p pool.
+         * @param pool  Chunk source; must outlive this awaitable.
+         */
+        explicit PoolAcquire(BufferPool &pool) noexcept
+            : pool_{pool}
+        {
+            notify = wake_;
+        }
+
+        /*! @brief Copying is deleted (the pool may hold its address). */
+        PoolAcquire(const PoolAcquire&) = delete;
+        /*! @brief Copying is deleted (the pool may hold its address). */
+        PoolAcquire& operator=(const PoolAcquire&) = delete;
+
+        /*! @brief Withdraw from the pool if destroyed while suspended. */
+        ~PoolAcquire() noexcept
+        {
+            if (handle_)
+            {
+                pool_.cancel(*this);
+            }
+        }
+
+        bool await_ready() noexcept
+        {
+            chunk_ = pool_.acquire();
+            return static_cast<bool>(chunk_);
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) noexcept
+        {
+            handle_ = handle;
+            return pool_.wait(*this);
+        }
+
+        BufferPool::Chunk await_resume() noexcept
+        {
+            if (!chunk_)
+            {
+                chunk_ = pool_.acquire();
+            }
+            return std::move(chunk_);
+        }
+    };
+
+    /*!
+     * @brief Encoder that suspends until an asynchronous sink has drained.
+     *
+     * A flush callback cannot wait, so this does not try to: every awaited
+     * call encodes synchronously into @ref BufferPool chunks, then hands each
+     * filled chunk to the sink and resumes only when the sink has taken it.
+     * The chunks go back to the pool as they are written, and none is held
+     * between a @ref flush and the next call, so one pool can serve every
+     * connection of a service and bounds its total buffered output.
+     *
+     * A call never needs more of the pool than is free. When the pool runs dry
+     * partway, the encoder stops there, hands what it has to the sink, awaits
+     * a free chunk (@ref PoolAcquire) and encodes the call again, dropping the
+     * bytes that already went out. The sink sees the same bytes as from one
+     * pass; a call that outgrows the pool by a factor of @e k costs up to
+     * @e k encodes of it.
+     *
+     * A call whose bytes the sink refused fails with @ref Error::BufferFull,
+     * which is sticky in @ref ok, and nothing is written after it.
+     *
+     * Bytes still buffered are @b not sent on destruction — the sink may not
+     * be awaited from a destructor. Finish with @c co_await @ref flush.
+     *
+     * @tparam Sink  Type whose @c write(std::span<const uint8_t>) is awaitable
+     *               and yields @c true once every byte has been taken.
+     */
+    template <typename Sink>
+    class OStreamAsync
+    {
+        //! Bytes @c [from, to) of a filled chunk, waiting for the sink.
+        struct Piece
+        {
+            BufferPool::Chunk chunk;
+            size_t from;
+            size_t to;
+        };
+
+        // Encodes into pool chunks and queues each filled one. A repeated
+        // pass drops its first skip_ bytes, which an earlier pass sent; with
+        // the pool dry the stream stalls on a zero-length buffer, and the
+        // write fails with BufferFull.
+        class ChunkStream final : public OStreamImpl
+        {
+        public:
+            BufferPool &pool_;
+            std::vector<Piece> &pending_;
+            BufferPool::Chunk chunk_;   //!< Chunk being encoded into.
+            size_t from_ = 0;           //!< First byte of chunk_ for the sink.
+            size_t mark_ = 0;           //!< First byte of chunk_ not yet counted.
+            size_t skip_ = 0;           //!< Bytes of the call still to drop.
+            size_t taken_ = 0;          //!< Bytes of the call kept by this pass.
+            uint8_t stall_[1] = {};     //!< Zero-length install while no chunk is held.
+
+            ChunkStream(BufferPool &pool, std::vector<Piece> &pending) noexcept
+                : pool_{pool}
+                , pending_{pending}
+            {
+                buffer_ = stall_;
+                sofab_ostream_init(&ctx_, buffer_, 0, 0, nullptr, this);
+            }
+
+            // Detached so the base destructor's flush queues nothing.
+            ~ChunkStream() noexcept override
+            {
+                ctx_.flush = nullptr;
+            }
+
+            static void flush_(
+                sofab_ostream_t *ctx, const uint8_t *data, size_t len, void *usrptr) noexcept
+            {
+                (void)ctx;
+                (void)data;
+
+                auto *self = static_cast<ChunkStream*>(usrptr);
+                self->count_(len);
+                if (self->from_ < len)
+                {
+                    self->pending_.push_back({std::move(self->chunk_), self->from_, len});
+                    self->install_(self->pool_.acquire());
+                }
+                else
+                {
+                    // All of it went out in an earlier pass: refill the chunk.
+                    self->install_(std::move(self->chunk_));
+                }
+            }
+
+            // Account for the call's bytes in front of used.
+            void count_(size_t used) noexcept
+            {
+                size_t drop = std::min(skip_, used - mark_);
+
+                skip_ -= drop;
+                from_ += drop;
+                taken_ += used - mark_ - drop;
+                mark_ = used;
+            }
+
+            void install_(BufferPool::Chunk chunk) noexcept
+            {
+                chunk_ = std::move(chunk);
+                from_ = 0;
+                mark_ = 0;
+                if (chunk_)
+                {
+                    ctx_.flush = flush_;
+                    buffer_ = chunk_.data();
+                    sofab_ostream_buffer_set(&ctx_, buffer_, pool_.chunkSize(), 0);
+                    return;
+                }
+
+                ctx_.flush = nullptr;
+                buffer_ = stall_;
+                sofab_ostream_buffer_set(&ctx_, buffer_, 0, 0);
+            }
+
+            // Start over on a fresh chunk: a stalled write may have left the
+            // encoder mid-field.
+            void restart_(BufferPool::Chunk chunk) noexcept
+            {
+                chunk_ = std::move(chunk);
+                from_ = 0;
+                mark_ = 0;
+                buffer_ = chunk_.data();
+                sofab_ostream_init(&ctx_, buffer_, pool_.chunkSize(), 0, flush_, this);
+                failed_ = 0;
+            }
+        };
+
+        Sink &sink_;
+        BufferPool &pool_;
+        std::vector<Piece> pending_;                //!< Filled chunks not yet written.
+        ChunkStream stream_;                        //!< Destroyed before pending_.
+        Error failed_ = Error::None;                //!< Sticky sink failure or call error.
+
+        Task<Error> drain_(Error error)
+        {
+            for (auto &piece : pending_)
+            {
+                std::span<const uint8_t> bytes{piece.chunk.data() + piece.from, piece.to - piece.from};
+                if (failed_ == Error::None && !co_await sink_.write(bytes))
+                {
+                    failed_ = Error::BufferFull;
+                }
+                piece.chunk.reset();
+            }
+            pending_.clear();
+
+            if (error != Error::None && failed_ == Error::None)
+            {
+                failed_ = error;
+            }
+            co_return error != Error::None ? error : failed_;
+        }
+
+        // One call, repeated past the bytes already sent until a pass gets
+        // through without the pool running dry.
+        template <typename Encode>
+        Task<Error> run_(Encode encode)
+        {
+            size_t sent = 0;
+
+            for (;;)
+            {
+                if (!stream_.chunk_)
+                {
+                    BufferPool::Chunk chunk;
+                    while (!chunk)
+                    {
+                        chunk = co_await PoolAcquire{pool_};
+                    }
+                    stream_.restart_(std::move(chunk));
+                }
+
+                stream_.skip_ = sent;
+                stream_.taken_ = 0;
+                stream_.mark_ = stream_.bytesUsed();
+                Error error = encode(stream_);
+                if (stream_.chunk_)
+                {
+                    stream_.count_(stream_.bytesUsed());
+                }
+
+                if (error != Error::BufferFull || stream_.chunk_)
+                {
+                    co_return co_await drain_(error);
+                }
+
+                sent += stream_.taken_;
+                if (co_await drain_(Error::None) != Error::None)
+                {
+                    co_return failed_;
+                }
+            }
+        }
+
+    public:
+        /*!
+         * @brief Construct over a sink and a chunk pool.
+         * @param sink  Asynchronous byte sink; must outlive this encoder.
+         * @param pool  Chunk source; must outlive this encoder.
+         */
+        OStreamAsync(Sink &sink, BufferPool &pool) noexcept
+            : sink_{sink}
+            , pool_{pool}
+            , stream_{pool, pending_}
+        {
+            // A call can hold at most every chunk of the pool: reserving that
+            // once keeps the flush path free of allocation.
+            pending_.reserve(pool.chunkCount());
+        }
+
+        /*!
+         * @brief Encode one field and wait until the sink has taken its chunks.
+         * @param id     Field identifier.
+         * @param value  Anything @ref OStreamImpl::write accepts; must not
+         *               change until the call completes.
+         * @return The write's error, else the first sink failure, else None.
+         */
+        template <typename T>
+        Task<Error> write(sofab_id_t id, const T &value)
+        {
+            co_return co_await run_([&] (OStreamImpl &os) {
+                return os.write(id, value).code();
+            });
+        }
+
+        /*!
+         * @brief Encode a whole message and wait until the sink has taken its chunks.
+         * @param message  Message to serialize at top level; must not change
+         *                 until the call completes.
+         * @return The encode error, else the first sink failure, else None.
+         */
+        template <typename T>
+            requires std::derived_from<T, OStreamMessage>
+        Task<Error> encode(const T &message)
+        {
+            co_return co_await run_([&] (OStreamImpl &os) {
+                return message.serialize(os).code();
+            });
+        }
+
+        /*!
+         * @brief Hand the last partial chunk to the sink and wait for it.
+         * @return The first failure this encoder saw, or None.
+         */
+        Task<Error> flush()
+        {
+            stream_.flush();
+            stream_.install_({});
+            co_return co_await drain_(Error::None);
+        }
+
+        /*! @brief Whether every call so far, and the sink, has succeeded. */
+        [[nodiscard]] bool ok() const noexcept
+        {
+            return failed_ == Error::None && stream_.ok();
+        }
+    };
+};
+
+/** @} */ // end of defgroup
+
+#endif // SOFAB_CORO_HPP
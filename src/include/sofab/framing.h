@@ -0,0 +1,469 @@
+/*!
+ * @file framing.h
+ * @brief SofaBuffers C - Length-delimited framing for streams of messages.
+ *
+ * A Sofab message carries no end marker: the all-default message is the empty
+ * byte string (MESSAGE_SPEC §2), and a decoder fed two messages back to back
+ * reads them as one. Anything that carries more than one message over a byte
+ * stream (a socket, a pipe, a log file) therefore needs a framing of its own.
+ * This module provides the one this library uses: every message is preceded by
+ * its length as a LEB128 varint, the same varint the wire format uses.
+ *
+ *     frame := varint(len) message[len]
+ *
+ * Writer: @ref sofab_framing_begin initializes an output stream over the
+ * caller's buffer with @ref SOFAB_FRAMING_PREFIX_MAX bytes of header room
+ * reserved at its start (the @c offset of sofab_ostream_init()); the message is
+ * encoded after it as usual, and @ref sofab_framing_end patches the length
+ * into the tail of that room once it is known. The payload is never moved, so
+ * the frame starts up to @ref SOFAB_FRAMING_PREFIX_MAX - 1 bytes into the
+ * buffer; the function returns where.
+ *
+ * Reader: a @ref sofab_framing_reader_t splits an arbitrary byte stream, chunked
+ * anywhere (inside the prefix included), into frames and decodes each with a
+ * fresh sofab_istream_t. The begin callback initializes that stream for the
+ * frame, the end callback receives the frame's verdict. A frame whose message is
+ * malformed or truncated is reported as such and the reader continues with the
+ * next frame, since the prefix already said where that one starts; only a
+ * malformed prefix loses the framing and stops the reader.
+ *
+ * Checked frames carry a CRC32C of the frame so far after the message, for
+ * links that corrupt bytes rather than lose them:
+ *
+ *     frame := varint(len) message[len] crc32c(varint(len) message[len])[4]
+ *
+ * with the check little-endian. The @c _checked writer computes it over the
+ * frame just encoded, while it is still in cache; the checked reader updates it
+ * chunk by chunk as it feeds the decoder, so no byte is read twice, and fails a
+ * frame whose check does not match. Both sides must agree on the variant: a
+ * stream carries one or the other.
+ *
+ * Resynchronization: the framing has no sync marker, so after a corrupted or
+ * lost stretch the next frame can start at any byte. @ref sofab_framing_resync
+ * tries every offset in turn: the prefix must be well-formed and minimal, the
+ * frame complete, the message exactly one well-formed message by a structural
+ * scan (the decoder's grammar and limits, no callbacks), and a checked frame's
+ * check must match; an unchecked candidate must also not be followed by a
+ * malformed frame. A reader given a window with
+ * @ref sofab_framing_reader_resync does this itself where it would otherwise
+ * lose the framing: it keeps the bytes that follow in the window, drops what
+ * cannot start a frame and resumes decoding at the first candidate that
+ * passes. A checked reader also resynchronizes after a failed check, since the
+ * length that led there is in doubt. Checked frames make a false start all but
+ * impossible (a 32-bit check); with unchecked ones the structural scan is all
+ * there is, and a payload that happens to look like frames can be taken for
+ * them.
+ *
+ * Typical usage:
+ *  - Writer: sofab_framing_begin(), sofab_ostream_write_*(), sofab_framing_end(),
+ *    then send the returned frame.
+ *  - Reader: sofab_framing_reader_init() once, sofab_framing_reader_feed() for
+ *    every chunk received.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_FRAMING_H
+#define SOFAB_FRAMING_H
+
+/**
+ * @defgroup c_api C API
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SOFAB_FRAMING_C
+# define SOFAB_FRAMING_EXTERN extern
+#else
+# define SOFAB_FRAMING_EXTERN
+#endif
+
+/* includes *******************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sofab/istream.h"
+#include "sofab/ostream.h"
+
+/* constants ******************************************************************/
+
+/*!
+ * @brief Largest message a frame can carry, in bytes.
+ *
+ * The prefix is a 32-bit length whatever the width of @ref sofab_unsigned_t, so
+ * the framing is the same on every target; a reader rejects a prefix above this
+ * (or above @c SIZE_MAX, on a target with a narrower @c size_t) as malformed.
+ */
+#define SOFAB_FRAMING_LEN_MAX       (UINT32_MAX)
+
+/*!
+ * @brief Header room sofab_framing_begin() reserves for the length prefix.
+ *
+ * A varint of @ref SOFAB_FRAMING_LEN_MAX takes 5 bytes; shorter lengths use
+ * fewer and leave the head of this room unused.
+ */
+#define SOFAB_FRAMING_PREFIX_MAX    (5)
+
+/*!
+ * @brief Bytes of the CRC32C that ends a checked frame.
+ */
+#define SOFAB_FRAMING_CHECK_LEN     (4)
+
+/* types **********************************************************************/
+
+/*!
+ * @brief Opaque frame reader context.
+ */
+typedef struct sofab_framing_reader sofab_framing_reader_t;
+
+/*!
+ * @brief Called when a frame's prefix is complete, before any of its payload.
+ *
+ * Must initialize @p is with sofab_istream_init() for this frame, with the field
+ * callback and destination the message is to be decoded into. This is also the
+ * place to reset that destination (e.g. sofab_object_init()), since every frame
+ * is a new message.
+ *
+ * @param ctx     Reader context.
+ * @param is      The stream that will decode this frame.
+ * @param len     Message length in bytes (0 for the all-default message).
+ * @param usrptr  User pointer given to sofab_framing_reader_init().
+ */
+typedef void (*sofab_framing_begin_cb_t) (
+    sofab_framing_reader_t *ctx, sofab_istream_t *is, size_t len, void *usrptr);
+
+/*!
+ * @brief Called when a frame's last byte has been decoded.
+ *
+ * @p result is @ref SOFAB_RET_OK if the frame held exactly one complete message,
+ * and @ref SOFAB_RET_E_INVALID_MSG if the message was malformed or did not end
+ * where the frame did (a truncated message is invalid here, unlike in
+ * sofab_istream_feed(): the frame is complete, so no more bytes can follow). On
+ * @ref SOFAB_RET_E_INVALID_MSG discard whatever the frame decoded.
+ *
+ * @param ctx     Reader context.
+ * @param is      The stream that decoded this frame (valid until the next frame).
+ * @param result  Verdict on the frame's message.
+ * @param usrptr  User pointer given to sofab_framing_reader_init().
+ */
+typedef void (*sofab_framing_end_cb_t) (
+    sofab_framing_reader_t *ctx, sofab_istream_t *is, sofab_ret_t result, void *usrptr);
+
+/*!
+ * @brief Frame reader context.
+ */
+struct sofab_framing_reader
+{
+    sofab_istream_t istream;            /*!< Decoder of the current frame */
+    sofab_framing_begin_cb_t begin;     /*!< Frame start callback */
+    sofab_framing_end_cb_t end;         /*!< Frame end callback */
+    void *usrptr;                       /*!< User pointer for both callbacks */
+    size_t remaining;                   /*!< Payload bytes of the current frame still to come */
+    uint32_t prefix;                    /*!< Length prefix under construction */
+    sofab_ret_t result;                 /*!< Outcome of the current frame's last feed */
+    uint32_t crc;                       /*!< CRC32C of the current frame so far (checked frames) */
+    uint32_t check;                     /*!< Check under construction (checked frames) */
+    uint8_t *window;                    /*!< Resynchronization window, NULL if none */
+    size_t window_size;                 /*!< Size of @c window */
+    size_t window_len;                  /*!< Bytes held in @c window */
+    size_t window_scan;                 /*!< Where the search of @c window goes on */
+    size_t skipped;                     /*!< Bytes dropped while resynchronizing */
+    uint8_t prefix_shift;               /*!< Bits of @c prefix received so far */
+    uint8_t check_len;                  /*!< Bytes of @c check received so far */
+    uint8_t checked;                    /*!< Frames end in a CRC32C */
+    uint8_t hold;                       /*!< @c window holds the current frame so far */
+    uint8_t state;                      /*!< Internal: prefix, payload, check, invalid or resync */
+};
+
+/* prototypes *****************************************************************/
+
+/*!
+ * @brief Encode the length prefix of a frame.
+ *
+ * For a writer that has the message already and writes the frame itself, e.g.
+ * with a gathering write of prefix and message.
+ *
+ * @param out  Destination, at least @ref SOFAB_FRAMING_PREFIX_MAX bytes.
+ * @param len  Message length.
+ *
+ * @return Bytes written to @p out.
+ */
+extern size_t sofab_framing_prefix (uint8_t *out, uint32_t len);
+
+/*!
+ * @brief Start encoding a framed message into @p buffer.
+ *
+ * Initializes @p os over @p buffer with @ref SOFAB_FRAMING_PREFIX_MAX bytes
+ * reserved for the prefix and no flush callback: the prefix is only known once
+ * the whole message is, so the whole frame must fit in @p buffer. A message
+ * that does not reports @ref SOFAB_RET_E_BUFFER_FULL from the write that
+ * overflows, as any unflushed stream does.
+ *
+ * @param os      Output stream to initialize.
+ * @param buffer  Buffer for the frame.
+ * @param buflen  Size of @p buffer, at least @ref SOFAB_FRAMING_PREFIX_MAX.
+ */
+extern void sofab_framing_begin (sofab_ostream_t *os, uint8_t *buffer, size_t buflen);
+
+/*!
+ * @brief Finish the framed message started by sofab_framing_begin().
+ *
+ * Writes the length prefix directly in front of the encoded message, in the
+ * room sofab_framing_begin() reserved. Every lazily opened sequence must have
+ * been closed.
+ *
+ * @param os        Output stream set up by sofab_framing_begin().
+ * @param frame     Receives the start of the frame (within the buffer).
+ * @param framelen  Receives the frame length, prefix included.
+ *
+ * @return SOFAB_RET_OK, or SOFAB_RET_E_ARGUMENT if the message is longer than
+ *         @ref SOFAB_FRAMING_LEN_MAX.
+ */
+extern sofab_ret_t sofab_framing_end (
+    sofab_ostream_t *os, uint8_t **frame, size_t *framelen);
+
+/*!
+ * @brief Start encoding a checked framed message into @p buffer.
+ *
+ * As sofab_framing_begin(), and keeps the last @ref SOFAB_FRAMING_CHECK_LEN
+ * bytes of @p buffer out of the stream's reach for the check.
+ *
+ * @param os      Output stream to initialize.
+ * @param buffer  Buffer for the frame.
+ * @param buflen  Size of @p buffer, at least @ref SOFAB_FRAMING_PREFIX_MAX +
+ *                @ref SOFAB_FRAMING_CHECK_LEN.
+ */
+extern void sofab_framing_begin_checked (sofab_ostream_t *os, uint8_t *buffer, size_t buflen);
+
+/*!
+ * @brief Finish the checked framed message started by
+ *        sofab_framing_begin_checked().
+ *
+ * Writes the prefix as sofab_framing_end() does and the CRC32C of prefix and
+ * message behind the message.
+ *
+ * @param os        Output stream set up by sofab_framing_begin_checked().
+ * @param frame     Receives the start of the frame (within the buffer).
+ * @param framelen  Receives the frame length, prefix and check included.
+ *
+ * @return SOFAB_RET_OK, or SOFAB_RET_E_ARGUMENT if the message is longer than
+ *         @ref SOFAB_FRAMING_LEN_MAX.
+ */
+extern sofab_ret_t sofab_framing_end_checked (
+    sofab_ostream_t *os, uint8_t **frame, size_t *framelen);
+
+/*!
+ * @brief Initialize a frame reader.
+ *
+ * @param ctx     Reader context.
+ * @param begin   Frame start callback (required, see @ref sofab_framing_begin_cb_t).
+ * @param end     Frame end callback (required, see @ref sofab_framing_end_cb_t).
+ * @param usrptr  User pointer passed to both callbacks.
+ */
+extern void sofab_framing_reader_init (
+    sofab_framing_reader_t *ctx, sofab_framing_begin_cb_t begin,
+    sofab_framing_end_cb_t end, void *usrptr);
+
+/*!
+ * @brief Initialize a reader of checked frames.
+ *
+ * As sofab_framing_reader_init(). A frame whose check does not match is
+ * reported to the end callback as @ref SOFAB_RET_E_INVALID_MSG, even where the
+ * message decoded; the reader goes on with the next frame.
+ *
+ * @param ctx     Reader context.
+ * @param begin   Frame start callback (required, see @ref sofab_framing_begin_cb_t).
+ * @param end     Frame end callback (required, see @ref sofab_framing_end_cb_t).
+ * @param usrptr  User pointer passed to both callbacks.
+ */
+extern void sofab_framing_reader_init_checked (
+    sofab_framing_reader_t *ctx, sofab_framing_begin_cb_t begin,
+    sofab_framing_end_cb_t end, void *usrptr);
+
+/*!
+ * @brief Let a reader resynchronize instead of losing the framing.
+ *
+ * With a window, a malformed prefix (and, for a checked reader, a failed
+ * check) no longer stops the reader: the bytes that follow are collected in
+ * @p window and searched as by sofab_framing_resync(), and decoding resumes at
+ * the first frame found. A frame longer than the window cannot be found; it is
+ * skipped along with the garbage. A checked reader also keeps every frame that
+ * fits in the window there until its check passed; should it fail, the search
+ * starts at the frame's second byte, so frames its wrong length ran into are
+ * still found. The search goes on from where it stopped as bytes arrive, at a
+ * cost of a few candidates per byte; a frame behind two false starts that are
+ * still incomplete is found once one of them is decided, at the latest when
+ * the window is full. Call after sofab_framing_reader_init() or
+ * sofab_framing_reader_init_checked().
+ *
+ * @param ctx     Reader context.
+ * @param window  Buffer, valid for the life of the reader.
+ * @param size    Size of @p window, at least @ref SOFAB_FRAMING_PREFIX_MAX +
+ *                @ref SOFAB_FRAMING_CHECK_LEN; best the longest frame expected.
+ */
+extern void sofab_framing_reader_resync (
+    sofab_framing_reader_t *ctx, uint8_t *window, size_t size);
+
+/*!
+ * @brief Feed the next chunk of a framed byte stream.
+ *
+ * Chunks may split the stream anywhere. Every frame completed by this chunk has
+ * run through both callbacks before the call returns, zero-length frames
+ * included.
+ *
+ * @param ctx      Reader context.
+ * @param data     Bytes received (may be NULL when @p datalen is 0).
+ * @param datalen  Length of @p data in bytes.
+ *
+ * @return SOFAB_RET_OK if the stream so far ends on a frame boundary,
+ *         SOFAB_RET_INCOMPLETE if it ends inside a prefix, a payload or a
+ *         check, or
+ *         SOFAB_RET_E_INVALID_MSG if a length prefix was malformed (too wide, or
+ *         above @ref SOFAB_FRAMING_LEN_MAX). The last is sticky: the framing is
+ *         lost, nothing more is decoded, and only sofab_framing_reader_init()
+ *         starts over. A malformed @e message is not reported here but by the
+ *         end callback, and does not stop the reader. A reader with a
+ *         resynchronization window never reports SOFAB_RET_E_INVALID_MSG;
+ *         it is SOFAB_RET_INCOMPLETE while it searches.
+ */
+extern sofab_ret_t sofab_framing_reader_feed (
+    sofab_framing_reader_t *ctx, const void *data, size_t datalen);
+
+/*!
+ * @brief Update a CRC32C (Castagnoli) with @p len more bytes.
+ *
+ * Start from 0; the value after the last chunk is the CRC32C of all of them.
+ * Runs on the SSE4.2 or ARMv8 CRC instructions where the CPU has them.
+ *
+ * @param crc   CRC32C of the bytes so far.
+ * @param data  Next bytes (may be NULL when @p len is 0).
+ * @param len   Length of @p data in bytes.
+ *
+ * @return CRC32C of the bytes so far and @p data.
+ */
+extern uint32_t sofab_crc32c (uint32_t crc, const void *data, size_t len);
+
+/*!
+ * @brief Locate and check the first frame of a buffer that holds whole checked
+ *        frames.
+ *
+ * As sofab_framing_next(); the next frame starts at @p data + @p *prefixlen +
+ * @p *msglen + @ref SOFAB_FRAMING_CHECK_LEN.
+ *
+ * @param data       Start of the frame.
+ * @param len        Bytes available at @p data.
+ * @param prefixlen  Receives the prefix length.
+ * @param msglen     Receives the message length.
+ *
+ * @return SOFAB_RET_OK if the whole frame lies within @p len bytes and its
+ *         check matches, SOFAB_RET_INCOMPLETE if it runs past them (or @p len is
+ *         0), or SOFAB_RET_E_INVALID_MSG if the prefix is malformed or the check
+ *         does not match.
+ */
+extern sofab_ret_t sofab_framing_next_checked (
+    const uint8_t *data, size_t len, size_t *prefixlen, size_t *msglen);
+
+/*!
+ * @brief Find the next plausible frame start in a buffer.
+ *
+ * Tries every offset of @p data, as described for resynchronization above, and
+ * stops at the first candidate that passes.
+ *
+ * @param data  Bytes to search.
+ * @param len   Length of @p data.
+ * @param skip  Receives the offset of the frame found; without one, the number
+ *              of bytes that cannot start a frame (those from there on may,
+ *              once more bytes follow).
+ *
+ * @return SOFAB_RET_OK if a frame was found, SOFAB_RET_INCOMPLETE otherwise.
+ */
+extern sofab_ret_t sofab_framing_resync (const uint8_t *data, size_t len, size_t *skip);
+
+/*!
+ * @brief Find the next plausible checked frame start in a buffer.
+ *
+ * As sofab_framing_resync(), for checked frames: a candidate's check must
+ * match.
+ *
+ * @param data  Bytes to search.
+ * @param len   Length of @p data.
+ * @param skip  As for sofab_framing_resync().
+ *
+ * @return SOFAB_RET_OK if a frame was found, SOFAB_RET_INCOMPLETE otherwise.
+ */
+extern sofab_ret_t sofab_framing_resync_checked (const uint8_t *data, size_t len, size_t *skip);
+
+/* inline convenience functions ***********************************************/
+
+/*!
+ * @brief Bytes a reader has dropped while resynchronizing, in total.
+ *
+ * @param ctx  Reader context.
+ * @return Bytes dropped since sofab_framing_reader_init().
+ */
+static inline size_t sofab_framing_reader_skipped (const sofab_framing_reader_t *ctx)
+{
+    return ctx->skipped;
+}
+
+/*!
+ * @brief Locate the first frame of a buffer that holds whole frames.
+ *
+ * The contiguous-input counterpart of the reader, for a caller that already
+ * has the frames in memory (a file read or mapped whole, a received batch) and
+ * wants to walk them without a per-byte state machine. The next frame starts
+ * at @p data + @p *prefixlen + @p *msglen.
+ *
+ * @param data       Start of the frame.
+ * @param len        Bytes available at @p data.
+ * @param prefixlen  Receives the prefix length.
+ * @param msglen     Receives the message length.
+ *
+ * @return SOFAB_RET_OK if the whole frame lies within @p len bytes,
+ *         SOFAB_RET_INCOMPLETE if it runs past them (or @p len is 0), or
+ *         SOFAB_RET_E_INVALID_MSG if the prefix is malformed.
+ */
+static inline sofab_ret_t sofab_framing_next (
+    const uint8_t *data, size_t len, size_t *prefixlen, size_t *msglen)
+{
+    uint32_t value = 0;
+
+    for (size_t i = 0; i < SOFAB_FRAMING_PREFIX_MAX; i++)
+    {
+        if (i == len)
+        {
+            return SOFAB_RET_INCOMPLETE;
+        }
+        /* the fifth byte may only carry the top 4 of the 32 bits */
+        if (i == SOFAB_FRAMING_PREFIX_MAX - 1 && (data[i] & 0xF0) != 0)
+        {
+            return SOFAB_RET_E_INVALID_MSG;
+        }
+        value |= (uint32_t)(data[i] & 0x7F) << (7 * i);
+        if ((data[i] & 0x80) == 0)
+        {
+#if SIZE_MAX < UINT32_MAX
+            if (value > SIZE_MAX)
+            {
+                return SOFAB_RET_E_INVALID_MSG;
+            }
+#endif
+            *prefixlen = i + 1;
+            *msglen = (size_t)value;
+            return (size_t)value <= len - (i + 1) ? SOFAB_RET_OK : SOFAB_RET_INCOMPLETE;
+        }
+    }
+
+    return SOFAB_RET_E_INVALID_MSG; /* not reached: the fifth byte ends the loop */
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */ // end of defgroup
+
+#endif /* SOFAB_FRAMING_H */
@@ -112,6 +112,28 @@ typedef struct sofab_istream_decoder
     uint8_t skip_depth;                         /*!< Counter for skipped nested fields */
 } sofab_istream_decoder_t;
 
+#if SOFAB_STATS
+/*!
+ * @brief Traffic statistics of an input stream (@ref SOFAB_STATS).
+ *
+ * Reset by @ref sofab_istream_init and @ref sofab_istream_reset, so they
+ * describe one message; aggregate across messages by adding them up before the
+ * next reset. Bytes that are neither copied nor skipped are framing: field
+ * headers, lengths and counts.
+ * The mean field size is @c bytes / @c fields.
+ */
+typedef struct sofab_istream_stats
+{
+    uint64_t feeds;          /*!< sofab_istream_feed() calls */
+    uint64_t bytes;          /*!< Bytes fed */
+    uint64_t bytes_copied;   /*!< Payload bytes decoded into a bound destination */
+    uint64_t bytes_skipped;  /*!< Payload bytes of fields nobody bound */
+    uint64_t fields;         /*!< Field headers decoded (sequence ends excluded) */
+    uint64_t callbacks;      /*!< Field callback invocations */
+    uint8_t max_depth;       /*!< Deepest sequence nesting reached */
+} sofab_istream_stats_t;
+#endif /* SOFAB_STATS */
+
 /*!
  * @brief Internal state of the Sofab input stream.
  */
@@ -157,6 +179,9 @@ struct sofab_istream
                                                  *!< skipped per MESSAGE_SPEC 7.3
                                                  *!< (@ref sofab_istream_skipped) */
 #endif
+#if SOFAB_STATS
+    sofab_istream_stats_t stats;                /*!< Traffic statistics (@ref sofab_istream_stats) */
+#endif
 };
 
 /* prototypes *****************************************************************/
@@ -174,6 +199,18 @@ struct sofab_istream
 extern void sofab_istream_init (
     sofab_istream_t *ctx, sofab_istream_field_cb_t field_callback, void *usrptr);
 
+/*!
+ * @brief Readies an input stream for the next message.
+ *
+ * The same state as after @ref sofab_istream_init, with the top-level field
+ * callback and user pointer kept, whatever the previous message ended in: a
+ * verdict, an error or the middle of a field. Cheaper than a fresh init when
+ * one stream decodes many messages.
+ *
+ * @param ctx  Pointer to an input stream context set up by sofab_istream_init().
+ */
+extern void sofab_istream_reset (sofab_istream_t *ctx);
+
 /*!
  * @brief Feeds raw Sofab-encoded bytes into the input stream.
  *
@@ -198,10 +235,10 @@ extern void sofab_istream_init (
  * continuation of bytes can make rejected input valid. Once this function returns
  * @ref SOFAB_RET_E_INVALID_MSG it returns it for every subsequent call on the same
  * context, no further field callback fires, and the only way forward is
- * @ref sofab_istream_init. That is enforcement, not just documentation: the
- * decoder stops mid-message but keeps its position, so resuming would
- * resynchronize on the *payload* of the field it just refused and deliver those
- * bytes as if they were new field headers.
+ * @ref sofab_istream_init or @ref sofab_istream_reset. That is enforcement, not
+ * just documentation: the decoder stops mid-message but keeps its position, so
+ * resuming would resynchronize on the *payload* of the field it just refused and
+ * deliver those bytes as if they were new field headers.
  *
  * The rejection does @b not un-deliver what already arrived. Fields decoded before
  * the offending one are already in the caller's destinations — a streaming decoder
@@ -249,7 +286,8 @@ extern sofab_ret_t sofab_istream_feed (
  * one) returns @ref SOFAB_RET_E_INVALID_MSG regardless of what else is decoded,
  * and no further field callback fires. The flag is set synchronously inside the
  * callback, so it takes effect even when the field's payload fill is deferred
- * across chunked feeds. It is cleared only by @ref sofab_istream_init.
+ * across chunked feeds. It is cleared only by @ref sofab_istream_init and
+ * @ref sofab_istream_reset.
  *
  * @param ctx  Pointer to the input stream context.
  */
@@ -269,7 +307,8 @@ extern void sofab_istream_invalidate (sofab_istream_t *ctx);
  * decoded successfully means the two sides disagree about what an id means —
  * useful in a log or a health metric, and the signal that used to be reported as
  * a usage error. The count saturates at 255; only zero versus non-zero
- * carries meaning. It is cleared by @ref sofab_istream_init.
+ * carries meaning. It is cleared by @ref sofab_istream_init and
+ * @ref sofab_istream_reset.
  *
  * @param ctx  Pointer to the input stream context.
  * @return Number of type-contradicting fields skipped, saturating at 255.
@@ -278,6 +317,18 @@ extern void sofab_istream_invalidate (sofab_istream_t *ctx);
 extern uint8_t sofab_istream_skipped (const sofab_istream_t *ctx);
 #endif
 
+/*!
+ * @brief Traffic statistics of the message decoded so far.
+ *
+ * Only with @ref SOFAB_STATS. Valid until the next feed or init of @p ctx.
+ *
+ * @param ctx  Pointer to the input stream context.
+ * @return The context's counters (see @ref sofab_istream_stats_t).
+ */
+#if SOFAB_STATS
+extern const sofab_istream_stats_t *sofab_istream_stats (const sofab_istream_t *ctx);
+#endif
+
 /* read functions *************************************************************/
 
 /*!
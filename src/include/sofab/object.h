@@ -557,6 +557,59 @@ extern void sofab_object_field_cb (
     size_t count,
     void *usrptr);
 
+/*!
+ * @brief Decode a buffer of framed messages into an array of objects.
+ *
+ * The bulk counterpart of driving @ref sofab_object_field_cb one message at a
+ * time. @p frames holds messages in the length-delimited framing of
+ * @c sofab/framing.h, back to back; record @c i is decoded into
+ * @c (uint8_t*)dst @c + @c i*stride, after @ref sofab_object_init has reset it,
+ * and its verdict stored in @c status[i]. One input stream and one decoder
+ * chain serve the whole batch: @p dec is set up once by the caller, as for
+ * @ref sofab_object_field_cb (@c info and @c depth of the first slot, one slot
+ * per nesting level), and only its destination moves from record to record;
+ * the stream is reset between records, not re-initialized. The top-level
+ * fields are found through a table built once per batch rather than by a
+ * search of the descriptor per field. While a record decodes, the next frame
+ * and the next destination are prefetched.
+ *
+ * A record whose message is malformed, or ends before its frame does, gets
+ * @ref SOFAB_RET_E_INVALID_MSG in @p status and the batch carries on with the
+ * next frame. The batch stops after @p n records, at the end of @p frames, at a
+ * frame that runs past the end of @p frames (a partial tail, to be completed by
+ * the next read), or at a malformed length prefix.
+ *
+ * @param dec     Decoder chain; @c dec[0].info and @c dec[0].depth set, the
+ *                destination is set per record.
+ * @param frames  Framed input (may be NULL when @p len is 0).
+ * @param len     Length of @p frames in bytes.
+ * @param dst     First destination object.
+ * @param stride  Distance between destination objects in bytes (usually the
+ *                element size of the caller's array).
+ * @param n       Capacity of @p dst and @p status, in records.
+ * @param status  Receives one verdict per decoded record: SOFAB_RET_OK or
+ *                SOFAB_RET_E_INVALID_MSG.
+ * @param count   Receives the number of records decoded.
+ * @param used    Receives the bytes consumed: the start of the first frame not
+ *                decoded. May be NULL.
+ *
+ * @return SOFAB_RET_OK if the batch stopped on a frame boundary (after @p n
+ *         records or with @p frames used up), SOFAB_RET_INCOMPLETE if
+ *         @p frames ends inside a frame, SOFAB_RET_E_INVALID_MSG if a length
+ *         prefix is malformed (the framing is lost from @p used on), or the
+ *         error of @ref sofab_object_init for a defective descriptor.
+ */
+extern sofab_ret_t sofab_object_decode_batch (
+    sofab_object_decoder_t *dec,
+    const void *frames,
+    size_t len,
+    void *dst,
+    size_t stride,
+    size_t n,
+    sofab_ret_t *status,
+    size_t *count,
+    size_t *used);
+
 #ifdef __cplusplus
 }
 #endif
@@ -143,6 +143,21 @@ typedef void (*sofab_ostream_flush_cb_t) (
 #  endif
 #endif /* SEQUENCE && LAZY_SEQ */
 
+#if SOFAB_STATS
+/*!
+ * @brief Traffic statistics of an output stream (@ref SOFAB_STATS).
+ *
+ * Reset by @ref sofab_ostream_init, not by @ref sofab_ostream_buffer_set. The
+ * mean bytes per flush is @c bytes_flushed / @c flushes; bytes still in the
+ * buffer are @ref sofab_ostream_bytes_used.
+ */
+typedef struct sofab_ostream_stats
+{
+    uint64_t flushes;        /*!< Flush callback invocations */
+    uint64_t bytes_flushed;  /*!< Bytes handed to the flush callback */
+} sofab_ostream_stats_t;
+#endif /* SOFAB_STATS */
+
 struct sofab_ostream
 {
     uint8_t *buffer;                /*!< Pointer to the start of the active buffer. */
@@ -166,6 +181,9 @@ struct sofab_ostream
     sofab_id_t pending[SOFAB_LAZY_SEQ_DEPTH];
     uint8_t npending;               /*!< Valid entries in @c pending. */
 #endif /* SEQUENCE && LAZY_SEQ */
+#if SOFAB_STATS
+    sofab_ostream_stats_t stats;    /*!< Traffic statistics (@ref sofab_ostream_stats) */
+#endif
 };
 
 /* prototypes *****************************************************************/
@@ -260,6 +278,18 @@ extern size_t sofab_ostream_bytes_used (sofab_ostream_t *ctx);
 extern void sofab_ostream_buffer_set (
     sofab_ostream_t *ctx, uint8_t *buffer, size_t buflen, size_t offset);
 
+/*!
+ * @brief Traffic statistics since the stream was initialized.
+ *
+ * Only with @ref SOFAB_STATS.
+ *
+ * @param ctx  Pointer to the output stream context.
+ * @return The context's counters (see @ref sofab_ostream_stats_t).
+ */
+#if SOFAB_STATS
+extern const sofab_ostream_stats_t *sofab_ostream_stats (const sofab_ostream_t *ctx);
+#endif
+
 /* write functions ************************************************************/
 
 /*!
@@ -470,6 +500,99 @@ extern sofab_ret_t sofab_ostream_write_array_of_fixlen (
 #endif /* !defined(SOFAB_DISABLE_FIXLEN_SUPPORT) */
 #endif /* !defined(SOFAB_DISABLE_ARRAY_SUPPORT) */
 
+/* streamed array functions ***************************************************/
+
+#if !defined(SOFAB_DISABLE_ARRAY_SUPPORT)
+/*!
+ * @brief Begin a varint array whose elements are supplied one at a time.
+ *
+ * Writes the field header and the element count, exactly as the
+ * sofab_ostream_write_array_of_*() writers do, but takes no element data. The
+ * caller follows up with @p element_count calls to
+ * sofab_ostream_write_array_element_unsigned() (for
+ * @ref SOFAB_TYPE_VARINTARRAY_UNSIGNED) or
+ * sofab_ostream_write_array_element_signed() (for
+ * @ref SOFAB_TYPE_VARINTARRAY_SIGNED). This lets an encoder stream elements that
+ * are computed, filtered or strided without first collecting them into a
+ * contiguous array; the bytes are identical to the contiguous writer's.
+ *
+ * The count is on the wire before the first element, so writing any other
+ * number of elements produces a malformed message. Nothing else may be written
+ * to @p ctx until the last element is.
+ *
+ * @param ctx            Pointer to the output stream context.
+ * @param id             Field identifier.
+ * @param type           @ref SOFAB_TYPE_VARINTARRAY_UNSIGNED or
+ *                       @ref SOFAB_TYPE_VARINTARRAY_SIGNED.
+ * @param element_count  Number of elements that will follow.
+ *
+ * @return SOFAB_RET_OK on success, otherwise an error code.
+ */
+extern sofab_ret_t sofab_ostream_write_array_begin (
+    sofab_ostream_t *ctx, sofab_id_t id, sofab_type_t type, int32_t element_count);
+
+/*!
+ * @brief Write one element of an array opened by sofab_ostream_write_array_begin().
+ *
+ * @param ctx    Pointer to the output stream context.
+ * @param value  Element value.
+ *
+ * @return SOFAB_RET_OK on success, otherwise an error code.
+ */
+extern sofab_ret_t sofab_ostream_write_array_element_unsigned (
+    sofab_ostream_t *ctx, sofab_unsigned_t value);
+
+/*!
+ * @brief Write one element of an array opened by sofab_ostream_write_array_begin()
+ *        (ZigZag encoded).
+ *
+ * @param ctx    Pointer to the output stream context.
+ * @param value  Element value.
+ *
+ * @return SOFAB_RET_OK on success, otherwise an error code.
+ */
+extern sofab_ret_t sofab_ostream_write_array_element_signed (
+    sofab_ostream_t *ctx, sofab_signed_t value);
+
+#if !defined(SOFAB_DISABLE_FIXLEN_SUPPORT)
+/*!
+ * @brief Begin a fixed-length array whose elements are supplied one at a time.
+ *
+ * The fixlen counterpart of sofab_ostream_write_array_begin(): writes the
+ * header, the element count and the shared fixlen word, then expects
+ * @p element_count calls to sofab_ostream_write_array_element_fixlen().
+ * Only floating-point types (FP32, FP64) are supported.
+ *
+ * @param ctx            Pointer to the output stream context.
+ * @param id             Field identifier.
+ * @param element_count  Number of elements that will follow.
+ * @param element_size   Size of each element in bytes.
+ * @param type           Semantic fixed-length type of elements.
+ *
+ * @return SOFAB_RET_OK on success, otherwise an error code.
+ */
+extern sofab_ret_t sofab_ostream_write_array_begin_fixlen (
+    sofab_ostream_t *ctx, sofab_id_t id,
+    int32_t element_count, int32_t element_size, sofab_fixlentype_t type);
+
+/*!
+ * @brief Write one element of an array opened by
+ *        sofab_ostream_write_array_begin_fixlen().
+ *
+ * The element is given in host byte order; on a big-endian host it is
+ * reversed on its way out, as in sofab_ostream_write_array_of_fixlen().
+ *
+ * @param ctx           Pointer to the output stream context.
+ * @param data          Pointer to the element.
+ * @param element_size  Size of the element in bytes (as passed to the opener).
+ *
+ * @return SOFAB_RET_OK on success, otherwise an error code.
+ */
+extern sofab_ret_t sofab_ostream_write_array_element_fixlen (
+    sofab_ostream_t *ctx, const void *data, int32_t element_size);
+#endif /* !defined(SOFAB_DISABLE_FIXLEN_SUPPORT) */
+#endif /* !defined(SOFAB_DISABLE_ARRAY_SUPPORT) */
+
 /* inline convenience array functions *****************************************/
 
 #if !defined(SOFAB_DISABLE_ARRAY_SUPPORT)
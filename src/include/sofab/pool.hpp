@@ -0,0 +1,493 @@
+/*!
+ * @file pool.hpp
+ * @brief SofaBuffers C++ - recycled chunk buffers for streamed encoding.
+ *
+ * The chunked streaming pattern — a flush callback hands the filled buffer to
+ * a sink and installs a fresh one — costs a @c std::shared_ptr allocation and
+ * refcount block per chunk when built on @ref sofab::OStream::setBuffer. At a
+ * few GB/s that allocator traffic dominates the encoder. This header replaces
+ * it with a fixed set of equally sized chunks, allocated once, that a sink
+ * returns simply by dropping the handle it was given.
+ *
+ * Kept out of `sofab.hpp` because it needs @c <atomic> with a lock-free 64-bit
+ * compare-and-swap, which a host has and a small MCU may not; nothing in the
+ * core wrapper depends on it.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_POOL_HPP
+#define SOFAB_POOL_HPP
+
+/**
+ * @defgroup cpp_api C++ API
+ * @{
+ */
+
+/* includes *******************************************************************/
+#include "sofab/sofab.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
+
+/* types **********************************************************************/
+namespace sofab
+{
+    /*!
+     * @brief Fixed set of equally sized byte chunks behind a lock-free free-list.
+     *
+     * All storage is allocated by the constructor; @ref acquire and the release
+     * done by a @ref Chunk handle never allocate, lock or block, and may be
+     * called from any thread. The free-list is a Treiber stack over chunk
+     * indices whose head carries a generation tag next to the index, so a
+     * chunk released and re-acquired between another thread's load and its
+     * compare-and-swap cannot be mistaken for the head it saw (ABA).
+     *
+     * A taker that cannot go on without a chunk may @ref wait for one instead
+     * of polling. Only then does a release take a lock: while a @ref Waiter is
+     * registered, the release that frees a chunk notifies every waiter.
+     *
+     * The pool must outlive every @ref Chunk handed out from it.
+     */
+    class BufferPool
+    {
+    public:
+        /*!
+         * @brief Owning handle to one chunk; returns it to the pool when dropped.
+         *
+         * Move-only. Carries the number of bytes the encoder filled, so a sink
+         * can queue the handle itself — instead of a borrowed span that dies
+         * with the flush callback — and release the chunk whenever the bytes
+         * have gone out.
+         */
+        class Chunk
+        {
+            BufferPool *pool_ = nullptr;    //!< Owner, or nullptr when empty.
+            uint32_t index_ = 0;            //!< Chunk index within the pool.
+            size_t size_ = 0;               //!< Bytes filled by the encoder.
+
+            friend class BufferPool;
+            friend class OStreamPooled;
+
+            Chunk(BufferPool *pool, uint32_t index) noexcept
+                : pool_{pool}
+                , index_{index}
+            { }
+
+        public:
+            /*! @brief Construct an empty handle. */
+            Chunk() noexcept = default;
+
+            /*! @brief Copying is deleted (a chunk has exactly one owner). */
+            Chunk(const Chunk&) = delete;
+            /*! @brief Copying is deleted (a chunk has exactly one owner). */
+            Chunk& operator=(const Chunk&) = delete;
+
+            /*! @brief Take over @p other's chunk, leaving it empty. */
+            Chunk(Chunk &&other) noexcept
+                : pool_{other.pool_}
+                , index_{other.index_}
+                , size_{other.size_}
+            {
+                other.pool_ = nullptr;
+                other.size_ = 0;
+            }
+
+            /*! @brief Release the held chunk, then take over @p other's. */
+            Chunk& operator=(Chunk &&other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    pool_ = other.pool_;
+                    index_ = other.index_;
+                    size_ = other.size_;
+                    other.pool_ = nullptr;
+                    other.size_ = 0;
+                }
+                return *this;
+            }
+
+            /*! @brief Return the chunk to its pool. */
+            ~Chunk() noexcept
+            {
+                reset();
+            }
+
+            /*! @brief Return the chunk to its pool now, leaving the handle empty. */
+            void reset() noexcept
+            {
+                if (pool_)
+                {
+                    pool_->release_(index_);
+                    pool_ = nullptr;
+                    size_ = 0;
+                }
+            }
+
+            /*! @brief True if the handle holds a chunk. */
+            explicit operator bool() const noexcept
+            {
+                return pool_ != nullptr;
+            }
+
+            /*! @brief Start of the chunk storage (@ref BufferPool::chunkSize bytes). */
+            uint8_t* data() const noexcept
+            {
+                return pool_ ? pool_->chunk_(index_) : nullptr;
+            }
+
+            /*! @brief Number of encoded bytes in the chunk. */
+            size_t size() const noexcept
+            {
+                return size_;
+            }
+
+            /*! @brief The encoded bytes, @c [data(), data() + size()). */
+            std::span<const uint8_t> bytes() const noexcept
+            {
+                return {data(), size_};
+            }
+        };
+
+        /*!
+         * @brief Registration for a notification once a chunk is released.
+         *
+         * @ref notify runs on the thread, and inside the call, that released the
+         * chunk, after the waiter has been unregistered. It may register again.
+         * Being notified does not reserve the chunk: another taker may get it
+         * first.
+         */
+        struct Waiter
+        {
+            void (*notify)(Waiter &waiter) noexcept = nullptr;  //!< Called once per registration.
+            Waiter *next_ = nullptr;                            //!< Pool's list link.
+        };
+
+    private:
+        static constexpr uint32_t NONE = UINT32_MAX;    //!< Free-list terminator.
+
+        std::unique_ptr<uint8_t[]> storage_;                //!< chunkCount * chunkSize bytes.
+        std::unique_ptr<std::atomic<uint32_t>[]> next_;     //!< Free-list links.
+        std::atomic<uint64_t> head_;                        //!< (tag << 32) | index.
+        std::atomic<size_t> available_;                     //!< Free chunks (diagnostic).
+        std::atomic<size_t> waiting_{0};                    //!< Registered waiters.
+        std::mutex waitLock_;                               //!< Guards waiters_.
+        Waiter *waiters_ = nullptr;                         //!< Registered waiters.
+        size_t chunkSize_;
+        size_t chunkCount_;
+
+        uint8_t* chunk_(uint32_t index) const noexcept
+        {
+            return storage_.get() + static_cast<size_t>(index) * chunkSize_;
+        }
+
+        void release_(uint32_t index) noexcept
+        {
+            uint64_t head = head_.load(std::memory_order_relaxed);
+            uint64_t desired;
+
+            do
+            {
+                next_[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+                desired = (((head >> 32) + 1) << 32) | index;
+            }
+            // Sequentially consistent against wait(): either the waiter sees
+            // this chunk on the free-list, or this sees the waiter.
+            while (!head_.compare_exchange_weak(
+                head, desired, std::memory_order_seq_cst, std::memory_order_relaxed));
+
+            available_.fetch_add(1, std::memory_order_relaxed);
+
+            if (waiting_.load(std::memory_order_seq_cst) != 0)
+            {
+                notify_();
+            }
+        }
+
+        void notify_() noexcept
+        {
+            Waiter *waiter;
+
+            {
+                std::lock_guard<std::mutex> lock{waitLock_};
+                waiter = std::exchange(waiters_, nullptr);
+                waiting_.store(0, std::memory_order_relaxed);
+            }
+
+            // Outside the lock: a notified waiter may register again, or be
+            // gone by the time its notify returns.
+            while (waiter)
+            {
+                Waiter *next = std::exchange(waiter->next_, nullptr);
+                waiter->notify(*waiter);
+                waiter = next;
+            }
+        }
+
+    public:
+        /*!
+         * @brief Allocate @p chunkCount chunks of @p chunkSize bytes each.
+         * @param chunkSize   Bytes per chunk (> 0).
+         * @param chunkCount  Number of chunks (> 0, < UINT32_MAX).
+         */
+        BufferPool(size_t chunkSize, size_t chunkCount) noexcept
+            : storage_{new uint8_t[chunkSize * chunkCount]}
+            , next_{new std::atomic<uint32_t>[chunkCount]}
+            , head_{0}
+            , available_{chunkCount}
+            , chunkSize_{chunkSize}
+            , chunkCount_{chunkCount}
+        {
+            static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "BufferPool needs a lock-free 64-bit compare-and-swap");
+            assert(chunkSize > 0);
+            assert(chunkCount > 0 && chunkCount < NONE);
+
+            for (size_t i = 0; i < chunkCount; i++)
+            {
+                next_[i].store(
+                    i + 1 < chunkCount ? static_cast<uint32_t>(i + 1) : NONE,
+                    std::memory_order_relaxed);
+            }
+        }
+
+        /*! @brief Copying is deleted (handed-out chunks point back at the pool). */
+        BufferPool(const BufferPool&) = delete;
+        /*! @brief Copying is deleted (handed-out chunks point back at the pool). */
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        /*!
+         * @brief Take a free chunk.
+         * @return A handle to the chunk, or an empty handle if none is free.
+         */
+        Chunk acquire() noexcept
+        {
+            uint64_t head = head_.load(std::memory_order_acquire);
+
+            for (;;)
+            {
+                uint32_t index = static_cast<uint32_t>(head);
+                if (index == NONE)
+                {
+                    return {};
+                }
+
+                uint64_t desired = (((head >> 32) + 1) << 32)
+                    | next_[index].load(std::memory_order_relaxed);
+                if (head_.compare_exchange_weak(
+                        head, desired, std::memory_order_acquire, std::memory_order_acquire))
+                {
+                    available_.fetch_sub(1, std::memory_order_relaxed);
+                    return Chunk{this, index};
+                }
+            }
+        }
+
+        /*!
+         * @brief Register @p waiter to be notified when a chunk is released.
+         *
+         * Returns false, leaving @p waiter unregistered, if a chunk is free
+         * already; take it with @ref acquire. Otherwise @p waiter stays
+         * registered until it is notified or @ref cancel ed, and must not be
+         * destroyed before either.
+         *
+         * @param waiter  Registration with @ref Waiter::notify set.
+         * @return true if @p waiter is registered.
+         */
+        bool wait(Waiter &waiter) noexcept
+        {
+            assert(waiter.notify != nullptr);
+
+            {
+                std::lock_guard<std::mutex> lock{waitLock_};
+                waiter.next_ = waiters_;
+                waiters_ = &waiter;
+                waiting_.fetch_add(1, std::memory_order_seq_cst);
+            }
+
+            if (static_cast<uint32_t>(head_.load(std::memory_order_seq_cst)) == NONE)
+            {
+                return true;
+            }
+
+            // A chunk came back before the registration counted; a release
+            // that already took the registration notifies it.
+            return !cancel(waiter);
+        }
+
+        /*!
+         * @brief Unregister @p waiter.
+         * @param waiter  Registration passed to @ref wait.
+         * @return true if it was still registered; false if it has been (or
+         *         is being) notified.
+         */
+        bool cancel(Waiter &waiter) noexcept
+        {
+            std::lock_guard<std::mutex> lock{waitLock_};
+
+            for (Waiter **link = &waiters_; *link; link = &(*link)->next_)
+            {
+                if (*link == &waiter)
+                {
+                    *link = waiter.next_;
+                    waiter.next_ = nullptr;
+                    waiting_.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /*! @brief Bytes per chunk. */
+        size_t chunkSize() const noexcept
+        {
+            return chunkSize_;
+        }
+
+        /*! @brief Total number of chunks. */
+        size_t chunkCount() const noexcept
+        {
+            return chunkCount_;
+        }
+
+        /*! @brief Chunks currently free (a snapshot; may change concurrently). */
+        size_t available() const noexcept
+        {
+            return available_.load(std::memory_order_relaxed);
+        }
+    };
+
+    /*!
+     * @brief Output stream that encodes into @ref BufferPool chunks and hands
+     *        each filled chunk to a sink as an owning handle.
+     *
+     * On every flush the filled chunk goes to the sink callback, and a free
+     * chunk is installed in its place. The sink may keep the handle as long as
+     * it likes — across threads, in a send queue — and the chunk returns to the
+     * pool when the handle is dropped. No allocation happens per chunk.
+     *
+     * The next chunk is taken only @b after the sink returns, so a sink that
+     * releases synchronously can run on a single-chunk pool. If no chunk is
+     * free at that point the stream cannot continue: the write that caused the
+     * flush, and every later one, fails with @ref Error::BufferFull, just as an
+     * @ref OStreamView does when its storage runs out. Size the pool to the
+     * number of chunks the sink can hold in flight, or call @ref resume once
+     * chunks have come back.
+     *
+     * Like @ref OStream, an @p offset reserves the first bytes of @b every
+     * chunk (a framing header a sink fills in); the reserved bytes are part of
+     * the handle's @ref BufferPool::Chunk::size.
+     */
+    class OStreamPooled : public OStreamImpl
+    {
+    public:
+        /*! @brief Sink invoked with each filled chunk. */
+        using chunkCallback = std::function<void(BufferPool::Chunk)>;
+
+    private:
+        BufferPool &pool_;              //!< Chunk source.
+        chunkCallback sink_;            //!< Receives filled chunks.
+        BufferPool::Chunk chunk_;       //!< Chunk being encoded into.
+        size_t offset_;                 //!< Reserved prefix of every chunk.
+        uint8_t stall_[1] = {};         //!< Zero-length install while no chunk is free.
+
+        static void chunk_flush_(
+            sofab_ostream_t *ctx, const uint8_t *data, size_t len, void *usrptr) noexcept
+        {
+            (void)ctx;
+            (void)data;
+
+            auto *self = static_cast<OStreamPooled*>(usrptr);
+            BufferPool::Chunk full = std::move(self->chunk_);
+            full.size_ = len;
+
+            if (self->sink_)
+            {
+                self->sink_(std::move(full));
+            }
+            full.reset();
+
+            self->install_();
+        }
+
+        // Install a fresh chunk, or — with the pool empty — a zero-length
+        // buffer and no flush callback, which the C core reports as
+        // E_BUFFER_FULL on the next byte.
+        bool install_() noexcept
+        {
+            chunk_ = pool_.acquire();
+            if (chunk_)
+            {
+                ctx_.flush = chunk_flush_;
+                buffer_ = chunk_.data();
+                sofab_ostream_buffer_set(&ctx_, buffer_, pool_.chunkSize(), offset_);
+                return true;
+            }
+
+            ctx_.flush = nullptr;
+            buffer_ = stall_;
+            sofab_ostream_buffer_set(&ctx_, buffer_, 0, 0);
+            return false;
+        }
+
+    public:
+        /*!
+         * @brief Construct over @p pool with a chunk sink.
+         * @param pool    Chunk source; must outlive this stream.
+         * @param sink    Invoked with each filled chunk (on flush or when full).
+         * @param offset  Bytes reserved at the start of every chunk (default 0).
+         */
+        OStreamPooled(BufferPool &pool, chunkCallback sink, size_t offset = 0) noexcept
+            : pool_{pool}
+            , sink_{std::move(sink)}
+            , offset_{offset}
+        {
+            assert(offset < pool.chunkSize());
+            assert(pool.chunkSize() - offset >= SOFAB_MIN_OUTPUT_BUFFER);
+
+            sofab_ostream_init(&ctx_, stall_, 0, 0, nullptr, this);
+            install_();
+        }
+
+        /*!
+         * @brief Hand the last partial chunk to the sink and return the spare.
+         *
+         * A chunk holding nothing but the reserved @p offset is not sent. The
+         * callback is detached afterwards so the base destructor's flush
+         * cannot reach members that are already gone.
+         */
+        ~OStreamPooled() noexcept override
+        {
+            if (bytesUsed() > offset_)
+            {
+                flush();
+            }
+            ctx_.flush = nullptr;
+        }
+
+        /*!
+         * @brief Continue after the pool ran dry.
+         *
+         * Installs a free chunk if one has come back since. Bytes lost to the
+         * failed writes stay lost, and @ref ok keeps reporting the failure.
+         *
+         * @return true if the stream has a chunk to write into.
+         */
+        bool resume() noexcept
+        {
+            return chunk_ ? true : install_();
+        }
+    };
+};
+
+/** @} */ // end of defgroup
+
+#endif // SOFAB_POOL_HPP
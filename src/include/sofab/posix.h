@@ -0,0 +1,168 @@
+/*!
+ * @file posix.h
+ * @brief SofaBuffers C - File descriptor and mmap adapters for the streams.
+ *
+ * The glue every POSIX consumer of the streams otherwise writes by hand, done
+ * once with the system-call edge cases handled (@c EINTR, short writes and
+ * reads, zero-length files):
+ *
+ * - @ref sofab_ostream_fd_sink installs a flush callback that writes the encoded
+ *   bytes to a file descriptor. The caller's buffer is cut into
+ *   @ref SOFAB_FD_SINK_SEGMENTS segments; every flush only moves the encoder on
+ *   to the next segment, and once all of them are filled they go out in a
+ *   single @c writev(), so a small encode buffer does not cost a system call
+ *   per buffer-full.
+ * - @ref sofab_istream_feed_fd reads a descriptor to its end in chunks of a size
+ *   the caller chooses and feeds every chunk to an input stream.
+ * - @ref sofab_istream_feed_mmap maps a whole file and feeds it in one call,
+ *   without copying it, with the kernel told the access is sequential.
+ *
+ * Unlike the codec this module needs a POSIX system, so it is not part of
+ * @c libsofabuffers but a library of its own, @c sofa-buffers::posix, built for
+ * hosted UNIX targets only. A system call that fails is reported as
+ * @ref SOFAB_RET_E_ARGUMENT with @c errno saying why.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_POSIX_H
+#define SOFAB_POSIX_H
+
+/**
+ * @defgroup c_api C API
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SOFAB_POSIX_C
+# define SOFAB_POSIX_EXTERN extern
+#else
+# define SOFAB_POSIX_EXTERN
+#endif
+
+/* includes *******************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include "sofab/istream.h"
+#include "sofab/ostream.h"
+
+/* constants ******************************************************************/
+
+/*!
+ * @brief Segments a file descriptor sink cuts its buffer into.
+ *
+ * One @c writev() carries this many buffer-fulls. 16 is the smallest @c IOV_MAX
+ * POSIX allows, and so the most a single call is guaranteed to take.
+ */
+#ifndef SOFAB_FD_SINK_SEGMENTS
+# define SOFAB_FD_SINK_SEGMENTS     (4)
+#endif
+#if SOFAB_FD_SINK_SEGMENTS < 1 || SOFAB_FD_SINK_SEGMENTS > 16
+# error "SOFAB_FD_SINK_SEGMENTS must be 1..16"
+#endif
+
+/* types **********************************************************************/
+
+/*!
+ * @brief File descriptor sink state (see @ref sofab_ostream_fd_sink).
+ */
+typedef struct sofab_fd_sink
+{
+    int fd;                                 /*!< Descriptor written to */
+    int error;                              /*!< @c errno of the first failed write, 0 if none */
+    uint8_t *buffer;                        /*!< Start of the first segment */
+    size_t seglen;                          /*!< Bytes per segment */
+    unsigned pending;                       /*!< Filled segments not yet written; also the
+                                             *!< index of the segment being encoded into */
+    struct iovec iov[SOFAB_FD_SINK_SEGMENTS]; /*!< The filled part of each pending segment */
+} sofab_fd_sink_t;
+
+/* prototypes *****************************************************************/
+
+/*!
+ * @brief Initialize an output stream that writes to a file descriptor.
+ *
+ * Initializes @p os over the first of @ref SOFAB_FD_SINK_SEGMENTS equal
+ * segments of @p buffer, with @p sink as its flush callback's state. Encode with
+ * the sofab_ostream_write_* functions as usual and finish with
+ * @ref sofab_ostream_fd_flush, which also reports whether every byte made it
+ * out.
+ *
+ * Writes loop over short writes and @c EINTR, so the descriptor should be in
+ * blocking mode; @c EAGAIN is a failure like any other. After a failure the
+ * stream keeps encoding (a flush callback cannot stop it), but nothing more is
+ * written.
+ *
+ * @param os      Output stream to initialize.
+ * @param sink    Sink state, valid as long as @p os is used.
+ * @param fd      Descriptor to write to.
+ * @param buffer  Encode buffer.
+ * @param buflen  Size of @p buffer, at least @ref SOFAB_FD_SINK_SEGMENTS times
+ *                @ref SOFAB_MIN_OUTPUT_BUFFER (a segment is a streaming
+ *                buffer, see sofab_ostream_init()).
+ */
+extern void sofab_ostream_fd_sink (
+    sofab_ostream_t *os, sofab_fd_sink_t *sink, int fd, uint8_t *buffer, size_t buflen);
+
+/*!
+ * @brief Write out everything encoded into a file descriptor stream so far.
+ *
+ * Flushes @p os and writes every pending segment, in one @c writev().
+ *
+ * @param os  Output stream set up by @ref sofab_ostream_fd_sink.
+ *
+ * @return SOFAB_RET_OK if every byte encoded since sofab_ostream_fd_sink() has
+ *         been written, or SOFAB_RET_E_ARGUMENT if a write failed, with
+ *         @c errno set to its error.
+ */
+extern sofab_ret_t sofab_ostream_fd_flush (sofab_ostream_t *os);
+
+/*!
+ * @brief Feed everything a file descriptor delivers, up to its end.
+ *
+ * Reads @p fd into @p buf until end of file and feeds every chunk read to
+ * @p is. @p buflen is the read size: one @c read() per @p buflen bytes, so a
+ * larger buffer means fewer system calls (64 KiB is a good start for a file).
+ *
+ * @param is      Input stream, initialized with sofab_istream_init().
+ * @param fd      Descriptor to read from.
+ * @param buf     Read buffer.
+ * @param buflen  Size of @p buf in bytes, at least 1.
+ *
+ * @return What @ref sofab_istream_feed reports for all the bytes read (the
+ *         reading stops at the first SOFAB_RET_E_INVALID_MSG), or
+ *         SOFAB_RET_E_ARGUMENT if a read failed, with @c errno set to its error.
+ */
+extern sofab_ret_t sofab_istream_feed_fd (
+    sofab_istream_t *is, int fd, uint8_t *buf, size_t buflen);
+
+/*!
+ * @brief Feed a whole file, mapped into memory, in a single call.
+ *
+ * Maps the file @p fd refers to read-only and feeds it to @p is as one buffer,
+ * the decoder's fastest path: no copy, and no field is ever split across
+ * feeds. The mapping is advised as sequential, so the kernel reads ahead, and
+ * is removed again before the call returns. The whole file is fed, whatever
+ * the position of @p fd; an empty file is the empty message.
+ *
+ * @param is  Input stream, initialized with sofab_istream_init().
+ * @param fd  Descriptor of a regular file open for reading.
+ *
+ * @return What @ref sofab_istream_feed reports for the file's content, or
+ *         SOFAB_RET_E_ARGUMENT if the file cannot be mapped, with @c errno set
+ *         to the error.
+ */
+extern sofab_ret_t sofab_istream_feed_mmap (sofab_istream_t *is, int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */ // end of defgroup
+
+#endif /* SOFAB_POSIX_H */
@@ -0,0 +1,261 @@
+/*!
+ * @file reclog.h
+ * @brief SofaBuffers C - Append-only record log with an index footer.
+ *
+ * A file of length-prefixed messages (the frames of @c sofab/framing.h) that
+ * can be read back by record number, or by key, without scanning it. The
+ * writer appends records and keeps their offsets; every so often it writes a
+ * checkpoint holding the offsets since the previous one, and on close an index
+ * of all of them as the file's footer. The reader maps the file, finds the
+ * footer from the end and goes straight to record @c n, or binary-searches the
+ * index for a key. The key is the value of one top-level unsigned field of
+ * every record, chosen when the log is created and taken from the encoded
+ * record as it is appended (0 where a record omits it, MESSAGE_SPEC §2).
+ *
+ * A log that was not closed (the writer crashed, or the machine did) has no
+ * footer. Opening it with the writer recovers it: the offsets come from the
+ * checkpoints, only the records after the last one are scanned, and a record
+ * torn by the crash is cut off. The writer then appends as usual. A crash can
+ * also leave the file extended over blocks never written, which read back as
+ * zeros, and a zero byte is an empty record; so a run of empty records after
+ * the last checkpoint is only kept if a non-empty record follows it. Empty
+ * records the writer appended last are lost with such a tail.
+ *
+ * File format (all integers little-endian):
+ *
+ *     log        := header entry* footer
+ *     header     := "SFBL" version:u8 flags:u8 0:u16 key_id:u32
+ *     entry      := record | checkpoint
+ *     record     := varint(len) message[len]
+ *     checkpoint := FF FF FF FF 'C' count:u32 self:u64 base:u64 prev:u64
+ *                   index[count] check:u32
+ *     footer     := FF FF FF FF 'I' index[n]
+ *                   n:u64 self:u64 checkpoint:u64 check:u32 "SFBI"
+ *     index      := offset:u64 (key:u64, when flags has @ref SOFAB_RECLOG_KEYED)
+ *
+ * The four FF bytes and the tag are a malformed length prefix, so a walk of the
+ * records can never mistake a checkpoint or the footer for one. @c self is the
+ * block's own offset, @c base the number of records before the checkpoint's
+ * @c count, @c prev the previous checkpoint (0 for none), and @c check the
+ * 32-bit FNV-1a of the block up to it.
+ *
+ * Like the adapters of @c sofab/posix.h, whose library it is part of, this
+ * module needs a POSIX system. A system call that fails is reported as
+ * @ref SOFAB_RET_E_ARGUMENT with @c errno saying why.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_RECLOG_H
+#define SOFAB_RECLOG_H
+
+/**
+ * @defgroup c_api C API
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SOFAB_RECLOG_C
+# define SOFAB_RECLOG_EXTERN extern
+#else
+# define SOFAB_RECLOG_EXTERN
+#endif
+
+/* includes *******************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sofab/sofab.h"
+
+/* constants ******************************************************************/
+
+/*! @brief Format version written to the header. */
+#define SOFAB_RECLOG_VERSION    (1)
+
+/*! @brief Header flag: the index carries a key per record. */
+#define SOFAB_RECLOG_KEYED      (0x01)
+
+/* types **********************************************************************/
+
+/*!
+ * @brief Record log writer.
+ */
+typedef struct sofab_reclog_writer
+{
+    int fd;                     /*!< Log file, positioned at its end */
+    int error;                  /*!< @c errno of the first failed write, 0 if none */
+    uint8_t keyed;              /*!< Whether records carry a key */
+    sofab_id_t key_id;          /*!< Field id of the key */
+    size_t interval;            /*!< Records between checkpoints, 0 for none */
+    uint64_t end;               /*!< Offset of the next record */
+    uint64_t checkpoint;        /*!< Offset of the last checkpoint, 0 if none */
+    uint64_t last_key;          /*!< Key of the last record */
+    uint64_t *index;            /*!< Offset (and key) of every record */
+    size_t count;               /*!< Records in the log */
+    size_t cap;                 /*!< Records @c index has room for */
+    size_t covered;             /*!< Records up to the last checkpoint */
+} sofab_reclog_writer_t;
+
+/*!
+ * @brief Record log reader.
+ */
+typedef struct sofab_reclog_reader
+{
+    const uint8_t *map;         /*!< The mapped file */
+    size_t len;                 /*!< Length of @c map */
+    const uint8_t *index;       /*!< First index entry in the footer */
+    size_t count;               /*!< Records in the log */
+    size_t entsize;             /*!< Bytes per index entry */
+    uint8_t keyed;              /*!< Whether records carry a key */
+    sofab_id_t key_id;          /*!< Field id of the key */
+} sofab_reclog_reader_t;
+
+/* prototypes *****************************************************************/
+
+/*!
+ * @brief Open a record log for appending.
+ *
+ * An empty file becomes a new log. An existing log is continued: one that was
+ * closed has its footer taken off, one that was not is recovered (see the
+ * file description), and the file is truncated to its last complete record in
+ * both cases. The caller keeps ownership of @p fd.
+ *
+ * @param w         Writer.
+ * @param fd        Log file, open for reading and writing.
+ * @param keyed     Whether every record carries a key.
+ * @param key_id    Field id of the key (ignored unless @p keyed).
+ * @param interval  Records between two checkpoints; 0 writes one only at
+ *                  @ref sofab_reclog_checkpoint and on close.
+ *
+ * @return SOFAB_RET_OK, SOFAB_RET_E_INVALID_MSG if the file is not a record log
+ *         (or its header is damaged), or SOFAB_RET_E_ARGUMENT if @p keyed and
+ *         @p key_id do not match the existing log (@c errno is then @c EINVAL)
+ *         or a system call fails.
+ */
+extern sofab_ret_t sofab_reclog_writer_open (
+    sofab_reclog_writer_t *w, int fd, int keyed, sofab_id_t key_id, size_t interval);
+
+/*!
+ * @brief Append one record.
+ *
+ * Writes @p msg, a complete encoded message, as the log's next record. Of a
+ * keyed log the key is read from @p msg first; keys must not decrease from one
+ * record to the next, which is what lets the reader binary-search them.
+ *
+ * @param w    Writer.
+ * @param msg  The encoded message (may be NULL when @p len is 0).
+ * @param len  Length of @p msg in bytes.
+ *
+ * @return SOFAB_RET_OK, SOFAB_RET_E_INVALID_MSG if the log is keyed and @p msg
+ *         is malformed or truncated, or SOFAB_RET_E_ARGUMENT if its key is below
+ *         the previous record's (nothing is written then) or a write fails.
+ *         A failed write is sticky; reopening the log recovers it.
+ */
+extern sofab_ret_t sofab_reclog_append (
+    sofab_reclog_writer_t *w, const void *msg, size_t len);
+
+/*!
+ * @brief Write a checkpoint now.
+ *
+ * Makes the records appended so far durable (@c fsync()) and then records
+ * their offsets in a checkpoint, so that recovery need not scan them. Does
+ * nothing if there are none since the last checkpoint.
+ *
+ * @param w  Writer.
+ * @return SOFAB_RET_OK, or SOFAB_RET_E_ARGUMENT if a system call fails.
+ */
+extern sofab_ret_t sofab_reclog_checkpoint (sofab_reclog_writer_t *w);
+
+/*!
+ * @brief Finish a record log.
+ *
+ * Writes a last checkpoint and the index footer, syncs the file and releases
+ * the writer's memory. The caller closes @p fd.
+ *
+ * @param w  Writer.
+ * @return SOFAB_RET_OK, or SOFAB_RET_E_ARGUMENT if a write failed, now or
+ *         before (the log is then left to recovery).
+ */
+extern sofab_ret_t sofab_reclog_writer_close (sofab_reclog_writer_t *w);
+
+/*!
+ * @brief Open a closed record log for reading.
+ *
+ * Maps the file and checks its header and footer. A log without a valid footer
+ * has to be recovered by @ref sofab_reclog_writer_open first. @p fd may be
+ * closed once this returns.
+ *
+ * @param r   Reader.
+ * @param fd  Log file, open for reading.
+ *
+ * @return SOFAB_RET_OK, SOFAB_RET_E_INVALID_MSG if the file is not a closed
+ *         record log, or SOFAB_RET_E_ARGUMENT if it cannot be mapped.
+ */
+extern sofab_ret_t sofab_reclog_reader_open (sofab_reclog_reader_t *r, int fd);
+
+/*!
+ * @brief Unmap a record log.
+ *
+ * @param r  Reader.
+ */
+extern void sofab_reclog_reader_close (sofab_reclog_reader_t *r);
+
+/*!
+ * @brief Locate record @p n.
+ *
+ * @param r    Reader.
+ * @param n    Record number, below @ref sofab_reclog_count.
+ * @param msg  Receives the start of the encoded message, inside the mapping.
+ * @param len  Receives its length.
+ *
+ * @return SOFAB_RET_OK, SOFAB_RET_E_ARGUMENT if there is no record @p n, or
+ *         SOFAB_RET_E_INVALID_MSG if the index points at no record.
+ */
+extern sofab_ret_t sofab_reclog_record (
+    const sofab_reclog_reader_t *r, size_t n, const uint8_t **msg, size_t *len);
+
+/*!
+ * @brief Key of record @p n.
+ *
+ * @param r  Reader of a keyed log.
+ * @param n  Record number, below @ref sofab_reclog_count.
+ * @return The key.
+ */
+extern uint64_t sofab_reclog_key (const sofab_reclog_reader_t *r, size_t n);
+
+/*!
+ * @brief Find the first record whose key is at least @p key.
+ *
+ * A binary search of the index; the records with keys in @c [lo, @c hi) are
+ * those from @c sofab_reclog_find(r, lo) up to @c sofab_reclog_find(r, hi).
+ *
+ * @param r    Reader of a keyed log.
+ * @param key  Key to look for.
+ * @return The record number, or @ref sofab_reclog_count if every key is below
+ *         @p key.
+ */
+extern size_t sofab_reclog_find (const sofab_reclog_reader_t *r, uint64_t key);
+
+/* inline convenience functions ***********************************************/
+
+/*!
+ * @brief Number of records in a log.
+ *
+ * @param r  Reader.
+ * @return The number of records.
+ */
+static inline size_t sofab_reclog_count (const sofab_reclog_reader_t *r)
+{
+    return r->count;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */ // end of defgroup
+
+#endif /* SOFAB_RECLOG_H */
@@ -314,6 +314,56 @@ typedef int32_t sofab_signed_t;
 # endif
 #endif
 
+/*!
+ * @brief Keep 64-bit traffic statistics on every input and output stream.
+ *
+ * What a deployment needs to size its buffers and pick its chunk sizes from
+ * live traffic rather than a guess: on decode, the bytes fed and how many went
+ * into a bound destination versus were skipped, the fields seen, the field
+ * callbacks fired and the deepest nesting reached; on encode, the flushes and
+ * the bytes they carried. Read through @ref sofab_istream_stats /
+ * @ref sofab_ostream_stats (C) or @c stats() on the C++ streams.
+ *
+ * Like @ref SOFAB_SKIP_COUNTER it is a pure diagnostic and @b defaults @b OFF:
+ * when off the counters, their increments and the accessors do not exist. When
+ * on it costs @c sizeof(sofab_istream_stats_t) of RAM per input stream (49
+ * bytes of members, padded to 56 where @c uint64_t is 8-byte aligned, as on
+ * LP64, and to 52 on i386) and 16 per output stream, plus an increment per
+ * decoded byte. Enable it by defining
+ * @c SOFAB_ENABLE_STATS; a direct @c -DSOFAB_STATS=1 also works and wins. The
+ * struct layouts change, so it MUST be set identically for the library and
+ * every one of its users (the CMake option does that).
+ */
+// #define SOFAB_ENABLE_STATS
+#if !defined(SOFAB_STATS)
+# if defined(SOFAB_ENABLE_STATS) && !defined(SOFAB_DISABLE_STATS)
+#  define SOFAB_STATS 1
+# else
+#  define SOFAB_STATS 0
+# endif
+#endif
+
+/*!
+ * @brief Compile static tracepoints (USDT) into the library.
+ *
+ * For correlating decode and encode activity with the rest of the system in
+ * @c perf or @c bpftrace without a logging build: feed entry and verdict,
+ * INVALID transitions, sequence boundaries, flushes and object encodes (the
+ * probe list is in src/trace.h). Needs @c <sys/sdt.h> (systemtap-sdt-dev);
+ * the CMake option falls back to no probes, with a warning, where it is
+ * missing. @b Defaults @b OFF. When on, a probe nobody attached to costs one
+ * @c nop plus a note in the ELF; when off, nothing. It does not change any
+ * public layout, so unlike @ref SOFAB_STATS only the library needs it.
+ */
+// #define SOFAB_ENABLE_USDT
+#if !defined(SOFAB_USDT)
+# if defined(SOFAB_ENABLE_USDT) && !defined(SOFAB_DISABLE_USDT)
+#  define SOFAB_USDT 1
+# else
+#  define SOFAB_USDT 0
+# endif
+#endif
+
 /*!
  * @brief Narrow unsigned/signed scalar varint values from 64-bit to 32-bit.
  *
@@ -18,7 +18,9 @@
 #include <concepts>
 #include <cstring>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <ranges>
 #include <span>
 #include <string>
 #include <type_traits>
@@ -877,6 +879,30 @@ namespace sofab
                 return *this;
             }
 
+            /*!
+             * @brief Chained array write from a range (no-op if a prior call failed).
+             * @param id     Field identifier.
+             * @param range  Range of integers or floating-point values.
+             * @return This Result, carrying the first error encountered (if any).
+             * @see OStreamImpl::writeRange
+             */
+            template <std::ranges::input_range R>
+            Result writeRange(sofab_id_t id, R &&range) noexcept
+            {
+                if (error_ != Error::None)
+                {
+                    return *this;
+                }
+
+                auto res = ostream_.writeRange(id, std::forward<R>(range));
+                if (!res.ok())
+                {
+                    error_ = res.code();
+                }
+
+                return *this;
+            }
+
             /*!
              * @brief Chained frame-keeping sequence-end (no-op if a prior call failed).
              * @return This Result, carrying the first error encountered (if any).
@@ -1005,6 +1031,20 @@ namespace sofab
             return sofab_ostream_bytes_used(&ctx_);
         }
 
+        /*!
+         * @brief Flush statistics since the stream was constructed.
+         *
+         * Facade over @ref sofab_ostream_stats.
+         *
+         * @return The stream's counters (see @ref sofab_ostream_stats_t).
+         */
+#if SOFAB_STATS
+        [[nodiscard]] const sofab_ostream_stats_t& stats() const noexcept
+        {
+            return *sofab_ostream_stats(&ctx_);
+        }
+#endif
+
         /*!
          * @brief Pointer to the start of the active encode buffer.
          * @return Read-only pointer to the buffer (valid for @ref bytesUsed bytes).
@@ -1220,6 +1260,162 @@ namespace sofab
             return result(ret);
         }
 
+        /*!
+         * @brief Encode an array field straight from a range, without a
+         *        contiguous copy.
+         *
+         * For arrays that exist only as a view — computed, filtered, strided
+         * or gathered from columnar storage — where @ref write would need the
+         * elements collected into a @c std::vector first. The element count is
+         * written up front and each element is then streamed through the same
+         * varint / fp path the contiguous writer uses, so the bytes are
+         * identical to @ref write of the materialized array.
+         *
+         * The count comes from @c std::ranges::size for a sized range and from
+         * a first pass over the range for an unsized forward range. A
+         * single-pass input range cannot be walked twice; it takes the counted
+         * overload.
+         *
+         * @param id     Field identifier.
+         * @param range  Range of integers (not @c bool), @c float or @c double.
+         * @return @ref Result for fluent chaining and error inspection.
+         */
+        template <std::ranges::input_range R>
+        Result writeRange(sofab_id_t id, R &&range) noexcept
+        {
+            if constexpr (std::ranges::sized_range<R>)
+            {
+                return writeRange(id,
+                    static_cast<size_t>(std::ranges::size(range)), range);
+            }
+            else if constexpr (std::ranges::forward_range<R>)
+            {
+                return writeRange(id,
+                    static_cast<size_t>(std::ranges::distance(range)), range);
+            }
+            else
+            {
+                static_assert(always_false_v<R>,
+                    "writeRange(): a single-pass range has no count; use "
+                    "writeRange(id, count, range)");
+                return result(SOFAB_RET_E_ARGUMENT);
+            }
+        }
+
+        /*!
+         * @brief Encode an array field of @p count elements taken from a range.
+         *
+         * The counted form of @ref writeRange, for a range that can only be
+         * walked once (a generator, an @c istream view). The count is on the
+         * wire before the first element, so the range must deliver it: extra
+         * elements are left unread, and a range that ends early is padded with
+         * zero elements — keeping the message well-formed — and reported as
+         * @ref Error::InvalidArgument.
+         *
+         * @param id     Field identifier.
+         * @param count  Number of elements to write.
+         * @param range  Range of integers (not @c bool), @c float or @c double.
+         * @return @ref Result for fluent chaining and error inspection.
+         */
+        template <std::ranges::input_range R>
+        Result writeRange(sofab_id_t id, size_t count, R &&range) noexcept
+        {
+#if SOFAB_CPP_HAVE_ARRAY
+            using Elem = std::remove_cvref_t<std::ranges::range_value_t<R>>;
+            sofab_ret_t ret;
+
+            if (count > static_cast<size_t>(INT32_MAX))
+            {
+                return result(SOFAB_RET_E_ARGUMENT);
+            }
+
+            auto element = [this](const Elem &value) noexcept -> sofab_ret_t
+            {
+                if constexpr (std::is_integral_v<Elem> && !std::is_same_v<Elem, bool>)
+                {
+#if !SOFAB_CPP_HAVE_INT64
+                    static_assert(sizeof(Elem) <= 4,
+                        "64-bit integer arrays require INT64 support, disabled "
+                        "via SOFAB_DISABLE_INT64_SUPPORT");
+#endif
+                    if constexpr (std::is_unsigned_v<Elem>)
+                    {
+                        return sofab_ostream_write_array_element_unsigned(
+                            &ctx_, static_cast<sofab_unsigned_t>(value));
+                    }
+                    else
+                    {
+                        return sofab_ostream_write_array_element_signed(
+                            &ctx_, static_cast<sofab_signed_t>(value));
+                    }
+                }
+                else if constexpr (std::is_same_v<Elem, float>
+#if SOFAB_CPP_HAVE_FP64
+                    || std::is_same_v<Elem, double>
+#endif
+                    )
+                {
+                    return sofab_ostream_write_array_element_fixlen(
+                        &ctx_, &value, sizeof(Elem));
+                }
+                else
+                {
+                    static_assert(always_false_v<Elem>,
+                        "Unsupported range element type in OStream::writeRange()");
+                    return SOFAB_RET_E_ARGUMENT;
+                }
+            };
+
+            if constexpr (std::is_floating_point_v<Elem>)
+            {
+                ret = sofab_ostream_write_array_begin_fixlen(
+                    &ctx_, id, static_cast<int32_t>(count), sizeof(Elem),
+                    std::is_same_v<Elem, float>
+                        ? SOFAB_FIXLENTYPE_FP32 : SOFAB_FIXLENTYPE_FP64);
+            }
+            else
+            {
+                ret = sofab_ostream_write_array_begin(
+                    &ctx_, id,
+                    std::is_unsigned_v<Elem>
+                        ? SOFAB_TYPE_VARINTARRAY_UNSIGNED : SOFAB_TYPE_VARINTARRAY_SIGNED,
+                    static_cast<int32_t>(count));
+            }
+
+            size_t written = 0;
+            auto it = std::ranges::begin(range);
+            auto end = std::ranges::end(range);
+            for (; ret == SOFAB_RET_OK && written < count && it != end; ++it, ++written)
+            {
+                ret = element(static_cast<Elem>(*it));
+            }
+
+            if (ret == SOFAB_RET_OK && written < count)
+            {
+                // The range ran dry after the count went out: finish the field
+                // so the stream stays decodable, then report the short range.
+                for (; ret == SOFAB_RET_OK && written < count; ++written)
+                {
+                    ret = element(Elem{});
+                }
+                if (ret == SOFAB_RET_OK)
+                {
+                    ret = SOFAB_RET_E_ARGUMENT;
+                }
+            }
+
+            return result(ret);
+#else
+            (void)id;
+            (void)count;
+            (void)range;
+            static_assert(always_false_v<R>,
+                "array fields require ARRAY support, disabled via "
+                "SOFAB_DISABLE_ARRAY_SUPPORT");
+            return result(SOFAB_RET_E_ARGUMENT);
+#endif
+        }
+
         /*!
          * @brief Encode a raw binary blob field.
          * @param id     Field identifier.
@@ -1557,7 +1753,8 @@ namespace sofab
      *
      * Bundles a @ref OStreamMessage instance with an @ref OStreamInline buffer
      * sized from the message's @c _maxSize, so a message can be populated and
-     * encoded in one object.
+     * encoded in one object. Derive @c _maxSize from the field types with
+     * @ref max_size_v rather than maintaining the number by hand.
      *
      * @tparam MessageType  An @ref OutputMessage type.
      * @tparam N            Buffer size in bytes (defaults to @c MessageType::_maxSize).
@@ -1613,6 +1810,272 @@ namespace sofab
     };
 
 
+    /************/
+    /*** Size ***/
+    /************/
+
+    /*!
+     * @brief Number of bytes the LEB128 varint encoding of @p value occupies.
+     * @param value  Value to measure.
+     * @return 1..10.
+     */
+    constexpr std::size_t varintSize(std::uint64_t value) noexcept
+    {
+        std::size_t n = 1;
+        while (value >= 0x80)
+        {
+            value >>= 7;
+            n++;
+        }
+        return n;
+    }
+
+    /*! @cond INTERNAL */
+    namespace detail
+    {
+        template <typename>
+        struct inline_vector_traits : std::false_type { };
+        template <typename T, std::size_t N>
+        struct inline_vector_traits<InlineVector<T, N>> : std::true_type
+        {
+            using elem = T;
+            static constexpr std::size_t count = N;
+        };
+        template <typename>
+        struct std_array_traits : std::false_type { };
+        template <typename T, std::size_t N>
+        struct std_array_traits<std::array<T, N>> : std::true_type
+        {
+            using elem = T;
+            static constexpr std::size_t count = N;
+        };
+
+        // A native scalar element is one the array wire types carry directly
+        // (MESSAGE_SPEC §3); anything else is lowered to a wrapper sequence (§5).
+        template <typename E>
+        inline constexpr bool is_array_scalar_v =
+            (std::is_integral_v<E> && !std::is_same_v<E, bool>) ||
+            std::is_same_v<E, float> || std::is_same_v<E, double>;
+
+        constexpr std::size_t headerSize(sofab_id_t id, sofab_type_t type) noexcept
+        {
+            return varintSize((static_cast<std::uint64_t>(id) << 3) | type);
+        }
+
+        template <typename E>
+        constexpr std::size_t scalarArrayMaxSize(sofab_id_t id, std::size_t count) noexcept
+        {
+            if constexpr (std::is_floating_point_v<E>)
+            {
+                return headerSize(id, SOFAB_TYPE_FIXLENARRAY) + varintSize(count)
+                    + varintSize(sizeof(E) << 3) + count * sizeof(E);
+            }
+            else
+            {
+                return headerSize(id, std::is_unsigned_v<E>
+                        ? SOFAB_TYPE_VARINTARRAY_UNSIGNED : SOFAB_TYPE_VARINTARRAY_SIGNED)
+                    + varintSize(count)
+                    + count * varintSize(std::numeric_limits<std::make_unsigned_t<E>>::max());
+            }
+        }
+    }
+    /*! @endcond */
+
+    /*!
+     * @brief Worst-case encoded size of one field of C++ type @p T at @p id.
+     *
+     * Derived from the type alone, the same way @ref OStreamImpl::write picks the
+     * wire encoding from it: an integer at its widest varint (a signed one after
+     * ZigZag), a float or double as its fixlen payload, a @ref FixedString /
+     * @ref FixedBytes at capacity, a native-scalar @c std::array or
+     * @ref InlineVector as a full-count array, any other @ref InlineVector as a
+     * full wrapper sequence (MESSAGE_SPEC §5.1) of worst-case elements, and a
+     * nested message as a frame around its own @c _maxSize. The header cost
+     * depends on @p id, which is why it is an argument rather than a constant.
+     *
+     * A heap-backed type (@c std::string, @c std::vector) has no bound and is a
+     * compile-time error.
+     *
+     * @tparam T  Field type, as passed to @ref OStreamImpl::write.
+     * @param id  Field identifier.
+     * @return Upper bound of the bytes the field can occupy on the wire.
+     */
+    template <typename T>
+    constexpr std::size_t fieldMaxSize(sofab_id_t id) noexcept
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            return detail::headerSize(id, SOFAB_TYPE_VARINT_UNSIGNED) + 1;
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            return detail::headerSize(id, std::is_unsigned_v<T>
+                    ? SOFAB_TYPE_VARINT_UNSIGNED : SOFAB_TYPE_VARINT_SIGNED)
+                + varintSize(std::numeric_limits<std::make_unsigned_t<T>>::max());
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            return detail::headerSize(id, SOFAB_TYPE_FIXLEN)
+                + varintSize(sizeof(T) << 3) + sizeof(T);
+        }
+        else if constexpr (is_fixed_string_v<T> || is_fixed_bytes_v<T>)
+        {
+            constexpr int sub = is_fixed_string_v<T>
+                ? SOFAB_FIXLENTYPE_STRING : SOFAB_FIXLENTYPE_BLOB;
+            return detail::headerSize(id, SOFAB_TYPE_FIXLEN)
+                + varintSize((static_cast<std::uint64_t>(T::capacity()) << 3) | sub)
+                + T::capacity();
+        }
+        else if constexpr (requires { { T::_maxSize } -> std::convertible_to<std::size_t>; })
+        {
+            return detail::headerSize(id, SOFAB_TYPE_SEQUENCE_START) + T::_maxSize
+                + detail::headerSize(0, SOFAB_TYPE_SEQUENCE_END);
+        }
+        else if constexpr (detail::std_array_traits<T>::value)
+        {
+            using Traits = detail::std_array_traits<T>;
+            static_assert(detail::is_array_scalar_v<typename Traits::elem>,
+                "fieldMaxSize(): std::array fields must hold native scalars");
+            return detail::scalarArrayMaxSize<typename Traits::elem>(id, Traits::count);
+        }
+        else if constexpr (detail::inline_vector_traits<T>::value)
+        {
+            using Traits = detail::inline_vector_traits<T>;
+            using Elem = typename Traits::elem;
+
+            if constexpr (detail::is_array_scalar_v<Elem>)
+            {
+                return detail::scalarArrayMaxSize<Elem>(id, Traits::count);
+            }
+            else
+            {
+                std::size_t n = detail::headerSize(id, SOFAB_TYPE_SEQUENCE_START)
+                    + detail::headerSize(0, SOFAB_TYPE_SEQUENCE_END);
+                for (std::size_t i = 0; i < Traits::count; i++)
+                {
+                    n += fieldMaxSize<Elem>(static_cast<sofab_id_t>(i));
+                }
+                return n;
+            }
+        }
+        else
+        {
+            static_assert(always_false_v<T>,
+                "fieldMaxSize(): type has no compile-time bound (use a fixed-capacity type)");
+            return 0;
+        }
+    }
+
+    /*!
+     * @brief One field of a message, for @ref max_size_v.
+     * @tparam Id  Field identifier.
+     * @tparam T   Field type.
+     */
+    template <sofab_id_t Id, typename T>
+    struct Field
+    {
+        /*! @brief Worst-case encoded size of this field. */
+        static constexpr std::size_t maxSize = fieldMaxSize<T>(Id);
+    };
+
+    /*!
+     * @brief Worst-case encoded size of a message made of @p Fields.
+     *
+     * Lets a message derive its @c _maxSize from its field list instead of
+     * carrying a hand-maintained number:
+     *
+     * ```cpp
+     * static constexpr size_t _maxSize = sofab::max_size_v<
+     *     sofab::Field<1, uint32_t>,
+     *     sofab::Field<2, sofab::FixedString<16>>,
+     *     sofab::Field<3, Inner>>;
+     * ```
+     *
+     * The bound is tight: every field at its widest, which a real value can hit.
+     * An @ref OStreamObject sized from it therefore never reports
+     * @ref Error::BufferFull for a value its types can hold.
+     *
+     * @tparam Fields  @ref Field entries, one per message field.
+     */
+    template <typename... Fields>
+    inline constexpr std::size_t max_size_v = (std::size_t{0} + ... + Fields::maxSize);
+
+    /*!
+     * @brief Output stream that counts the bytes it is given and keeps none.
+     *
+     * Runs the real encoder over a small inline scratch buffer whose flush
+     * callback only adds to a total, so the count is exact by construction: the
+     * default-omission rules, the hold-back framing of nested messages
+     * (MESSAGE_SPEC §2) and every varint width come out exactly as they would
+     * on a real stream. Allocates nothing.
+     */
+    class OStreamCounter : public OStreamImpl
+    {
+        std::array<uint8_t, 16> scratch_ = {};  //!< Discarded encode buffer.
+        std::size_t counted_ = 0;               //!< Bytes flushed so far.
+
+        static void count_(
+            sofab_ostream_t *ctx, const uint8_t *data, size_t len, void *usrptr) noexcept
+        {
+            (void)ctx;
+            (void)data;
+
+            static_cast<OStreamCounter*>(usrptr)->counted_ += len;
+        }
+
+    public:
+        /*! @brief Construct an empty counter. */
+        OStreamCounter() noexcept
+        {
+            buffer_ = scratch_.data();
+            sofab_ostream_init(&ctx_, buffer_, scratch_.size(), 0, count_, this);
+        }
+
+        /*!
+         * @brief Bytes written so far.
+         * @return Total encoded size of everything written to this stream.
+         */
+        std::size_t count() noexcept
+        {
+            return counted_ + bytesUsed();
+        }
+    };
+
+    /*!
+     * @brief Exact encoded size of @p message, without producing the bytes.
+     *
+     * The runtime counterpart of a @c _maxSize bound: it reflects the actual
+     * values (string lengths, varint widths, omitted defaults). The count stops
+     * at the first failing write; use an @ref OStreamCounter directly when the
+     * verdict matters as well.
+     *
+     * @param message  Message to measure.
+     * @return Bytes @p message encodes to as a top-level message.
+     */
+    template <typename T>
+        requires std::derived_from<T, OStreamMessage>
+    std::size_t encodedSize(const T &message) noexcept
+    {
+        OStreamCounter counter;
+        (void)message.serialize(counter);
+        return counter.count();
+    }
+
+    /*!
+     * @brief Exact encoded size of one field, without producing the bytes.
+     * @param id     Field identifier.
+     * @param value  Field value; anything @ref OStreamImpl::write accepts.
+     * @return Bytes the field encodes to.
+     */
+    template <typename T>
+    std::size_t encodedSize(sofab_id_t id, const T &value) noexcept
+    {
+        OStreamCounter counter;
+        (void)counter.write(id, value);
+        return counter.count();
+    }
+
+
     /***************/
     /*** IStream ***/
     /***************/
@@ -2230,6 +2693,21 @@ namespace sofab
         }
 #endif
 
+        /*!
+         * @brief Traffic statistics of the message decoded so far.
+         *
+         * Facade over @ref sofab_istream_stats; reset whenever the stream is
+         * (re)initialized.
+         *
+         * @return The stream's counters (see @ref sofab_istream_stats_t).
+         */
+#if SOFAB_STATS
+        [[nodiscard]] const sofab_istream_stats_t& stats() const noexcept
+        {
+            return *sofab_istream_stats(&ctx_);
+        }
+#endif
+
         /*!
          * @brief Decode a sequence of variable-length string elements into a vector.
          *
@@ -0,0 +1,205 @@
+/*!
+ * @file uring.h
+ * @brief SofaBuffers C - Asynchronous stream I/O on Linux io_uring.
+ *
+ * The io_uring counterparts of the adapters in @c sofab/posix.h, for nodes where
+ * the write inside a flush callback (or the read before a feed) is the
+ * bottleneck. A @ref sofab_uring_t is a submission ring plus
+ * @ref SOFAB_URING_BUFFERS buffers, registered with the kernel once, so that no
+ * request has to map its memory again.
+ *
+ * - @ref sofab_ostream_uring_sink: a flush submits the filled buffer as an
+ *   asynchronous write and the encoder goes straight on in the next buffer;
+ *   it waits only when every buffer is still in flight.
+ * - @ref sofab_istream_feed_uring keeps reads into all buffers in flight and
+ *   feeds each one as it completes, in file order, while the kernel already
+ *   fills the others.
+ *
+ * Encoding and I/O thus overlap without a copy and without a thread. The
+ * requests are made with the io_uring system calls directly; liburing is not
+ * needed.
+ *
+ * This module is only built for Linux, as part of @c sofa-buffers::posix,
+ * where the kernel headers declare io_uring. A kernel or sandbox that refuses
+ * io_uring makes @ref sofab_uring_init fail (@c ENOSYS, @c EPERM), and the
+ * caller falls back to @c sofab/posix.h. A failed system call is reported as
+ * @ref SOFAB_RET_E_ARGUMENT with @c errno saying why.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_URING_H
+#define SOFAB_URING_H
+
+/**
+ * @defgroup c_api C API
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SOFAB_URING_C
+# define SOFAB_URING_EXTERN extern
+#else
+# define SOFAB_URING_EXTERN
+#endif
+
+/* includes *******************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sofab/istream.h"
+#include "sofab/ostream.h"
+
+/* constants ******************************************************************/
+
+/*!
+ * @brief Buffers of a ring, and so requests in flight at most.
+ *
+ * Two already overlap encoding (or decoding) with I/O; more absorb jitter in
+ * the I/O's completion.
+ */
+#ifndef SOFAB_URING_BUFFERS
+# define SOFAB_URING_BUFFERS        (4)
+#endif
+#if SOFAB_URING_BUFFERS < 2 || SOFAB_URING_BUFFERS > 64
+# error "SOFAB_URING_BUFFERS must be 2..64"
+#endif
+
+/*!
+ * @brief Offset for a descriptor without one (a pipe, a socket).
+ *
+ * Its requests are made at the descriptor's position, so only one is in
+ * flight at a time, to keep them in order.
+ */
+#define SOFAB_URING_STREAM          (-1)
+
+/* types **********************************************************************/
+
+/*!
+ * @brief State of one buffer's request.
+ */
+typedef struct sofab_uring_slot
+{
+    size_t len;                 /*!< Bytes requested */
+    size_t done;                /*!< Bytes transferred so far */
+    int64_t off;                /*!< File offset of the request, or SOFAB_URING_STREAM */
+    uint8_t op;                 /*!< Operation (a read or a write) */
+    uint8_t busy;               /*!< Request in flight */
+    uint8_t eof;                /*!< The read met the end of the file */
+} sofab_uring_slot_t;
+
+/*!
+ * @brief An io_uring instance with its registered buffers.
+ *
+ * One ring serves one stream at a time. The members past @c slot map the
+ * kernel's ring memory; they are opaque.
+ */
+typedef struct sofab_uring
+{
+    int fd;                     /*!< The ring */
+    int target;                 /*!< Descriptor of the stream being served */
+    int error;                  /*!< @c errno of the first failed request, 0 if none */
+    uint8_t fixed;              /*!< Whether the buffers could be registered */
+    unsigned cur;               /*!< Buffer the encoder writes into */
+    int64_t offset;             /*!< Offset of the next request, or SOFAB_URING_STREAM */
+    uint8_t *buffer;            /*!< Start of the first buffer */
+    size_t seglen;              /*!< Bytes per buffer */
+    sofab_uring_slot_t slot[SOFAB_URING_BUFFERS]; /*!< One per buffer */
+
+    void *sq_ring;              /*!< Submission ring mapping */
+    size_t sq_ring_len;         /*!< Its length */
+    void *cq_ring;              /*!< Completion ring mapping (may be @c sq_ring) */
+    size_t cq_ring_len;         /*!< Its length */
+    void *sqes;                 /*!< Submission entries mapping */
+    size_t sqes_len;            /*!< Its length */
+    unsigned *sq_tail;          /*!< Submission ring tail */
+    unsigned *sq_mask;          /*!< Submission ring index mask */
+    unsigned *sq_array;         /*!< Submission ring entry indices */
+    unsigned *cq_head;          /*!< Completion ring head */
+    unsigned *cq_tail;          /*!< Completion ring tail */
+    unsigned *cq_mask;          /*!< Completion ring index mask */
+    void *cqes;                 /*!< Completion entries */
+} sofab_uring_t;
+
+/* prototypes *****************************************************************/
+
+/*!
+ * @brief Set up a ring over @p buffer.
+ *
+ * Creates the io_uring instance, cuts @p buffer into @ref SOFAB_URING_BUFFERS
+ * equal buffers and registers them with the kernel. Where registration is
+ * refused (the locked-memory limit), the ring works with unregistered buffers.
+ *
+ * @param u       Ring.
+ * @param buffer  Memory for the buffers, valid until sofab_uring_exit().
+ * @param buflen  Size of @p buffer, at least @ref SOFAB_URING_BUFFERS times
+ *                @ref SOFAB_MIN_OUTPUT_BUFFER.
+ *
+ * @return SOFAB_RET_OK, or SOFAB_RET_E_ARGUMENT if io_uring is not available,
+ *         with @c errno set to the reason.
+ */
+extern sofab_ret_t sofab_uring_init (sofab_uring_t *u, uint8_t *buffer, size_t buflen);
+
+/*!
+ * @brief Tear a ring down.
+ *
+ * Every request must have completed (sofab_ostream_uring_flush() and
+ * sofab_istream_feed_uring() return only once they have).
+ *
+ * @param u  Ring.
+ */
+extern void sofab_uring_exit (sofab_uring_t *u);
+
+/*!
+ * @brief Initialize an output stream that writes to @p fd through a ring.
+ *
+ * The stream encodes into the ring's buffers in turn; each flush submits the
+ * filled one as a write and moves on. Finish with
+ * @ref sofab_ostream_uring_flush.
+ *
+ * @param os      Output stream to initialize.
+ * @param u       Ring, not serving another stream.
+ * @param fd      Descriptor to write to.
+ * @param offset  File offset of the first byte, or @ref SOFAB_URING_STREAM.
+ */
+extern void sofab_ostream_uring_sink (
+    sofab_ostream_t *os, sofab_uring_t *u, int fd, int64_t offset);
+
+/*!
+ * @brief Write out everything encoded so far and wait for it.
+ *
+ * @param os  Output stream set up by @ref sofab_ostream_uring_sink.
+ *
+ * @return SOFAB_RET_OK if every byte has been written, or SOFAB_RET_E_ARGUMENT
+ *         if a write failed, with @c errno set to its error.
+ */
+extern sofab_ret_t sofab_ostream_uring_flush (sofab_ostream_t *os);
+
+/*!
+ * @brief Feed everything a descriptor delivers, up to its end, reading ahead.
+ *
+ * Keeps a read into every buffer of @p u in flight (one, for
+ * @ref SOFAB_URING_STREAM) and feeds the buffers to @p is in file order.
+ *
+ * @param is      Input stream, initialized with sofab_istream_init().
+ * @param u       Ring, not serving another stream.
+ * @param fd      Descriptor to read from.
+ * @param offset  File offset to read from, or @ref SOFAB_URING_STREAM.
+ *
+ * @return What @ref sofab_istream_feed reports for all the bytes read (the
+ *         reading stops at the first SOFAB_RET_E_INVALID_MSG), or
+ *         SOFAB_RET_E_ARGUMENT if a read failed, with @c errno set to its error.
+ */
+extern sofab_ret_t sofab_istream_feed_uring (
+    sofab_istream_t *is, sofab_uring_t *u, int fd, int64_t offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */ // end of defgroup
+
+#endif /* SOFAB_URING_H */
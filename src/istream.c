@@ -10,6 +10,7 @@
 /* includes *******************************************************************/
 #include "sofab/istream.h"
 #include "sofab/utf8.h"
+#include "trace.h"
 
 #include <assert.h>
 
@@ -318,6 +319,10 @@ static sofab_ret_t _call_field_callback_masked (
     }
 #endif /* !defined(SOFAB_DISABLE_SEQUENCE_SUPPORT) */
 
+#if SOFAB_STATS
+    ctx->stats.callbacks++;
+#endif
+
     // call field callback to notify about new field with size
     ctx->decoder->field_callback(
         ctx, ctx->id, ctx->target_len, ctx->target_count, ctx->decoder->usrptr);
@@ -501,6 +506,32 @@ extern void sofab_istream_init (
     ctx->decoder->usrptr = usrptr;
 }
 
+extern void sofab_istream_reset (sofab_istream_t *ctx)
+{
+    assert(ctx != NULL);
+    assert(ctx->decoder != NULL);
+
+    // Everything else is set from the next field header on, before it is read.
+    ctx->decoder = &ctx->default_decoder;
+    ctx->default_decoder.state = _DECODER_STATE_IDLE;
+    ctx->default_decoder.skip_depth = 0;
+    ctx->varint_value = 0;
+    ctx->varint_shift = 0;
+    ctx->invalid = 0;
+#if SOFAB_STRICT_UTF8
+    ctx->utf8_start = NULL;
+#endif
+#if !defined(SOFAB_DISABLE_SEQUENCE_SUPPORT)
+    ctx->depth = 0;
+#endif
+#if SOFAB_SKIP_COUNTER
+    ctx->skipped = 0;
+#endif
+#if SOFAB_STATS
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+#endif
+}
+
 extern sofab_ret_t sofab_istream_feed (sofab_istream_t *ctx, const void *data, size_t datalen)
 {
     int dec;
@@ -519,17 +550,47 @@ extern sofab_ret_t sofab_istream_feed (sofab_istream_t *ctx, const void *data, s
      */
     assert(datalen == 0 || data != NULL);
 
+    SOFAB_PROBE3(feed__start, ctx, data, datalen);
+
     // The message may already have been rejected on an earlier feed -- by a
     // callback, or by the decoder itself. The flag is sticky, so short-circuit
     // rather than decode bytes that belong to a message already condemned.
     if (ctx->invalid)
     {
+        SOFAB_PROBE3(feed__done, ctx, 0, (int)SOFAB_RET_E_INVALID_MSG);
         return SOFAB_RET_E_INVALID_MSG;
     }
 
+#if SOFAB_STATS
+    ctx->stats.feeds++;
+    ctx->stats.bytes += datalen;
+#endif
+
     const uint8_t *p;
     for (p = (const uint8_t *)data; datalen > 0; p++, datalen--)
     {
+#if SOFAB_STATS
+        // Classify the byte by the state about to consume it: a value byte
+        // (varint payload or fixlen data) lands in a bound destination or is
+        // dropped; header, length and count bytes are neither.
+        {
+            uint8_t state = ctx->decoder->state;
+            if (state == _DECODER_STATE_VARINT_UNSIGNED
+                || state == _DECODER_STATE_VARINT_SIGNED
+                || state > _DECODER_STATE_ARRAY_COUNT)
+            {
+                if (ctx->target_ptr)
+                {
+                    ctx->stats.bytes_copied++;
+                }
+                else
+                {
+                    ctx->stats.bytes_skipped++;
+                }
+            }
+        }
+#endif /* SOFAB_STATS */
+
         // The varint-decoding states (state <= _DECODER_STATE_ARRAY_COUNT) all
         // start by pulling one LEB128 varint and reject an over-wide value the
         // same way, so that shared preamble lives here once instead of in each
@@ -573,6 +634,13 @@ extern sofab_ret_t sofab_istream_feed (sofab_istream_t *ctx, const void *data, s
                 ctx->target_len = 0;
                 ctx->target_count = 0;
 
+#if SOFAB_STATS
+                if (type != SOFAB_TYPE_SEQUENCE_END)
+                {
+                    ctx->stats.fields++;
+                }
+#endif
+
                 uint8_t callback = 0;
                 switch (type)
                 {
@@ -654,6 +722,13 @@ extern sofab_ret_t sofab_istream_feed (sofab_istream_t *ctx, const void *data, s
                     // skip_depth alone would undercount the nesting by exactly
                     // the number of levels the caller took an interest in.
                     ctx->depth++;
+                    SOFAB_PROBE3(sequence__start, ctx, ctx->id, ctx->depth);
+#if SOFAB_STATS
+                    if (ctx->depth > ctx->stats.max_depth)
+                    {
+                        ctx->stats.max_depth = ctx->depth;
+                    }
+#endif
 
                     // if not interested in sequence ...
                     if (!ctx->target_ptr)
@@ -686,6 +761,7 @@ extern sofab_ret_t sofab_istream_feed (sofab_istream_t *ctx, const void *data, s
                     // the level closed above is no longer open (the unmatched
                     // end returns above, so this only runs for a real close)
                     ctx->depth--;
+                    SOFAB_PROBE2(sequence__end, ctx, ctx->depth);
                 }
 #endif /* !defined(SOFAB_DISABLE_SEQUENCE_SUPPORT) */
 
@@ -702,6 +778,8 @@ extern sofab_ret_t sofab_istream_feed (sofab_istream_t *ctx, const void *data, s
                     if (_store_scalar(ctx->target_ptr, ctx->target_len, unsigned_value) != 0)
                     {
                         // target width is not 1/2/4/8: a bad read_* argument
+                        SOFAB_PROBE3(feed__done, ctx, p - (const uint8_t *)data,
+                                     (int)SOFAB_RET_E_ARGUMENT);
                         return SOFAB_RET_E_ARGUMENT;
                     }
 
@@ -745,6 +823,8 @@ extern sofab_ret_t sofab_istream_feed (sofab_istream_t *ctx, const void *data, s
                             (sofab_unsigned_t)signed_value) != 0)
                     {
                         // target width is not 1/2/4/8: a bad read_* argument
+                        SOFAB_PROBE3(feed__done, ctx, p - (const uint8_t *)data,
+                                     (int)SOFAB_RET_E_ARGUMENT);
                         return SOFAB_RET_E_ARGUMENT;
                     }
 
@@ -1099,7 +1179,12 @@ extern sofab_ret_t sofab_istream_feed (sofab_istream_t *ctx, const void *data, s
     // (consumed bytes end mid-field or with an open sequence). INCOMPLETE is a
     // valid but partial decode, NOT a rejection: the caller owns end-of-input
     // and may resume by feeding more bytes. There is no finalize step.
-    return _at_message_boundary(ctx) ? SOFAB_RET_OK : SOFAB_RET_INCOMPLETE;
+    {
+        sofab_ret_t ret = _at_message_boundary(ctx) ? SOFAB_RET_OK : SOFAB_RET_INCOMPLETE;
+
+        SOFAB_PROBE3(feed__done, ctx, p - (const uint8_t *)data, (int)ret);
+        return ret;
+    }
 
 invalid:
     /*
@@ -1130,6 +1215,8 @@ invalid:
      */
     ctx->invalid = 1;
 
+    SOFAB_PROBE3(invalid, ctx, p - (const uint8_t *)data, ctx->depth);
+    SOFAB_PROBE3(feed__done, ctx, p - (const uint8_t *)data, (int)SOFAB_RET_E_INVALID_MSG);
     return SOFAB_RET_E_INVALID_MSG;
 }
 
@@ -1151,6 +1238,15 @@ extern uint8_t sofab_istream_skipped (const sofab_istream_t *ctx)
 }
 #endif /* SOFAB_SKIP_COUNTER */
 
+#if SOFAB_STATS
+extern const sofab_istream_stats_t *sofab_istream_stats (const sofab_istream_t *ctx)
+{
+    assert(ctx != NULL);
+
+    return &ctx->stats;
+}
+#endif /* SOFAB_STATS */
+
 extern void sofab_istream_read_field (
     sofab_istream_t *ctx, void *var, size_t varlen, uint8_t opt)
 {
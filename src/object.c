@@ -9,16 +9,36 @@
 
 /* includes *******************************************************************/
 #include "sofab/object.h"
+#include "sofab/framing.h"
+#include "trace.h"
 
 #include <assert.h>
 
 /* constants ******************************************************************/
+/*! @brief Field ids a batch decode looks up by table; larger ids are searched. */
+#define _BATCH_INDEX    (64)
 
 /* macros *********************************************************************/
 /*! @brief Cast @p ptr advanced by @p offset bytes to @p type (field accessor). */
 #define CAST_TO(type, ptr, offset) ((type)((const uint8_t *)(ptr) + (offset)))
 
+/*! @brief Hint that @p ptr will be read (rw 0) or written (rw 1) soon. */
+#if defined(__GNUC__)
+# define PREFETCH(ptr, rw) __builtin_prefetch((ptr), (rw))
+#else
+# define PREFETCH(ptr, rw) ((void)(ptr))
+#endif
+
 /* types **********************************************************************/
+/*!
+ * @brief Top-level field lookup of a batch decode, built once per batch.
+ */
+typedef struct
+{
+    sofab_object_decoder_t *dec;        /*!< The caller's decoder chain */
+    uint8_t indexed;                    /*!< The table below is in use */
+    uint8_t index[_BATCH_INDEX];        /*!< Per id: field position + 1, 0 for none */
+} _batch_t;
 
 /* prototypes *****************************************************************/
 
@@ -607,6 +627,8 @@ extern sofab_ret_t sofab_object_encode (
     assert(info != NULL);
     assert(src != NULL);
 
+    SOFAB_PROBE3(object__encode__start, ctx, info, src);
+
     /*
      * MESSAGE_SPEC §2/§5.1, positional element rule inside a wrapper-array holder
      * (info->fixed_seq): a wrapper carries no length field, so the decoded length
@@ -691,7 +713,9 @@ extern sofab_ret_t sofab_object_encode (
                 const uint8_t width = field->element_size;
                 if (((_SOFAB_WIDTH_SET >> width) & 1u) == 0)
                 {
-                    return SOFAB_RET_E_ARGUMENT; // Unsupported size (8 requires 64-bit values)
+                    // Unsupported size (8 requires 64-bit values)
+                    SOFAB_PROBE3(object__encode__done, ctx, info, (int)SOFAB_RET_E_ARGUMENT);
+                    return SOFAB_RET_E_ARGUMENT;
                 }
 
                 sofab_unsigned_t val = (sofab_unsigned_t)_load_uint(
@@ -809,18 +833,44 @@ extern sofab_ret_t sofab_object_encode (
 
             default:
                 // Unsupported field type in descriptor
+                SOFAB_PROBE3(object__encode__done, ctx, info, (int)SOFAB_RET_E_ARGUMENT);
                 return SOFAB_RET_E_ARGUMENT;
         }
     }
 #undef _SOFAB_FIELD_COUNT
 #undef _SOFAB_ELEMENT_HELD
 
+    SOFAB_PROBE3(object__encode__done, ctx, info, (int)ret);
     return ret;
 }
 
-extern void sofab_object_field_cb (sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usrptr)
+/*!
+ * @brief Find the descriptor field of @p id: the first one listed with it.
+ *
+ * @return The field, or NULL if the descriptor has none.
+ */
+static const sofab_object_descr_field_t *_find_field (const sofab_object_descr_t *info, sofab_id_t id)
+{
+    for (size_t i = 0; i < info->field_count; i++)
+    {
+        if (info->field_list[i].id == id)
+        {
+            return &info->field_list[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*!
+ * @brief Field callback body: bind field @p id to @p field of the current
+ *        destination, or handle an id the descriptor does not have.
+ *
+ * @param field  The descriptor field of @p id, or NULL if there is none.
+ */
+static void _field_cb (sofab_istream_t *ctx, sofab_object_decoder_t *decoder,
+    const sofab_object_descr_field_t *field, sofab_id_t id, size_t size, size_t count)
 {
-    sofab_object_decoder_t *decoder = (sofab_object_decoder_t *)usrptr;
     const sofab_object_descr_t *info = decoder->info;
 
 #if defined(SOFAB_DISABLE_FIXLEN_SUPPORT)
@@ -841,14 +891,8 @@ extern void sofab_object_field_cb (sofab_istream_t *ctx, sofab_id_t id, size_t s
     const uint8_t wire_opt = ctx->target_opt;
 #endif /* !defined(SOFAB_DISABLE_SEQUENCE_SUPPORT) */
 
-    for (size_t i = 0; i < info->field_count; i++)
+    if (field != NULL)
     {
-        const sofab_object_descr_field_t *field = &info->field_list[i];
-        if (field->id != id)
-        {
-            continue;
-        }
-
         /* MESSAGE_SPEC §7.3 (a header wire type that contradicts the declared
          * type is skipped like an unknown id) needs no check for a branch that
          * only binds: the istream unbinds a contradicting read and skips the
@@ -1085,3 +1129,114 @@ extern void sofab_object_field_cb (sofab_istream_t *ctx, sofab_id_t id, size_t s
     }
 #endif /* !defined(SOFAB_DISABLE_SEQUENCE_SUPPORT) */
 }
+
+/*!
+ * @brief Top-level field callback of a batch decode: as sofab_object_field_cb(),
+ *        with the field looked up in the batch's table.
+ */
+static void _batch_field_cb (sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usrptr)
+{
+    _batch_t *batch = (_batch_t *)usrptr;
+    const sofab_object_descr_field_t *field;
+
+    if (batch->indexed && id < _BATCH_INDEX)
+    {
+        field = batch->index[id] != 0 ? &batch->dec->info->field_list[batch->index[id] - 1] : NULL;
+    }
+    else
+    {
+        field = _find_field(batch->dec->info, id);
+    }
+
+    _field_cb(ctx, batch->dec, field, id, size, count);
+}
+
+extern void sofab_object_field_cb (sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usrptr)
+{
+    sofab_object_decoder_t *decoder = (sofab_object_decoder_t *)usrptr;
+
+    _field_cb(ctx, decoder, _find_field(decoder->info, id), id, size, count);
+}
+
+extern sofab_ret_t sofab_object_decode_batch (
+    sofab_object_decoder_t *dec,
+    const void *frames,
+    size_t len,
+    void *dst,
+    size_t stride,
+    size_t n,
+    sofab_ret_t *status,
+    size_t *count,
+    size_t *used)
+{
+    const uint8_t *p = (const uint8_t *)frames;
+    const uint8_t *end = len ? p + len : p;
+    uint8_t *obj = (uint8_t *)dst;
+    sofab_istream_t is;
+    _batch_t batch;
+    sofab_ret_t ret = SOFAB_RET_OK;
+    size_t i;
+
+    assert(dec != NULL && dec->info != NULL);
+    assert(frames != NULL || len == 0);
+    assert(dst != NULL || n == 0);
+    assert(status != NULL || n == 0);
+    assert(count != NULL);
+
+    /* The top-level lookup, once for the whole batch: the first field listed
+     * with an id wins, as in _find_field(). A descriptor too long for a byte
+     * per position keeps the search. */
+    batch.dec = dec;
+    batch.indexed = dec->info->field_count < UINT8_MAX;
+    memset(batch.index, 0, sizeof(batch.index));
+    for (i = dec->info->field_count; batch.indexed && i-- > 0; )
+    {
+        if (dec->info->field_list[i].id < _BATCH_INDEX)
+        {
+            batch.index[dec->info->field_list[i].id] = (uint8_t)(i + 1);
+        }
+    }
+    sofab_istream_init(&is, _batch_field_cb, &batch);
+
+    for (i = 0; i < n && p != end; i++, obj += stride)
+    {
+        size_t prefixlen, msglen;
+
+        ret = sofab_framing_next(p, (size_t)(end - p), &prefixlen, &msglen);
+        if (ret != SOFAB_RET_OK)
+        {
+            break;
+        }
+
+        const uint8_t *msg = p + prefixlen;
+        p = msg + msglen;
+        /* the next frame's prefix and record, while this one decodes */
+        if (p != end)
+        {
+            PREFETCH(p, 0);
+        }
+        if (i + 1 < n)
+        {
+            PREFETCH(obj + stride, 1);
+        }
+
+        ret = sofab_object_init(dec->info, obj);
+        if (ret != SOFAB_RET_OK)
+        {
+            p = msg - prefixlen;
+            break;
+        }
+        dec->dst = obj;
+        sofab_istream_reset(&is);
+        status[i] = sofab_istream_feed(&is, msg, msglen) == SOFAB_RET_OK
+            ? SOFAB_RET_OK : SOFAB_RET_E_INVALID_MSG;
+    }
+
+    *count = i;
+    if (used != NULL)
+    {
+        *used = (size_t)(p - (const uint8_t *)frames);
+    }
+
+    return ret;
+}
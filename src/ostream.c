@@ -10,6 +10,7 @@
 /* includes *******************************************************************/
 #include "sofab/ostream.h"
 #include "sofab/utf8.h"
+#include "trace.h"
 
 #include <assert.h>
 
@@ -86,6 +87,11 @@ static void _drain (sofab_ostream_t *ctx)
     size_t used = (size_t)(ctx->offset - data);
 
     ctx->offset = data;
+#if SOFAB_STATS
+    ctx->stats.flushes++;
+    ctx->stats.bytes_flushed += used;
+#endif
+    SOFAB_PROBE3(flush, ctx, data, used);
     ctx->flush(ctx, data, used, ctx->usrptr);
 }
 
@@ -375,6 +381,10 @@ extern void sofab_ostream_init (
      * themselves stay untouched -- npending bounds every read of them. */
     ctx->npending = 0;
 #endif /* SEQUENCE && LAZY_SEQ */
+#if SOFAB_STATS
+    ctx->stats.flushes = 0;
+    ctx->stats.bytes_flushed = 0;
+#endif
 }
 
 extern size_t sofab_ostream_flush (sofab_ostream_t *ctx)
@@ -399,6 +409,15 @@ extern size_t sofab_ostream_bytes_used (sofab_ostream_t *ctx)
     return (size_t)(ctx->offset - ctx->buffer);
 }
 
+#if SOFAB_STATS
+extern const sofab_ostream_stats_t *sofab_ostream_stats (const sofab_ostream_t *ctx)
+{
+    assert(ctx != NULL);
+
+    return &ctx->stats;
+}
+#endif /* SOFAB_STATS */
+
 extern void sofab_ostream_buffer_set	(
     sofab_ostream_t *ctx, uint8_t *buffer, size_t buflen, size_t offset)
 {
@@ -661,6 +680,90 @@ extern sofab_ret_t sofab_ostream_write_array_of_fixlen (
     return SOFAB_RET_OK;
 }
 #endif /* !defined(SOFAB_DISABLE_FIXLEN_SUPPORT) */
+
+extern sofab_ret_t sofab_ostream_write_array_begin (
+    sofab_ostream_t *ctx, sofab_id_t id, sofab_type_t type, int32_t element_count)
+{
+    assert(ctx != NULL);
+    assert(element_count >= 0); /* zero-count arrays are legal */
+    assert(type == SOFAB_TYPE_VARINTARRAY_UNSIGNED
+        || type == SOFAB_TYPE_VARINTARRAY_SIGNED);
+
+    return _write_id_varint(ctx, id, type, (sofab_unsigned_t)element_count);
+}
+
+extern sofab_ret_t sofab_ostream_write_array_element_unsigned (
+    sofab_ostream_t *ctx, sofab_unsigned_t value)
+{
+    assert(ctx != NULL);
+
+    // The header went out with sofab_ostream_write_array_begin(), which is also
+    // where any held-back sequence run was committed; an element is a bare
+    // varint inside that field.
+    if (_varint_encode(ctx, value) < 0)
+    {
+        return SOFAB_RET_E_BUFFER_FULL;
+    }
+
+    return SOFAB_RET_OK;
+}
+
+extern sofab_ret_t sofab_ostream_write_array_element_signed (
+    sofab_ostream_t *ctx, sofab_signed_t value)
+{
+    assert(ctx != NULL);
+
+    if (_varint_encode(ctx, _zigzag_encode(value)) < 0)
+    {
+        return SOFAB_RET_E_BUFFER_FULL;
+    }
+
+    return SOFAB_RET_OK;
+}
+
+#if !defined(SOFAB_DISABLE_FIXLEN_SUPPORT)
+extern sofab_ret_t sofab_ostream_write_array_begin_fixlen (
+    sofab_ostream_t *ctx, sofab_id_t id,
+    int32_t element_count, int32_t element_size, sofab_fixlentype_t type)
+{
+    sofab_ret_t ret;
+
+    assert(ctx != NULL);
+    assert(element_count >= 0); /* zero-count arrays are legal */
+    assert(element_size > 0);
+
+    // only FP32 and FP64 are supported for fixlen arrays
+    assert(type <= SOFAB_FIXLENTYPE_FP64);
+
+    if ((ret = _write_id_varint(ctx, id, SOFAB_TYPE_FIXLENARRAY,
+            (sofab_unsigned_t)element_count)) != SOFAB_RET_OK)
+    {
+        return ret;
+    }
+
+    // Always written, as in sofab_ostream_write_array_of_fixlen().
+    if (_varint_encode(ctx, _type_encode(element_size, type)) < 0)
+    {
+        return SOFAB_RET_E_BUFFER_FULL;
+    }
+
+    return SOFAB_RET_OK;
+}
+
+extern sofab_ret_t sofab_ostream_write_array_element_fixlen (
+    sofab_ostream_t *ctx, const void *data, int32_t element_size)
+{
+    assert(ctx != NULL);
+    assert(data != NULL);
+    assert(element_size > 0);
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return _write_fixlen_reverse(ctx, (const uint8_t *)data, element_size);
+#else
+    return _write_fixlen(ctx, data, (size_t)element_size);
+#endif /* defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ */
+}
+#endif /* !defined(SOFAB_DISABLE_FIXLEN_SUPPORT) */
 #endif /* !defined(SOFAB_DISABLE_ARRAY_SUPPORT) */
 
 #if !defined(SOFAB_DISABLE_SEQUENCE_SUPPORT)
@@ -0,0 +1,221 @@
+/*!
+ * @file posix.c
+ * @brief SofaBuffers C - File descriptor and mmap adapters for the streams.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* writev, mmap and friends are POSIX, not C99; the library itself is built with extensions off */
+#define _POSIX_C_SOURCE 200809L
+
+#define SOFAB_POSIX_C
+
+/* includes *******************************************************************/
+#include "sofab/posix.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* functions ******************************************************************/
+
+/*!
+ * @brief Write every pending segment of a sink, in as few writev() as it takes.
+ *
+ * A short write advances the vector past what went out and writes the rest; an
+ * interrupted one is repeated. The first failure is kept in @c sink->error and
+ * ends the sink's writing for good. The pending segments are gone either way.
+ *
+ * @param sink  Sink state.
+ */
+static void _write_pending (sofab_fd_sink_t *sink)
+{
+    struct iovec *iov = sink->iov;
+    int cnt = (int)sink->pending;
+
+    sink->pending = 0;
+
+    while (cnt > 0 && sink->error == 0)
+    {
+        ssize_t n = writev(sink->fd, iov, cnt);
+        size_t done;
+
+        if (n < 0)
+        {
+            if (errno != EINTR)
+            {
+                sink->error = errno;
+            }
+            continue;
+        }
+        if (n == 0)
+        {
+            /* nothing taken, nothing refused: a descriptor that would spin us */
+            sink->error = EIO;
+            break;
+        }
+
+        done = (size_t)n;
+        while (cnt > 0 && done >= iov->iov_len)
+        {
+            done -= iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if (cnt > 0)
+        {
+            iov->iov_base = (uint8_t *)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+}
+
+/*!
+ * @brief Flush callback of a file descriptor sink.
+ *
+ * Queues the flushed bytes as the next pending segment and moves the encoder on
+ * to the following one; when there is none left, all of them are written
+ * first and the encoder starts over at the first. An empty flush queues
+ * nothing, and after a failed write nothing is queued at all.
+ */
+static void _fd_flush (sofab_ostream_t *ctx, const uint8_t *data, size_t len, void *usrptr)
+{
+    sofab_fd_sink_t *sink = (sofab_fd_sink_t *)usrptr;
+
+    if (len > 0 && sink->error == 0)
+    {
+        sink->iov[sink->pending].iov_base = (void *)data;
+        sink->iov[sink->pending].iov_len = len;
+        sink->pending++;
+
+        if (sink->pending == SOFAB_FD_SINK_SEGMENTS)
+        {
+            _write_pending(sink);
+        }
+    }
+
+    sofab_ostream_buffer_set(ctx, sink->buffer + sink->pending * sink->seglen, sink->seglen, 0);
+}
+
+//
+
+extern void sofab_ostream_fd_sink (
+    sofab_ostream_t *os, sofab_fd_sink_t *sink, int fd, uint8_t *buffer, size_t buflen)
+{
+    assert(os != NULL);
+    assert(sink != NULL);
+    assert(buffer != NULL);
+    assert(buflen / SOFAB_FD_SINK_SEGMENTS >= SOFAB_MIN_OUTPUT_BUFFER);
+
+    sink->fd = fd;
+    sink->error = 0;
+    sink->buffer = buffer;
+    sink->seglen = buflen / SOFAB_FD_SINK_SEGMENTS;
+    sink->pending = 0;
+
+    sofab_ostream_init(os, buffer, sink->seglen, 0, _fd_flush, sink);
+}
+
+extern sofab_ret_t sofab_ostream_fd_flush (sofab_ostream_t *os)
+{
+    sofab_fd_sink_t *sink;
+
+    assert(os != NULL);
+    assert(os->flush == _fd_flush);
+
+    sink = (sofab_fd_sink_t *)os->usrptr;
+
+    sofab_ostream_flush(os);
+    _write_pending(sink);
+
+    /* the segment the flush moved on to is the first again */
+    sofab_ostream_buffer_set(os, sink->buffer, sink->seglen, 0);
+
+    if (sink->error != 0)
+    {
+        errno = sink->error;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    return SOFAB_RET_OK;
+}
+
+extern sofab_ret_t sofab_istream_feed_fd (
+    sofab_istream_t *is, int fd, uint8_t *buf, size_t buflen)
+{
+    sofab_ret_t ret;
+
+    assert(is != NULL);
+    assert(buf != NULL);
+    assert(buflen > 0);
+
+    /* the outcome so far, should the descriptor be empty */
+    ret = sofab_istream_feed(is, NULL, 0);
+
+    while (ret != SOFAB_RET_E_INVALID_MSG)
+    {
+        ssize_t n = read(fd, buf, buflen);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return SOFAB_RET_E_ARGUMENT;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+
+        ret = sofab_istream_feed(is, buf, (size_t)n);
+    }
+
+    return ret;
+}
+
+extern sofab_ret_t sofab_istream_feed_mmap (sofab_istream_t *is, int fd)
+{
+    struct stat st;
+    size_t len;
+    void *map;
+    sofab_ret_t ret;
+
+    assert(is != NULL);
+
+    if (fstat(fd, &st) != 0)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    /* mmap() refuses a zero length, and the empty file is the empty message */
+    if (st.st_size == 0)
+    {
+        return sofab_istream_feed(is, NULL, 0);
+    }
+
+    if (st.st_size < 0 || (uintmax_t)st.st_size > SIZE_MAX)
+    {
+        errno = EFBIG;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+    len = (size_t)st.st_size;
+
+    map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    /* advisory only: a kernel that ignores it just reads ahead less */
+    (void)posix_madvise(map, len, POSIX_MADV_SEQUENTIAL);
+
+    ret = sofab_istream_feed(is, map, len);
+
+    munmap(map, len);
+
+    return ret;
+}
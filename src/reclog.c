@@ -0,0 +1,968 @@
+/*!
+ * @file reclog.c
+ * @brief SofaBuffers C - Append-only record log with an index footer.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* pwrite, mmap and friends are POSIX, not C99; the library itself is built with extensions off */
+#define _POSIX_C_SOURCE 200809L
+
+#define SOFAB_RECLOG_C
+
+/* includes *******************************************************************/
+#include "sofab/reclog.h"
+#include "sofab/framing.h"
+#include "scan.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* constants ******************************************************************/
+
+#define RECLOG_HEADER_LEN       (12)
+#define RECLOG_MARKER_LEN       (5)     /* FF FF FF FF and the block's tag */
+#define RECLOG_TAG_CHECKPOINT   (0x43)  /* 'C' */
+#define RECLOG_TAG_INDEX        (0x49)  /* 'I' */
+
+/* Checkpoint up to its index: marker, count, self, base and prev. */
+#define RECLOG_CHECKPOINT_HEAD  (RECLOG_MARKER_LEN + 4 + 8 + 8 + 8)
+
+/* Footer after its index: n, self, checkpoint, check and the magic. */
+#define RECLOG_TRAILER_LEN      (8 + 8 + 8 + 4 + 4)
+
+/* First index allocation, in records, before it grows by doubling. */
+#define RECLOG_INDEX_INITIAL    (1024)
+
+static const uint8_t _header_magic[4] = { 0x53, 0x46, 0x42, 0x4C }; /* "SFBL" */
+static const uint8_t _footer_magic[4] = { 0x53, 0x46, 0x42, 0x49 }; /* "SFBI" */
+
+/* functions ******************************************************************/
+
+static void _put_u32 (uint8_t *p, uint32_t v)
+{
+    for (unsigned i = 0; i < 4; i++)
+    {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static void _put_u64 (uint8_t *p, uint64_t v)
+{
+    for (unsigned i = 0; i < 8; i++)
+    {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint32_t _get_u32 (const uint8_t *p)
+{
+    uint32_t v = 0;
+
+    for (unsigned i = 0; i < 4; i++)
+    {
+        v |= (uint32_t)p[i] << (8 * i);
+    }
+
+    return v;
+}
+
+static uint64_t _get_u64 (const uint8_t *p)
+{
+    uint64_t v = 0;
+
+    for (unsigned i = 0; i < 8; i++)
+    {
+        v |= (uint64_t)p[i] << (8 * i);
+    }
+
+    return v;
+}
+
+/*!
+ * @brief 32-bit FNV-1a, the check of checkpoints and the footer.
+ */
+static uint32_t _check (const uint8_t *p, size_t len)
+{
+    uint32_t h = 2166136261u;
+
+    while (len--)
+    {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+static void _put_marker (uint8_t *p, uint8_t tag)
+{
+    memset(p, 0xFF, RECLOG_MARKER_LEN - 1);
+    p[RECLOG_MARKER_LEN - 1] = tag;
+}
+
+static int _is_marker (const uint8_t *p, size_t avail, uint8_t tag)
+{
+    return avail >= RECLOG_MARKER_LEN
+        && p[0] == 0xFF && p[1] == 0xFF && p[2] == 0xFF && p[3] == 0xFF
+        && p[4] == tag;
+}
+
+/*!
+ * @brief Write a whole vector at the descriptor's position, through short
+ *        writes and @c EINTR.
+ *
+ * @return 0 on success, -1 on failure with @c errno set.
+ */
+static int _write_all (int fd, struct iovec *iov, int cnt)
+{
+    while (cnt > 0)
+    {
+        ssize_t n = writev(fd, iov, cnt);
+        size_t done;
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        done = (size_t)n;
+        while (cnt > 0 && done >= iov->iov_len)
+        {
+            done -= iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if (cnt > 0)
+        {
+            if (n == 0)
+            {
+                errno = EIO;
+                return -1;
+            }
+            iov->iov_base = (uint8_t *)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * @brief Read the key out of an encoded record.
+ *
+ * The value of the last top-level unsigned field @p id, as the decoder would
+ * leave it; 0 if there is none, the value a record that omits it has.
+ *
+ * @return 0 on success, -1 if the message is malformed or truncated.
+ */
+static int _key_of (const uint8_t *msg, size_t len, sofab_id_t id, uint64_t *key)
+{
+    const uint8_t *p = msg, *end = msg + len;
+    unsigned depth = 0;
+
+    *key = 0;
+
+    while (p != end)
+    {
+        sofab_id_t field;
+        uint8_t type;
+
+        if (sofab_scan_header(&p, end, &field, &type) != 0)
+        {
+            return -1;
+        }
+
+        if (type == SOFAB_TYPE_SEQUENCE_START)
+        {
+            if (depth == SOFAB_MAX_DEPTH)
+            {
+                return -1;
+            }
+            depth++;
+        }
+        else if (type == SOFAB_TYPE_SEQUENCE_END)
+        {
+            if (depth == 0)
+            {
+                return -1;
+            }
+            depth--;
+        }
+        else if (depth == 0 && type == SOFAB_TYPE_VARINT_UNSIGNED && field == id)
+        {
+            if (sofab_scan_varint(&p, end, key) != 0)
+            {
+                return -1;
+            }
+        }
+        else if (sofab_scan_value(&p, end, type) != 0)
+        {
+            return -1;
+        }
+    }
+
+    return depth == 0 ? 0 : -1;
+}
+
+/*!
+ * @brief Index words per record: the offset, and the key of a keyed log.
+ */
+static size_t _words (uint8_t keyed)
+{
+    return keyed ? 2 : 1;
+}
+
+/*!
+ * @brief Make room in the writer's index for @p records records.
+ *
+ * @return 0 on success, -1 if the memory cannot be had (@c errno is set).
+ */
+static int _index_reserve (sofab_reclog_writer_t *w, size_t records)
+{
+    size_t cap = w->cap ? w->cap : RECLOG_INDEX_INITIAL;
+    uint64_t *index;
+
+    if (records <= w->cap)
+    {
+        return 0;
+    }
+    while (cap < records)
+    {
+        cap *= 2;
+    }
+    if (cap > SIZE_MAX / (_words(w->keyed) * sizeof(uint64_t)))
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    index = (uint64_t *)realloc(w->index, cap * _words(w->keyed) * sizeof(uint64_t));
+    if (index == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    w->index = index;
+    w->cap = cap;
+
+    return 0;
+}
+
+/*!
+ * @brief Encode the index entries of records [@p from, @p to) to @p out.
+ */
+static void _index_encode (const sofab_reclog_writer_t *w, size_t from, size_t to, uint8_t *out)
+{
+    const size_t words = _words(w->keyed);
+
+    for (size_t i = from * words; i < to * words; i++)
+    {
+        _put_u64(out, w->index[i]);
+        out += 8;
+    }
+}
+
+/*!
+ * @brief Decode @p n index entries from @p in into the writer's index,
+ *        starting at record @p at.
+ */
+static void _index_decode (sofab_reclog_writer_t *w, size_t at, size_t n, const uint8_t *in)
+{
+    const size_t words = _words(w->keyed);
+
+    for (size_t i = at * words; i < (at + n) * words; i++)
+    {
+        w->index[i] = _get_u64(in);
+        in += 8;
+    }
+}
+
+/*!
+ * @brief Check for a valid checkpoint at @p pos of a mapped log.
+ *
+ * @return 1 if there is one (its @p count, @p base and @p prev filled in),
+ *         0 otherwise.
+ */
+static int _checkpoint_at (
+    const uint8_t *map, size_t len, size_t pos, size_t entbytes,
+    size_t *count, uint64_t *base, uint64_t *prev)
+{
+    const uint8_t *p = map + pos;
+    size_t room, n;
+
+    if (len - pos < RECLOG_CHECKPOINT_HEAD + 4
+        || !_is_marker(p, len - pos, RECLOG_TAG_CHECKPOINT))
+    {
+        return 0;
+    }
+
+    n = _get_u32(p + RECLOG_MARKER_LEN);
+    room = len - pos - RECLOG_CHECKPOINT_HEAD - 4;
+    if (n > room / entbytes
+        || _get_u64(p + RECLOG_MARKER_LEN + 4) != pos
+        || _get_u64(p + RECLOG_MARKER_LEN + 20) >= pos
+        || _get_u32(p + RECLOG_CHECKPOINT_HEAD + n * entbytes)
+           != _check(p, RECLOG_CHECKPOINT_HEAD + n * entbytes))
+    {
+        return 0;
+    }
+
+    *count = n;
+    *base = _get_u64(p + RECLOG_MARKER_LEN + 12);
+    *prev = _get_u64(p + RECLOG_MARKER_LEN + 20);
+
+    return 1;
+}
+
+/*!
+ * @brief Check for a valid footer at the end of a mapped log.
+ *
+ * @return 1 if there is one (its @p self, @p count and @p checkpoint filled
+ *         in), 0 otherwise.
+ */
+static int _footer_at (
+    const uint8_t *map, size_t len, size_t entbytes,
+    size_t *self, size_t *count, uint64_t *checkpoint)
+{
+    const uint8_t *t;
+    uint64_t n, s;
+    size_t room;
+
+    if (len < RECLOG_HEADER_LEN + RECLOG_MARKER_LEN + RECLOG_TRAILER_LEN)
+    {
+        return 0;
+    }
+
+    t = map + len - RECLOG_TRAILER_LEN;
+    if (memcmp(t + RECLOG_TRAILER_LEN - 4, _footer_magic, 4) != 0)
+    {
+        return 0;
+    }
+
+    n = _get_u64(t);
+    s = _get_u64(t + 8);
+    if (s < RECLOG_HEADER_LEN || s > len - RECLOG_TRAILER_LEN - RECLOG_MARKER_LEN)
+    {
+        return 0;
+    }
+    room = len - RECLOG_TRAILER_LEN - RECLOG_MARKER_LEN - (size_t)s;
+    if (room % entbytes != 0 || room / entbytes != n
+        || !_is_marker(map + s, len - s, RECLOG_TAG_INDEX)
+        || _get_u64(t + 16) >= s
+        || _get_u32(t + 24) != _check(map + s, len - 8 - (size_t)s))
+    {
+        return 0;
+    }
+
+    *self = (size_t)s;
+    *count = (size_t)n;
+    *checkpoint = _get_u64(t + 16);
+
+    return 1;
+}
+
+/*!
+ * @brief Load the offsets of every record up to the last checkpoint.
+ *
+ * Finds the last valid checkpoint by searching back from the end, then follows
+ * the chain of checkpoints to the first. Each holds the offsets of the records
+ * between it and its predecessor, so together they make the whole index.
+ *
+ * @return The offset just past the last checkpoint, or 0 if there is none or
+ *         the chain is broken (the writer's index is then empty).
+ */
+static size_t _load_checkpoints (sofab_reclog_writer_t *w, const uint8_t *map, size_t len)
+{
+    const size_t entbytes = 8 * _words(w->keyed);
+    size_t pos, count = 0, next;
+    uint64_t base = 0, prev = 0;
+
+    if (len < RECLOG_HEADER_LEN + RECLOG_CHECKPOINT_HEAD + 4)
+    {
+        return 0;
+    }
+
+    for (pos = len - RECLOG_CHECKPOINT_HEAD - 4; pos >= RECLOG_HEADER_LEN; pos--)
+    {
+        if (map[pos] == 0xFF && _checkpoint_at(map, len, pos, entbytes, &count, &base, &prev))
+        {
+            break;
+        }
+    }
+    if (pos < RECLOG_HEADER_LEN || base > SIZE_MAX - count
+        || _index_reserve(w, (size_t)base + count) != 0)
+    {
+        return 0;
+    }
+
+    w->checkpoint = pos;
+    w->count = (size_t)base + count;
+    next = pos + RECLOG_CHECKPOINT_HEAD + count * entbytes + 4;
+
+    /* walk the chain back, each checkpoint ending where the next one starts */
+    for (;;)
+    {
+        uint64_t end = base;
+
+        _index_decode(w, (size_t)base, count, map + pos + RECLOG_CHECKPOINT_HEAD);
+
+        if (prev == 0)
+        {
+            if (base == 0)
+            {
+                w->covered = w->count;
+                return next;
+            }
+            break;
+        }
+
+        pos = (size_t)prev;
+        if (!_checkpoint_at(map, len, pos, entbytes, &count, &base, &prev)
+            || base > end || base + count != end)
+        {
+            break;
+        }
+    }
+
+    w->checkpoint = 0;
+    w->count = 0;
+
+    return 0;
+}
+
+/*!
+ * @brief Scan the records from @p pos on and add them to the writer's index.
+ *
+ * Stops at the first thing that is not a whole, well-formed record: the tear
+ * of a crash, a checkpoint or footer that was not completely written, or the
+ * end of the file. A valid checkpoint on the way (only met when the chain
+ * could not be used) is stepped over.
+ *
+ * A zero byte reads as an empty record, and a crash can leave the file
+ * extended over blocks that were never written, which read back as zeros. So
+ * a run of empty records is only kept once a non-empty record or a checkpoint
+ * follows it; one that runs into the place the scan stops is cut off with it.
+ *
+ * @return The offset of the end of the last good record, or 0 if the index
+ *         could not grow (@c errno is set).
+ */
+static size_t _scan_records (sofab_reclog_writer_t *w, const uint8_t *map, size_t len, size_t pos)
+{
+    const size_t entbytes = 8 * _words(w->keyed);
+    const size_t words = _words(w->keyed);
+    size_t run_pos = 0, run_count = 0;     /* a run of empty records, unconfirmed */
+
+    while (pos < len)
+    {
+        size_t prefixlen, msglen, count;
+        uint64_t key = 0, base, prev;
+        sofab_ret_t ret = sofab_framing_next(map + pos, len - pos, &prefixlen, &msglen);
+
+        if (ret == SOFAB_RET_E_INVALID_MSG
+            && _checkpoint_at(map, len, pos, entbytes, &count, &base, &prev))
+        {
+            pos += RECLOG_CHECKPOINT_HEAD + count * entbytes + 4;
+            run_pos = 0;
+            continue;
+        }
+        if (ret != SOFAB_RET_OK)
+        {
+            break;
+        }
+        if (w->keyed)
+        {
+            if (_key_of(map + pos + prefixlen, msglen, w->key_id, &key) != 0
+                || (w->count != 0 && key < w->last_key))
+            {
+                break;
+            }
+        }
+
+        if (_index_reserve(w, w->count + 1) != 0)
+        {
+            return 0;
+        }
+        w->index[w->count * words] = pos;
+        if (w->keyed)
+        {
+            w->index[w->count * words + 1] = key;
+            w->last_key = key;
+        }
+        if (msglen != 0)
+        {
+            run_pos = 0;
+        }
+        else if (run_pos == 0)
+        {
+            run_pos = pos;
+            run_count = w->count;
+        }
+        w->count++;
+        pos += prefixlen + msglen;
+    }
+
+    if (run_pos != 0)
+    {
+        /* the keys of a run are all 0, and so was the last one before it */
+        w->count = run_count;
+        pos = run_pos;
+    }
+
+    return pos;
+}
+
+/*!
+ * @brief Take over an existing log: its index, its end and its last
+ *        checkpoint, from the footer or by recovery.
+ *
+ * @return 0 on success, -1 if memory ran out (@c errno is set).
+ */
+static int _resume (sofab_reclog_writer_t *w, const uint8_t *map, size_t len)
+{
+    const size_t words = _words(w->keyed);
+    size_t self, count, start;
+    uint64_t checkpoint;
+
+    if (_footer_at(map, len, 8 * words, &self, &count, &checkpoint))
+    {
+        if (_index_reserve(w, count) != 0)
+        {
+            return -1;
+        }
+        _index_decode(w, 0, count, map + self + RECLOG_MARKER_LEN);
+        w->count = count;
+        w->covered = count;
+        w->checkpoint = checkpoint;
+        w->end = self;
+    }
+    else
+    {
+        start = _load_checkpoints(w, map, len);
+        if (start == 0)
+        {
+            start = RECLOG_HEADER_LEN;
+        }
+        w->end = _scan_records(w, map, len, start);
+        if (w->end == 0)
+        {
+            return -1;
+        }
+    }
+
+    if (w->keyed && w->count != 0)
+    {
+        w->last_key = w->index[(w->count - 1) * words + 1];
+    }
+
+    return 0;
+}
+
+//
+
+extern sofab_ret_t sofab_reclog_writer_open (
+    sofab_reclog_writer_t *w, int fd, int keyed, sofab_id_t key_id, size_t interval)
+{
+    struct stat st;
+    uint8_t header[RECLOG_HEADER_LEN];
+    size_t len;
+    void *map;
+    int ret;
+
+    assert(w != NULL);
+
+    memset(w, 0, sizeof(*w));
+    w->fd = fd;
+    w->keyed = keyed ? 1 : 0;
+    w->key_id = keyed ? key_id : 0;
+    w->interval = interval;
+
+    memcpy(header, _header_magic, 4);
+    header[4] = SOFAB_RECLOG_VERSION;
+    header[5] = w->keyed ? SOFAB_RECLOG_KEYED : 0;
+    header[6] = 0;
+    header[7] = 0;
+    _put_u32(header + 8, (uint32_t)w->key_id);
+
+    if (fstat(fd, &st) != 0)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    if (st.st_size == 0)
+    {
+        struct iovec iov = { header, sizeof(header) };
+
+        if (lseek(fd, 0, SEEK_SET) != 0 || _write_all(fd, &iov, 1) != 0)
+        {
+            return SOFAB_RET_E_ARGUMENT;
+        }
+        w->end = RECLOG_HEADER_LEN;
+        return SOFAB_RET_OK;
+    }
+
+    if (st.st_size < 0 || (uintmax_t)st.st_size > SIZE_MAX)
+    {
+        errno = EFBIG;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+    len = (size_t)st.st_size;
+
+    map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    if (len < RECLOG_HEADER_LEN || memcmp(map, header, 5) != 0
+        || (((const uint8_t *)map)[5] & ~SOFAB_RECLOG_KEYED) != 0)
+    {
+        munmap(map, len);
+        return SOFAB_RET_E_INVALID_MSG;
+    }
+    if (memcmp(map, header, RECLOG_HEADER_LEN) != 0)
+    {
+        munmap(map, len);
+        errno = EINVAL;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    ret = _resume(w, (const uint8_t *)map, len);
+    munmap(map, len);
+
+    if (ret != 0
+        || (w->end < len && ftruncate(fd, (off_t)w->end) != 0)
+        || lseek(fd, (off_t)w->end, SEEK_SET) < 0)
+    {
+        free(w->index);
+        w->index = NULL;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    return SOFAB_RET_OK;
+}
+
+extern sofab_ret_t sofab_reclog_append (
+    sofab_reclog_writer_t *w, const void *msg, size_t len)
+{
+    const size_t words = _words(w->keyed);
+    uint8_t prefix[SOFAB_FRAMING_PREFIX_MAX];
+    struct iovec iov[2];
+    size_t prefixlen;
+    uint64_t key = 0;
+
+    assert(w != NULL);
+    assert(msg != NULL || len == 0);
+
+    if (w->error != 0)
+    {
+        errno = w->error;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    if (w->keyed)
+    {
+        if (_key_of((const uint8_t *)msg, len, w->key_id, &key) != 0)
+        {
+            return SOFAB_RET_E_INVALID_MSG;
+        }
+        if (w->count != 0 && key < w->last_key)
+        {
+            return SOFAB_RET_E_ARGUMENT;
+        }
+    }
+
+#if SIZE_MAX > UINT32_MAX
+    if (len > SOFAB_FRAMING_LEN_MAX)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+#endif
+
+    if (_index_reserve(w, w->count + 1) != 0)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    prefixlen = sofab_framing_prefix(prefix, (uint32_t)len);
+
+    iov[0].iov_base = prefix;
+    iov[0].iov_len = prefixlen;
+    iov[1].iov_base = (void *)msg;
+    iov[1].iov_len = len;
+    if (_write_all(w->fd, iov, len ? 2 : 1) != 0)
+    {
+        w->error = errno;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    w->index[w->count * words] = w->end;
+    if (w->keyed)
+    {
+        w->index[w->count * words + 1] = key;
+        w->last_key = key;
+    }
+    w->count++;
+    w->end += prefixlen + len;
+
+    if (w->interval != 0 && w->count - w->covered >= w->interval)
+    {
+        return sofab_reclog_checkpoint(w);
+    }
+
+    return SOFAB_RET_OK;
+}
+
+extern sofab_ret_t sofab_reclog_checkpoint (sofab_reclog_writer_t *w)
+{
+    const size_t entbytes = 8 * _words(w->keyed);
+
+    assert(w != NULL);
+
+    if (w->error != 0)
+    {
+        errno = w->error;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    while (w->covered < w->count)
+    {
+        size_t n = w->count - w->covered;
+        size_t size;
+        uint8_t *block;
+        struct iovec iov;
+
+        if (n > UINT32_MAX)
+        {
+            n = UINT32_MAX;
+        }
+        size = RECLOG_CHECKPOINT_HEAD + n * entbytes + 4;
+
+        block = (uint8_t *)malloc(size);
+        if (block == NULL)
+        {
+            errno = ENOMEM;
+            return SOFAB_RET_E_ARGUMENT;
+        }
+
+        _put_marker(block, RECLOG_TAG_CHECKPOINT);
+        _put_u32(block + RECLOG_MARKER_LEN, (uint32_t)n);
+        _put_u64(block + RECLOG_MARKER_LEN + 4, w->end);
+        _put_u64(block + RECLOG_MARKER_LEN + 12, w->covered);
+        _put_u64(block + RECLOG_MARKER_LEN + 20, w->checkpoint);
+        _index_encode(w, w->covered, w->covered + n, block + RECLOG_CHECKPOINT_HEAD);
+        _put_u32(block + size - 4, _check(block, size - 4));
+
+        /* the records first: a checkpoint must never point at bytes a crash
+         * could still take back */
+        iov.iov_base = block;
+        iov.iov_len = size;
+        if (fsync(w->fd) != 0 || _write_all(w->fd, &iov, 1) != 0)
+        {
+            w->error = errno;
+            free(block);
+            return SOFAB_RET_E_ARGUMENT;
+        }
+        free(block);
+
+        w->checkpoint = w->end;
+        w->covered += n;
+        w->end += size;
+    }
+
+    return SOFAB_RET_OK;
+}
+
+extern sofab_ret_t sofab_reclog_writer_close (sofab_reclog_writer_t *w)
+{
+    const size_t entbytes = 8 * _words(w->keyed);
+    sofab_ret_t ret;
+    uint8_t *block = NULL;
+    size_t size;
+
+    assert(w != NULL);
+
+    ret = sofab_reclog_checkpoint(w);
+
+    if (ret == SOFAB_RET_OK)
+    {
+        size = RECLOG_MARKER_LEN + w->count * entbytes + RECLOG_TRAILER_LEN;
+        block = (uint8_t *)malloc(size);
+        if (block == NULL)
+        {
+            errno = ENOMEM;
+            ret = SOFAB_RET_E_ARGUMENT;
+        }
+    }
+
+    if (ret == SOFAB_RET_OK)
+    {
+        uint8_t *t = block + size - RECLOG_TRAILER_LEN;
+        struct iovec iov = { block, size };
+
+        _put_marker(block, RECLOG_TAG_INDEX);
+        _index_encode(w, 0, w->count, block + RECLOG_MARKER_LEN);
+        _put_u64(t, w->count);
+        _put_u64(t + 8, w->end);
+        _put_u64(t + 16, w->checkpoint);
+        _put_u32(t + 24, _check(block, size - 8));
+        memcpy(t + 28, _footer_magic, 4);
+
+        if (fsync(w->fd) != 0 || _write_all(w->fd, &iov, 1) != 0 || fsync(w->fd) != 0)
+        {
+            ret = SOFAB_RET_E_ARGUMENT;
+        }
+    }
+
+    free(block);
+    free(w->index);
+    w->index = NULL;
+    w->count = 0;
+    w->cap = 0;
+
+    return ret;
+}
+
+extern sofab_ret_t sofab_reclog_reader_open (sofab_reclog_reader_t *r, int fd)
+{
+    struct stat st;
+    size_t len, self, count;
+    uint64_t checkpoint;
+    const uint8_t *map;
+    void *m;
+
+    assert(r != NULL);
+
+    memset(r, 0, sizeof(*r));
+
+    if (fstat(fd, &st) != 0)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+    if (st.st_size < RECLOG_HEADER_LEN)
+    {
+        return SOFAB_RET_E_INVALID_MSG;
+    }
+    if ((uintmax_t)st.st_size > SIZE_MAX)
+    {
+        errno = EFBIG;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+    len = (size_t)st.st_size;
+
+    m = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+    map = (const uint8_t *)m;
+
+    /* record n is one jump away, wherever n is */
+    (void)posix_madvise(m, len, POSIX_MADV_RANDOM);
+
+    r->keyed = (map[5] & SOFAB_RECLOG_KEYED) ? 1 : 0;
+    r->entsize = 8 * _words(r->keyed);
+
+    if (memcmp(map, _header_magic, 4) != 0 || map[4] != SOFAB_RECLOG_VERSION
+        || (map[5] & ~SOFAB_RECLOG_KEYED) != 0
+        || !_footer_at(map, len, r->entsize, &self, &count, &checkpoint))
+    {
+        munmap(m, len);
+        memset(r, 0, sizeof(*r));
+        return SOFAB_RET_E_INVALID_MSG;
+    }
+
+    r->map = map;
+    r->len = len;
+    r->index = map + self + RECLOG_MARKER_LEN;
+    r->count = count;
+    r->key_id = (sofab_id_t)_get_u32(map + 8);
+
+    return SOFAB_RET_OK;
+}
+
+extern void sofab_reclog_reader_close (sofab_reclog_reader_t *r)
+{
+    assert(r != NULL);
+
+    if (r->map != NULL)
+    {
+        munmap((void *)r->map, r->len);
+    }
+    memset(r, 0, sizeof(*r));
+}
+
+extern sofab_ret_t sofab_reclog_record (
+    const sofab_reclog_reader_t *r, size_t n, const uint8_t **msg, size_t *len)
+{
+    size_t footer, prefixlen, msglen;
+    uint64_t offset;
+
+    assert(r != NULL);
+    assert(msg != NULL);
+    assert(len != NULL);
+
+    if (n >= r->count)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    footer = (size_t)(r->index - r->map) - RECLOG_MARKER_LEN;
+    offset = _get_u64(r->index + n * r->entsize);
+    if (offset < RECLOG_HEADER_LEN || offset >= footer
+        || sofab_framing_next(r->map + offset, footer - (size_t)offset,
+                              &prefixlen, &msglen) != SOFAB_RET_OK)
+    {
+        return SOFAB_RET_E_INVALID_MSG;
+    }
+
+    *msg = r->map + offset + prefixlen;
+    *len = msglen;
+
+    return SOFAB_RET_OK;
+}
+
+extern uint64_t sofab_reclog_key (const sofab_reclog_reader_t *r, size_t n)
+{
+    assert(r != NULL);
+    assert(r->keyed);
+    assert(n < r->count);
+
+    return _get_u64(r->index + n * r->entsize + 8);
+}
+
+extern size_t sofab_reclog_find (const sofab_reclog_reader_t *r, uint64_t key)
+{
+    size_t lo = 0, hi;
+
+    assert(r != NULL);
+    assert(r->keyed);
+
+    hi = r->count;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (sofab_reclog_key(r, mid) < key)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
@@ -0,0 +1,251 @@
+/*!
+ * @file scan.h
+ * @brief SofaBuffers C - Structural scan of the wire format, library-internal.
+ *
+ * Walks encoded fields without decoding them: no callback, no destination,
+ * nothing but the grammar, the lengths and counts and the limits on them. It
+ * mirrors the decoder's checks rather than sharing its code, and follows the
+ * same SOFAB_DISABLE_*_SUPPORT switches: a wire type or fixlen subtype this
+ * build cannot decode fails the scan too. For code that needs to know where
+ * the fields of a message lie (or one field's value) without paying for a
+ * decode: the batch module's element scan, the record log's key extraction and
+ * the framing layer's check of resynchronization candidates.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_SCAN_H
+#define SOFAB_SCAN_H
+
+#include "sofab/sofab.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*!
+ * @brief Scan one LEB128 varint.
+ *
+ * @param p      Read position, advanced past the varint.
+ * @param end    End of the input.
+ * @param value  Receives the value.
+ * @return 0 on success, -1 if the varint runs past @p end or is wider than
+ *         @ref sofab_unsigned_t.
+ */
+static inline int sofab_scan_varint (const uint8_t **p, const uint8_t *end, uint64_t *value)
+{
+    const unsigned bits = sizeof(sofab_unsigned_t) * 8;
+    uint64_t v = 0;
+    unsigned shift;
+
+    /* the decoder's rule: no bit past the value width, no byte after the one
+     * that fills it */
+    for (shift = 0; shift < bits; shift += 7)
+    {
+        uint8_t b;
+
+        if (*p == end)
+        {
+            return -1;
+        }
+        b = *(*p)++;
+        if (bits - shift < 7 && ((b & 0x7F) >> (bits - shift)) != 0)
+        {
+            return -1;
+        }
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+        {
+            *value = v;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/*!
+ * @brief Scan a field header.
+ *
+ * @param p     Read position, advanced past the header.
+ * @param end   End of the input.
+ * @param id    Receives the field id, unless NULL.
+ * @param type  Receives the wire type.
+ * @return 0 on success, -1 if the header is malformed or runs past @p end,
+ *         the id is over @ref SOFAB_ID_MAX, or it opens or closes a sequence
+ *         in a build without them.
+ */
+static inline int sofab_scan_header (const uint8_t **p, const uint8_t *end, sofab_id_t *id, uint8_t *type)
+{
+    uint64_t v;
+
+    if (sofab_scan_varint(p, end, &v) != 0 || (v >> 3) > SOFAB_ID_MAX)
+    {
+        return -1;
+    }
+    if (id != NULL)
+    {
+        *id = (sofab_id_t)(v >> 3);
+    }
+    *type = (uint8_t)(v & 0x07);
+
+#if defined(SOFAB_DISABLE_SEQUENCE_SUPPORT)
+    if (*type == SOFAB_TYPE_SEQUENCE_START || *type == SOFAB_TYPE_SEQUENCE_END)
+    {
+        return -1;
+    }
+#endif /* defined(SOFAB_DISABLE_SEQUENCE_SUPPORT) */
+
+    return 0;
+}
+
+/*!
+ * @brief Scan past the value of a field that is not a sequence.
+ *
+ * Follows the decoder's grammar, lengths and counts and the limits on them,
+ * but reads no payload.
+ *
+ * @param p     Read position, just after the field header; advanced past the value.
+ * @param end   End of the input.
+ * @param type  Wire type from the header.
+ * @return 0 on success, -1 if the value is malformed, runs past @p end or
+ *         uses a type this build cannot decode.
+ */
+static inline int sofab_scan_value (const uint8_t **p, const uint8_t *end, uint8_t type)
+{
+    uint64_t v;
+
+    switch (type)
+    {
+        case SOFAB_TYPE_VARINT_UNSIGNED:
+        case SOFAB_TYPE_VARINT_SIGNED:
+            return sofab_scan_varint(p, end, &v);
+
+#if !defined(SOFAB_DISABLE_FIXLEN_SUPPORT)
+        case SOFAB_TYPE_FIXLEN:
+        {
+            uint64_t word, n;
+
+            if (sofab_scan_varint(p, end, &word) != 0)
+            {
+                return -1;
+            }
+            n = word >> 3;
+            switch (word & 0x07)
+            {
+                case SOFAB_FIXLENTYPE_FP32:     if (n != 4) return -1; break;
+#if !defined(SOFAB_DISABLE_FP64_SUPPORT)
+                case SOFAB_FIXLENTYPE_FP64:     if (n != 8) return -1; break;
+#endif /* !defined(SOFAB_DISABLE_FP64_SUPPORT) */
+                case SOFAB_FIXLENTYPE_STRING:
+                case SOFAB_FIXLENTYPE_BLOB:     if (n > SOFAB_FIXLEN_MAX) return -1; break;
+                default:                        return -1;
+            }
+            if (n > (uint64_t)(end - *p))
+            {
+                return -1;
+            }
+            *p += n;
+            return 0;
+        }
+#endif /* !defined(SOFAB_DISABLE_FIXLEN_SUPPORT) */
+
+#if !defined(SOFAB_DISABLE_ARRAY_SUPPORT)
+        case SOFAB_TYPE_VARINTARRAY_UNSIGNED:
+        case SOFAB_TYPE_VARINTARRAY_SIGNED:
+        {
+            uint64_t count;
+
+            if (sofab_scan_varint(p, end, &count) != 0 || count > SOFAB_ARRAY_MAX)
+            {
+                return -1;
+            }
+            while (count--)
+            {
+                if (sofab_scan_varint(p, end, &v) != 0)
+                {
+                    return -1;
+                }
+            }
+            return 0;
+        }
+
+#if !defined(SOFAB_DISABLE_FIXLEN_SUPPORT)
+        case SOFAB_TYPE_FIXLENARRAY:
+        {
+            uint64_t count, word, n;
+
+            if (sofab_scan_varint(p, end, &count) != 0 || count > SOFAB_ARRAY_MAX
+                || sofab_scan_varint(p, end, &word) != 0)
+            {
+                return -1;
+            }
+            n = word >> 3;
+            if (!((word & 0x07) == SOFAB_FIXLENTYPE_FP32 && n == 4)
+#if !defined(SOFAB_DISABLE_FP64_SUPPORT)
+                && !((word & 0x07) == SOFAB_FIXLENTYPE_FP64 && n == 8)
+#endif /* !defined(SOFAB_DISABLE_FP64_SUPPORT) */
+                )
+            {
+                return -1;
+            }
+            if (count > (uint64_t)(end - *p) / n)
+            {
+                return -1;
+            }
+            *p += count * n;
+            return 0;
+        }
+#endif /* !defined(SOFAB_DISABLE_FIXLEN_SUPPORT) */
+#endif /* !defined(SOFAB_DISABLE_ARRAY_SUPPORT) */
+    }
+
+    return -1;
+}
+
+/*!
+ * @brief Scan a whole message.
+ *
+ * @param msg  The message.
+ * @param len  Length of @p msg.
+ * @return 0 if @p msg is exactly one well-formed message, -1 otherwise.
+ */
+static inline int sofab_scan_message (const uint8_t *msg, size_t len)
+{
+    const uint8_t *p = msg, *end = msg + len;
+    unsigned depth = 0;
+
+    while (p != end)
+    {
+        uint8_t type;
+
+        if (sofab_scan_header(&p, end, NULL, &type) != 0)
+        {
+            return -1;
+        }
+
+        if (type == SOFAB_TYPE_SEQUENCE_START)
+        {
+            if (depth == SOFAB_MAX_DEPTH)
+            {
+                return -1;
+            }
+            depth++;
+        }
+        else if (type == SOFAB_TYPE_SEQUENCE_END)
+        {
+            if (depth == 0)
+            {
+                return -1;
+            }
+            depth--;
+        }
+        else if (sofab_scan_value(&p, end, type) != 0)
+        {
+            return -1;
+        }
+    }
+
+    return depth == 0 ? 0 : -1;
+}
+
+#endif /* SOFAB_SCAN_H */
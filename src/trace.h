@@ -0,0 +1,52 @@
+/*!
+ * @file trace.h
+ * @brief SofaBuffers C - Static tracepoints (USDT), library-internal.
+ *
+ * With @ref SOFAB_USDT the probes below are SystemTap/DTrace user-space
+ * static probes under the provider @c sofab, listable with
+ * `perf list 'sdt_sofab:*'` or `bpftrace -l 'usdt:<lib>:sofab:*'` once the
+ * library is built. A disarmed probe is a single @c nop in the hot path. There
+ * are no SDT semaphores, so its arguments are still computed on every pass;
+ * they are values the code has at hand anyway (pointers, lengths, a depth, a
+ * return code). Without it every probe expands to nothing.
+ *
+ * Probes, under the names tracers list them by (arguments in order):
+ *
+ *  - @c feed__start     istream, data, datalen: a sofab_istream_feed() call.
+ *  - @c feed__done      istream, consumed, ret: its verdict; @c consumed bytes
+ *                       were read before it returned (all of them unless the
+ *                       verdict is an error).
+ *  - @c invalid         istream, offset, depth: the message became INVALID at
+ *                       byte @c offset of this feed (the feed's length when a
+ *                       field callback invalidated it).
+ *  - @c sequence__start istream, id, depth: a sequence opened; in an object
+ *                       decode, a nested object starts.
+ *  - @c sequence__end   istream, depth: a sequence closed; a nested object ends.
+ *  - @c flush           ostream, data, len: the buffer was handed to the flush
+ *                       callback.
+ *  - @c object__encode__start  ostream, descr, src: sofab_object_encode()
+ *                       entry, once per nesting level.
+ *  - @c object__encode__done   ostream, descr, ret: its result.
+ *
+ * A top-level object decode has no call of its own: it starts with the first
+ * @c feed__start after sofab_istream_init() and ends at the @c feed__done that
+ * reports SOFAB_RET_OK (0), which is also the per-message decode latency.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_TRACE_H
+#define SOFAB_TRACE_H
+
+#include "sofab/sofab.h"
+
+#if SOFAB_USDT
+# include <sys/sdt.h>
+# define SOFAB_PROBE2(name, a, b)       DTRACE_PROBE2(sofab, name, a, b)
+# define SOFAB_PROBE3(name, a, b, c)    DTRACE_PROBE3(sofab, name, a, b, c)
+#else
+# define SOFAB_PROBE2(name, a, b)       do { } while (0)
+# define SOFAB_PROBE3(name, a, b, c)    do { } while (0)
+#endif /* SOFAB_USDT */
+
+#endif /* SOFAB_TRACE_H */
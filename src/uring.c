@@ -0,0 +1,459 @@
+/*!
+ * @file uring.c
+ * @brief SofaBuffers C - Asynchronous stream I/O on Linux io_uring.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* syscall() and the io_uring ABI are Linux, not C99; the library itself is built with extensions off */
+#define _GNU_SOURCE
+
+#define SOFAB_URING_C
+
+/* includes *******************************************************************/
+#include "sofab/uring.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* functions ******************************************************************/
+
+static int _setup (unsigned entries, struct io_uring_params *p)
+{
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int _enter (sofab_uring_t *u, unsigned submit, unsigned wait)
+{
+    int ret;
+
+    do
+    {
+        ret = (int)syscall(__NR_io_uring_enter, u->fd, submit, wait,
+                           wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (ret < 0 && errno == EINTR);
+
+    return ret;
+}
+
+static uint8_t *_segment (const sofab_uring_t *u, unsigned i)
+{
+    return u->buffer + (size_t)i * u->seglen;
+}
+
+/*!
+ * @brief Submit the (rest of the) request of buffer @p i.
+ *
+ * A slot has at most one request in flight and the ring as many entries as
+ * there are slots, so the submission ring cannot be full. A submission the
+ * kernel refuses fails the slot like a failed request.
+ */
+static void _submit (sofab_uring_t *u, unsigned i)
+{
+    sofab_uring_slot_t *s = &u->slot[i];
+    struct io_uring_sqe *sqe;
+    unsigned tail = *u->sq_tail;
+    unsigned idx = tail & *u->sq_mask;
+
+    sqe = &((struct io_uring_sqe *)u->sqes)[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = s->op;
+    sqe->fd = u->target;
+    sqe->addr = (uint64_t)(uintptr_t)(_segment(u, i) + s->done);
+    sqe->len = (uint32_t)(s->len - s->done);
+    sqe->off = s->off < 0 ? (uint64_t)-1 : (uint64_t)s->off + s->done;
+    sqe->buf_index = u->fixed ? (uint16_t)i : 0;
+    sqe->user_data = i;
+
+    u->sq_array[idx] = idx;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    s->busy = 1;
+    if (_enter(u, 1, 0) < 0)
+    {
+        /* take the entry back: the kernel did not consume it */
+        __atomic_store_n(u->sq_tail, tail, __ATOMIC_RELEASE);
+        s->busy = 0;
+        if (u->error == 0)
+        {
+            u->error = errno;
+        }
+    }
+}
+
+/*!
+ * @brief Account for one completion.
+ *
+ * A write completes when all of it is written; a read into a file when its
+ * buffer is full or the file ends, a read from a stream with whatever it got.
+ * Anything short of that is submitted again for the rest.
+ */
+static void _complete (sofab_uring_t *u, unsigned i, int res)
+{
+    sofab_uring_slot_t *s = &u->slot[i];
+
+    s->busy = 0;
+
+    if (res == -EINTR || res == -EAGAIN)
+    {
+        _submit(u, i);
+        return;
+    }
+    if (res < 0)
+    {
+        if (u->error == 0)
+        {
+            u->error = -res;
+        }
+        return;
+    }
+
+    s->done += (size_t)res;
+    if (res == 0)
+    {
+        if (s->op == IORING_OP_READ_FIXED || s->op == IORING_OP_READ)
+        {
+            s->eof = 1;
+        }
+        else if (s->done < s->len && u->error == 0)
+        {
+            u->error = EIO;
+        }
+        return;
+    }
+
+    if (s->done < s->len && (s->off >= 0 || s->op == IORING_OP_WRITE_FIXED || s->op == IORING_OP_WRITE))
+    {
+        _submit(u, i);
+    }
+}
+
+/*!
+ * @brief Process the completions there are, waiting for one if there are none
+ *        and @p wait is set.
+ */
+static void _reap (sofab_uring_t *u, int wait)
+{
+    unsigned head = *u->cq_head;
+    unsigned tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+
+    if (head == tail && wait)
+    {
+        if (_enter(u, 0, 1) < 0)
+        {
+            if (u->error == 0)
+            {
+                u->error = errno;
+            }
+            return;
+        }
+        tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+    }
+
+    while (head != tail)
+    {
+        const struct io_uring_cqe *cqe = &((const struct io_uring_cqe *)u->cqes)[head & *u->cq_mask];
+        unsigned i = (unsigned)cqe->user_data;
+        int res = cqe->res;
+
+        head++;
+        __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+        _complete(u, i, res);
+    }
+}
+
+/*!
+ * @brief Wait until buffer @p i is free (or until every buffer is, for
+ *        @p i == SOFAB_URING_BUFFERS).
+ */
+static void _wait_idle (sofab_uring_t *u, unsigned i)
+{
+    for (;;)
+    {
+        unsigned j, busy = 0;
+
+        for (j = 0; j < SOFAB_URING_BUFFERS; j++)
+        {
+            if ((i == SOFAB_URING_BUFFERS || i == j) && u->slot[j].busy)
+            {
+                busy = 1;
+            }
+        }
+        if (!busy)
+        {
+            return;
+        }
+        _reap(u, 1);
+    }
+}
+
+/*!
+ * @brief Flush callback of a ring sink: submit the buffer, move to the next.
+ */
+static void _uring_flush (sofab_ostream_t *ctx, const uint8_t *data, size_t len, void *usrptr)
+{
+    sofab_uring_t *u = (sofab_uring_t *)usrptr;
+    sofab_uring_slot_t *s = &u->slot[u->cur];
+
+    assert(data == _segment(u, u->cur));
+    (void)data;
+
+    if (len > 0 && u->error == 0)
+    {
+        if (u->offset < 0)
+        {
+            /* at the descriptor's position: one write at a time, in order */
+            _wait_idle(u, SOFAB_URING_BUFFERS);
+        }
+
+        s->op = u->fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        s->len = len;
+        s->done = 0;
+        s->off = u->offset;
+        s->eof = 0;
+        _submit(u, u->cur);
+
+        if (u->offset >= 0)
+        {
+            u->offset += (int64_t)len;
+        }
+        u->cur = (u->cur + 1) % SOFAB_URING_BUFFERS;
+    }
+
+    /* back-pressure: only once every buffer is in flight */
+    _wait_idle(u, u->cur);
+    sofab_ostream_buffer_set(ctx, _segment(u, u->cur), u->seglen, 0);
+}
+
+//
+
+extern sofab_ret_t sofab_uring_init (sofab_uring_t *u, uint8_t *buffer, size_t buflen)
+{
+    struct io_uring_params p;
+    struct iovec iov[SOFAB_URING_BUFFERS];
+    unsigned i;
+    int err;
+
+    assert(u != NULL);
+    assert(buffer != NULL);
+    assert(buflen / SOFAB_URING_BUFFERS >= SOFAB_MIN_OUTPUT_BUFFER);
+
+    memset(u, 0, sizeof(*u));
+    memset(&p, 0, sizeof(p));
+    u->buffer = buffer;
+    u->seglen = buflen / SOFAB_URING_BUFFERS;
+    u->target = -1;
+
+    u->fd = _setup(SOFAB_URING_BUFFERS, &p);
+    if (u->fd < 0)
+    {
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    u->sq_ring_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_ring_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (u->cq_ring_len > u->sq_ring_len)
+        {
+            u->sq_ring_len = u->cq_ring_len;
+        }
+        u->cq_ring_len = u->sq_ring_len;
+    }
+    u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    u->sq_ring = mmap(NULL, u->sq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED, u->fd, IORING_OFF_SQ_RING);
+    if (u->sq_ring == MAP_FAILED)
+    {
+        u->sq_ring = NULL;
+        goto fail;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        u->cq_ring = u->sq_ring;
+    }
+    else
+    {
+        u->cq_ring = mmap(NULL, u->cq_ring_len, PROT_READ | PROT_WRITE, MAP_SHARED, u->fd, IORING_OFF_CQ_RING);
+        if (u->cq_ring == MAP_FAILED)
+        {
+            u->cq_ring = NULL;
+            goto fail;
+        }
+    }
+    u->sqes = mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED, u->fd, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED)
+    {
+        u->sqes = NULL;
+        goto fail;
+    }
+
+    u->sq_tail = (unsigned *)((uint8_t *)u->sq_ring + p.sq_off.tail);
+    u->sq_mask = (unsigned *)((uint8_t *)u->sq_ring + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)((uint8_t *)u->sq_ring + p.sq_off.array);
+    u->cq_head = (unsigned *)((uint8_t *)u->cq_ring + p.cq_off.head);
+    u->cq_tail = (unsigned *)((uint8_t *)u->cq_ring + p.cq_off.tail);
+    u->cq_mask = (unsigned *)((uint8_t *)u->cq_ring + p.cq_off.ring_mask);
+    u->cqes = (uint8_t *)u->cq_ring + p.cq_off.cqes;
+
+    for (i = 0; i < SOFAB_URING_BUFFERS; i++)
+    {
+        iov[i].iov_base = _segment(u, i);
+        iov[i].iov_len = u->seglen;
+    }
+    /* registered buffers count against RLIMIT_MEMLOCK; without them every
+     * request maps its buffer anew, which is slower but works */
+    u->fixed = syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_BUFFERS,
+                       iov, SOFAB_URING_BUFFERS) == 0;
+
+    return SOFAB_RET_OK;
+
+fail:
+    err = errno;
+    sofab_uring_exit(u);
+    errno = err;
+    return SOFAB_RET_E_ARGUMENT;
+}
+
+extern void sofab_uring_exit (sofab_uring_t *u)
+{
+    assert(u != NULL);
+
+    if (u->sqes != NULL)
+    {
+        munmap(u->sqes, u->sqes_len);
+    }
+    if (u->cq_ring != NULL && u->cq_ring != u->sq_ring)
+    {
+        munmap(u->cq_ring, u->cq_ring_len);
+    }
+    if (u->sq_ring != NULL)
+    {
+        munmap(u->sq_ring, u->sq_ring_len);
+    }
+    if (u->fd >= 0)
+    {
+        close(u->fd); /* also unregisters the buffers */
+    }
+    memset(u, 0, sizeof(*u));
+    u->fd = -1;
+}
+
+extern void sofab_ostream_uring_sink (
+    sofab_ostream_t *os, sofab_uring_t *u, int fd, int64_t offset)
+{
+    assert(os != NULL);
+    assert(u != NULL);
+    assert(u->sq_ring != NULL);
+
+    u->target = fd;
+    u->error = 0;
+    u->offset = offset < 0 ? SOFAB_URING_STREAM : offset;
+    u->cur = 0;
+
+    sofab_ostream_init(os, _segment(u, 0), u->seglen, 0, _uring_flush, u);
+}
+
+extern sofab_ret_t sofab_ostream_uring_flush (sofab_ostream_t *os)
+{
+    sofab_uring_t *u;
+
+    assert(os != NULL);
+    assert(os->flush == _uring_flush);
+
+    u = (sofab_uring_t *)os->usrptr;
+
+    sofab_ostream_flush(os);
+    _wait_idle(u, SOFAB_URING_BUFFERS);
+
+    if (u->error != 0)
+    {
+        errno = u->error;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    return SOFAB_RET_OK;
+}
+
+extern sofab_ret_t sofab_istream_feed_uring (
+    sofab_istream_t *is, sofab_uring_t *u, int fd, int64_t offset)
+{
+    const unsigned depth = offset < 0 ? 1 : SOFAB_URING_BUFFERS;
+    sofab_ret_t ret;
+    unsigned i, head = 0;
+
+    assert(is != NULL);
+    assert(u != NULL);
+    assert(u->sq_ring != NULL);
+
+    u->target = fd;
+    u->error = 0;
+    u->offset = offset < 0 ? SOFAB_URING_STREAM : offset;
+
+    /* the outcome so far, should the descriptor be empty */
+    ret = sofab_istream_feed(is, NULL, 0);
+
+    /* read ahead into every buffer, at consecutive offsets */
+    for (i = 0; i < depth && u->error == 0; i++)
+    {
+        sofab_uring_slot_t *s = &u->slot[i];
+
+        s->op = u->fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        s->len = u->seglen;
+        s->done = 0;
+        s->off = u->offset;
+        s->eof = 0;
+        _submit(u, i);
+        if (u->offset >= 0)
+        {
+            u->offset += (int64_t)u->seglen;
+        }
+    }
+
+    while (u->error == 0)
+    {
+        sofab_uring_slot_t *s = &u->slot[head];
+
+        _wait_idle(u, head);
+        if (u->error != 0)
+        {
+            break;
+        }
+
+        if (s->done > 0)
+        {
+            ret = sofab_istream_feed(is, _segment(u, head), s->done);
+        }
+        if (s->eof || ret == SOFAB_RET_E_INVALID_MSG)
+        {
+            break;
+        }
+
+        /* the buffer is consumed: read the next chunk into it */
+        s->done = 0;
+        s->off = u->offset;
+        _submit(u, head);
+        if (u->offset >= 0)
+        {
+            u->offset += (int64_t)u->seglen;
+        }
+        head = (head + 1) % depth;
+    }
+
+    /* reads still in flight (past the end, or after an error) */
+    _wait_idle(u, SOFAB_URING_BUFFERS);
+
+    if (u->error != 0)
+    {
+        errno = u->error;
+        return SOFAB_RET_E_ARGUMENT;
+    }
+
+    return ret;
+}
@@ -31,6 +31,12 @@ int test_istream_main (void);
 int test_object_main (void);
 int test_vectors_main (void);
 int test_utf8_main (void);
+int test_framing_main (void);
+int test_batch_main (void);
+int test_posix_main (void);
+int test_reclog_main (void);
+int test_uring_main (void);
+int test_bgsink_main (void);
 
 int main (void)
 {
@@ -41,6 +47,12 @@ int main (void)
     result |= test_object_main();
     result |= test_vectors_main();
     result |= test_utf8_main();
+    result |= test_framing_main();
+    result |= test_batch_main();
+    result |= test_posix_main();
+    result |= test_reclog_main();
+    result |= test_uring_main();
+    result |= test_bgsink_main();
 
     return result;
 }
@@ -0,0 +1,421 @@
+/*!
+ * @file test_batch.c
+ * @brief SofaBuffers test for the parallel batch encode and decode.
+ *
+ * Encode: the framed output is byte for byte the sequential one, whatever the
+ * thread count, and a too-small output reports the size it needs. Decode: a
+ * batch large enough to be split over several threads decodes every record into
+ * its own slot; a malformed record only fails itself, and a partial tail stops
+ * the batch where the sequential decoder would. Wrapper array: the two-phase
+ * decode of one large array agrees with the serial decode, on the value and on
+ * the verdict, through gaps, repeated and mistyped elements, over-index ids,
+ * bodies that do not decode and truncation.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "sofab/batch.h"
+#include "sofab/framing.h"
+
+#include "sofab_test_batch.h"
+
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if SOFAB_TEST_BATCH
+
+/* helpers *******************************************************************/
+
+/* enough records for four runs of SOFAB_BATCH_MIN_RUN, and an uneven split */
+#define RECORDS     (4 * SOFAB_BATCH_MIN_RUN + 37)
+#define FRAMES_MAX  (RECORDS * 64)
+
+static sofab_test_batch_rec_t in[RECORDS];
+static sofab_test_batch_slot_t out[RECORDS + 2];
+static sofab_ret_t status[RECORDS + 2];
+static uint8_t expect[FRAMES_MAX];
+static uint8_t frames[FRAMES_MAX];
+
+/* Records of varying size, every 100th the all-default (empty) message. */
+static void fill_records (void)
+{
+    for (unsigned i = 0; i < RECORDS; i++)
+    {
+        in[i] = sofab_test_batch_defaults;
+        if (i % 100 == 0)
+        {
+            continue;
+        }
+        in[i].id = i * 2654435761u;
+        in[i].delta = (int32_t)i - RECORDS / 2;
+        snprintf(in[i].name, sizeof(in[i].name), "%.*s", (int)(i % 20), "abcdefghijklmnopqrstuvwxyz");
+        in[i].child.v = (uint16_t)i;
+    }
+}
+
+/* The sequential framed encoding of records [first, first + n), for comparison. */
+static size_t encode_sequential (uint8_t *buf, unsigned first, unsigned n)
+{
+    size_t len = 0;
+
+    for (unsigned i = first; i < first + n; i++)
+    {
+        len += sofab_test_batch_frame(buf + len, &in[i]);
+    }
+
+    return len;
+}
+
+static void assert_record (unsigned i, unsigned slot)
+{
+    sofab_test_batch_check(&in[i], status[slot], &out[slot]);
+}
+
+/* encode ********************************************************************/
+
+static void test_batch_encode_matches_sequential (void)
+{
+    static const unsigned threads[] = { 1, 2, 4, 7 };
+    size_t len, used;
+
+    fill_records();
+    len = encode_sequential(expect, 0, RECORDS);
+
+    for (unsigned t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+    {
+        memset(frames, 0xEE, sizeof(frames));
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_batch_encode(&sofab_test_batch_descr, in, sizeof(in[0]),
+            RECORDS, threads[t], frames, sizeof(frames), &used));
+        TEST_ASSERT_EQUAL_size_t(len, used);
+        TEST_ASSERT_EQUAL_MEMORY(expect, frames, len);
+        TEST_ASSERT_EQUAL_UINT8(0xEE, frames[len]);
+    }
+
+    /* nothing to encode */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_batch_encode(&sofab_test_batch_descr, in, sizeof(in[0]),
+        0, 4, NULL, 0, &used));
+    TEST_ASSERT_EQUAL_size_t(0, used);
+}
+
+static void test_batch_encode_buffer_full (void)
+{
+    size_t len, used;
+
+    fill_records();
+    len = encode_sequential(expect, 0, RECORDS);
+
+    /* one byte short: nothing is written, and the size needed is reported */
+    memset(frames, 0xEE, sizeof(frames));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_BUFFER_FULL, sofab_batch_encode(&sofab_test_batch_descr, in,
+        sizeof(in[0]), RECORDS, 4, frames, len - 1, &used));
+    TEST_ASSERT_EQUAL_size_t(len, used);
+    TEST_ASSERT_EQUAL_UINT8(0xEE, frames[0]);
+    TEST_ASSERT_EQUAL_UINT8(0xEE, frames[len - 2]);
+}
+
+/* decode ********************************************************************/
+
+static void test_batch_decode_roundtrip (void)
+{
+    static const unsigned threads[] = { 1, 3, 4, 16 };
+    size_t len, count, used;
+
+    fill_records();
+    len = encode_sequential(frames, 0, RECORDS);
+
+    for (unsigned t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+    {
+        /* stale contents everywhere: each record must be re-initialized */
+        memset(out, SOFAB_TEST_BATCH_STALE, sizeof(out));
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_batch_decode(&sofab_test_batch_descr, 1, frames, len,
+            &out[0].rec, sizeof(out[0]), RECORDS + 1, status, threads[t], &count, &used));
+        TEST_ASSERT_EQUAL_size_t(RECORDS, count);
+        TEST_ASSERT_EQUAL_size_t(len, used);
+
+        for (unsigned i = 0; i < RECORDS; i++)
+        {
+            assert_record(i, i);
+        }
+        TEST_ASSERT_EQUAL_UINT32(SOFAB_TEST_BATCH_TAG, out[RECORDS].rec.id);
+    }
+
+    /* n bounds the batch; the rest is left for the next call */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_batch_decode(&sofab_test_batch_descr, 1, frames, len,
+        &out[0].rec, sizeof(out[0]), 600, status, 4, &count, &used));
+    TEST_ASSERT_EQUAL_size_t(600, count);
+    TEST_ASSERT_EQUAL_size_t(encode_sequential(expect, 0, 600), used);
+}
+
+static void test_batch_decode_bad_record_and_tail (void)
+{
+    const unsigned bad = 700;
+    size_t len, count, used;
+
+    fill_records();
+
+    /* RECORDS frames with one malformed message spliced in at index bad... */
+    len = encode_sequential(frames, 0, bad);
+    frames[len++] = 2;
+    frames[len++] = 0x00;   /* id 0, unsigned varint */
+    frames[len++] = 0x80;   /* still open where the frame ends */
+    len += encode_sequential(frames + len, bad, RECORDS - bad);
+    /* ...and the head of a frame still to come */
+    frames[len++] = 10;
+    frames[len++] = 0x00;
+
+    memset(out, SOFAB_TEST_BATCH_STALE, sizeof(out));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_INCOMPLETE, sofab_batch_decode(&sofab_test_batch_descr, 1, frames, len,
+        &out[0].rec, sizeof(out[0]), RECORDS + 2, status, 4, &count, &used));
+    TEST_ASSERT_EQUAL_size_t(RECORDS + 1, count);
+    TEST_ASSERT_EQUAL_size_t(len - 2, used);
+
+    for (unsigned i = 0; i < RECORDS; i++)
+    {
+        assert_record(i, i < bad ? i : i + 1);
+    }
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, status[bad]);
+
+    /* a malformed prefix stops the batch in front of it */
+    len = encode_sequential(frames, 0, 10);
+    memset(frames + len, 0x80, SOFAB_FRAMING_PREFIX_MAX);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, sofab_batch_decode(&sofab_test_batch_descr, 1, frames,
+        len + SOFAB_FRAMING_PREFIX_MAX, &out[0].rec, sizeof(out[0]), RECORDS, status, 4,
+        &count, &used));
+    TEST_ASSERT_EQUAL_size_t(10, count);
+    TEST_ASSERT_EQUAL_size_t(len, used);
+}
+
+/* wrapper array decode *******************************************************/
+
+#define PTS_CAP     1024
+
+typedef struct
+{
+    uint16_t v;
+} inner_t;
+
+typedef struct
+{
+    int32_t x;
+    int32_t y;
+    char tag[8];
+    inner_t inner;
+} pt_t;
+
+typedef struct
+{
+    uint16_t len;                   /* element count: first member of a sized holder */
+    pt_t e[PTS_CAP];
+} pts_t;
+
+typedef struct
+{
+    uint32_t a;
+    pts_t pts;
+    char name[16];
+} cloud_t;
+
+static const sofab_object_descr_field_t inner_fields[] = {
+    SOFAB_OBJECT_FIELD(0, inner_t, v, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+};
+static const sofab_object_descr_t inner_descr =
+    SOFAB_OBJECT_DESCR(inner_fields, 1, NULL, 0);
+
+static const sofab_object_descr_field_t pt_fields[] = {
+    SOFAB_OBJECT_FIELD(0, pt_t, x, SOFAB_OBJECT_FIELDTYPE_SIGNED),
+    SOFAB_OBJECT_FIELD(1, pt_t, y, SOFAB_OBJECT_FIELDTYPE_SIGNED),
+    SOFAB_OBJECT_FIELD(2, pt_t, tag, SOFAB_OBJECT_FIELDTYPE_STRING),
+    SOFAB_OBJECT_FIELD_SEQUENCE(3, pt_t, inner, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+};
+static const sofab_object_descr_t *const pt_nested[] = { &inner_descr };
+static const sofab_object_descr_t pt_descr =
+    SOFAB_OBJECT_DESCR(pt_fields, 4, pt_nested, 1);
+
+/* slot n of the holder; 1024 of them, spelled out by the preprocessor */
+#define PTS_SLOT(n)     SOFAB_OBJECT_FIELD_SEQUENCE((n), pts_t, e[(n)], SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+#define PTS_SLOT4(n)    PTS_SLOT(n) PTS_SLOT((n) + 1) PTS_SLOT((n) + 2) PTS_SLOT((n) + 3)
+#define PTS_SLOT16(n)   PTS_SLOT4(n) PTS_SLOT4((n) + 4) PTS_SLOT4((n) + 8) PTS_SLOT4((n) + 12)
+#define PTS_SLOT64(n)   PTS_SLOT16(n) PTS_SLOT16((n) + 16) PTS_SLOT16((n) + 32) PTS_SLOT16((n) + 48)
+#define PTS_SLOT256(n)  PTS_SLOT64(n) PTS_SLOT64((n) + 64) PTS_SLOT64((n) + 128) PTS_SLOT64((n) + 192)
+
+static const sofab_object_descr_field_t pts_fields[] = {
+    PTS_SLOT256(0) PTS_SLOT256(256) PTS_SLOT256(512) PTS_SLOT256(768)
+};
+static const sofab_object_descr_t *const pts_nested[] = { &pt_descr };
+static const sofab_object_descr_t pts_descr =
+    SOFAB_OBJECT_DESCR_SEQ_SIZED(pts_fields, PTS_CAP, pts_nested, 1, pts_t, len);
+
+static const sofab_object_descr_field_t cloud_fields[] = {
+    SOFAB_OBJECT_FIELD(1, cloud_t, a, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+    SOFAB_OBJECT_FIELD_SEQUENCE(5, cloud_t, pts, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+    SOFAB_OBJECT_FIELD(9, cloud_t, name, SOFAB_OBJECT_FIELDTYPE_STRING),
+};
+static const sofab_object_descr_t *const cloud_nested[] = { &pts_descr };
+static const sofab_object_descr_t cloud_descr =
+    SOFAB_OBJECT_DESCR(cloud_fields, 3, cloud_nested, 1);
+
+static cloud_t cloud_in, cloud_serial, cloud_parallel;
+static uint8_t cloud_buf[PTS_CAP * 40];
+
+/* Decode msg serially and with threads, and expect the same outcome. */
+static sofab_ret_t decode_both (const uint8_t *msg, size_t len, unsigned threads)
+{
+    sofab_object_decoder_t dec[4];
+    sofab_istream_t is;
+    sofab_ret_t serial, parallel;
+
+    /* zeroed first, so that padding compares equal too */
+    memset(&cloud_serial, 0, sizeof(cloud_serial));
+    memset(&cloud_parallel, 0, sizeof(cloud_parallel));
+    sofab_object_init(&cloud_descr, &cloud_serial);
+    sofab_object_init(&cloud_descr, &cloud_parallel);
+
+    memset(dec, 0, sizeof(dec));
+    dec[0].info = &cloud_descr;
+    dec[0].dst = (uint8_t *)&cloud_serial;
+    dec[0].depth = 3;
+    sofab_istream_init(&is, sofab_object_field_cb, dec);
+    serial = sofab_istream_feed(&is, msg, len);
+
+    parallel = sofab_batch_decode_seq(&cloud_descr, 3, 5, msg, len, &cloud_parallel, threads);
+    TEST_ASSERT_EQUAL_INT(serial, parallel);
+    if (serial == SOFAB_RET_OK)
+    {
+        TEST_ASSERT_EQUAL_MEMORY(&cloud_serial, &cloud_parallel, sizeof(cloud_serial));
+    }
+
+    return parallel;
+}
+
+static void test_batch_decode_seq_matches_serial (void)
+{
+    static const unsigned threads[] = { 1, 2, 3, 8 };
+    sofab_ostream_t os;
+    size_t len;
+
+    memset(&cloud_in, 0, sizeof(cloud_in));
+    sofab_object_init(&cloud_descr, &cloud_in);
+    cloud_in.a = 42;
+    strcpy(cloud_in.name, "tile 7/64/42");
+    cloud_in.pts.len = 1000;
+    for (unsigned i = 0; i < 1000; i++)
+    {
+        if (i % 50 == 7)
+        {
+            continue;   /* all-default interior elements leave id gaps */
+        }
+        cloud_in.pts.e[i].x = (int32_t)i * 3 - 1500;
+        cloud_in.pts.e[i].y = -(int32_t)i;
+        snprintf(cloud_in.pts.e[i].tag, sizeof(cloud_in.pts.e[i].tag), "p%u", i % 1000);
+        cloud_in.pts.e[i].inner.v = (uint16_t)(i * 7);
+    }
+
+    sofab_ostream_init(&os, cloud_buf, sizeof(cloud_buf), 0, NULL, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_object_encode(&os, &cloud_descr, &cloud_in));
+    len = sofab_ostream_flush(&os);
+
+    for (unsigned t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+    {
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, decode_both(cloud_buf, len, threads[t]));
+        TEST_ASSERT_EQUAL_UINT16(1000, cloud_parallel.pts.len);
+        TEST_ASSERT_EQUAL_INT32(cloud_in.pts.e[999].x, cloud_parallel.pts.e[999].x);
+        TEST_ASSERT_EQUAL_STRING("tile 7/64/42", cloud_parallel.name);
+    }
+
+    /* truncated anywhere: INCOMPLETE, as the serial decode says */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_INCOMPLETE, decode_both(cloud_buf, len / 2, 4));
+}
+
+/* A point element written by hand, so the tests below can bend the rules. */
+static void put_point (sofab_ostream_t *os, sofab_id_t id, int32_t x, const char *tag)
+{
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_write_sequence_begin(os, id));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_write_signed(os, 0, x));
+    if (tag != NULL)
+    {
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_write_string(os, 2, tag));
+    }
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_write_sequence_end(os));
+}
+
+static void test_batch_decode_seq_edge_cases (void)
+{
+    sofab_ostream_t os;
+    size_t len;
+
+    /* out-of-order and repeated ids (the repeat merges), and an element whose
+       wire type contradicts the declared one (§7.3: skipped, and not counted) */
+    sofab_ostream_init(&os, cloud_buf, sizeof(cloud_buf), 0, NULL, NULL);
+    sofab_ostream_write_unsigned(&os, 1, 7);
+    sofab_ostream_write_sequence_begin(&os, 5);
+    put_point(&os, 4, 40, "four");
+    put_point(&os, 1, 10, NULL);
+    put_point(&os, 4, 41, NULL);
+    sofab_ostream_write_unsigned(&os, 9, 99);
+    sofab_ostream_write_sequence_end(&os);
+    sofab_ostream_write_string(&os, 9, "after");
+    len = sofab_ostream_flush(&os);
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, decode_both(cloud_buf, len, 4));
+    TEST_ASSERT_EQUAL_UINT16(5, cloud_parallel.pts.len);
+    TEST_ASSERT_EQUAL_INT32(41, cloud_parallel.pts.e[4].x);
+    TEST_ASSERT_EQUAL_STRING("four", cloud_parallel.pts.e[4].tag);
+
+    /* an over-index element rejects the message */
+    sofab_ostream_init(&os, cloud_buf, sizeof(cloud_buf), 0, NULL, NULL);
+    sofab_ostream_write_sequence_begin(&os, 5);
+    put_point(&os, 0, 1, NULL);
+    put_point(&os, PTS_CAP, 2, NULL);
+    sofab_ostream_write_sequence_end(&os);
+    len = sofab_ostream_flush(&os);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, decode_both(cloud_buf, len, 4));
+
+    /* a body that is well-framed but does not decode: a tag too long for its slot */
+    sofab_ostream_init(&os, cloud_buf, sizeof(cloud_buf), 0, NULL, NULL);
+    sofab_ostream_write_sequence_begin(&os, 5);
+    put_point(&os, 0, 1, "ok");
+    put_point(&os, 1, 2, "far too long");
+    sofab_ostream_write_sequence_end(&os);
+    len = sofab_ostream_flush(&os);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, decode_both(cloud_buf, len, 4));
+
+    /* the array twice: the second replaces the first (§7.4), decoded serially */
+    sofab_ostream_init(&os, cloud_buf, sizeof(cloud_buf), 0, NULL, NULL);
+    sofab_ostream_write_sequence_begin(&os, 5);
+    put_point(&os, 3, 30, NULL);
+    sofab_ostream_write_sequence_end(&os);
+    sofab_ostream_write_sequence_begin(&os, 5);
+    put_point(&os, 1, 10, NULL);
+    sofab_ostream_write_sequence_end(&os);
+    len = sofab_ostream_flush(&os);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, decode_both(cloud_buf, len, 4));
+    TEST_ASSERT_EQUAL_UINT16(2, cloud_parallel.pts.len);
+    TEST_ASSERT_EQUAL_INT32(0, cloud_parallel.pts.e[3].x);
+}
+
+int test_batch_main (void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_batch_encode_matches_sequential);
+    RUN_TEST(test_batch_encode_buffer_full);
+
+    RUN_TEST(test_batch_decode_roundtrip);
+    RUN_TEST(test_batch_decode_bad_record_and_tail);
+
+    RUN_TEST(test_batch_decode_seq_matches_serial);
+    RUN_TEST(test_batch_decode_seq_edge_cases);
+
+    return UNITY_END();
+}
+
+#else /* !SOFAB_TEST_BATCH */
+
+int test_batch_main (void)
+{
+    return 0; /* batch library not built */
+}
+
+#endif /* SOFAB_TEST_BATCH */
@@ -0,0 +1,243 @@
+/*!
+ * @file test_bgsink.c
+ * @brief SofaBuffers test for the background-flushing sink.
+ *
+ * A message many times the sink's buffers reaches a slow write callback byte
+ * for byte as a one-buffer encode would have produced it, in order, and always
+ * from the writer thread; a flush waits until it has all been written; a
+ * stalled writer holds the encoder back only once SOFAB_BGSINK_BUFFERS - 1
+ * buffers are queued; a sink can be restarted after it was stopped.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* nanosleep and pthread_self are POSIX, not C99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include "sofab/bgsink.h"
+
+#include "sofab_test_stream.h"
+
+#include "unity.h"
+
+#include <string.h>
+#include <time.h>
+
+#if SOFAB_TEST_BGSINK
+
+/* helpers *******************************************************************/
+
+typedef struct
+{
+    uint8_t data[2048];
+    size_t len;
+    size_t calls;
+    int foreign;            /* every call came from another thread */
+    pthread_t encoder;
+    long delay_ns;
+} collect_t;
+
+static uint8_t sink_mem[SOFAB_BGSINK_BUFFERS * 16];
+
+static void collect_write (const uint8_t *data, size_t len, void *usrptr)
+{
+    collect_t *c = (collect_t *)usrptr;
+
+    if (c->delay_ns > 0)
+    {
+        struct timespec ts = { 0, c->delay_ns };
+        nanosleep(&ts, NULL);
+    }
+
+    if (pthread_equal(pthread_self(), c->encoder))
+    {
+        c->foreign = 0;
+    }
+    if (c->len + len <= sizeof(c->data))
+    {
+        memcpy(c->data + c->len, data, len);
+    }
+    c->len += len;
+    c->calls++;
+}
+
+static void collect_init (collect_t *c, long delay_ns)
+{
+    memset(c, 0, sizeof(*c));
+    c->foreign = 1;
+    c->encoder = pthread_self();
+    c->delay_ns = delay_ns;
+}
+
+/* a write callback that blocks until the test opens the gate */
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int open;
+    size_t calls;
+    sofab_ostream_t os;
+    unsigned flushed;       /* flushes the encoder thread got through */
+} gate_t;
+
+static void gate_write (const uint8_t *data, size_t len, void *usrptr)
+{
+    gate_t *g = (gate_t *)usrptr;
+
+    (void)data;
+    (void)len;
+
+    pthread_mutex_lock(&g->lock);
+    while (!g->open)
+    {
+        pthread_cond_wait(&g->cond, &g->lock);
+    }
+    g->calls++;
+    pthread_mutex_unlock(&g->lock);
+}
+
+static void *gate_encoder (void *arg)
+{
+    gate_t *g = (gate_t *)arg;
+    unsigned i;
+
+    for (i = 1; i <= SOFAB_BGSINK_BUFFERS; i++)
+    {
+        sofab_test_encode_fields(&g->os, i, i);
+        sofab_ostream_flush(&g->os);
+        __atomic_store_n(&g->flushed, i, __ATOMIC_SEQ_CST);
+    }
+
+    return NULL;
+}
+
+static void sleep_ms (long ms)
+{
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/* tests *********************************************************************/
+
+static void test_bgsink_slow_writer (void)
+{
+    uint8_t plain[2048];
+    size_t n = sofab_test_encode_plain(plain, sizeof(plain), 1, SOFAB_TEST_FIELDS);
+    sofab_bgsink_t sink;
+    sofab_ostream_t os;
+    collect_t c;
+
+    /* a writer slower than the encoder: the ring fills and holds it back */
+    collect_init(&c, 20000);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK,
+        sofab_ostream_bgsink_start(&os, &sink, sink_mem, sizeof(sink_mem), collect_write, &c));
+    sofab_test_encode_fields(&os, 1, SOFAB_TEST_FIELDS);
+    sofab_ostream_bgsink_stop(&os);
+
+    TEST_ASSERT_EQUAL_size_t(n, c.len);
+    TEST_ASSERT_EQUAL_MEMORY(plain, c.data, n);
+    TEST_ASSERT_TRUE(c.calls > SOFAB_BGSINK_BUFFERS);
+    TEST_ASSERT_TRUE(c.foreign);
+
+    /* a writer as fast as it gets, and a restart on the same state */
+    collect_init(&c, 0);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK,
+        sofab_ostream_bgsink_start(&os, &sink, sink_mem, sizeof(sink_mem), collect_write, &c));
+    sofab_test_encode_fields(&os, 1, SOFAB_TEST_FIELDS);
+    sofab_ostream_bgsink_stop(&os);
+
+    TEST_ASSERT_EQUAL_size_t(n, c.len);
+    TEST_ASSERT_EQUAL_MEMORY(plain, c.data, n);
+}
+
+static void test_bgsink_flush (void)
+{
+    uint8_t plain[2048];
+    size_t n1 = sofab_test_encode_plain(plain, sizeof(plain), 1, 10);
+    size_t n2 = sofab_test_encode_plain(plain, sizeof(plain), 1, 20);
+    sofab_bgsink_t sink;
+    sofab_ostream_t os;
+    collect_t c;
+
+    collect_init(&c, 100000);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK,
+        sofab_ostream_bgsink_start(&os, &sink, sink_mem, sizeof(sink_mem), collect_write, &c));
+
+    /* nothing encoded: nothing written */
+    sofab_ostream_bgsink_flush(&os);
+    TEST_ASSERT_EQUAL_size_t(0, c.calls);
+
+    /* everything encoded is written once the flush returns */
+    sofab_test_encode_fields(&os, 1, 10);
+    sofab_ostream_bgsink_flush(&os);
+    TEST_ASSERT_EQUAL_size_t(n1, c.len);
+
+    /* and the stream carries on behind it */
+    sofab_test_encode_fields(&os, 11, 20);
+    sofab_ostream_bgsink_flush(&os);
+    TEST_ASSERT_EQUAL_size_t(n2, c.len);
+    TEST_ASSERT_EQUAL_MEMORY(plain, c.data, n2);
+
+    sofab_ostream_bgsink_stop(&os);
+    TEST_ASSERT_EQUAL_size_t(n2, c.len);
+}
+
+static void test_bgsink_backpressure (void)
+{
+    sofab_bgsink_t sink;
+    pthread_t encoder;
+    gate_t g;
+    int i;
+
+    memset(&g, 0, sizeof(g));
+    pthread_mutex_init(&g.lock, NULL);
+    pthread_cond_init(&g.cond, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK,
+        sofab_ostream_bgsink_start(&g.os, &sink, sink_mem, sizeof(sink_mem), gate_write, &g));
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&encoder, NULL, gate_encoder, &g));
+
+    /* the writer is stuck on the first buffer: K - 1 flushes go through */
+    for (i = 0; i < 2000 && __atomic_load_n(&g.flushed, __ATOMIC_SEQ_CST) < SOFAB_BGSINK_BUFFERS - 1; i++)
+    {
+        sleep_ms(1);
+    }
+    TEST_ASSERT_EQUAL_UINT(SOFAB_BGSINK_BUFFERS - 1, __atomic_load_n(&g.flushed, __ATOMIC_SEQ_CST));
+
+    /* the K-th would reuse the buffer being written, so it waits */
+    sleep_ms(50);
+    TEST_ASSERT_EQUAL_UINT(SOFAB_BGSINK_BUFFERS - 1, __atomic_load_n(&g.flushed, __ATOMIC_SEQ_CST));
+
+    pthread_mutex_lock(&g.lock);
+    g.open = 1;
+    pthread_cond_broadcast(&g.cond);
+    pthread_mutex_unlock(&g.lock);
+
+    pthread_join(encoder, NULL);
+    TEST_ASSERT_EQUAL_UINT(SOFAB_BGSINK_BUFFERS, __atomic_load_n(&g.flushed, __ATOMIC_SEQ_CST));
+
+    sofab_ostream_bgsink_stop(&g.os);
+    TEST_ASSERT_EQUAL_size_t(SOFAB_BGSINK_BUFFERS, g.calls);
+
+    pthread_cond_destroy(&g.cond);
+    pthread_mutex_destroy(&g.lock);
+}
+
+int test_bgsink_main (void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_bgsink_slow_writer);
+    RUN_TEST(test_bgsink_flush);
+    RUN_TEST(test_bgsink_backpressure);
+
+    return UNITY_END();
+}
+
+#else /* !SOFAB_TEST_BGSINK */
+
+int test_bgsink_main (void)
+{
+    return 0; /* background sink not built */
+}
+
+#endif /* SOFAB_TEST_BGSINK */
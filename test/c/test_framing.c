@@ -0,0 +1,728 @@
+/*!
+ * @file test_framing.c
+ * @brief SofaBuffers test for the length-delimited framing layer.
+ *
+ * Writer: the prefix lands directly in front of the encoded message, in the
+ * reserved header room, for one- and two-byte prefixes and the empty message.
+ * Reader: a stream of frames decodes identically whole and byte by byte; empty
+ * frames, malformed and truncated messages are reported per frame without
+ * losing the framing; a malformed prefix is terminal.
+ * Checked frames: CRC32C matches the reference value and a bitwise reference
+ * at every alignment; checked frames read whole and byte by byte, and a
+ * corrupted byte fails its own frame only.
+ * Resynchronization: the scanner finds the first frame behind garbage, past
+ * an incomplete false start; a reader with a window recovers from a malformed
+ * prefix and, when checked, from a length too short or too long, whole and
+ * byte by byte; fed garbage byte by byte through a large window, it keeps up.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "sofab/framing.h"
+
+#include "unity.h"
+
+#include <string.h>
+#include <time.h>
+
+#if SOFAB_TEST_FRAMING
+
+/* helpers *******************************************************************/
+
+#define MAX_FRAMES 8
+
+typedef struct
+{
+    uint32_t a;
+    char text[32];
+} msg_t;
+
+typedef struct
+{
+    msg_t msg[MAX_FRAMES];
+    size_t len[MAX_FRAMES];
+    sofab_ret_t result[MAX_FRAMES];
+    unsigned begun;
+    unsigned ended;
+} frames_t;
+
+static void msg_field_cb (
+    sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usrptr)
+{
+    msg_t *m = usrptr;
+    (void)size; (void)count;
+
+    switch (id)
+    {
+        case 1: sofab_istream_read_u32(ctx, &m->a); break;
+        case 2: sofab_istream_read_string(ctx, m->text, sizeof(m->text)); break;
+    }
+}
+
+static void frame_begin_cb (
+    sofab_framing_reader_t *ctx, sofab_istream_t *is, size_t len, void *usrptr)
+{
+    frames_t *f = usrptr;
+    (void)ctx;
+
+    TEST_ASSERT_TRUE(f->begun < MAX_FRAMES);
+    TEST_ASSERT_EQUAL_UINT(f->ended, f->begun);
+    f->len[f->begun] = len;
+    sofab_istream_init(is, msg_field_cb, &f->msg[f->begun]);
+    f->begun++;
+}
+
+static void frame_end_cb (
+    sofab_framing_reader_t *ctx, sofab_istream_t *is, sofab_ret_t result, void *usrptr)
+{
+    frames_t *f = usrptr;
+    (void)ctx; (void)is;
+
+    TEST_ASSERT_EQUAL_UINT(f->ended + 1, f->begun);
+    f->result[f->ended++] = result;
+}
+
+/* Append one framed message (fields left at 0 / "" are omitted) to out. */
+static size_t put_frame (uint8_t *out, uint32_t a, const char *text)
+{
+    uint8_t buf[64];
+    sofab_ostream_t os;
+    uint8_t *frame;
+    size_t framelen;
+
+    sofab_framing_begin(&os, buf, sizeof(buf));
+    if (a)
+    {
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_write_unsigned(&os, 1, a));
+    }
+    if (text[0])
+    {
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_write_string(&os, 2, text));
+    }
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_end(&os, &frame, &framelen));
+    memcpy(out, frame, framelen);
+
+    return framelen;
+}
+
+/* Append one checked framed message to out. */
+static size_t put_checked_frame (uint8_t *out, uint32_t a, const char *text)
+{
+    uint8_t buf[64];
+    sofab_ostream_t os;
+    uint8_t *frame;
+    size_t framelen;
+
+    sofab_framing_begin_checked(&os, buf, sizeof(buf));
+    if (a)
+    {
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_write_unsigned(&os, 1, a));
+    }
+    if (text[0])
+    {
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_write_string(&os, 2, text));
+    }
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_end_checked(&os, &frame, &framelen));
+    memcpy(out, frame, framelen);
+
+    return framelen;
+}
+
+static size_t three_checked_frames (uint8_t *out)
+{
+    size_t n = 0;
+
+    n += put_checked_frame(out + n, 7, "first");
+    n += put_checked_frame(out + n, 0, "");
+    n += put_checked_frame(out + n, 1234567, "third");
+
+    return n;
+}
+
+/* writer ********************************************************************/
+
+static void test_framing_write_patches_prefix_in_place (void)
+{
+    uint8_t buf[32], plain[32];
+    sofab_ostream_t os;
+    uint8_t *frame;
+    size_t framelen, n;
+
+    /* the same message without framing, for comparison */
+    sofab_ostream_init(&os, plain, sizeof(plain), 0, NULL, NULL);
+    sofab_ostream_write_unsigned(&os, 1, 300);
+    sofab_ostream_write_string(&os, 2, "hi");
+    n = sofab_ostream_bytes_used(&os);
+
+    sofab_framing_begin(&os, buf, sizeof(buf));
+    sofab_ostream_write_unsigned(&os, 1, 300);
+    sofab_ostream_write_string(&os, 2, "hi");
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_end(&os, &frame, &framelen));
+
+    /* one prefix byte, right in front of the payload, which did not move */
+    TEST_ASSERT_EQUAL_PTR(buf + SOFAB_FRAMING_PREFIX_MAX - 1, frame);
+    TEST_ASSERT_EQUAL_size_t(n + 1, framelen);
+    TEST_ASSERT_EQUAL_HEX8(n, frame[0]);
+    TEST_ASSERT_EQUAL_MEMORY(plain, frame + 1, n);
+}
+
+static void test_framing_write_two_byte_prefix (void)
+{
+    char text[150];
+    uint8_t buf[256];
+    sofab_ostream_t os;
+    uint8_t *frame;
+    size_t framelen, n;
+
+    /* long enough that the length takes two varint bytes (>= 128) */
+    memset(text, 'x', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    sofab_framing_begin(&os, buf, sizeof(buf));
+    sofab_ostream_write_string(&os, 2, text);
+    n = sofab_ostream_bytes_used(&os) - SOFAB_FRAMING_PREFIX_MAX;
+    TEST_ASSERT_TRUE(n >= 128);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_end(&os, &frame, &framelen));
+
+    TEST_ASSERT_EQUAL_PTR(buf + SOFAB_FRAMING_PREFIX_MAX - 2, frame);
+    TEST_ASSERT_EQUAL_size_t(n + 2, framelen);
+    TEST_ASSERT_EQUAL_HEX8(0x80 | (n & 0x7F), frame[0]);
+    TEST_ASSERT_EQUAL_HEX8(n >> 7, frame[1]);
+}
+
+static void test_framing_write_empty_message (void)
+{
+    uint8_t buf[SOFAB_FRAMING_PREFIX_MAX];
+    sofab_ostream_t os;
+    uint8_t *frame;
+    size_t framelen;
+
+    /* all-default: nothing encoded, the frame is the prefix 0 alone */
+    sofab_framing_begin(&os, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_end(&os, &frame, &framelen));
+    TEST_ASSERT_EQUAL_size_t(1, framelen);
+    TEST_ASSERT_EQUAL_HEX8(0x00, frame[0]);
+}
+
+static void test_framing_write_overflow (void)
+{
+    uint8_t buf[SOFAB_FRAMING_PREFIX_MAX + 4];
+    sofab_ostream_t os;
+
+    /* the frame must fit: there is no flush to fall back on */
+    sofab_framing_begin(&os, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_BUFFER_FULL,
+        sofab_ostream_write_string(&os, 2, "does not fit"));
+}
+
+/* reader ********************************************************************/
+
+static size_t three_frames (uint8_t *out)
+{
+    size_t n = 0;
+
+    n += put_frame(out + n, 7, "first");
+    n += put_frame(out + n, 0, "");             /* all-default, empty frame */
+    n += put_frame(out + n, 1234567, "third");
+    return n;
+}
+
+static void check_three_frames (const frames_t *f)
+{
+    TEST_ASSERT_EQUAL_UINT(3, f->ended);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f->result[0]);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f->result[1]);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f->result[2]);
+    TEST_ASSERT_EQUAL_UINT32(7, f->msg[0].a);
+    TEST_ASSERT_EQUAL_STRING("first", f->msg[0].text);
+    TEST_ASSERT_EQUAL_size_t(0, f->len[1]);
+    TEST_ASSERT_EQUAL_UINT32(0, f->msg[1].a);
+    TEST_ASSERT_EQUAL_STRING("", f->msg[1].text);
+    TEST_ASSERT_EQUAL_UINT32(1234567, f->msg[2].a);
+    TEST_ASSERT_EQUAL_STRING("third", f->msg[2].text);
+}
+
+static void test_framing_read_whole (void)
+{
+    uint8_t stream[128];
+    frames_t f;
+    sofab_framing_reader_t rd;
+    size_t n = three_frames(stream);
+
+    memset(&f, 0, sizeof(f));
+    sofab_framing_reader_init(&rd, frame_begin_cb, frame_end_cb, &f);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_reader_feed(&rd, stream, n));
+    check_three_frames(&f);
+
+    /* an empty feed between frames changes nothing */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_reader_feed(&rd, NULL, 0));
+    TEST_ASSERT_EQUAL_UINT(3, f.ended);
+}
+
+static void test_framing_read_bytewise (void)
+{
+    uint8_t stream[128];
+    frames_t f;
+    sofab_framing_reader_t rd;
+    size_t n = three_frames(stream);
+    sofab_ret_t ret = SOFAB_RET_OK;
+
+    memset(&f, 0, sizeof(f));
+    sofab_framing_reader_init(&rd, frame_begin_cb, frame_end_cb, &f);
+    for (size_t i = 0; i < n; i++)
+    {
+        ret = sofab_framing_reader_feed(&rd, &stream[i], 1);
+        /* a frame boundary reads OK, anything inside a frame INCOMPLETE */
+        TEST_ASSERT_EQUAL_INT(f.begun == f.ended ? SOFAB_RET_OK : SOFAB_RET_INCOMPLETE, ret);
+    }
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, ret);
+    check_three_frames(&f);
+}
+
+static void test_framing_read_split_prefix (void)
+{
+    char text[150];
+    uint8_t stream[256], buf[256];
+    frames_t f;
+    sofab_framing_reader_t rd;
+    sofab_ostream_t os;
+    uint8_t *frame;
+    size_t framelen;
+    size_t n = put_frame(stream, 0, "");
+
+    /* an empty frame, then one with a two-byte prefix; the first feed ends
+     * between the two prefix bytes. Id 3 is not bound, so the text is skipped. */
+    memset(text, 'x', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    sofab_framing_begin(&os, buf, sizeof(buf));
+    sofab_ostream_write_string(&os, 3, text);
+    sofab_framing_end(&os, &frame, &framelen);
+    memcpy(stream + n, frame, framelen);
+    n += framelen;
+
+    memset(&f, 0, sizeof(f));
+    sofab_framing_reader_init(&rd, frame_begin_cb, frame_end_cb, &f);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_INCOMPLETE, sofab_framing_reader_feed(&rd, stream, 2));
+    TEST_ASSERT_EQUAL_UINT(1, f.ended);
+    TEST_ASSERT_EQUAL_UINT(1, f.begun);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_reader_feed(&rd, stream + 2, n - 2));
+    TEST_ASSERT_EQUAL_UINT(2, f.ended);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[1]);
+    TEST_ASSERT_EQUAL_size_t(framelen - 2, f.len[1]);
+}
+
+static void test_framing_read_bad_message_keeps_framing (void)
+{
+    uint8_t stream[128], plain[32];
+    frames_t f;
+    sofab_framing_reader_t rd;
+    sofab_ostream_t os;
+    size_t n = 0, m;
+
+    /* a varint too wide for any value type, framed correctly */
+    stream[n++] = 12;
+    stream[n++] = 0x08;
+    for (int i = 0; i < 11; i++)
+    {
+        stream[n++] = 0xFF;
+    }
+    /* a well-formed message cut short by its frame: the string is 2 bytes short */
+    sofab_ostream_init(&os, plain, sizeof(plain), 0, NULL, NULL);
+    sofab_ostream_write_string(&os, 2, "hello");
+    m = sofab_ostream_bytes_used(&os) - 2;
+    stream[n++] = (uint8_t)m;
+    memcpy(stream + n, plain, m);
+    n += m;
+    n += put_frame(stream + n, 42, "ok");
+
+    memset(&f, 0, sizeof(f));
+    sofab_framing_reader_init(&rd, frame_begin_cb, frame_end_cb, &f);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_reader_feed(&rd, stream, n));
+    TEST_ASSERT_EQUAL_UINT(3, f.ended);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, f.result[0]);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, f.result[1]);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[2]);
+    TEST_ASSERT_EQUAL_UINT32(42, f.msg[2].a);
+    TEST_ASSERT_EQUAL_STRING("ok", f.msg[2].text);
+}
+
+static void test_framing_read_bad_prefix_is_terminal (void)
+{
+    /* a 33-bit length: the fifth byte carries more than the top 4 bits */
+    static const uint8_t bad[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x1F };
+    static const uint8_t wide[] = { 0x80, 0x80, 0x80, 0x80, 0x80 };
+    uint8_t next[16];
+    frames_t f;
+    sofab_framing_reader_t rd;
+    size_t n = put_frame(next, 1, "");
+
+    memset(&f, 0, sizeof(f));
+    sofab_framing_reader_init(&rd, frame_begin_cb, frame_end_cb, &f);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, sofab_framing_reader_feed(&rd, bad, sizeof(bad)));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, sofab_framing_reader_feed(&rd, next, n));
+    TEST_ASSERT_EQUAL_UINT(0, f.begun);
+
+    /* a fifth byte may not continue: a prefix has at most five */
+    sofab_framing_reader_init(&rd, frame_begin_cb, frame_end_cb, &f);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, sofab_framing_reader_feed(&rd, wide, sizeof(wide)));
+    TEST_ASSERT_EQUAL_UINT(0, f.begun);
+
+    /* init starts over */
+    sofab_framing_reader_init(&rd, frame_begin_cb, frame_end_cb, &f);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_reader_feed(&rd, next, n));
+    TEST_ASSERT_EQUAL_UINT(1, f.ended);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[0]);
+    TEST_ASSERT_EQUAL_UINT32(1, f.msg[0].a);
+}
+
+/* checked frames ************************************************************/
+
+static uint32_t crc32c_bitwise (const uint8_t *p, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+
+    while (len--)
+    {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++)
+        {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+        }
+    }
+
+    return ~crc;
+}
+
+static void test_framing_crc32c (void)
+{
+    static uint8_t data[300];
+
+    TEST_ASSERT_EQUAL_UINT32(0xE3069283u, sofab_crc32c(0, "123456789", 9));
+    TEST_ASSERT_EQUAL_UINT32(0, sofab_crc32c(0, NULL, 0));
+
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)(i * 131 + 7);
+    }
+    /* every start alignment and tail length, whole and in two chunks */
+    for (size_t off = 0; off < 9; off++)
+    {
+        for (size_t len = 0; len + off <= sizeof(data); len += 37)
+        {
+            uint32_t ref = crc32c_bitwise(data + off, len);
+            size_t cut = len / 3;
+
+            TEST_ASSERT_EQUAL_UINT32(ref, sofab_crc32c(0, data + off, len));
+            TEST_ASSERT_EQUAL_UINT32(ref, sofab_crc32c(sofab_crc32c(0, data + off, cut),
+                                                      data + off + cut, len - cut));
+        }
+    }
+}
+
+static void test_framing_checked_write_and_read (void)
+{
+    uint8_t stream[128];
+    frames_t f;
+    sofab_framing_reader_t rd;
+    size_t n = three_checked_frames(stream);
+    size_t first = 1 + (size_t)stream[0];
+    sofab_ret_t ret = SOFAB_RET_OK;
+    size_t prefixlen, msglen;
+
+    /* the check is the CRC32C of prefix and message, little-endian, behind them */
+    TEST_ASSERT_EQUAL_UINT32(sofab_crc32c(0, stream, first),
+        (uint32_t)stream[first] | (uint32_t)stream[first + 1] << 8
+        | (uint32_t)stream[first + 2] << 16 | (uint32_t)stream[first + 3] << 24);
+
+    memset(&f, 0, sizeof(f));
+    sofab_framing_reader_init_checked(&rd, frame_begin_cb, frame_end_cb, &f);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_reader_feed(&rd, stream, n));
+    check_three_frames(&f);
+
+    memset(&f, 0, sizeof(f));
+    sofab_framing_reader_init_checked(&rd, frame_begin_cb, frame_end_cb, &f);
+    for (size_t i = 0; i < n; i++)
+    {
+        ret = sofab_framing_reader_feed(&rd, &stream[i], 1);
+        /* the frame ends with its check, not with its message */
+        TEST_ASSERT_EQUAL_INT(f.begun == f.ended ? SOFAB_RET_OK : SOFAB_RET_INCOMPLETE, ret);
+    }
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, ret);
+    check_three_frames(&f);
+
+    /* the contiguous walk */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_next_checked(stream, n, &prefixlen, &msglen));
+    TEST_ASSERT_EQUAL_size_t(1, prefixlen);
+    TEST_ASSERT_EQUAL_size_t(first - 1, msglen);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_INCOMPLETE,
+        sofab_framing_next_checked(stream, first + SOFAB_FRAMING_CHECK_LEN - 1, &prefixlen, &msglen));
+}
+
+static void test_framing_checked_corruption (void)
+{
+    uint8_t stream[128];
+    frames_t f;
+    sofab_framing_reader_t rd;
+    size_t n = three_checked_frames(stream);
+    size_t first = 1 + (size_t)stream[0];
+    size_t prefixlen, msglen;
+
+    /* a flipped bit in a string of the first message: it still decodes, but
+     * the check fails it; the frames behind are unharmed */
+    stream[first - 1] ^= 0x01;
+    memset(&f, 0, sizeof(f));
+    sofab_framing_reader_init_checked(&rd, frame_begin_cb, frame_end_cb, &f);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_reader_feed(&rd, stream, n));
+    TEST_ASSERT_EQUAL_UINT(3, f.ended);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, f.result[0]);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[1]);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[2]);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, sofab_framing_next_checked(stream, n, &prefixlen, &msglen));
+    stream[first - 1] ^= 0x01;
+
+    /* a flipped bit in the check itself */
+    stream[first + 2] ^= 0x80;
+    memset(&f, 0, sizeof(f));
+    sofab_framing_reader_init_checked(&rd, frame_begin_cb, frame_end_cb, &f);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_reader_feed(&rd, stream, n));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, f.result[0]);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[2]);
+    TEST_ASSERT_EQUAL_UINT32(1234567, f.msg[2].a);
+}
+
+/* resynchronization *********************************************************/
+
+static void test_framing_resync_scan (void)
+{
+    /* a frame whose message does not scan, then a prefix run into a length
+     * far past the end: an incomplete false start */
+    static const uint8_t garbage[] = { 0x03, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x0A };
+    uint8_t stream[160];
+    size_t n, skip;
+    uint32_t x = 12345;
+
+    memcpy(stream, garbage, sizeof(garbage));
+    n = sizeof(garbage) + three_frames(stream + sizeof(garbage));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_resync(stream, n, &skip));
+    TEST_ASSERT_EQUAL_size_t(sizeof(garbage), skip);
+
+    /* only the start of a frame: kept, everything before it dropped */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_INCOMPLETE, sofab_framing_resync(stream, sizeof(garbage) + 3, &skip));
+    TEST_ASSERT_TRUE(skip <= sizeof(garbage));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_INCOMPLETE, sofab_framing_resync(NULL, 0, &skip));
+    TEST_ASSERT_EQUAL_size_t(0, skip);
+
+    /* pseudo-random garbage in front of checked frames */
+    for (size_t i = 0; i < 40; i++)
+    {
+        x = x * 1103515245u + 12345u;
+        stream[i] = (uint8_t)(x >> 16);
+    }
+    n = 40 + three_checked_frames(stream + 40);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_resync_checked(stream, n, &skip));
+    TEST_ASSERT_EQUAL_size_t(40, skip);
+}
+
+static void test_framing_reader_resyncs_after_bad_prefix (void)
+{
+    static const uint8_t bad[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x1F };
+    uint8_t stream[160], window[64];
+    frames_t f;
+    sofab_framing_reader_t rd;
+    size_t n = 0;
+    sofab_ret_t ret = SOFAB_RET_OK;
+
+    n += put_frame(stream + n, 5, "before");
+    memcpy(stream + n, bad, sizeof(bad));
+    n += sizeof(bad);
+    n += three_frames(stream + n);
+
+    /* whole: the frame before, then the three behind the garbage */
+    memset(&f, 0, sizeof(f));
+    sofab_framing_reader_init(&rd, frame_begin_cb, frame_end_cb, &f);
+    sofab_framing_reader_resync(&rd, window, sizeof(window));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_reader_feed(&rd, stream, n));
+    TEST_ASSERT_EQUAL_UINT(4, f.ended);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[0]);
+    TEST_ASSERT_EQUAL_STRING("before", f.msg[0].text);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[1]);
+    TEST_ASSERT_EQUAL_STRING("first", f.msg[1].text);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[3]);
+    TEST_ASSERT_EQUAL_UINT32(1234567, f.msg[3].a);
+    TEST_ASSERT_TRUE(sofab_framing_reader_skipped(&rd) > 0);
+    TEST_ASSERT_TRUE(sofab_framing_reader_skipped(&rd) <= sizeof(bad));
+
+    /* byte by byte: the same frames */
+    memset(&f, 0, sizeof(f));
+    sofab_framing_reader_init(&rd, frame_begin_cb, frame_end_cb, &f);
+    sofab_framing_reader_resync(&rd, window, sizeof(window));
+    for (size_t i = 0; i < n; i++)
+    {
+        ret = sofab_framing_reader_feed(&rd, &stream[i], 1);
+        TEST_ASSERT_TRUE(ret != SOFAB_RET_E_INVALID_MSG);
+    }
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, ret);
+    TEST_ASSERT_EQUAL_UINT(4, f.ended);
+    TEST_ASSERT_EQUAL_STRING("third", f.msg[3].text);
+}
+
+static void test_framing_reader_resyncs_after_bad_check (void)
+{
+    static const int delta[] = { -1, +10 };
+    uint8_t stream[160], window[32];
+    frames_t f;
+    sofab_framing_reader_t rd;
+    size_t n = 0, second;
+
+    n += put_checked_frame(stream + n, 1, "one");
+    second = n;
+    n += put_checked_frame(stream + n, 2, "two");
+    n += put_checked_frame(stream + n, 3, "three");
+    n += put_checked_frame(stream + n, 4, "four");
+
+    /* the second frame's length one short: its check is read a byte early;
+     * or ten too long: it runs into the third frame. Either way the check
+     * fails, and the reader has to find the third frame on its own */
+    for (size_t d = 0; d < sizeof(delta) / sizeof(delta[0]); d++)
+    {
+        stream[second] = (uint8_t)(stream[second] + delta[d]);
+
+        for (size_t chunk = 1; chunk <= n; chunk += n - 1)
+        {
+            memset(&f, 0, sizeof(f));
+            sofab_framing_reader_init_checked(&rd, frame_begin_cb, frame_end_cb, &f);
+            sofab_framing_reader_resync(&rd, window, sizeof(window));
+            for (size_t i = 0; i < n; i += chunk)
+            {
+                size_t len = n - i < chunk ? n - i : chunk;
+                TEST_ASSERT_TRUE(sofab_framing_reader_feed(&rd, stream + i, len) != SOFAB_RET_E_INVALID_MSG);
+            }
+            TEST_ASSERT_EQUAL_UINT(4, f.ended);
+            TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[0]);
+            TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, f.result[1]);
+            TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[2]);
+            TEST_ASSERT_EQUAL_STRING("three", f.msg[2].text);
+            TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, f.result[3]);
+            TEST_ASSERT_EQUAL_UINT32(4, f.msg[3].a);
+        }
+
+        /* without a window a failed check only fails its frame, as before */
+        memset(&f, 0, sizeof(f));
+        sofab_framing_reader_init_checked(&rd, frame_begin_cb, frame_end_cb, &f);
+        sofab_framing_reader_feed(&rd, stream, n);
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, f.result[1]);
+
+        stream[second] = (uint8_t)(stream[second] - delta[d]);
+    }
+}
+
+/* Counts the frames that passed, and keeps the last one's message. */
+typedef struct
+{
+    msg_t msg;
+    unsigned ok;
+} tally_t;
+
+static void tally_begin_cb (
+    sofab_framing_reader_t *ctx, sofab_istream_t *is, size_t len, void *usrptr)
+{
+    tally_t *t = usrptr;
+    (void)ctx; (void)len;
+
+    memset(&t->msg, 0, sizeof(t->msg));
+    sofab_istream_init(is, msg_field_cb, &t->msg);
+}
+
+static void tally_end_cb (
+    sofab_framing_reader_t *ctx, sofab_istream_t *is, sofab_ret_t result, void *usrptr)
+{
+    tally_t *t = usrptr;
+    (void)ctx; (void)is;
+
+    if (result == SOFAB_RET_OK)
+    {
+        t->ok++;
+    }
+}
+
+static void test_framing_reader_resync_time (void)
+{
+    static const uint8_t bad[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x1F };
+    static uint8_t garbage[64 * 1024], window[4096];
+    uint8_t frame[32];
+    sofab_framing_reader_t rd;
+    tally_t t;
+    clock_t start;
+    uint32_t x = 12345;
+    size_t len;
+
+    for (size_t i = 0; i < sizeof(garbage); i++)
+    {
+        x = x * 1103515245u + 12345u;
+        garbage[i] = (uint8_t)(x >> 16);
+    }
+
+    /* byte by byte through a large window: every byte a search, which must
+     * not go over the whole window again */
+    memset(&t, 0, sizeof(t));
+    sofab_framing_reader_init_checked(&rd, tally_begin_cb, tally_end_cb, &t);
+    sofab_framing_reader_resync(&rd, window, sizeof(window));
+    start = clock();
+    for (size_t i = 0; i < sizeof(bad); i++)
+    {
+        sofab_framing_reader_feed(&rd, &bad[i], 1);
+    }
+    for (size_t i = 0; i < sizeof(garbage); i++)
+    {
+        TEST_ASSERT_TRUE(sofab_framing_reader_feed(&rd, &garbage[i], 1) != SOFAB_RET_E_INVALID_MSG);
+    }
+
+    /* then frames for more than a window: all found, if late */
+    len = put_checked_frame(frame, 1, "after");
+    for (uint32_t k = 0; k < 2 * sizeof(window) / len; k++)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            sofab_framing_reader_feed(&rd, &frame[i], 1);
+        }
+    }
+    TEST_ASSERT_TRUE(clock() - start < CLOCKS_PER_SEC);
+    TEST_ASSERT_EQUAL_UINT(2 * sizeof(window) / len, t.ok);
+    TEST_ASSERT_EQUAL_STRING("after", t.msg.text);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_framing_reader_feed(&rd, NULL, 0));
+}
+
+int test_framing_main (void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_framing_write_patches_prefix_in_place);
+    RUN_TEST(test_framing_write_two_byte_prefix);
+    RUN_TEST(test_framing_write_empty_message);
+    RUN_TEST(test_framing_write_overflow);
+
+    RUN_TEST(test_framing_read_whole);
+    RUN_TEST(test_framing_read_bytewise);
+    RUN_TEST(test_framing_read_split_prefix);
+    RUN_TEST(test_framing_read_bad_message_keeps_framing);
+    RUN_TEST(test_framing_read_bad_prefix_is_terminal);
+
+    RUN_TEST(test_framing_crc32c);
+    RUN_TEST(test_framing_checked_write_and_read);
+    RUN_TEST(test_framing_checked_corruption);
+
+    RUN_TEST(test_framing_resync_scan);
+    RUN_TEST(test_framing_reader_resyncs_after_bad_prefix);
+    RUN_TEST(test_framing_reader_resyncs_after_bad_check);
+    RUN_TEST(test_framing_reader_resync_time);
+
+    return UNITY_END();
+}
+
+#else /* !SOFAB_TEST_FRAMING */
+
+int test_framing_main (void)
+{
+    return 0; /* framing layer compiled out */
+}
+
+#endif /* SOFAB_TEST_FRAMING */
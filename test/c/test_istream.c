@@ -239,6 +239,115 @@ static void test_feed_buffer_stream (void)
     TEST_ASSERT_EQUAL_UINT8(1, test.calls);
 }
 
+static void test_reset (void)
+{
+    sofab_istream_t ctx;
+    const uint8_t buffer[] = {0x00, 0x7F};
+    const uint8_t open_varint[] = {0x00, 0xFF};
+#if !defined(SOFAB_DISABLE_SEQUENCE_SUPPORT)
+    const uint8_t open_sequence[] = {0x06};
+#endif
+
+    uint8_t value = 0x55;
+    test_single_field_t test =
+    {
+        .expected_id = 0,
+        .target_type = FIELD_TYPE_INT8U,
+        .target_ptr = &value,
+        .target_size = sizeof(value),
+        .calls = 0
+    };
+
+    // Whatever the previous message ended in, the next one decodes as on a
+    // fresh stream, through the callback given to init.
+    sofab_istream_init(&ctx, _single_field_callback, &test);
+    TEST_ASSERT_EQUAL(SOFAB_RET_INCOMPLETE, sofab_istream_feed(&ctx, open_varint, sizeof(open_varint)));
+    sofab_istream_reset(&ctx);
+    TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_istream_feed(&ctx, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT8(127, value);
+
+    sofab_istream_invalidate(&ctx);
+    TEST_ASSERT_EQUAL(SOFAB_RET_E_INVALID_MSG, sofab_istream_feed(&ctx, buffer, sizeof(buffer)));
+    sofab_istream_reset(&ctx);
+    value = 0x55;
+    TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_istream_feed(&ctx, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT8(127, value);
+
+#if !defined(SOFAB_DISABLE_SEQUENCE_SUPPORT)
+    TEST_ASSERT_EQUAL(SOFAB_RET_INCOMPLETE, sofab_istream_feed(&ctx, open_sequence, sizeof(open_sequence)));
+    sofab_istream_reset(&ctx);
+    value = 0x55;
+    TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_istream_feed(&ctx, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUAL_UINT8(127, value);
+#endif
+}
+
+#if SOFAB_STATS
+/* 0: u16 = 300 (bound), 1: string "abc" (not bound), 2: sequence (not bound)
+ * holding 0: u8 = 5. Value bytes split 2 copied / 4 skipped; the other six are
+ * headers, the string length and the sequence end. The nested field is seen
+ * but, inside a skipped sequence, gets no callback. */
+static const uint8_t _stats_msg[] = {
+    0x00, 0xAC, 0x02,
+    0x0A, 0x1A, 0x61, 0x62, 0x63,
+    0x16, 0x00, 0x05, 0x07
+};
+
+static void _check_stats (const sofab_istream_stats_t *stats, uint64_t feeds)
+{
+    TEST_ASSERT_EQUAL_UINT64(feeds, stats->feeds);
+    TEST_ASSERT_EQUAL_UINT64(sizeof(_stats_msg), stats->bytes);
+    TEST_ASSERT_EQUAL_UINT64(2, stats->bytes_copied);
+    TEST_ASSERT_EQUAL_UINT64(4, stats->bytes_skipped);
+    TEST_ASSERT_EQUAL_UINT64(4, stats->fields);
+    TEST_ASSERT_EQUAL_UINT64(3, stats->callbacks);
+    TEST_ASSERT_EQUAL_UINT8(1, stats->max_depth);
+}
+
+static void test_stats (void)
+{
+    sofab_istream_t ctx;
+    uint16_t value = 0;
+    test_single_field_t test =
+    {
+        .expected_id = 0,
+        .target_type = FIELD_TYPE_INT16U,
+        .target_ptr = &value,
+        .target_size = sizeof(value),
+        .calls = 0
+    };
+
+    sofab_istream_init(&ctx, _single_field_callback, &test);
+    TEST_ASSERT_EQUAL_UINT64(0, sofab_istream_stats(&ctx)->bytes);
+    TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_istream_feed(&ctx, _stats_msg, sizeof(_stats_msg)));
+    TEST_ASSERT_EQUAL_UINT16(300, value);
+    _check_stats(sofab_istream_stats(&ctx), 1);
+}
+
+static void test_stats_bytewise (void)
+{
+    sofab_istream_t ctx;
+    uint16_t value = 0;
+    test_single_field_t test =
+    {
+        .expected_id = 0,
+        .target_type = FIELD_TYPE_INT16U,
+        .target_ptr = &value,
+        .target_size = sizeof(value),
+        .calls = 0
+    };
+
+    // the split is by decoder state, so chunking must not change it
+    sofab_istream_init(&ctx, _single_field_callback, &test);
+    for (size_t i = 0; i < sizeof(_stats_msg); i++)
+    {
+        sofab_istream_feed(&ctx, &_stats_msg[i], 1);
+    }
+    TEST_ASSERT_EQUAL_UINT16(300, value);
+    _check_stats(sofab_istream_stats(&ctx), sizeof(_stats_msg));
+}
+#endif /* SOFAB_STATS */
+
 /* MESSAGE_SPEC §7.3: a field whose wire type contradicts the type the callback
  * bound carries no value for that target, so it is skipped like an unknown id.
  * The decode succeeds, the destination keeps the value it had, and the skip is
@@ -3416,6 +3525,11 @@ int test_istream_main (void)
     RUN_TEST(test_init);
     RUN_TEST(test_feed_buffer);
     RUN_TEST(test_feed_buffer_stream);
+    RUN_TEST(test_reset);
+#if SOFAB_STATS
+    RUN_TEST(test_stats);
+    RUN_TEST(test_stats_bytewise);
+#endif
     RUN_TEST(test_wiretype_varint_for_fp32_skipped);
     RUN_TEST(test_wiretype_array_for_string_skipped);
     RUN_TEST(test_wiretype_string_for_u8_skipped);
@@ -7,6 +7,8 @@
 
 #include "sofab/object.h"
 
+#include "sofab_test_batch.h"
+
 #include "unity.h"
 
 #include <string.h>
@@ -3120,6 +3122,169 @@ static void test_object_sized_wrapper_init_clears_length (void)
 
 //
 
+/* batch decode ***************************************************************/
+
+static void _batch_dec_init (sofab_object_decoder_t *dec)
+{
+    memset(dec, 0, 2 * sizeof(*dec));
+    dec[0].info = &sofab_test_batch_descr;
+    dec[0].depth = 1;
+}
+
+static void test_object_decode_batch (void)
+{
+    const sofab_test_batch_rec_t in[3] = {
+        { .id = 1, .delta = 5, .name = "one", .child = { .v = 10 } },
+        { .id = 0, .delta = -1 },                 /* all-default: an empty frame */
+        { .id = 3, .delta = -3, .name = "three", .child = { .v = 30 } },
+    };
+    uint8_t frames[3 * SOFAB_TEST_BATCH_FRAME_MAX];
+    sofab_test_batch_slot_t out[4];
+    sofab_ret_t status[4];
+    sofab_object_decoder_t dec[2];
+    size_t len = 0, count, used;
+
+    for (int i = 0; i < 3; i++)
+    {
+        len += sofab_test_batch_frame(frames + len, &in[i]);
+    }
+
+    /* stale contents everywhere: each record must be re-initialized */
+    memset(out, SOFAB_TEST_BATCH_STALE, sizeof(out));
+    _batch_dec_init(dec);
+    TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_object_decode_batch(dec, frames, len,
+        &out[0].rec, sizeof(out[0]), 4, status, &count, &used));
+    TEST_ASSERT_EQUAL_size_t(3, count);
+    TEST_ASSERT_EQUAL_size_t(len, used);
+
+    for (int i = 0; i < 3; i++)
+    {
+        sofab_test_batch_check(&in[i], status[i], &out[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(SOFAB_TEST_BATCH_TAG, out[3].rec.id);
+
+    /* n bounds the batch; the rest is left for the next call */
+    _batch_dec_init(dec);
+    TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_object_decode_batch(dec, frames, len,
+        &out[0].rec, sizeof(out[0]), 1, status, &count, &used));
+    TEST_ASSERT_EQUAL_size_t(1, count);
+    TEST_ASSERT_EQUAL_size_t(frames[0] + 1u, used);
+}
+
+/* Ids past the batch's lookup table, and ids the descriptor does not have. */
+typedef struct
+{
+    uint32_t lo;
+    uint32_t hi;
+} _batch_wide_t;
+
+static const sofab_object_descr_field_t _batch_wide_fields[] = {
+    SOFAB_OBJECT_FIELD(1, _batch_wide_t, lo, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+    SOFAB_OBJECT_FIELD(1000, _batch_wide_t, hi, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+};
+static const sofab_object_descr_t _batch_wide =
+    SOFAB_OBJECT_DESCR(_batch_wide_fields, 2, NULL, 0);
+
+static void test_object_decode_batch_wide_ids (void)
+{
+    uint8_t frames[2 * 16];
+    _batch_wide_t out[2];
+    sofab_ret_t status[2];
+    sofab_object_decoder_t dec[1];
+    size_t len = 0, count;
+
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        sofab_ostream_t os;
+
+        sofab_ostream_init(&os, frames + len, 16, 1, NULL, NULL);
+        TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_ostream_write_unsigned(&os, 1, 10 + i));
+        TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_ostream_write_unsigned(&os, 2, 7));   /* not in the descriptor */
+        TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_ostream_write_unsigned(&os, 999, 7)); /* nor this */
+        TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_ostream_write_unsigned(&os, 1000, 20 + i));
+        frames[len] = (uint8_t)(sofab_ostream_bytes_used(&os) - 1);
+        len += sofab_ostream_bytes_used(&os);
+    }
+
+    memset(dec, 0, sizeof(dec));
+    dec[0].info = &_batch_wide;
+    TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_object_decode_batch(dec, frames, len,
+        out, sizeof(out[0]), 2, status, &count, NULL));
+    TEST_ASSERT_EQUAL_size_t(2, count);
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        TEST_ASSERT_EQUAL(SOFAB_RET_OK, status[i]);
+        TEST_ASSERT_EQUAL_UINT32(10 + i, out[i].lo);
+        TEST_ASSERT_EQUAL_UINT32(20 + i, out[i].hi);
+    }
+}
+
+static void test_object_decode_batch_bad_record_continues (void)
+{
+    const sofab_test_batch_rec_t ok = { .id = 7, .delta = 7, .name = "seven" };
+    uint8_t frames[3 * SOFAB_TEST_BATCH_FRAME_MAX];
+    sofab_test_batch_slot_t out[3];
+    sofab_ret_t status[3];
+    sofab_object_decoder_t dec[2];
+    size_t len = 0, count, used;
+
+    /* a varint still open where its frame ends */
+    frames[len++] = 2;
+    frames[len++] = 0x00;   /* id 0, unsigned varint */
+    frames[len++] = 0x80;
+    /* a well-formed message whose frame ends two bytes into its string */
+    size_t n = sofab_test_batch_frame(frames + len, &ok);
+    frames[len] = (uint8_t)(n - 1 - 2);
+    len += n - 2;
+    len += sofab_test_batch_frame(frames + len, &ok);
+
+    _batch_dec_init(dec);
+    TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_object_decode_batch(dec, frames, len,
+        &out[0].rec, sizeof(out[0]), 3, status, &count, &used));
+    TEST_ASSERT_EQUAL_size_t(3, count);
+    TEST_ASSERT_EQUAL_size_t(len, used);
+    TEST_ASSERT_EQUAL(SOFAB_RET_E_INVALID_MSG, status[0]);
+    TEST_ASSERT_EQUAL(SOFAB_RET_E_INVALID_MSG, status[1]);
+    TEST_ASSERT_EQUAL(SOFAB_RET_OK, status[2]);
+    TEST_ASSERT_EQUAL_UINT32(7, out[2].rec.id);
+    TEST_ASSERT_EQUAL_STRING("seven", out[2].rec.name);
+}
+
+static void test_object_decode_batch_stops (void)
+{
+    const sofab_test_batch_rec_t rec = { .id = 9, .name = "nine" };
+    static const uint8_t bad[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x00 };
+    uint8_t frames[2 * SOFAB_TEST_BATCH_FRAME_MAX];
+    sofab_test_batch_slot_t out[2];
+    sofab_ret_t status[2];
+    sofab_object_decoder_t dec[2];
+    size_t first = 0, len, count, used;
+
+    /* a partial tail: the second frame is missing its last byte */
+    first = sofab_test_batch_frame(frames, &rec);
+    len = first + sofab_test_batch_frame(frames + first, &rec) - 1;
+    _batch_dec_init(dec);
+    TEST_ASSERT_EQUAL(SOFAB_RET_INCOMPLETE, sofab_object_decode_batch(dec, frames, len,
+        &out[0].rec, sizeof(out[0]), 2, status, &count, &used));
+    TEST_ASSERT_EQUAL_size_t(1, count);
+    TEST_ASSERT_EQUAL_size_t(first, used);
+    TEST_ASSERT_EQUAL(SOFAB_RET_OK, status[0]);
+
+    /* a malformed prefix after the first frame: the framing is lost there */
+    memcpy(frames + first, bad, sizeof(bad));
+    TEST_ASSERT_EQUAL(SOFAB_RET_E_INVALID_MSG, sofab_object_decode_batch(dec, frames,
+        first + sizeof(bad), &out[0].rec, sizeof(out[0]), 2, status, &count, &used));
+    TEST_ASSERT_EQUAL_size_t(1, count);
+    TEST_ASSERT_EQUAL_size_t(first, used);
+
+    /* no input, no records */
+    TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_object_decode_batch(dec, NULL, 0,
+        &out[0].rec, sizeof(out[0]), 2, status, &count, NULL));
+    TEST_ASSERT_EQUAL_size_t(0, count);
+}
+
+//
+
 int test_object_main (void)
 {
     UNITY_BEGIN();
@@ -3199,6 +3364,11 @@ int test_object_main (void)
     RUN_TEST(test_object_sized_wrapper_row_lengths);
     RUN_TEST(test_object_sized_wrapper_row_decode_stores_length);
 
+    RUN_TEST(test_object_decode_batch);
+    RUN_TEST(test_object_decode_batch_wide_ids);
+    RUN_TEST(test_object_decode_batch_bad_record_continues);
+    RUN_TEST(test_object_decode_batch_stops);
+
     RUN_TEST(test_object_sized_wrapper_init_clears_length);
 
     return UNITY_END();
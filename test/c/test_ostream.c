@@ -117,6 +117,34 @@ static void test_buffer_flush (void)
     TEST_ASSERT_EQUAL_size_t_MESSAGE(1, used, "used != 1");
 }
 
+#if SOFAB_STATS
+static void test_stats_count_flushes (void)
+{
+    sofab_ostream_t ctx;
+    uint8_t buffer[4];
+
+    sofab_ostream_init(&ctx, buffer, sizeof(buffer), 0, _flush_callback, NULL);
+    TEST_ASSERT_EQUAL_UINT64(0, sofab_ostream_stats(&ctx)->flushes);
+
+    // three 3-byte fields through a 4-byte buffer: drained full twice, then
+    // the 1-byte tail by the explicit flush
+    for (sofab_id_t id = 0; id < 3; id++)
+    {
+        TEST_ASSERT_EQUAL(SOFAB_RET_OK, sofab_ostream_write_unsigned(&ctx, id, 300));
+    }
+    TEST_ASSERT_EQUAL_UINT64(2, sofab_ostream_stats(&ctx)->flushes);
+    TEST_ASSERT_EQUAL_size_t(1, sofab_ostream_flush(&ctx));
+
+    const sofab_ostream_stats_t *stats = sofab_ostream_stats(&ctx);
+    TEST_ASSERT_EQUAL_UINT64(3, stats->flushes);
+    TEST_ASSERT_EQUAL_UINT64(9, stats->bytes_flushed);
+
+    // an empty flush does not reach the callback and is not counted
+    sofab_ostream_flush(&ctx);
+    TEST_ASSERT_EQUAL_UINT64(3, stats->flushes);
+}
+#endif /* SOFAB_STATS */
+
 static void test_buffer_overflow_by_id_via_unsigned (void)
 {
     sofab_ostream_t ctx;
@@ -1068,6 +1096,62 @@ static void test_write_array_of_fp64_specials (void)
 #endif
 }
 
+static void test_write_array_streamed (void)
+{
+    sofab_ostream_t ctx;
+    sofab_ret_t ret = SOFAB_RET_OK;
+    uint8_t buffer[48];
+    uint8_t reference[48];
+    memset(buffer, 0x55, sizeof(buffer));
+
+    const uint32_t u[] = {1, 2, 3, 0x80000000, UINT32_MAX};
+    const int32_t i[] = {-1, -2, -3, INT32_MIN, INT32_MAX};
+    const float f[] = {1.5f, -0.0f};
+
+    sofab_ostream_init(&ctx, reference, sizeof(reference), 0, NULL, NULL);
+    sofab_ostream_write_array_of_unsigned(&ctx, 1, u, 5, sizeof(u[0]));
+    sofab_ostream_write_array_of_signed(&ctx, 2, i, 5, sizeof(i[0]));
+    sofab_ostream_write_array_of_fp32(&ctx, 3, f, 2);
+    size_t expected = sofab_ostream_bytes_used(&ctx);
+
+    sofab_ostream_init(&ctx, buffer, sizeof(buffer), 0, NULL, NULL);
+    ret |= sofab_ostream_write_array_begin(&ctx, 1, SOFAB_TYPE_VARINTARRAY_UNSIGNED, 5);
+    for (int k = 0; k < 5; k++)
+    {
+        ret |= sofab_ostream_write_array_element_unsigned(&ctx, u[k]);
+    }
+    ret |= sofab_ostream_write_array_begin(&ctx, 2, SOFAB_TYPE_VARINTARRAY_SIGNED, 5);
+    for (int k = 0; k < 5; k++)
+    {
+        ret |= sofab_ostream_write_array_element_signed(&ctx, i[k]);
+    }
+    ret |= sofab_ostream_write_array_begin_fixlen(&ctx, 3, 2, sizeof(float), SOFAB_FIXLENTYPE_FP32);
+    for (int k = 0; k < 2; k++)
+    {
+        ret |= sofab_ostream_write_array_element_fixlen(&ctx, &f[k], sizeof(float));
+    }
+    size_t used = sofab_ostream_bytes_used(&ctx);
+
+    TEST_ASSERT_EQUAL_MESSAGE(ret, SOFAB_RET_OK, "ret != SOFAB_RET_OK");
+    TEST_ASSERT_EQUAL_size_t_MESSAGE(expected, used, "used != contiguous writer");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(reference, buffer, used, "buffer != contiguous writer");
+}
+
+static void test_write_array_streamed_overflow (void)
+{
+    sofab_ostream_t ctx;
+    sofab_ret_t ret;
+    uint8_t buffer[3];
+
+    sofab_ostream_init(&ctx, buffer, sizeof(buffer), 0, NULL, NULL);
+    ret = sofab_ostream_write_array_begin(&ctx, 0, SOFAB_TYPE_VARINTARRAY_UNSIGNED, 2);
+    TEST_ASSERT_EQUAL_MESSAGE(ret, SOFAB_RET_OK, "ret != SOFAB_RET_OK");
+    ret = sofab_ostream_write_array_element_unsigned(&ctx, 1);
+    TEST_ASSERT_EQUAL_MESSAGE(ret, SOFAB_RET_OK, "ret != SOFAB_RET_OK");
+    ret = sofab_ostream_write_array_element_unsigned(&ctx, 2);
+    TEST_ASSERT_EQUAL_MESSAGE(ret, SOFAB_RET_E_BUFFER_FULL, "ret != SOFAB_RET_E_BUFFER_FULL");
+}
+
 static void test_write_nested_sequence (void)
 {
     sofab_ostream_t ctx;
@@ -1968,6 +2052,9 @@ int test_ostream_main (void)
     RUN_TEST(test_init);
     RUN_TEST(test_buffer_set);
     RUN_TEST(test_buffer_flush);
+#if SOFAB_STATS
+    RUN_TEST(test_stats_count_flushes);
+#endif
 #if !defined(SOFAB_DISABLE_FIXLEN_SUPPORT)
     RUN_TEST(test_flush_callback_buffer_set_keeps_its_offset);
     RUN_TEST(test_bare_callback_return_resumes_at_zero);
@@ -2053,6 +2140,8 @@ int test_ostream_main (void)
     RUN_TEST(test_write_array_of_fp32_specials);
     RUN_TEST(test_write_array_of_fp64);
     RUN_TEST(test_write_array_of_fp64_specials);
+    RUN_TEST(test_write_array_streamed);
+    RUN_TEST(test_write_array_streamed_overflow);
 
     RUN_TEST(test_write_nested_sequence);
     RUN_TEST(test_eager_sequence_without_content_still_frames);
@@ -0,0 +1,195 @@
+/*!
+ * @file test_posix.c
+ * @brief SofaBuffers test for the file descriptor and mmap adapters.
+ *
+ * Sink: a message many times the encode buffer reaches the file byte for byte
+ * as a one-buffer encode would have produced it, and a failed write surfaces
+ * with its errno on the final flush. Sources: the file decodes identically read
+ * in small chunks and mapped whole; an empty file is the empty message, a
+ * truncated one incomplete, a malformed one invalid.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* mkstemp, unlink and friends are POSIX, not C99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include "sofab/posix.h"
+
+#include "sofab_test_stream.h"
+
+#include "unity.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if SOFAB_TEST_POSIX
+
+/* helpers *******************************************************************/
+
+static size_t read_back (int fd, uint8_t *buf, size_t buflen)
+{
+    ssize_t n;
+
+    TEST_ASSERT_EQUAL_INT(0, (int)lseek(fd, 0, SEEK_SET));
+    n = read(fd, buf, buflen);
+    TEST_ASSERT_TRUE(n >= 0);
+
+    return (size_t)n;
+}
+
+/* sink **********************************************************************/
+
+static void test_posix_fd_sink_matches_buffer (void)
+{
+    uint8_t plain[2048], file[2048];
+    uint8_t buf[SOFAB_FD_SINK_SEGMENTS * 8];
+    sofab_fd_sink_t sink;
+    sofab_ostream_t os;
+    size_t n = sofab_test_encode_plain(plain, sizeof(plain), 1, SOFAB_TEST_FIELDS);
+    int fd = sofab_test_temp_file(NULL, 0);
+
+    /* a message of ~1 KiB through segments of 8 bytes */
+    sofab_ostream_fd_sink(&os, &sink, fd, buf, sizeof(buf));
+    sofab_test_encode_fields(&os, 1, SOFAB_TEST_FIELDS);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_fd_flush(&os));
+
+    TEST_ASSERT_EQUAL_size_t(n, read_back(fd, file, sizeof(file)));
+    TEST_ASSERT_EQUAL_MEMORY(plain, file, n);
+
+    /* the stream goes on after a flush; the file just grows */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_write_unsigned(&os, 1, 7));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_fd_flush(&os));
+    TEST_ASSERT_EQUAL_size_t(n + 2, read_back(fd, file, sizeof(file)));
+
+    /* nothing encoded, nothing written */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_fd_flush(&os));
+    TEST_ASSERT_EQUAL_size_t(n + 2, read_back(fd, file, sizeof(file)));
+
+    close(fd);
+}
+
+static void test_posix_fd_sink_write_error (void)
+{
+    uint8_t buf[SOFAB_FD_SINK_SEGMENTS * 8];
+    sofab_fd_sink_t sink;
+    sofab_ostream_t os;
+    int fds[2];
+
+    /* a descriptor that is not open */
+    sofab_ostream_fd_sink(&os, &sink, -1, buf, sizeof(buf));
+    sofab_test_encode_fields(&os, 1, SOFAB_TEST_FIELDS);
+    errno = 0;
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_ARGUMENT, sofab_ostream_fd_flush(&os));
+    TEST_ASSERT_EQUAL_INT(EBADF, errno);
+
+    /* the failure is kept: later flushes report it too */
+    errno = 0;
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_ARGUMENT, sofab_ostream_fd_flush(&os));
+    TEST_ASSERT_EQUAL_INT(EBADF, errno);
+
+    /* the read end of a pipe cannot be written either */
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+    sofab_ostream_fd_sink(&os, &sink, fds[0], buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_write_unsigned(&os, 1, 1));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_ARGUMENT, sofab_ostream_fd_flush(&os));
+    TEST_ASSERT_EQUAL_INT(EBADF, errno);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/* sources *******************************************************************/
+
+static void test_posix_feed_fd (void)
+{
+    uint8_t plain[2048], chunk[7];
+    sofab_istream_t is;
+    size_t n = sofab_test_encode_plain(plain, sizeof(plain), 1, SOFAB_TEST_FIELDS);
+    int fd = sofab_test_temp_file(plain, n);
+
+    /* chunks of 7 bytes, so fields straddle the reads */
+    memset(sofab_test_values, 0, sizeof(sofab_test_values));
+    TEST_ASSERT_EQUAL_INT(0, (int)lseek(fd, 0, SEEK_SET));
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_istream_feed_fd(&is, fd, chunk, sizeof(chunk)));
+    sofab_test_check_values();
+    close(fd);
+
+    /* cut inside the last field */
+    fd = sofab_test_temp_file(plain, n - 1);
+    TEST_ASSERT_EQUAL_INT(0, (int)lseek(fd, 0, SEEK_SET));
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_INCOMPLETE, sofab_istream_feed_fd(&is, fd, chunk, sizeof(chunk)));
+    close(fd);
+
+    /* at the end already: the empty message */
+    fd = sofab_test_temp_file(plain, n);
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_istream_feed_fd(&is, fd, chunk, sizeof(chunk)));
+    close(fd);
+
+    errno = 0;
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_ARGUMENT, sofab_istream_feed_fd(&is, -1, chunk, sizeof(chunk)));
+    TEST_ASSERT_EQUAL_INT(EBADF, errno);
+}
+
+static void test_posix_feed_mmap (void)
+{
+    static const uint8_t too_wide[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 };
+    uint8_t plain[2048];
+    sofab_istream_t is;
+    size_t n = sofab_test_encode_plain(plain, sizeof(plain), 1, SOFAB_TEST_FIELDS);
+    int fd = sofab_test_temp_file(plain, n);
+
+    /* the whole file, whatever the descriptor's position */
+    memset(sofab_test_values, 0, sizeof(sofab_test_values));
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_istream_feed_mmap(&is, fd));
+    sofab_test_check_values();
+    close(fd);
+
+    fd = sofab_test_temp_file(plain, n - 1);
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_INCOMPLETE, sofab_istream_feed_mmap(&is, fd));
+    close(fd);
+
+    fd = sofab_test_temp_file(NULL, 0);
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_istream_feed_mmap(&is, fd));
+    close(fd);
+
+    fd = sofab_test_temp_file(too_wide, sizeof(too_wide));
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, sofab_istream_feed_mmap(&is, fd));
+    close(fd);
+
+    errno = 0;
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_ARGUMENT, sofab_istream_feed_mmap(&is, -1));
+    TEST_ASSERT_EQUAL_INT(EBADF, errno);
+}
+
+int test_posix_main (void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_posix_fd_sink_matches_buffer);
+    RUN_TEST(test_posix_fd_sink_write_error);
+
+    RUN_TEST(test_posix_feed_fd);
+    RUN_TEST(test_posix_feed_mmap);
+
+    return UNITY_END();
+}
+
+#else /* !SOFAB_TEST_POSIX */
+
+int test_posix_main (void)
+{
+    return 0; /* POSIX adapters not built */
+}
+
+#endif /* SOFAB_TEST_POSIX */
@@ -0,0 +1,368 @@
+/*!
+ * @file test_reclog.c
+ * @brief SofaBuffers test for the append-only record log.
+ *
+ * Every record of a closed log is found by number and by key range, and decodes
+ * to what was appended; a log reopened after close is continued. A log whose
+ * writer died (with a torn record, a torn checkpoint, or before any checkpoint)
+ * is recovered to its last complete record. Out-of-order keys and malformed
+ * records are refused, as are files that are not record logs.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* lseek, write and friends are POSIX, not C99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include "sofab/reclog.h"
+#include "sofab/istream.h"
+#include "sofab/ostream.h"
+
+#include "sofab_test_stream.h"
+
+#include "unity.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if SOFAB_TEST_RECLOG
+
+/* helpers *******************************************************************/
+
+#define KEY_ID  (1)
+
+typedef struct
+{
+    uint64_t key;
+    uint32_t seq;
+} rec_t;
+
+static void rec_field_cb (
+    sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usrptr)
+{
+    rec_t *r = usrptr;
+    (void)size; (void)count;
+
+    switch (id)
+    {
+        case KEY_ID: sofab_istream_read_u64(ctx, &r->key); break;
+        case 2: sofab_istream_read_u32(ctx, &r->seq); break;
+    }
+}
+
+/* Record i: key 10 * (i / 2), so every key but 0 is held by two records. */
+static uint64_t key_of (uint32_t i)
+{
+    return 10 * (uint64_t)(i / 2);
+}
+
+static sofab_ret_t append (sofab_reclog_writer_t *w, uint32_t i)
+{
+    uint8_t buf[32];
+    sofab_ostream_t os;
+
+    sofab_ostream_init(&os, buf, sizeof(buf), 0, NULL, NULL);
+    if (key_of(i) != 0)
+    {
+        sofab_ostream_write_unsigned(&os, KEY_ID, key_of(i));
+    }
+    sofab_ostream_write_unsigned(&os, 2, i);
+
+    return sofab_reclog_append(w, buf, sofab_ostream_bytes_used(&os));
+}
+
+static void append_range (sofab_reclog_writer_t *w, uint32_t from, uint32_t to)
+{
+    for (uint32_t i = from; i < to; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, append(w, i));
+    }
+}
+
+/* Open the log read-only and check it holds records 0 .. n-1. */
+static void check_log (int fd, uint32_t n)
+{
+    sofab_reclog_reader_t r;
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_reader_open(&r, fd));
+    TEST_ASSERT_EQUAL_size_t(n, sofab_reclog_count(&r));
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        const uint8_t *msg;
+        size_t len;
+        sofab_istream_t is;
+        rec_t rec = { 0, 0 };
+
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_record(&r, i, &msg, &len));
+        sofab_istream_init(&is, rec_field_cb, &rec);
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_istream_feed(&is, msg, len));
+        TEST_ASSERT_EQUAL_UINT32(i, rec.seq);
+        TEST_ASSERT_EQUAL_UINT64(key_of(i), rec.key);
+        TEST_ASSERT_EQUAL_UINT64(key_of(i), sofab_reclog_key(&r, i));
+    }
+
+    sofab_reclog_reader_close(&r);
+}
+
+/* What a crash leaves: the records on disk, the writer's memory gone. */
+static void crash (sofab_reclog_writer_t *w)
+{
+    free(w->index);
+    w->index = NULL;
+}
+
+static void put_raw (int fd, const void *data, size_t len)
+{
+    TEST_ASSERT_EQUAL_INT(0, lseek(fd, 0, SEEK_END) < 0);
+    TEST_ASSERT_EQUAL_INT((int)len, (int)write(fd, data, len));
+}
+
+/* closed logs ***************************************************************/
+
+static void test_reclog_roundtrip_and_find (void)
+{
+    sofab_reclog_writer_t w;
+    sofab_reclog_reader_t r;
+    const uint8_t *msg;
+    size_t len;
+    int fd = sofab_test_temp_file(NULL, 0);
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 1, KEY_ID, 16));
+    append_range(&w, 0, 1000);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_close(&w));
+
+    check_log(fd, 1000);
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_reader_open(&r, fd));
+
+    /* key k is held by records 2k/10 and 2k/10 + 1 */
+    TEST_ASSERT_EQUAL_size_t(0, sofab_reclog_find(&r, 0));
+    TEST_ASSERT_EQUAL_size_t(2, sofab_reclog_find(&r, 1));
+    TEST_ASSERT_EQUAL_size_t(2, sofab_reclog_find(&r, 10));
+    TEST_ASSERT_EQUAL_size_t(50, sofab_reclog_find(&r, 250));
+    TEST_ASSERT_EQUAL_size_t(52, sofab_reclog_find(&r, 251));
+    TEST_ASSERT_EQUAL_size_t(998, sofab_reclog_find(&r, 4990));
+    TEST_ASSERT_EQUAL_size_t(1000, sofab_reclog_find(&r, 4991));
+
+    /* the keys in [100, 200): records 20 .. 39 */
+    TEST_ASSERT_EQUAL_size_t(20, sofab_reclog_find(&r, 100));
+    TEST_ASSERT_EQUAL_size_t(40, sofab_reclog_find(&r, 200));
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_ARGUMENT, sofab_reclog_record(&r, 1000, &msg, &len));
+    sofab_reclog_reader_close(&r);
+
+    close(fd);
+}
+
+static void test_reclog_reopen_continues (void)
+{
+    sofab_reclog_writer_t w;
+    int fd = sofab_test_temp_file(NULL, 0);
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 1, KEY_ID, 0));
+    append_range(&w, 0, 30);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_close(&w));
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 1, KEY_ID, 0));
+    TEST_ASSERT_EQUAL_size_t(30, w.count);
+    append_range(&w, 30, 45);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_close(&w));
+
+    check_log(fd, 45);
+
+    /* reopened under another key, or unkeyed */
+    errno = 0;
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_ARGUMENT, sofab_reclog_writer_open(&w, fd, 1, 2, 0));
+    TEST_ASSERT_EQUAL_INT(EINVAL, errno);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_ARGUMENT, sofab_reclog_writer_open(&w, fd, 0, 0, 0));
+
+    close(fd);
+}
+
+static void test_reclog_append_rejects (void)
+{
+    static const uint8_t truncated[] = { 0x08 };   /* id 1 unsigned, no value */
+    sofab_reclog_writer_t w;
+    int fd = sofab_test_temp_file(NULL, 0);
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 1, KEY_ID, 0));
+    append_range(&w, 0, 10);
+
+    /* record 3 has key 10, below the last one's 40 */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_ARGUMENT, append(&w, 3));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, sofab_reclog_append(&w, truncated, sizeof(truncated)));
+
+    /* neither was written, and the log goes on */
+    append_range(&w, 10, 12);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_close(&w));
+    check_log(fd, 12);
+
+    close(fd);
+}
+
+static void test_reclog_unkeyed_and_foreign (void)
+{
+    static const uint8_t junk[] = "not a record log at all";
+    sofab_reclog_writer_t w;
+    sofab_reclog_reader_t r;
+    const uint8_t *msg;
+    size_t len;
+    int fd = sofab_test_temp_file(NULL, 0);
+
+    /* an unkeyed log takes any message, the empty one included */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 0, 0, 2));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_append(&w, junk, 5));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_append(&w, NULL, 0));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_append(&w, junk, sizeof(junk)));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_close(&w));
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_reader_open(&r, fd));
+    TEST_ASSERT_EQUAL_size_t(3, sofab_reclog_count(&r));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_record(&r, 1, &msg, &len));
+    TEST_ASSERT_EQUAL_size_t(0, len);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_record(&r, 2, &msg, &len));
+    TEST_ASSERT_EQUAL_size_t(sizeof(junk), len);
+    TEST_ASSERT_EQUAL_MEMORY(junk, msg, len);
+    sofab_reclog_reader_close(&r);
+    close(fd);
+
+    /* a file that is something else */
+    fd = sofab_test_temp_file(NULL, 0);
+    put_raw(fd, junk, sizeof(junk));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, sofab_reclog_reader_open(&r, fd));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, sofab_reclog_writer_open(&w, fd, 0, 0, 0));
+    close(fd);
+}
+
+/* recovery ******************************************************************/
+
+static void test_reclog_recover_torn_record (void)
+{
+    static const uint8_t torn[] = { 40, 0x08, 0x01 }; /* 40 bytes announced, 2 there */
+    sofab_reclog_writer_t w;
+    sofab_reclog_reader_t r;
+    int fd = sofab_test_temp_file(NULL, 0);
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 1, KEY_ID, 10));
+    append_range(&w, 0, 95);
+    crash(&w);
+    put_raw(fd, torn, sizeof(torn));
+
+    /* no footer: only the writer can open it */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_INVALID_MSG, sofab_reclog_reader_open(&r, fd));
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 1, KEY_ID, 10));
+    TEST_ASSERT_EQUAL_size_t(95, w.count);
+    TEST_ASSERT_EQUAL_size_t(90, w.covered);
+    TEST_ASSERT_EQUAL_UINT64(w.end, (uint64_t)lseek(fd, 0, SEEK_END));
+    append_range(&w, 95, 100);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_close(&w));
+
+    check_log(fd, 100);
+    close(fd);
+}
+
+static void test_reclog_recover_torn_checkpoint (void)
+{
+    static const uint8_t torn[] = { 0xFF, 0xFF, 0xFF, 0xFF, 'C', 5, 0, 0 };
+    sofab_reclog_writer_t w;
+    int fd = sofab_test_temp_file(NULL, 0);
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 1, KEY_ID, 10));
+    append_range(&w, 0, 25);
+    crash(&w);
+    put_raw(fd, torn, sizeof(torn));
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 1, KEY_ID, 10));
+    TEST_ASSERT_EQUAL_size_t(25, w.count);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_close(&w));
+
+    check_log(fd, 25);
+    close(fd);
+}
+
+static void test_reclog_recover_without_checkpoint (void)
+{
+    sofab_reclog_writer_t w;
+    int fd = sofab_test_temp_file(NULL, 0);
+
+    /* nothing but records: recovery scans them all */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 1, KEY_ID, 0));
+    append_range(&w, 0, 17);
+    crash(&w);
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 1, KEY_ID, 0));
+    TEST_ASSERT_EQUAL_size_t(17, w.count);
+    TEST_ASSERT_EQUAL_size_t(0, w.covered);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_close(&w));
+
+    check_log(fd, 17);
+    close(fd);
+}
+
+static void test_reclog_recover_zero_tail (void)
+{
+    static const uint8_t zeros[64] = { 0 };
+    sofab_reclog_writer_t w;
+    sofab_reclog_reader_t r;
+    const uint8_t *msg;
+    size_t len;
+    uint64_t end;
+    int fd = sofab_test_temp_file(NULL, 0);
+
+    /* empty records are legal in an unkeyed log: two of them inside it */
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 0, 0, 0));
+    append_range(&w, 0, 5);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_append(&w, NULL, 0));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_append(&w, NULL, 0));
+    append_range(&w, 5, 6);
+    end = w.end;
+    crash(&w);
+
+    /* the file grew over blocks that were never written */
+    put_raw(fd, zeros, sizeof(zeros));
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_open(&w, fd, 0, 0, 0));
+    TEST_ASSERT_EQUAL_size_t(8, w.count);
+    TEST_ASSERT_EQUAL_UINT64(end, w.end);
+    TEST_ASSERT_EQUAL_UINT64(end, (uint64_t)lseek(fd, 0, SEEK_END));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_writer_close(&w));
+
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_reader_open(&r, fd));
+    TEST_ASSERT_EQUAL_size_t(8, sofab_reclog_count(&r));
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_record(&r, 6, &msg, &len));
+    TEST_ASSERT_EQUAL_size_t(0, len);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_reclog_record(&r, 7, &msg, &len));
+    TEST_ASSERT_TRUE(len > 0);
+    sofab_reclog_reader_close(&r);
+    close(fd);
+}
+
+int test_reclog_main (void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_reclog_roundtrip_and_find);
+    RUN_TEST(test_reclog_reopen_continues);
+    RUN_TEST(test_reclog_append_rejects);
+    RUN_TEST(test_reclog_unkeyed_and_foreign);
+
+    RUN_TEST(test_reclog_recover_torn_record);
+    RUN_TEST(test_reclog_recover_torn_checkpoint);
+    RUN_TEST(test_reclog_recover_without_checkpoint);
+    RUN_TEST(test_reclog_recover_zero_tail);
+
+    return UNITY_END();
+}
+
+#else /* !SOFAB_TEST_RECLOG */
+
+int test_reclog_main (void)
+{
+    return 0; /* record log not built */
+}
+
+#endif /* SOFAB_TEST_RECLOG */
@@ -0,0 +1,157 @@
+/*!
+ * @file test_uring.c
+ * @brief SofaBuffers test for the io_uring sink and source.
+ *
+ * Sink: a message many times the ring's buffers reaches a file (at an offset)
+ * and a pipe byte for byte as a one-buffer encode would have produced it, and
+ * a failed write surfaces with its errno. Source: the file decodes identically
+ * read ahead in small buffers, at an offset and from a pipe; a truncated file
+ * is incomplete and an empty one the empty message.
+ *
+ * Where the kernel or a sandbox refuses io_uring the tests have nothing to run
+ * and pass.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* mkstemp, pipe and friends are POSIX, not C99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include "sofab/uring.h"
+
+#include "sofab_test_stream.h"
+
+#include "unity.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if SOFAB_TEST_URING
+
+/* helpers *******************************************************************/
+
+static uint8_t ring_mem[SOFAB_URING_BUFFERS * 16];
+
+/* Set up the ring, or report that io_uring is not to be had here. */
+static int ring_up (sofab_uring_t *u)
+{
+    return sofab_uring_init(u, ring_mem, sizeof(ring_mem)) == SOFAB_RET_OK;
+}
+
+/* sink **********************************************************************/
+
+static void test_uring_sink_file_and_pipe (void)
+{
+    uint8_t plain[2048], back[2048 + 8];
+    sofab_uring_t u;
+    sofab_ostream_t os;
+    size_t n = sofab_test_encode_plain(plain, sizeof(plain), 1, SOFAB_TEST_FIELDS);
+    int fd, fds[2];
+
+    if (!ring_up(&u))
+    {
+        return;
+    }
+
+    /* at offset 8 of a file: the head is left alone */
+    fd = sofab_test_temp_file((const uint8_t *)"12345678", 8);
+    sofab_ostream_uring_sink(&os, &u, fd, 8);
+    sofab_test_encode_fields(&os, 1, SOFAB_TEST_FIELDS);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_uring_flush(&os));
+    TEST_ASSERT_EQUAL_INT((int)(n + 8), (int)pread(fd, back, sizeof(back), 0));
+    TEST_ASSERT_EQUAL_MEMORY("12345678", back, 8);
+    TEST_ASSERT_EQUAL_MEMORY(plain, back + 8, n);
+    close(fd);
+
+    /* a pipe, one write at a time */
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+    sofab_ostream_uring_sink(&os, &u, fds[1], SOFAB_URING_STREAM);
+    sofab_test_encode_fields(&os, 1, SOFAB_TEST_FIELDS);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_uring_flush(&os));
+    close(fds[1]);
+    TEST_ASSERT_EQUAL_INT((int)n, (int)read(fds[0], back, sizeof(back)));
+    TEST_ASSERT_EQUAL_MEMORY(plain, back, n);
+    close(fds[0]);
+
+    /* the read end of a pipe cannot be written */
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+    sofab_ostream_uring_sink(&os, &u, fds[0], SOFAB_URING_STREAM);
+    sofab_test_encode_fields(&os, 1, SOFAB_TEST_FIELDS);
+    errno = 0;
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_ARGUMENT, sofab_ostream_uring_flush(&os));
+    TEST_ASSERT_EQUAL_INT(EBADF, errno);
+    close(fds[0]);
+    close(fds[1]);
+
+    sofab_uring_exit(&u);
+}
+
+/* source ********************************************************************/
+
+static void test_uring_feed (void)
+{
+    uint8_t plain[2048];
+    sofab_uring_t u;
+    sofab_istream_t is;
+    size_t n = sofab_test_encode_plain(plain, sizeof(plain), 1, SOFAB_TEST_FIELDS);
+    int fd, fds[2];
+
+    if (!ring_up(&u))
+    {
+        return;
+    }
+
+    /* read ahead in 16-byte buffers, fields straddling them */
+    fd = sofab_test_temp_file(plain, n);
+    memset(sofab_test_values, 0, sizeof(sofab_test_values));
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_istream_feed_uring(&is, &u, fd, 0));
+    sofab_test_check_values();
+
+    /* from an offset inside the last field */
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_INCOMPLETE, sofab_istream_feed_uring(&is, &u, fd, (int64_t)n - 1));
+
+    /* past the end: the empty message */
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_istream_feed_uring(&is, &u, fd, (int64_t)n));
+    close(fd);
+
+    /* a pipe */
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+    TEST_ASSERT_EQUAL_INT((int)n, (int)write(fds[1], plain, n));
+    close(fds[1]);
+    memset(sofab_test_values, 0, sizeof(sofab_test_values));
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_istream_feed_uring(&is, &u, fds[0], SOFAB_URING_STREAM));
+    sofab_test_check_values();
+    close(fds[0]);
+
+    errno = 0;
+    sofab_istream_init(&is, sofab_test_values_field_cb, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_E_ARGUMENT, sofab_istream_feed_uring(&is, &u, -1, 0));
+    TEST_ASSERT_EQUAL_INT(EBADF, errno);
+
+    sofab_uring_exit(&u);
+}
+
+int test_uring_main (void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_uring_sink_file_and_pipe);
+    RUN_TEST(test_uring_feed);
+
+    return UNITY_END();
+}
+
+#else /* !SOFAB_TEST_URING */
+
+int test_uring_main (void)
+{
+    return 0; /* io_uring adapters not built */
+}
+
+#endif /* SOFAB_TEST_URING */
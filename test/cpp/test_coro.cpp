@@ -0,0 +1,552 @@
+/*!
+ * @file test_coro.cpp
+ * @brief SofaBuffers test for the coroutine decode/encode adapters (coro.hpp)
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * No async runtime is linked: a poll() loop over non-blocking socketpairs is
+ * the whole executor, which is exactly the situation the adapters are for.
+ */
+
+#include "sofab/coro.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* helpers ********************************************************************/
+
+namespace
+{
+
+//! Single-threaded executor: resumes each coroutine once its fd is ready.
+struct Loop
+{
+    struct Wait
+    {
+        int fd;
+        short events;
+        std::coroutine_handle<> handle;
+    };
+
+    std::vector<Wait> waits;
+
+    void run()
+    {
+        while (!waits.empty())
+        {
+            std::vector<pollfd> fds;
+            for (auto &wait : waits)
+            {
+                fds.push_back({wait.fd, wait.events, 0});
+            }
+            REQUIRE(::poll(fds.data(), fds.size(), 5000) > 0);
+
+            std::vector<std::coroutine_handle<>> ready;
+            std::vector<Wait> blocked;
+            for (size_t i = 0; i < fds.size(); i++)
+            {
+                if (fds[i].revents)
+                {
+                    ready.push_back(waits[i].handle);
+                }
+                else
+                {
+                    blocked.push_back(waits[i]);
+                }
+            }
+            waits = std::move(blocked);
+
+            for (auto handle : ready)
+            {
+                handle.resume();
+            }
+        }
+    }
+};
+
+//! Suspends the awaiting coroutine until @c fd is ready for @c events.
+struct Ready
+{
+    Loop &loop;
+    int fd;
+    short events;
+
+    bool await_ready() noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { loop.waits.push_back({fd, events, handle}); }
+    void await_resume() noexcept { }
+};
+
+//! Non-blocking socket end as an awaitable source and sink.
+struct Socket
+{
+    Loop &loop;
+    int fd;
+    size_t reads = 0;
+
+    sofab::Task<size_t> read(std::span<uint8_t> buffer)
+    {
+        for (;;)
+        {
+            ssize_t n = ::read(fd, buffer.data(), buffer.size());
+            if (n >= 0)
+            {
+                reads++;
+                co_return static_cast<size_t>(n);
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                co_return 0;
+            }
+            co_await Ready{loop, fd, POLLIN};
+        }
+    }
+
+    sofab::Task<bool> write(std::span<const uint8_t> bytes)
+    {
+        while (!bytes.empty())
+        {
+            ssize_t n = ::write(fd, bytes.data(), bytes.size());
+            if (n > 0)
+            {
+                bytes = bytes.subspan(static_cast<size_t>(n));
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                co_await Ready{loop, fd, POLLOUT};
+                continue;
+            }
+            co_return false;
+        }
+        co_return true;
+    }
+};
+
+//! A connected pair of non-blocking sockets with a small send buffer, so a
+//! message of a few kilobytes cannot be written without waiting.
+struct Pair
+{
+    int fds[2] = {-1, -1};
+
+    Pair()
+    {
+        REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        for (int fd : fds)
+        {
+            int small = 2048;
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+    }
+
+    ~Pair()
+    {
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+};
+
+struct Record final : sofab::Message
+{
+    uint64_t seq = 0;
+    sofab::InlineVector<uint32_t, 2048> values;
+
+    sofab::OStreamImpl::Result serialize(sofab::OStreamImpl &os) const noexcept override
+    {
+        return os.write(0, seq).write(1, values);
+    }
+
+    void deserialize(sofab::IStreamImpl &is, sofab::id id, size_t, size_t count) noexcept override
+    {
+        switch (id)
+        {
+            case 0: is.read(seq); break;
+            case 1: is.readArray(values, count, 2048); break;
+            default: break;
+        }
+    }
+};
+
+Record makeRecord(uint64_t seq, size_t count)
+{
+    Record record;
+    record.seq = seq;
+    for (size_t i = 0; i < count; i++)
+    {
+        record.values.push_back(static_cast<uint32_t>((i + seq) * 2654435761u));
+    }
+    return record;
+}
+
+sofab::Task<sofab::Error> sendRecord(Socket &socket, sofab::BufferPool &pool, const Record &record)
+{
+    sofab::OStreamAsync<Socket> out{socket, pool};
+
+    // Field by field, so the pool only has to hold one field at a time.
+    sofab::Error error = co_await out.write(0, record.seq);
+    if (error == sofab::Error::None)
+    {
+        error = co_await out.write(1, record.values);
+    }
+    if (error == sofab::Error::None)
+    {
+        error = co_await out.flush();
+    }
+
+    ::shutdown(socket.fd, SHUT_WR);
+    co_return error;
+}
+
+sofab::Task<sofab::Error> sendMessage(Socket &socket, sofab::BufferPool &pool, const Record &record)
+{
+    sofab::OStreamAsync<Socket> out{socket, pool};
+
+    // All in one call, however small the pool.
+    sofab::Error error = co_await out.encode(record);
+    if (error == sofab::Error::None)
+    {
+        error = co_await out.flush();
+    }
+
+    ::shutdown(socket.fd, SHUT_WR);
+    co_return error;
+}
+
+sofab::Task<sofab::Error> receiveRecord(Socket &socket, sofab::IStreamImpl &istream)
+{
+    std::array<uint8_t, 61> buffer;
+    co_return co_await sofab::decodeFrom(istream, socket, buffer);
+}
+
+//! In-memory source yielding fixed-size pieces of a byte string.
+struct MemorySource
+{
+    std::span<const uint8_t> bytes;
+    size_t piece;
+
+    sofab::Task<size_t> read(std::span<uint8_t> buffer)
+    {
+        size_t len = std::min({piece, buffer.size(), bytes.size()});
+        std::copy_n(bytes.begin(), len, buffer.begin());
+        bytes = bytes.subspan(len);
+        co_return len;
+    }
+};
+
+//! In-memory sink that takes at most @c limit bytes in total.
+struct MemorySink
+{
+    std::vector<uint8_t> bytes;
+    size_t limit = SIZE_MAX;
+    size_t writes = 0;
+
+    sofab::Task<bool> write(std::span<const uint8_t> chunk)
+    {
+        writes++;
+        if (bytes.size() + chunk.size() > limit)
+        {
+            co_return false;
+        }
+        bytes.insert(bytes.end(), chunk.begin(), chunk.end());
+        co_return true;
+    }
+};
+
+template <typename Sink>
+sofab::Task<sofab::Error> encodeAndFlush(sofab::OStreamAsync<Sink> &out, const Record &record)
+{
+    sofab::Error error = co_await out.encode(record);
+    if (error == sofab::Error::None)
+    {
+        error = co_await out.flush();
+    }
+    co_return error;
+}
+
+std::vector<uint8_t> encodeSync(const Record &record)
+{
+    std::vector<uint8_t> bytes(sofab::encodedSize(record));
+    sofab::OStreamView reference{bytes.data(), bytes.size()};
+    REQUIRE(record.serialize(reference).ok());
+    bytes.resize(reference.bytesUsed());
+    return bytes;
+}
+
+} // namespace
+
+/* tests **********************************************************************/
+
+TEST_CASE("Coro: a message crosses a socketpair through both adapters")
+{
+    const Record sent = makeRecord(7, 2000);
+    sofab::BufferPool pool{256, 64};
+    Loop loop;
+    Pair pair;
+    Socket writer{loop, pair.fds[0]};
+    Socket reader{loop, pair.fds[1]};
+    sofab::IStreamObject<Record> received;
+
+    auto send = sendRecord(writer, pool, sent);
+    auto receive = receiveRecord(reader, received);
+    send.start();
+    receive.start();
+    loop.run();
+
+    REQUIRE(send.done());
+    REQUIRE(receive.done());
+    REQUIRE(send.result() == sofab::Error::None);
+    REQUIRE(receive.result() == sofab::Error::None);
+    REQUIRE((*received).seq == sent.seq);
+    REQUIRE((*received).values.size() == sent.values.size());
+    REQUIRE(std::equal(sent.values.begin(), sent.values.end(), (*received).values.begin()));
+
+    // The payload did not fit one socket buffer, so the reader had to wait
+    // and resume several times.
+    REQUIRE(reader.reads > 2);
+    REQUIRE(pool.available() == pool.chunkCount());
+}
+
+TEST_CASE("Coro: many connections share one loop and one pool")
+{
+    constexpr size_t connections = 8;
+    // Far less than one connection's values field: writers wait for each
+    // other's chunks.
+    sofab::BufferPool pool{128, 8};
+    Loop loop;
+
+    std::vector<std::unique_ptr<Pair>> pairs;
+    std::vector<std::unique_ptr<Socket>> sockets;
+    std::vector<Record> sent;
+    std::vector<std::unique_ptr<sofab::IStreamObject<Record>>> received;
+    std::vector<sofab::Task<sofab::Error>> tasks;
+
+    for (size_t i = 0; i < connections; i++)
+    {
+        sent.push_back(makeRecord(i, 300 + 100 * i));
+    }
+
+    for (size_t i = 0; i < connections; i++)
+    {
+        pairs.push_back(std::make_unique<Pair>());
+        sockets.push_back(std::make_unique<Socket>(Socket{loop, pairs[i]->fds[0]}));
+        sockets.push_back(std::make_unique<Socket>(Socket{loop, pairs[i]->fds[1]}));
+        received.push_back(std::make_unique<sofab::IStreamObject<Record>>());
+
+        tasks.push_back(sendRecord(*sockets[2 * i], pool, sent[i]));
+        tasks.push_back(receiveRecord(*sockets[2 * i + 1], *received[i]));
+    }
+
+    for (auto &task : tasks)
+    {
+        task.start();
+    }
+    loop.run();
+
+    for (size_t i = 0; i < connections; i++)
+    {
+        REQUIRE(tasks[2 * i].done());
+        REQUIRE(tasks[2 * i + 1].done());
+        REQUIRE(tasks[2 * i].result() == sofab::Error::None);
+        REQUIRE(tasks[2 * i + 1].result() == sofab::Error::None);
+
+        auto &record = **received[i];
+        REQUIRE(record.seq == sent[i].seq);
+        REQUIRE(record.values.size() == sent[i].values.size());
+        REQUIRE(std::equal(sent[i].values.begin(), sent[i].values.end(), record.values.begin()));
+    }
+    REQUIRE(pool.available() == pool.chunkCount());
+}
+
+TEST_CASE("Coro: a message larger than the pool streams through a slow socket")
+{
+    const Record sent = makeRecord(11, 2000);
+    sofab::BufferPool pool{64, 4};
+    Loop loop;
+    Pair pair;
+    Socket writer{loop, pair.fds[0]};
+    Socket reader{loop, pair.fds[1]};
+    sofab::IStreamObject<Record> received;
+
+    REQUIRE(encodeSync(sent).size() > 8 * pool.chunkSize() * pool.chunkCount());
+
+    auto send = sendMessage(writer, pool, sent);
+    auto receive = receiveRecord(reader, received);
+    send.start();
+    receive.start();
+    loop.run();
+
+    REQUIRE(send.done());
+    REQUIRE(receive.done());
+    REQUIRE(send.result() == sofab::Error::None);
+    REQUIRE(receive.result() == sofab::Error::None);
+    REQUIRE((*received).seq == sent.seq);
+    REQUIRE((*received).values.size() == sent.values.size());
+    REQUIRE(std::equal(sent.values.begin(), sent.values.end(), (*received).values.begin()));
+    REQUIRE(reader.reads > 2);
+    REQUIRE(pool.available() == pool.chunkCount());
+}
+
+TEST_CASE("Coro: a call larger than the pool sends the synchronous bytes")
+{
+    const Record record = makeRecord(5, 200);
+    const std::vector<uint8_t> expected = encodeSync(record);
+
+    sofab::BufferPool pool{32, 4};
+    MemorySink sink;
+    sofab::OStreamAsync<MemorySink> out{sink, pool};
+
+    auto task = encodeAndFlush(out, record);
+    task.start();
+
+    REQUIRE(task.done());
+    REQUIRE(task.result() == sofab::Error::None);
+    REQUIRE(out.ok());
+    REQUIRE(sink.bytes == expected);
+    REQUIRE(pool.available() == pool.chunkCount());
+}
+
+TEST_CASE("Coro: an encoder waits for a chunk held elsewhere")
+{
+    const Record record = makeRecord(2, 50);
+    const std::vector<uint8_t> expected = encodeSync(record);
+
+    sofab::BufferPool pool{32, 2};
+    MemorySink sink;
+    sofab::OStreamAsync<MemorySink> out{sink, pool};
+    sofab::BufferPool::Chunk held[2] = {pool.acquire(), pool.acquire()};
+
+    auto task = encodeAndFlush(out, record);
+    task.start();
+    REQUIRE_FALSE(task.done());
+    REQUIRE(sink.writes == 0);
+
+    // The release resumes the encoder, which gets through on that one chunk.
+    held[0].reset();
+    REQUIRE(task.done());
+    REQUIRE(task.result() == sofab::Error::None);
+    REQUIRE(sink.bytes == expected);
+    REQUIRE(pool.available() == 1);
+
+    held[1].reset();
+    REQUIRE(pool.available() == pool.chunkCount());
+}
+
+TEST_CASE("Coro: encode drains a whole message and matches the synchronous bytes")
+{
+    const Record record = makeRecord(3, 500);
+    const std::vector<uint8_t> expected = encodeSync(record);
+
+    sofab::BufferPool pool{64, 64};
+    MemorySink sink;
+    sofab::OStreamAsync<MemorySink> out{sink, pool};
+
+    auto task = encodeAndFlush(out, record);
+    task.start();
+
+    REQUIRE(task.done());
+    REQUIRE(task.result() == sofab::Error::None);
+    REQUIRE(out.ok());
+    REQUIRE(sink.bytes == expected);
+    REQUIRE(sink.writes == (expected.size() + 63) / 64);
+}
+
+TEST_CASE("Coro: a refusing sink is reported")
+{
+    const Record record = makeRecord(1, 200);
+
+    SECTION("within the pool")
+    {
+        sofab::BufferPool pool{64, 64};
+        MemorySink sink;
+        sink.limit = 100;
+        sofab::OStreamAsync<MemorySink> out{sink, pool};
+
+        auto task = out.encode(record);
+        task.start();
+        REQUIRE(task.done());
+        REQUIRE(task.result() == sofab::Error::BufferFull);
+        REQUIRE_FALSE(out.ok());
+        REQUIRE(pool.available() == pool.chunkCount() - 1);
+    }
+
+    SECTION("between passes of a call larger than the pool")
+    {
+        sofab::BufferPool pool{32, 4};
+        MemorySink sink;
+        sink.limit = 200;
+        sofab::OStreamAsync<MemorySink> out{sink, pool};
+
+        auto big = out.write(1, record.values);
+        big.start();
+        REQUIRE(big.done());
+        REQUIRE(big.result() == sofab::Error::BufferFull);
+        REQUIRE(pool.available() == pool.chunkCount());
+
+        // Nothing goes out after it, and the failure stays on record.
+        size_t taken = sink.bytes.size();
+        auto small = out.write(0, record.seq);
+        small.start();
+        REQUIRE(small.done());
+        REQUIRE(small.result() == sofab::Error::BufferFull);
+        REQUIRE(sink.bytes.size() == taken);
+        REQUIRE_FALSE(out.ok());
+    }
+}
+
+TEST_CASE("Coro: decodeFrom reports how the input ended")
+{
+    SECTION("end of input on a field boundary")
+    {
+        const uint8_t wire[] = {0x00, 0x2A};
+        MemorySource source{wire, 1};
+        sofab::IStreamObject<Record> istream;
+        std::array<uint8_t, 8> buffer;
+
+        auto task = sofab::decodeFrom(istream, source, buffer);
+        task.start();
+        REQUIRE(task.done());
+        REQUIRE(task.result() == sofab::Error::None);
+        REQUIRE((*istream).seq == 42);
+    }
+
+    SECTION("end of input mid-field")
+    {
+        const uint8_t wire[] = {0x00, 0xAA};
+        MemorySource source{wire, 1};
+        sofab::IStreamObject<Record> istream;
+        std::array<uint8_t, 8> buffer;
+
+        auto task = sofab::decodeFrom(istream, source, buffer);
+        task.start();
+        REQUIRE(task.done());
+        REQUIRE(task.result() == sofab::Error::Incomplete);
+    }
+
+    SECTION("a malformed message ends the read early")
+    {
+        // A sequence end with no open sequence, followed by input that is
+        // never read.
+        const uint8_t wire[] = {0x07, 0x00, 0x01, 0x00, 0x02};
+        MemorySource source{wire, 1};
+        sofab::IStreamObject<Record> istream;
+        std::array<uint8_t, 8> buffer;
+
+        auto task = sofab::decodeFrom(istream, source, buffer);
+        task.start();
+        REQUIRE(task.done());
+        REQUIRE(task.result() == sofab::Error::InvalidMessage);
+        REQUIRE(source.bytes.size() == sizeof(wire) - 1);
+    }
+}
@@ -1679,3 +1679,25 @@ TEST_CASE("IStream: a skipped field does not disturb the fields around it")
     REQUIRE(istream.skipped() == 1);
 #endif
 }
+
+#if SOFAB_STATS
+TEST_CASE("IStream: stats split the payload into copied and skipped bytes")
+{
+    sofab::OStream os{256};
+    os.write(1, uint32_t{42});                  // contradicts readString -> skipped
+    os.write(2, std::vector<uint8_t>{7, 7}.data(), 2);
+    os.write(0, uint32_t{3});
+
+    sofab::IStreamObject<TypeCheckedObject> istream;
+    REQUIRE(istream.feed(os.data(), os.bytesUsed()).ok());
+
+    const auto& stats = istream.stats();
+    REQUIRE(stats.feeds == 1);
+    REQUIRE(stats.bytes == os.bytesUsed());
+    REQUIRE(stats.bytes_copied == 3);     // the blob and the scalar
+    REQUIRE(stats.bytes_skipped == 1);    // the contradicting varint
+    REQUIRE(stats.fields == 3);
+    REQUIRE(stats.callbacks == 3);
+    REQUIRE(stats.max_depth == 0);
+}
+#endif
@@ -14,6 +14,9 @@
 #include <valarray>
 #include <vector>
 #include <span>
+#include <list>
+#include <ranges>
+#include <sstream>
 
 //
 
@@ -1436,3 +1439,213 @@ TEST_CASE("OStream: a failing nested ELEMENT serialize still closes its sequence
     REQUIRE(used == sizeof(expected));
     REQUIRE(std::memcmp(ostream.data(), expected, used) == 0);
 }
+
+//
+// ---------------------------------------------------------------------------
+// Compile-time worst-case size (sofab::max_size_v) and exact encodedSize().
+// ---------------------------------------------------------------------------
+//
+
+// SimpleObject hand-carries _maxSize = 12; the derived bound must agree.
+static_assert(sofab::max_size_v<
+    sofab::Field<1, uint32_t>,
+    sofab::Field<2, float>> == SimpleObject::_maxSize);
+
+static_assert(sofab::varintSize(0) == 1);
+static_assert(sofab::varintSize(127) == 1);
+static_assert(sofab::varintSize(128) == 2);
+static_assert(sofab::varintSize(UINT64_MAX) == 10);
+static_assert(sofab::fieldMaxSize<int8_t>(0) == 1 + 2);
+static_assert(sofab::fieldMaxSize<uint64_t>(16) == 2 + 10);
+static_assert(sofab::fieldMaxSize<bool>(0) == 2);
+static_assert(sofab::fieldMaxSize<double>(0) == 1 + 1 + 8);
+static_assert(sofab::fieldMaxSize<sofab::FixedString<16>>(0) == 1 + 2 + 16);
+static_assert(sofab::fieldMaxSize<sofab::FixedBytes<8>>(0) == 1 + 1 + 8);
+static_assert(sofab::fieldMaxSize<std::array<uint16_t, 4>>(0) == 1 + 1 + 4 * 3);
+static_assert(sofab::fieldMaxSize<sofab::InlineVector<float, 3>>(0) == 1 + 1 + 1 + 3 * 4);
+static_assert(sofab::fieldMaxSize<sofab::InlineVector<sofab::FixedString<2>, 2>>(0)
+    == 1 + (1 + 1 + 2) * 2 + 1);
+
+class SizedInner : public sofab::OStreamMessage
+{
+public:
+    int32_t a = 0;
+    sofab::FixedBytes<4> b;
+
+    static constexpr size_t _maxSize = sofab::max_size_v<
+        sofab::Field<0, int32_t>,
+        sofab::Field<1, sofab::FixedBytes<4>>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        auto result = _ostream.writeIf(0, a, a != 0);
+        if (result && b.size() != 0)
+        {
+            return _ostream.write(1, b.data(), static_cast<int32_t>(b.size()));
+        }
+
+        return result;
+    }
+};
+
+class SizedOuter : public sofab::OStreamMessage
+{
+public:
+    uint64_t id = 0;
+    sofab::FixedString<20> name;
+    sofab::InlineVector<int16_t, 5> samples;
+    SizedInner inner;
+
+    static constexpr size_t _maxSize = sofab::max_size_v<
+        sofab::Field<1, uint64_t>,
+        sofab::Field<2, sofab::FixedString<20>>,
+        sofab::Field<3, sofab::InlineVector<int16_t, 5>>,
+        sofab::Field<200, SizedInner>>;
+
+    sofab::OStreamImpl::Result
+    serialize(sofab::OStreamImpl &_ostream) const noexcept override
+    {
+        return _ostream
+            .writeIf(1, id, id != 0)
+            .writeIf(2, name, name.size() != 0)
+            .writeIf(3, samples, samples.size() != 0)
+            .writeLazy(200, inner)
+        ;
+    }
+};
+
+static_assert(SizedInner::_maxSize == (1 + 5) + (1 + 1 + 4));
+static_assert(SizedOuter::_maxSize ==
+    (1 + 10) + (1 + 2 + 20) + (1 + 1 + 5 * 3) + (2 + SizedInner::_maxSize + 1));
+
+TEST_CASE("OStream: a derived _maxSize holds the widest value exactly")
+{
+    sofab::OStreamObject<SizedOuter> ostream;
+    SizedOuter &msg = ostream.operator->();
+    msg.id = UINT64_MAX;
+    msg.name = "abcdefghijklmnopqrst";
+    msg.samples = {INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN};
+    msg.inner.a = INT32_MIN;
+    msg.inner.b = {1, 2, 3, 4};
+
+    REQUIRE(sofab::encodedSize(msg) == SizedOuter::_maxSize);
+
+    REQUIRE(ostream.serialize().ok());
+    REQUIRE(ostream.ok());
+    REQUIRE(ostream.bytesUsed() == SizedOuter::_maxSize);
+}
+
+TEST_CASE("OStream: encodedSize matches the bytes written")
+{
+    SizedOuter msg;
+    REQUIRE(sofab::encodedSize(msg) == 0);   // all-default: nothing on the wire
+
+    msg.id = 300;
+    msg.name = "hi";
+    msg.samples = {-1, 64};
+
+    sofab::OStream ostream{SizedOuter::_maxSize};
+    REQUIRE(msg.serialize(ostream).ok());
+    REQUIRE(sofab::encodedSize(msg) == ostream.bytesUsed());
+    REQUIRE(sofab::encodedSize(msg) == 3 + 4 + 5);
+
+    msg.inner.a = 1;
+    REQUIRE(sofab::encodedSize(msg) == 3 + 4 + 5 + (2 + 2 + 1));
+
+    REQUIRE(sofab::encodedSize(1, 300u) == 3);
+    REQUIRE(sofab::encodedSize(1, std::string_view{"hello"}) == 1 + 1 + 5);
+}
+
+//
+// ---------------------------------------------------------------------------
+// writeRange(): arrays streamed from a range, byte-identical to write().
+// ---------------------------------------------------------------------------
+//
+
+TEST_CASE("OStream: writeRange over a sized view matches write of the array")
+{
+    const std::array<int32_t, 6> column = {-3, 1, 400, -70000, 5, INT32_MIN};
+    auto view = column | std::views::transform([](int32_t v) { return v * 2; });
+    std::vector<int32_t> copy(view.begin(), view.end());
+
+    sofab::OStreamInline<64> expected;
+    expected.write(7, copy);
+
+    sofab::OStreamInline<64> ostream;
+    REQUIRE(ostream.writeRange(7, view).ok());
+
+    REQUIRE(ostream.bytesUsed() == expected.bytesUsed());
+    REQUIRE(std::memcmp(ostream.data(), expected.data(), ostream.bytesUsed()) == 0);
+}
+
+TEST_CASE("OStream: writeRange over an unsized filtered view counts in a first pass")
+{
+    const std::array<uint16_t, 8> column = {1, 200, 3, 40000, 5, 6, 7, 65535};
+    auto view = column | std::views::filter([](uint16_t v) { return v % 2 != 0; });
+    std::vector<uint16_t> copy(view.begin(), view.end());
+
+    sofab::OStreamInline<64> expected;
+    expected.write(1, copy);
+
+    sofab::OStreamInline<64> ostream;
+    REQUIRE(ostream.writeRange(1, view).ok());
+
+    REQUIRE(ostream.bytesUsed() == expected.bytesUsed());
+    REQUIRE(std::memcmp(ostream.data(), expected.data(), ostream.bytesUsed()) == 0);
+}
+
+TEST_CASE("OStream: writeRange of floats and doubles, strided")
+{
+    const std::vector<double> matrix = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+    auto column = std::views::iota(size_t{0}, matrix.size() / 2)
+        | std::views::transform([&](size_t row) { return matrix[row * 2 + 1]; });
+    const std::vector<double> copy = {2.0, 4.0, 6.0};
+    const std::list<float> floats = {0.5f, -0.0f, 1e30f};
+    const std::vector<float> fcopy(floats.begin(), floats.end());
+
+    sofab::OStreamInline<64> expected;
+    expected.write(2, copy).write(3, fcopy);
+
+    sofab::OStreamInline<64> ostream;
+    REQUIRE(ostream.writeRange(2, column).writeRange(3, floats).ok());
+
+    REQUIRE(ostream.bytesUsed() == expected.bytesUsed());
+    REQUIRE(std::memcmp(ostream.data(), expected.data(), ostream.bytesUsed()) == 0);
+}
+
+TEST_CASE("OStream: writeRange counted form over a single-pass range")
+{
+    std::istringstream in{"10 20 30"};
+    auto values = std::views::istream<uint32_t>(in);
+
+    sofab::OStreamInline<16> ostream;
+    REQUIRE(ostream.writeRange(0, 3, values).ok());
+
+    const uint8_t expected[] = {0x03, 0x03, 0x0A, 0x14, 0x1E};
+    REQUIRE(ostream.bytesUsed() == sizeof(expected));
+    REQUIRE(std::memcmp(ostream.data(), expected, sizeof(expected)) == 0);
+}
+
+TEST_CASE("OStream: writeRange counted form pads a short range and reports it")
+{
+    std::istringstream in{"10"};
+    auto values = std::views::istream<uint32_t>(in);
+
+    sofab::OStreamInline<16> ostream;
+    REQUIRE(ostream.writeRange(0, 3, values) == sofab::Error::InvalidArgument);
+    REQUIRE_FALSE(ostream.ok());
+
+    // still a well-formed 3-element array
+    const uint8_t expected[] = {0x03, 0x03, 0x0A, 0x00, 0x00};
+    REQUIRE(ostream.bytesUsed() == sizeof(expected));
+    REQUIRE(std::memcmp(ostream.data(), expected, sizeof(expected)) == 0);
+}
+
+TEST_CASE("OStream: writeRange reports a full buffer")
+{
+    auto values = std::views::iota(0u, 100u);
+
+    sofab::OStreamInline<16> ostream;
+    REQUIRE(ostream.writeRange(0, values) == sofab::Error::BufferFull);
+}
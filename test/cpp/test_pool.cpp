@@ -0,0 +1,263 @@
+/*!
+ * @file test_pool.cpp
+ * @brief SofaBuffers test for the pooled chunk stream (pool.hpp)
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "sofab/pool.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* helpers ********************************************************************/
+
+namespace
+{
+
+//! A few kilobytes of mixed fields, written the same way to any stream.
+void encodeSample(sofab::OStreamImpl &ostream)
+{
+    std::vector<uint32_t> values;
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        values.push_back(i * 2654435761u);
+    }
+
+    for (sofab_id_t id = 0; id < 8; id++)
+    {
+        ostream.write(id * 4 + 0, static_cast<int64_t>(id) * -1000003);
+        ostream.write(id * 4 + 1, std::string("pooled chunk ") + std::to_string(id));
+        ostream.write(id * 4 + 2, values);
+        ostream.write(id * 4 + 3, 0.25 * id);
+    }
+}
+
+//! The sample encoded into one buffer large enough to hold it.
+std::vector<uint8_t> referenceBytes()
+{
+    std::array<uint8_t, 4096> buffer{};
+    sofab::OStreamView ostream{buffer.data(), buffer.size()};
+    encodeSample(ostream);
+    REQUIRE(ostream.ok());
+    return {buffer.begin(), buffer.begin() + ostream.bytesUsed()};
+}
+
+} // namespace
+
+/* tests **********************************************************************/
+
+TEST_CASE("BufferPool: acquire hands out distinct chunks until empty")
+{
+    sofab::BufferPool pool{32, 3};
+    REQUIRE(pool.available() == 3);
+
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    auto c = pool.acquire();
+    REQUIRE(a);
+    REQUIRE(b);
+    REQUIRE(c);
+    REQUIRE(a.data() != b.data());
+    REQUIRE(b.data() != c.data());
+    REQUIRE(a.data() != c.data());
+    REQUIRE(pool.available() == 0);
+
+    auto none = pool.acquire();
+    REQUIRE_FALSE(none);
+    REQUIRE(none.data() == nullptr);
+
+    // Dropping a handle returns its chunk; moving one does not.
+    sofab::BufferPool::Chunk moved = std::move(b);
+    REQUIRE_FALSE(b);
+    REQUIRE(pool.available() == 0);
+
+    moved.reset();
+    REQUIRE(pool.available() == 1);
+
+    auto again = pool.acquire();
+    REQUIRE(again);
+    REQUIRE(pool.available() == 0);
+}
+
+TEST_CASE("BufferPool: concurrent acquire and release keep every chunk")
+{
+    constexpr size_t chunks = 8;
+    sofab::BufferPool pool{16, chunks};
+
+    // Catch2 assertions are not thread-safe: the workers only count, the
+    // main thread checks.
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&pool, &failures, t] {
+            for (int i = 0; i < 20000; i++)
+            {
+                auto chunk = pool.acquire();
+                if (chunk)
+                {
+                    // Owned exclusively while held: a torn hand-out would
+                    // let another thread overwrite this byte.
+                    chunk.data()[0] = static_cast<uint8_t>(t);
+                    if (chunk.data()[0] != static_cast<uint8_t>(t))
+                    {
+                        failures.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    REQUIRE(failures == 0);
+    REQUIRE(pool.available() == chunks);
+
+    std::vector<sofab::BufferPool::Chunk> held;
+    for (size_t i = 0; i < chunks; i++)
+    {
+        held.push_back(pool.acquire());
+        REQUIRE(held.back());
+    }
+    REQUIRE_FALSE(pool.acquire());
+}
+
+TEST_CASE("OStreamPooled: chunks concatenate to the unchunked encoding")
+{
+    const auto expected = referenceBytes();
+
+    sofab::BufferPool pool{64, 2};
+    std::vector<uint8_t> received;
+    size_t chunks = 0;
+
+    {
+        sofab::OStreamPooled ostream{pool, [&](sofab::BufferPool::Chunk chunk) {
+            REQUIRE(chunk.size() <= pool.chunkSize());
+            auto bytes = chunk.bytes();
+            received.insert(received.end(), bytes.begin(), bytes.end());
+            chunks++;
+        }};
+
+        encodeSample(ostream);
+        REQUIRE(ostream.ok());
+    }
+
+    REQUIRE(chunks == (expected.size() + 63) / 64);
+    REQUIRE(received == expected);
+    REQUIRE(pool.available() == pool.chunkCount());
+}
+
+TEST_CASE("OStreamPooled: a single chunk suffices when the sink releases")
+{
+    const auto expected = referenceBytes();
+
+    sofab::BufferPool pool{SOFAB_MIN_OUTPUT_BUFFER, 1};
+    std::vector<uint8_t> received;
+
+    {
+        sofab::OStreamPooled ostream{pool, [&](sofab::BufferPool::Chunk chunk) {
+            auto bytes = chunk.bytes();
+            received.insert(received.end(), bytes.begin(), bytes.end());
+        }};
+
+        encodeSample(ostream);
+        REQUIRE(ostream.ok());
+    }
+
+    REQUIRE(received == expected);
+    REQUIRE(pool.available() == 1);
+}
+
+TEST_CASE("OStreamPooled: a sink may keep chunks past the callback")
+{
+    const auto expected = referenceBytes();
+
+    sofab::BufferPool pool{128, 32};
+    std::vector<sofab::BufferPool::Chunk> queue;
+
+    {
+        sofab::OStreamPooled ostream{pool, [&](sofab::BufferPool::Chunk chunk) {
+            queue.push_back(std::move(chunk));
+        }};
+
+        encodeSample(ostream);
+        REQUIRE(ostream.ok());
+    }
+
+    REQUIRE(pool.available() == pool.chunkCount() - queue.size());
+
+    std::vector<uint8_t> received;
+    for (auto &chunk : queue)
+    {
+        auto bytes = chunk.bytes();
+        received.insert(received.end(), bytes.begin(), bytes.end());
+    }
+    REQUIRE(received == expected);
+
+    queue.clear();
+    REQUIRE(pool.available() == pool.chunkCount());
+}
+
+TEST_CASE("OStreamPooled: an exhausted pool fails the write, resume continues")
+{
+    sofab::BufferPool pool{16, 2};
+    std::vector<sofab::BufferPool::Chunk> queue;
+
+    sofab::OStreamPooled ostream{pool, [&](sofab::BufferPool::Chunk chunk) {
+        queue.push_back(std::move(chunk));
+    }};
+
+    const std::array<uint8_t, 40> blob{};
+    auto result = ostream.write(1, blob.data(), blob.size());
+    REQUIRE(result.code() == sofab::Error::BufferFull);
+    REQUIRE_FALSE(ostream.ok());
+    REQUIRE(queue.size() == 2);
+    REQUIRE(pool.available() == 0);
+
+    // Still stalled: nothing came back.
+    REQUIRE(ostream.write(2, 1u).code() == sofab::Error::BufferFull);
+    REQUIRE_FALSE(ostream.resume());
+
+    queue.erase(queue.begin());
+    REQUIRE(ostream.resume());
+    REQUIRE(ostream.write(2, 1u).code() == sofab::Error::None);
+    REQUIRE(ostream.error() == sofab::Error::BufferFull);
+}
+
+TEST_CASE("OStreamPooled: offset reserves the head of every chunk")
+{
+    constexpr size_t offset = 4;
+    const auto expected = referenceBytes();
+
+    sofab::BufferPool pool{48, 2};
+    std::vector<uint8_t> received;
+    size_t chunks = 0;
+
+    {
+        sofab::OStreamPooled ostream{pool, [&](sofab::BufferPool::Chunk chunk) {
+            REQUIRE(chunk.size() > offset);
+            // The sink owns the reserved bytes; fill them as a framing header would.
+            std::memset(chunk.data(), 0xA5, offset);
+            auto bytes = chunk.bytes().subspan(offset);
+            received.insert(received.end(), bytes.begin(), bytes.end());
+            chunks++;
+        }, offset};
+
+        encodeSample(ostream);
+        REQUIRE(ostream.ok());
+    }
+
+    const size_t payload = pool.chunkSize() - offset;
+    REQUIRE(chunks == (expected.size() + payload - 1) / payload);
+    REQUIRE(received == expected);
+    REQUIRE(pool.available() == pool.chunkCount());
+}
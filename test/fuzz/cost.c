@@ -0,0 +1,279 @@
+/*!
+ * @file cost.c
+ * @brief SofaBuffers C - Algorithmic-complexity fuzzing of the object decoder
+ *
+ * main.c hunts crashes; this hunts slow inputs. It keeps a small pool of the
+ * inputs that cost the most CPU time per byte to decode (cost_target.h) and
+ * mutates them, keeping a mutant that beats the cheapest in the pool. Besides
+ * byte edits the mutations repeat and splice whole ranges, which is how a
+ * cheap pattern becomes an expensive message. The search starts from the
+ * target's seeds.
+ *
+ * Usage: sofabfuzz_cost [--iterations N] [--seed S] [--out DIR]
+ *
+ * The pool is printed at the end, most expensive first; with --out it is also
+ * written as DIR/cost-NN.bin, the format bench_cost replays. The regression
+ * corpus is test/fuzz/corpus/cost: when a search turns up a worse input, add it
+ * there and fix what it found.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cost_target.h"
+
+/*****************************************************************************/
+/* search */
+/*****************************************************************************/
+
+#define MAX_INPUT   4096
+#define POOL        16
+#define REPS        8       /* decodes per measurement */
+#define ROUNDS      3       /* measurements per input, the fastest counts */
+
+typedef struct
+{
+    size_t len;
+    double cost;            /* CPU ns per input byte */
+    uint8_t buf[MAX_INPUT];
+} entry_t;
+
+static entry_t pool[POOL];
+static unsigned pool_used;
+
+static double cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double measure(const uint8_t *buf, size_t len)
+{
+    double best = 0;
+
+    if (len == 0)
+    {
+        return 0;
+    }
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        double t0 = cpu_ns();
+        for (int i = 0; i < REPS; i++)
+        {
+            cost_target_decode(buf, len);
+        }
+        double t = (cpu_ns() - t0) / REPS;
+        if (r == 0 || t < best)
+        {
+            best = t;
+        }
+    }
+    return best / (double)len;
+}
+
+static unsigned pool_cheapest(void)
+{
+    unsigned min = 0;
+    for (unsigned i = 1; i < pool_used; i++)
+    {
+        if (pool[i].cost < pool[min].cost)
+        {
+            min = i;
+        }
+    }
+    return min;
+}
+
+/* Keep the input if the pool has room or it beats the cheapest entry. */
+static int pool_offer(const uint8_t *buf, size_t len, double cost)
+{
+    for (unsigned i = 0; i < pool_used; i++)
+    {
+        if (pool[i].len == len && memcmp(pool[i].buf, buf, len) == 0)
+        {
+            return 0;
+        }
+    }
+
+    unsigned slot;
+    if (pool_used < POOL)
+    {
+        slot = pool_used++;
+    }
+    else
+    {
+        slot = pool_cheapest();
+        if (pool[slot].cost >= cost)
+        {
+            return 0;
+        }
+    }
+    pool[slot].len = len;
+    pool[slot].cost = cost;
+    memcpy(pool[slot].buf, buf, len);
+    return 1;
+}
+
+/* Bytes the format gives meaning to: a sequence end, the wrapper holder and an
+ * unknown sequence opening, a varint continuation, a fixlen-array header. */
+static const uint8_t tokens[] = { 0x07, 0x0E, 0x9E, 0x06, 0x80, 0xFF, 0x25, 0x1D };
+
+static size_t mutate(uint8_t *buf, size_t len)
+{
+    int mutations = 1 + (rand() % 4);
+
+    for (int m = 0; m < mutations; m++)
+    {
+        size_t pos = len ? (size_t)rand() % len : 0;
+
+        switch (rand() % 7)
+        {
+            case 0:     /* flip a bit */
+                if (len) buf[pos] ^= (uint8_t)(1u << (rand() % 8));
+                break;
+
+            case 1:     /* overwrite with a format token */
+                if (len) buf[pos] = tokens[rand() % sizeof tokens];
+                break;
+
+            case 2:     /* insert a token */
+                if (len < MAX_INPUT)
+                {
+                    memmove(buf + pos + 1, buf + pos, len - pos);
+                    buf[pos] = tokens[rand() % sizeof tokens];
+                    len++;
+                }
+                break;
+
+            case 3:     /* delete a byte */
+                if (len > 1)
+                {
+                    memmove(buf + pos, buf + pos + 1, len - pos - 1);
+                    len--;
+                }
+                break;
+
+            case 4:     /* repeat a range in place: cheap patterns become runs */
+            case 5:
+            {
+                size_t n = 1 + (size_t)rand() % 16;
+                if (pos + n > len) n = len - pos;
+                while (n && len + n <= MAX_INPUT && rand() % 4)
+                {
+                    memmove(buf + pos + n, buf + pos, len - pos);
+                    len += n;
+                }
+                break;
+            }
+
+            default:    /* splice in a range of another pool entry */
+            {
+                const entry_t *e = &pool[(unsigned)rand() % pool_used];
+                if (e->len == 0) break;
+                size_t from = (size_t)rand() % e->len;
+                size_t n = 1 + (size_t)rand() % 32;
+                if (from + n > e->len) n = e->len - from;
+                if (len + n > MAX_INPUT) break;
+                memmove(buf + pos + n, buf + pos, len - pos);
+                memcpy(buf + pos, e->buf + from, n);
+                len += n;
+                break;
+            }
+        }
+    }
+    return len;
+}
+
+static int by_cost(const void *a, const void *b)
+{
+    double ca = ((const entry_t *)a)->cost;
+    double cb = ((const entry_t *)b)->cost;
+    return (ca < cb) - (ca > cb);
+}
+
+int main (int argc, char **argv)
+{
+    unsigned long iterations = 200000;
+    unsigned seed = 0xC0FFEE;
+    const char *out = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+            iterations = strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = (unsigned)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+            out = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--iterations N] [--seed S] [--out DIR]\n", argv[0]);
+            return 2;
+        }
+    }
+    srand(seed);
+
+    static uint8_t input[MAX_INPUT];
+    for (unsigned i = 0; i < COST_SEED_COUNT; i++)
+    {
+        size_t len = cost_target_seed(i, input, sizeof input);
+        double cost = measure(input, len);
+        pool_offer(input, len, cost);
+        fprintf(stderr, "%-20s %5zu bytes  %8.2f ns/byte\n", cost_seed_names[i], len, cost);
+    }
+
+    double worst = 0;
+    for (unsigned long iter = 1; iter <= iterations; iter++)
+    {
+        const entry_t *parent = &pool[(unsigned)rand() % pool_used];
+        memcpy(input, parent->buf, parent->len);
+        size_t len = mutate(input, parent->len);
+
+        double cost = measure(input, len);
+        if (pool_offer(input, len, cost) && cost > worst)
+        {
+            worst = cost;
+            fprintf(stderr, "iteration %lu: new worst %.2f ns/byte (%zu bytes)\n",
+                    iter, cost, len);
+        }
+        if ((iter % 100000) == 0)
+        {
+            fprintf(stderr, "fuzzing iterations: %lu\n", iter);
+        }
+    }
+
+    /* re-measure the survivors once more so the ranking is not one lucky run */
+    for (unsigned i = 0; i < pool_used; i++)
+    {
+        pool[i].cost = measure(pool[i].buf, pool[i].len);
+    }
+    qsort(pool, pool_used, sizeof pool[0], by_cost);
+
+    printf("rank\tbytes\tns/byte\n");
+    for (unsigned i = 0; i < pool_used; i++)
+    {
+        printf("%u\t%zu\t%.2f\n", i, pool[i].len, pool[i].cost);
+        if (out)
+        {
+            char path[1024];
+            snprintf(path, sizeof path, "%s/cost-%02u.bin", out, i);
+            FILE *f = fopen(path, "wb");
+            if (!f || fwrite(pool[i].buf, 1, pool[i].len, f) != pool[i].len)
+            {
+                fprintf(stderr, "cannot write %s\n", path);
+                if (f) fclose(f);
+                return 1;
+            }
+            fclose(f);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*!
+ * @file cost_target.h
+ * @brief SofaBuffers - Decode target and seeds for algorithmic-complexity fuzzing.
+ *
+ * The decoder is a byte-at-a-time state machine, so its own cost per input
+ * byte is bounded. What is not bounded by the byte count is the work a few
+ * bytes can trigger on the object path: every field header is looked up by a
+ * linear scan of the descriptor (sofab_object_field_cb), and every re-open of a
+ * wrapper-array holder resets the whole holder (MESSAGE_SPEC §7.4) — two bytes
+ * of input, a memset/memcpy of its full capacity. Add sequences nested to
+ * SOFAB_MAX_DEPTH that are skipped whole, and fixlen arrays whose elements
+ * nobody binds, and these are the shapes an adversary on a public ingress
+ * would send to buy the most CPU per byte.
+ *
+ * This header is the one target both sides use: test/fuzz/cost.c searches for
+ * inputs that maximise the cost per byte of cost_target_decode(), and
+ * bench/c/cost.c replays the corpus it records and reports that cost. Keeping
+ * the descriptor in one place is what makes the corpus mean the same thing to
+ * both. Valid C99, header-only (static), like bench/perf_events.h.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_COST_TARGET_H
+#define SOFAB_COST_TARGET_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "sofab/istream.h"
+#include "sofab/ostream.h"
+#include "sofab/object.h"
+
+#define COST_SLOTS      64      /* wrapper holder capacity (elements) */
+#define COST_SLOT_LEN   32      /* bytes per wrapper element */
+#define COST_SCALARS    32      /* flat scalar fields: the lookup scan */
+#define COST_LEVELS     4       /* nesting levels below the root */
+
+/* ---- target object -------------------------------------------------------- */
+
+typedef struct { char s[COST_SLOTS][COST_SLOT_LEN]; } cost_items_t;
+typedef struct { uint32_t v; } cost_l4_t;
+typedef struct { cost_l4_t l4; } cost_l3_t;
+typedef struct { cost_l3_t l3; } cost_l2_t;
+typedef struct { cost_l2_t l2; int32_t tail; } cost_l1_t;
+
+typedef struct
+{
+    cost_items_t items;
+    cost_l1_t    l1;
+    uint32_t     u32[64];
+    double       fp64[16];
+    char         text[64];
+    uint32_t     f[COST_SCALARS];
+} cost_obj_t;
+
+#define COST_SLOT(i) \
+    SOFAB_OBJECT_FIELD(i, cost_items_t, s[i], SOFAB_OBJECT_FIELDTYPE_STRING)
+#define COST_SLOT4(i)  COST_SLOT(i), COST_SLOT(i + 1), COST_SLOT(i + 2), COST_SLOT(i + 3)
+#define COST_SLOT16(i) COST_SLOT4(i), COST_SLOT4(i + 4), COST_SLOT4(i + 8), COST_SLOT4(i + 12)
+
+static const sofab_object_descr_field_t cost_items_fields[] = {
+    COST_SLOT16(0), COST_SLOT16(16), COST_SLOT16(32), COST_SLOT16(48),
+};
+static const sofab_object_descr_t cost_items_info =
+    SOFAB_OBJECT_DESCR_SEQ(cost_items_fields, COST_SLOTS, NULL, 0);
+
+static const sofab_object_descr_field_t cost_l4_fields[] = {
+    SOFAB_OBJECT_FIELD(1, cost_l4_t, v, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+};
+static const sofab_object_descr_t cost_l4_info =
+    SOFAB_OBJECT_DESCR(cost_l4_fields, 1, NULL, 0);
+
+static const sofab_object_descr_field_t cost_l3_fields[] = {
+    SOFAB_OBJECT_FIELD_SEQUENCE(1, cost_l3_t, l4, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+};
+static const sofab_object_descr_t *const cost_l3_nested[] = { &cost_l4_info };
+static const sofab_object_descr_t cost_l3_info =
+    SOFAB_OBJECT_DESCR(cost_l3_fields, 1, cost_l3_nested, 1);
+
+static const sofab_object_descr_field_t cost_l2_fields[] = {
+    SOFAB_OBJECT_FIELD_SEQUENCE(1, cost_l2_t, l3, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+};
+static const sofab_object_descr_t *const cost_l2_nested[] = { &cost_l3_info };
+static const sofab_object_descr_t cost_l2_info =
+    SOFAB_OBJECT_DESCR(cost_l2_fields, 1, cost_l2_nested, 1);
+
+static const sofab_object_descr_field_t cost_l1_fields[] = {
+    SOFAB_OBJECT_FIELD_SEQUENCE(1, cost_l1_t, l2, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+    SOFAB_OBJECT_FIELD(2, cost_l1_t, tail, SOFAB_OBJECT_FIELDTYPE_SIGNED),
+};
+static const sofab_object_descr_t *const cost_l1_nested[] = { &cost_l2_info };
+static const sofab_object_descr_t cost_l1_info =
+    SOFAB_OBJECT_DESCR(cost_l1_fields, 2, cost_l1_nested, 1);
+
+#define COST_F(i) \
+    SOFAB_OBJECT_FIELD(10 + i, cost_obj_t, f[i], SOFAB_OBJECT_FIELDTYPE_UNSIGNED)
+#define COST_F4(i)  COST_F(i), COST_F(i + 1), COST_F(i + 2), COST_F(i + 3)
+#define COST_F16(i) COST_F4(i), COST_F4(i + 4), COST_F4(i + 8), COST_F4(i + 12)
+
+/* The scalars come last, so a header naming one of them walks past every
+ * other field first. */
+static const sofab_object_descr_field_t cost_obj_fields[] = {
+    SOFAB_OBJECT_FIELD_SEQUENCE(1, cost_obj_t, items, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+    SOFAB_OBJECT_FIELD_SEQUENCE(2, cost_obj_t, l1, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 1),
+    SOFAB_OBJECT_FIELD_ARRAY(3, cost_obj_t, u32, SOFAB_OBJECT_FIELDTYPE_ARRAY_UNSIGNED),
+    SOFAB_OBJECT_FIELD_ARRAY(4, cost_obj_t, fp64, SOFAB_OBJECT_FIELDTYPE_ARRAY_FP64),
+    SOFAB_OBJECT_FIELD(5, cost_obj_t, text, SOFAB_OBJECT_FIELDTYPE_STRING),
+    COST_F16(0), COST_F16(16),
+};
+static const sofab_object_descr_t *const cost_obj_nested[] = {
+    &cost_items_info, &cost_l1_info,
+};
+static const sofab_object_descr_t cost_obj_info =
+    SOFAB_OBJECT_DESCR(cost_obj_fields, 5 + COST_SCALARS, cost_obj_nested, 2);
+
+static cost_obj_t cost_obj_dst;
+
+/*!
+ * @brief Decode one message into the target object, as a receiver would:
+ *        re-initialize the destination, then feed the whole input.
+ */
+static sofab_ret_t cost_target_decode(const uint8_t *data, size_t len)
+{
+    sofab_istream_t is;
+    sofab_object_decoder_t dec[COST_LEVELS + 1];
+
+    sofab_object_init(&cost_obj_info, &cost_obj_dst);
+    memset(dec, 0, sizeof dec);
+    dec[0].info = &cost_obj_info;
+    dec[0].dst = (uint8_t *)&cost_obj_dst;
+    dec[0].depth = COST_LEVELS;
+    sofab_istream_init(&is, sofab_object_field_cb, dec);
+    return sofab_istream_feed(&is, data, len);
+}
+
+/* ---- seeds ---------------------------------------------------------------- */
+
+#define COST_SEED_COUNT 4
+
+static const char *const cost_seed_names[COST_SEED_COUNT] = {
+    "seed-typical", "seed-deep-skip", "seed-wrapper-reopen", "seed-skipped-fixlen",
+};
+
+/*!
+ * @brief Write seed @p i (< COST_SEED_COUNT) into @p buf.
+ *
+ * One well-formed message filling every field, then one starting point per
+ * suspected vector, each in its plainest form for the search to build on.
+ *
+ * @return Bytes written (the seeds fit in 4 KiB).
+ */
+static size_t cost_target_seed(unsigned i, uint8_t *buf, size_t cap)
+{
+    sofab_ostream_t os;
+    size_t n = 0;
+
+    sofab_ostream_init(&os, buf, cap, 0, NULL, NULL);
+    switch (i)
+    {
+        case 0:
+        {
+            static cost_obj_t src;
+            for (unsigned k = 0; k < COST_SLOTS; k++)
+                memcpy(src.items.s[k], "item", 5);
+            src.l1.l2.l3.l4.v = 7;
+            src.l1.tail = -1;
+            for (unsigned k = 0; k < 64; k++)
+                src.u32[k] = 1000u * k + 1;
+            for (unsigned k = 0; k < 16; k++)
+                src.fp64[k] = 0.5 * k + 0.25;
+            memcpy(src.text, "cost target", 12);
+            for (unsigned k = 0; k < COST_SCALARS; k++)
+                src.f[k] = k + 1;
+            sofab_object_encode(&os, &cost_obj_info, &src);
+            return sofab_ostream_bytes_used(&os);
+        }
+
+        case 1:
+            /* Unknown sequences nested to near the depth ceiling, skipped whole
+             * with a scalar at the bottom. Header: id 99, SEQUENCE_START. */
+            for (unsigned k = 0; k < SOFAB_MAX_DEPTH - 5 && n + 2 < cap; k++)
+            {
+                buf[n++] = 0x9E;
+                buf[n++] = 0x06;
+            }
+            buf[n++] = 0x08;    /* id 1, varint */
+            buf[n++] = 0x01;
+            for (unsigned k = 0; k < SOFAB_MAX_DEPTH - 5 && n < cap; k++)
+                buf[n++] = 0x07;
+            return n;
+
+        case 2:
+            /* Open-and-close of the wrapper holder (id 1): each re-open resets
+             * all COST_SLOTS elements. */
+            for (unsigned k = 0; k < 128 && n + 2 <= cap; k++)
+            {
+                buf[n++] = 0x0E;
+                buf[n++] = 0x07;
+            }
+            return n;
+
+        default:
+        {
+            /* An fp64 array under an id nobody declared: every element skipped. */
+            static double skipped[200];
+            sofab_ostream_write_array_of_fp64(&os, 98, skipped, 200);
+            return sofab_ostream_bytes_used(&os);
+        }
+    }
+}
+
+#endif /* SOFAB_COST_TARGET_H */
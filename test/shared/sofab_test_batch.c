@@ -0,0 +1,54 @@
+/*!
+ * @file sofab_test_batch.c
+ * @brief Shared record for the batch decode tests (see sofab_test_batch.h).
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "sofab_test_batch.h"
+
+#include "unity.h"
+
+static const sofab_object_descr_field_t _child_fields[] = {
+    SOFAB_OBJECT_FIELD(0, sofab_test_batch_child_t, v, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+};
+static const sofab_object_descr_t _child_descr =
+    SOFAB_OBJECT_DESCR(_child_fields, 1, NULL, 0);
+
+static const sofab_object_descr_field_t _rec_fields[] = {
+    SOFAB_OBJECT_FIELD(0, sofab_test_batch_rec_t, id, SOFAB_OBJECT_FIELDTYPE_UNSIGNED),
+    SOFAB_OBJECT_FIELD(1, sofab_test_batch_rec_t, delta, SOFAB_OBJECT_FIELDTYPE_SIGNED),
+    SOFAB_OBJECT_FIELD(2, sofab_test_batch_rec_t, name, SOFAB_OBJECT_FIELDTYPE_STRING),
+    SOFAB_OBJECT_FIELD_SEQUENCE(3, sofab_test_batch_rec_t, child, SOFAB_OBJECT_FIELDTYPE_SEQUENCE, 0),
+};
+static const sofab_object_descr_t *const _rec_nested[] = { &_child_descr };
+
+const sofab_test_batch_rec_t sofab_test_batch_defaults = { .delta = -1 };
+
+const sofab_object_descr_t sofab_test_batch_descr =
+    SOFAB_OBJECT_DESCR_WITH_DEFAULTS(_rec_fields, 4, _rec_nested, 1, &sofab_test_batch_defaults);
+
+size_t sofab_test_batch_frame(uint8_t *out, const sofab_test_batch_rec_t *rec)
+{
+    sofab_ostream_t os;
+    size_t used;
+
+    /* offset 1 keeps the prefix byte free */
+    sofab_ostream_init(&os, out, SOFAB_TEST_BATCH_FRAME_MAX, 1, NULL, NULL);
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_object_encode(&os, &sofab_test_batch_descr, rec));
+    used = sofab_ostream_bytes_used(&os);
+    out[0] = (uint8_t)(used - 1);
+
+    return used;
+}
+
+void sofab_test_batch_check(
+    const sofab_test_batch_rec_t *expect, sofab_ret_t status, const sofab_test_batch_slot_t *slot)
+{
+    TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, status);
+    TEST_ASSERT_EQUAL_UINT32(expect->id, slot->rec.id);
+    TEST_ASSERT_EQUAL_INT32(expect->delta, slot->rec.delta);
+    TEST_ASSERT_EQUAL_STRING(expect->name, slot->rec.name);
+    TEST_ASSERT_EQUAL_UINT16(expect->child.v, slot->rec.child.v);
+    TEST_ASSERT_EQUAL_UINT32(SOFAB_TEST_BATCH_TAG, slot->tag);
+}
@@ -0,0 +1,78 @@
+/*!
+ * @file sofab_test_batch.h
+ * @brief Shared record for the batch decode tests.
+ *
+ * The object API's serial batch decode (test_object.c) and the parallel batch
+ * library (test_batch.c) run on the same record: an id, a delta defaulting to
+ * -1, a name and a nested child. The caller's array holds it in a slot whose
+ * tag the batch must leave alone; the tests fill the slots with
+ * SOFAB_TEST_BATCH_STALE bytes first, so a record the batch did not reset
+ * shows up as stale and an untouched tag reads SOFAB_TEST_BATCH_TAG.
+ *
+ * Plain C with Unity assertions, so C test binary only.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_TEST_BATCH_H
+#define SOFAB_TEST_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sofab/object.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! @brief Byte the tests fill the slots with before a batch. */
+#define SOFAB_TEST_BATCH_STALE  (0x5A)
+
+/*! @brief A tag (or any 32-bit word) left as SOFAB_TEST_BATCH_STALE bytes. */
+#define SOFAB_TEST_BATCH_TAG    (0x5A5A5A5Au)
+
+/*! @brief Room for one frame; every record encodes well under it, so its
+ *         length prefix is a single byte. */
+#define SOFAB_TEST_BATCH_FRAME_MAX  (128)
+
+typedef struct
+{
+    uint16_t v;
+} sofab_test_batch_child_t;
+
+typedef struct
+{
+    uint32_t id;
+    int32_t delta;
+    char name[24];
+    sofab_test_batch_child_t child;
+} sofab_test_batch_rec_t;
+
+/*! @brief What the caller's array holds: the record plus data the batch must
+ *         not touch. */
+typedef struct
+{
+    sofab_test_batch_rec_t rec;
+    uint32_t tag;
+} sofab_test_batch_slot_t;
+
+/*! @brief Descriptor of sofab_test_batch_rec_t, with its defaults. */
+extern const sofab_object_descr_t sofab_test_batch_descr;
+
+/*! @brief The all-default record: it encodes to an empty message. */
+extern const sofab_test_batch_rec_t sofab_test_batch_defaults;
+
+/*! @brief Write @p rec as one frame to @p out (SOFAB_TEST_BATCH_FRAME_MAX
+ *         bytes of room); returns the frame's length. */
+size_t sofab_test_batch_frame(uint8_t *out, const sofab_test_batch_rec_t *rec);
+
+/*! @brief Check that @p slot holds @p expect, decoded OK with its tag intact. */
+void sofab_test_batch_check(
+    const sofab_test_batch_rec_t *expect, sofab_ret_t status, const sofab_test_batch_slot_t *slot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFAB_TEST_BATCH_H */
@@ -0,0 +1,70 @@
+/*!
+ * @file sofab_test_stream.c
+ * @brief Shared message and file helpers (see sofab_test_stream.h).
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+/* mkstemp and unlink are POSIX, not C99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include "sofab_test_stream.h"
+
+#include "unity.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+uint32_t sofab_test_values[SOFAB_TEST_FIELDS + 1];
+
+void sofab_test_values_field_cb(
+    sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usrptr)
+{
+    (void)size; (void)count; (void)usrptr;
+
+    if (id <= SOFAB_TEST_FIELDS)
+    {
+        sofab_istream_read_u32(ctx, &sofab_test_values[id]);
+    }
+}
+
+void sofab_test_encode_fields(sofab_ostream_t *os, uint32_t first, uint32_t last)
+{
+    for (uint32_t i = first; i <= last; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(SOFAB_RET_OK, sofab_ostream_write_unsigned(os, i, i * 1000));
+    }
+}
+
+size_t sofab_test_encode_plain(uint8_t *buf, size_t buflen, uint32_t first, uint32_t last)
+{
+    sofab_ostream_t os;
+
+    sofab_ostream_init(&os, buf, buflen, 0, NULL, NULL);
+    sofab_test_encode_fields(&os, first, last);
+
+    return sofab_ostream_bytes_used(&os);
+}
+
+void sofab_test_check_values(void)
+{
+    for (uint32_t i = 1; i <= SOFAB_TEST_FIELDS; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(i * 1000, sofab_test_values[i]);
+    }
+}
+
+int sofab_test_temp_file(const uint8_t *data, size_t len)
+{
+    char path[] = "/tmp/sofab_test_XXXXXX";
+    int fd = mkstemp(path);
+
+    TEST_ASSERT_TRUE(fd >= 0);
+    unlink(path);
+    if (len > 0)
+    {
+        TEST_ASSERT_EQUAL_INT((int)len, (int)write(fd, data, len));
+    }
+
+    return fd;
+}
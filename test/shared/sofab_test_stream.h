@@ -0,0 +1,57 @@
+/*!
+ * @file sofab_test_stream.h
+ * @brief Shared message and file helpers for the stream adapter tests.
+ *
+ * The sink and source adapters (test_posix.c, test_uring.c, test_bgsink.c) all
+ * push the same message through their adapter and compare it with a one-buffer
+ * encode of it: fields 1..SOFAB_TEST_FIELDS, field i holding i * 1000, several
+ * times the size of the buffers under test. A decode through
+ * sofab_test_values_field_cb() collects the values in sofab_test_values.
+ *
+ * Plain C with Unity assertions, so C test binary only; sofab_test_temp_file()
+ * needs a POSIX system.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef SOFAB_TEST_STREAM_H
+#define SOFAB_TEST_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sofab/istream.h"
+#include "sofab/ostream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! @brief Fields of the test message. */
+#define SOFAB_TEST_FIELDS  (300)
+
+/*! @brief Values decoded by sofab_test_values_field_cb(), by field id. */
+extern uint32_t sofab_test_values[SOFAB_TEST_FIELDS + 1];
+
+/*! @brief Field callback storing field i in sofab_test_values[i]. */
+void sofab_test_values_field_cb(
+    sofab_istream_t *ctx, sofab_id_t id, size_t size, size_t count, void *usrptr);
+
+/*! @brief Write fields @p first .. @p last of the test message to @p os. */
+void sofab_test_encode_fields(sofab_ostream_t *os, uint32_t first, uint32_t last);
+
+/*! @brief Fields @p first .. @p last in one buffer, as the reference; returns its length. */
+size_t sofab_test_encode_plain(uint8_t *buf, size_t buflen, uint32_t first, uint32_t last);
+
+/*! @brief Check that sofab_test_values holds the whole test message. */
+void sofab_test_check_values(void);
+
+/*! @brief A fresh, unlinked temporary file holding @p len bytes of @p data,
+ *         positioned at its end. */
+int sofab_test_temp_file(const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFAB_TEST_STREAM_H */
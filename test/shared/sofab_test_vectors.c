@@ -105,6 +105,7 @@ typedef struct
 typedef struct
 {
     char    *name;
+    char    *group;             /* construct family ("scalar/unsigned", ...) */
     op_t    *ops;
     size_t   nops;
     uint8_t *bytes;
@@ -283,6 +284,7 @@ static void free_vector(vector_t *v)
     }
     free(v->bytes);
     free(v->name);
+    free(v->group);
     memset(v, 0, sizeof(*v));
 }
 
@@ -295,6 +297,11 @@ static int load_vector(const sofab_json_t *vj, vector_t *out)
     if (!out->name) return -1;
     if (nm) memcpy(out->name, nm, nl + 1); else out->name[0] = '\0';
 
+    size_t gl; const char *gr = sofab_json_string(sofab_json_get(vj, "group"), &gl);
+    out->group = (char *)malloc(gr ? gl + 1 : 1);
+    if (!out->group) { free_vector(out); return -1; }
+    if (gr) memcpy(out->group, gr, gl + 1); else out->group[0] = '\0';
+
     const sofab_json_t *fields = sofab_json_get(vj, "fields");
     size_t nf = sofab_json_array_size(fields);
     out->ops = (op_t *)calloc(nf ? nf : 1, sizeof(op_t));
@@ -1057,3 +1064,135 @@ int sofab_test_vectors_run_all(const char *path, sofab_test_vectors_result_t *ou
     sofab_json_free(root);
     return out->failures ? -1 : 0;
 }
+
+/* benchmark access **********************************************************
+ *
+ * The same vectors, loaded once and replayed on demand: bench/c/vectors.c times
+ * encode and decode of each one. The encode is replay_op over a flat buffer and
+ * the decode is vec_field_cb, i.e. exactly what the conformance checks run,
+ * minus the value comparison — the caller checks each vector once with
+ * sofab_test_vectors_check() before timing it.
+ */
+
+struct sofab_test_vector_set
+{
+    vector_t *vec;
+    size_t    n;
+    slot_t   *slots;    /* decode destinations, sized for the longest vector */
+    uint32_t  caps;
+};
+
+sofab_test_vector_set_t *sofab_test_vectors_load(const char *path, char *err, size_t errlen)
+{
+    size_t flen = 0;
+    char *text = read_file(path, &flen);
+    if (!text) { snprintf(err, errlen, "cannot open %s", path); return NULL; }
+
+    char perr[128];
+    sofab_json_t *root = sofab_json_parse(text, flen, perr, sizeof(perr));
+    free(text);
+    if (!root) { snprintf(err, errlen, "json parse error: %s", perr); return NULL; }
+
+    const sofab_json_t *vectors = sofab_json_get(root, "vectors");
+    size_t nv = sofab_json_array_size(vectors);
+
+    sofab_test_vector_set_t *set = (sofab_test_vector_set_t *)calloc(1, sizeof(*set));
+    if (set) set->vec = (vector_t *)calloc(nv ? nv : 1, sizeof(vector_t));
+    if (!set || !set->vec)
+    {
+        snprintf(err, errlen, "oom");
+        free(set);
+        sofab_json_free(root);
+        return NULL;
+    }
+    set->caps = build_caps();
+
+    size_t maxops = 1;
+    for (size_t i = 0; i < nv; i++)
+    {
+        if (load_vector(sofab_json_array_at(vectors, i), &set->vec[set->n]))
+        {
+            snprintf(err, errlen, "vector %zu: failed to load", i);
+            sofab_json_free(root);
+            sofab_test_vectors_free(set);
+            return NULL;
+        }
+        if (set->vec[set->n].nops > maxops) maxops = set->vec[set->n].nops;
+        set->n++;
+    }
+    sofab_json_free(root);
+
+    set->slots = (slot_t *)calloc(maxops, sizeof(slot_t));
+    if (!set->slots)
+    {
+        snprintf(err, errlen, "oom");
+        sofab_test_vectors_free(set);
+        return NULL;
+    }
+    return set;
+}
+
+void sofab_test_vectors_free(sofab_test_vector_set_t *set)
+{
+    if (!set) return;
+    for (size_t i = 0; i < set->n; i++) free_vector(&set->vec[i]);
+    free(set->vec);
+    free(set->slots);
+    free(set);
+}
+
+size_t sofab_test_vectors_count(const sofab_test_vector_set_t *set) { return set->n; }
+
+const char *sofab_test_vectors_name(const sofab_test_vector_set_t *set, size_t i) { return set->vec[i].name; }
+
+const char *sofab_test_vectors_group(const sofab_test_vector_set_t *set, size_t i) { return set->vec[i].group; }
+
+int sofab_test_vectors_supported(const sofab_test_vector_set_t *set, size_t i)
+{
+    return (set->vec[i].req & ~set->caps) == 0;
+}
+
+const uint8_t *sofab_test_vectors_bytes(const sofab_test_vector_set_t *set, size_t i, size_t *len)
+{
+    *len = set->vec[i].nbytes;
+    return set->vec[i].bytes;
+}
+
+int sofab_test_vectors_check(const sofab_test_vector_set_t *set, size_t i, char *err, size_t errlen)
+{
+    const vector_t *v = &set->vec[i];
+    if (run_encode(v, 0, err, errlen)) return -1;
+    return decode_bytes(v->ops, v->nops, v->bytes, v->nbytes, 0, NULL, 0, err, errlen);
+}
+
+int sofab_test_vectors_encode(const sofab_test_vector_set_t *set, size_t i,
+                              uint8_t *out, size_t outcap, size_t *outlen)
+{
+    const vector_t *v = &set->vec[i];
+    sofab_ostream_t os;
+    sofab_ostream_init(&os, out, outcap, 0, NULL, NULL);
+    for (size_t k = 0; k < v->nops; k++)
+        if (replay_op(&os, &v->ops[k]) != SOFAB_RET_OK) return -1;
+    *outlen = sofab_ostream_flush(&os);
+    return 0;
+}
+
+int sofab_test_vectors_decode(sofab_test_vector_set_t *set, size_t i,
+                              const uint8_t *bytes, size_t nbytes)
+{
+    const vector_t *v = &set->vec[i];
+    cursor_t c;
+    c.ops = v->ops;
+    c.n = v->nops;
+    c.i = 0;
+    c.depth = 0;
+    c.slots = set->slots;
+    c.overflow = 0;
+    c.skip_ids = NULL;
+    c.nskip = 0;
+
+    sofab_istream_t is;
+    sofab_istream_init(&is, vec_field_cb, &c);
+    if (sofab_istream_feed(&is, bytes, nbytes) != SOFAB_RET_OK) return -1;
+    return c.overflow ? -1 : 0;
+}
@@ -44,6 +44,7 @@
 #define SOFAB_TEST_VECTORS_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -69,6 +70,36 @@ typedef struct
  */
 int sofab_test_vectors_run_all(const char *path, sofab_test_vectors_result_t *out);
 
+/*
+ * Benchmark access (bench/c/vectors.c): the vectors loaded once, indexed
+ * 0..count-1, each encoded and decoded on demand by the same replay the
+ * conformance checks use. Encode and decode do not compare values; run
+ * sofab_test_vectors_check() on a vector before timing it.
+ */
+typedef struct sofab_test_vector_set sofab_test_vector_set_t;
+
+/*! @brief Load every positive vector of @p path; NULL (reason in @p err) on failure. */
+sofab_test_vector_set_t *sofab_test_vectors_load(const char *path, char *err, size_t errlen);
+void sofab_test_vectors_free(sofab_test_vector_set_t *set);
+
+size_t sofab_test_vectors_count(const sofab_test_vector_set_t *set);
+const char *sofab_test_vectors_name(const sofab_test_vector_set_t *set, size_t i);
+/*! @brief The vector's construct family, e.g. "scalar/unsigned", "array/float". */
+const char *sofab_test_vectors_group(const sofab_test_vector_set_t *set, size_t i);
+/*! @brief 1 if this build has every capability the vector requires. */
+int sofab_test_vectors_supported(const sofab_test_vector_set_t *set, size_t i);
+/*! @brief The vector's serialized bytes (the decode input). */
+const uint8_t *sofab_test_vectors_bytes(const sofab_test_vector_set_t *set, size_t i, size_t *len);
+
+/*! @brief Encode and decode check of vector @p i: 0 if both match the vector. */
+int sofab_test_vectors_check(const sofab_test_vector_set_t *set, size_t i, char *err, size_t errlen);
+/*! @brief Replay vector @p i's fields into @p out; 0 on success. */
+int sofab_test_vectors_encode(const sofab_test_vector_set_t *set, size_t i,
+                              uint8_t *out, size_t outcap, size_t *outlen);
+/*! @brief Decode @p bytes as vector @p i into the set's slots; 0 on success. */
+int sofab_test_vectors_decode(sofab_test_vector_set_t *set, size_t i,
+                              const uint8_t *bytes, size_t nbytes);
+
 #ifdef __cplusplus
 }
 #endif
@@ -39,12 +39,15 @@ BUILD_DIR="${BUILD_DIR:-${ROOT}/build/footprint}"
 # --- shared CMake flags (match the CI build jobs) --------------------------
 # Only the static library is built, so tests/bench/install/C++ are all off to
 # keep the configure step dependency-free (no FetchContent of Unity/Catch2).
+# The framing layer is left out: it is a separate object a consumer links only
+# if it calls it, and the tables describe the codec.
 COMMON=(
   -DCMAKE_BUILD_TYPE=Release
   -DSOFAB_ENABLE_CPP=OFF
   -DSOFAB_ENABLE_BENCH=OFF
   -DSOFAB_BUILD_TESTS=OFF
   -DSOFAB_INSTALL=OFF
+  -DSOFAB_DISABLE_FRAMING=ON
 )
 
 # The four configurations, and the flags that define them, come from the file the
@@ -134,6 +137,7 @@ SWITCHES=(
   "SOFAB_DISABLE_OBJECT_API|-DSOFAB_DISABLE_OBJECT_API=ON"
   "SOFAB_ENABLE_STRICT_UTF8|-DSOFAB_ENABLE_STRICT_UTF8=ON"
   "SOFAB_ENABLE_SKIP_COUNTER|-DSOFAB_ENABLE_SKIP_COUNTER=ON"
+  "SOFAB_ENABLE_STATS|-DSOFAB_ENABLE_STATS=ON"
   "SOFAB_OBJECT_DESCR_PROFILE=SOFAB_OBJECT_DESCR_SMALL|-DSOFAB_OBJECT_DESCR_PROFILE=SOFAB_OBJECT_DESCR_SMALL"
   "SOFAB_OBJECT_DESCR_PROFILE=SOFAB_OBJECT_DESCR_BIG|-DSOFAB_OBJECT_DESCR_PROFILE=SOFAB_OBJECT_DESCR_BIG"
 )